@@ -1,9 +1,4 @@
 
-INCLUDE_DIRS    := $(INCLUDE_DIRS) \
-                   $(ROOT)/lib/main/dyad
-
-MCU_COMMON_SRC  := $(ROOT)/lib/main/dyad/dyad.c
-
 #Flags
 ARCH_FLAGS      =
 DEVICE_FLAGS    =
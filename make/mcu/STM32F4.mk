@@ -218,7 +218,8 @@ ifneq ($(filter ONBOARDFLASH,$(FEATURES)),)
 MSC_SRC += \
             msc/usbd_storage_emfat.c \
             msc/emfat.c \
-            msc/emfat_file.c
+            msc/emfat_file.c \
+            msc/flash_readahead.c
 endif
 
 DSP_LIB := $(ROOT)/lib/main/CMSIS/DSP
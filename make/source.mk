@@ -44,6 +44,8 @@ COMMON_SRC = \
             fc/runtime_config.c \
             interface/msp.c \
             interface/msp_box.c \
+            interface/msp_dataflash.c \
+            interface/msp_dispatch.c \
             interface/tramp_protocol.c \
             interface/smartaudio_protocol.c \
             io/beeper.c \
@@ -85,6 +87,7 @@ COMMON_SRC = \
             flight/servos.c \
             flight/servos_tricopter.c \
             interface/cli.c \
+            interface/msp_settings.c \
             interface/settings.c \
             io/serial_4way.c \
             io/serial_4way_avrootloader.c \
@@ -138,6 +141,7 @@ COMMON_SRC = \
             io/displayport_srxl.c \
             io/displayport_crsf.c \
             io/displayport_hott.c \
+            io/displayport_sim.c \
             io/rcdevice_cam.c \
             io/rcdevice.c \
             io/gps.c \
@@ -147,6 +151,7 @@ COMMON_SRC = \
             sensors/barometer.c \
             sensors/rangefinder.c \
             telemetry/telemetry.c \
+            telemetry/telemetry_scheduler.c \
             telemetry/crsf.c \
             telemetry/srxl.c \
             telemetry/frsky_hub.c \
@@ -278,6 +283,7 @@ SIZE_OPTIMISED_SRC := $(SIZE_OPTIMISED_SRC) \
             config/config_streamer.c \
             i2c_bst.c \
             interface/cli.c \
+            interface/msp_settings.c \
             interface/settings.c \
             io/dashboard.c \
             io/osd.c \
@@ -314,6 +320,7 @@ SPEED_OPTIMISED_SRC := $(SPEED_OPTIMISED_SRC) \
             drivers/bus_i2c_hal.c \
             drivers/bus_spi_ll.c \
             drivers/max7456.c \
+            drivers/max7456_stream.c \
             drivers/pwm_output_dshot.c \
             drivers/pwm_output_dshot_hal.c
 endif #!F3
@@ -349,6 +356,10 @@ SRC += \
             $(MSC_SRC)
 endif
 
+ifneq ($(filter drivers/max7456.c,$(SRC)),)
+SRC += drivers/max7456_stream.c
+endif
+
 SRC += $(COMMON_SRC)
 
 #excludes
@@ -55,6 +55,8 @@ typedef struct blackboxConfig_s {
     uint8_t device;
     uint8_t record_acc;
     uint8_t mode;
+    uint8_t flash_circular;         // wrap around and overwrite the oldest logs when the flash is full
+    uint16_t flash_erase_ahead_kb;  // space kept erased ahead of the end of the log while disarmed
 } blackboxConfig_t;
 
 PG_DECLARE(blackboxConfig_t, blackboxConfig);
@@ -67,8 +67,9 @@ static struct {
     enum {
         BLACKBOX_SDCARD_INITIAL,
         BLACKBOX_SDCARD_WAITING,
-        BLACKBOX_SDCARD_ENUMERATE_FILES,
         BLACKBOX_SDCARD_CHANGE_INTO_LOG_DIRECTORY,
+        BLACKBOX_SDCARD_FIND_LARGEST_LOG_NUMBER,
+        BLACKBOX_SDCARD_ENUMERATE_FILES,
         BLACKBOX_SDCARD_READY_TO_CREATE_LOG,
         BLACKBOX_SDCARD_READY_TO_LOG
     } state;
@@ -359,9 +360,7 @@ static void blackboxLogDirCreated(afatfsFilePtr_t directory)
     if (directory) {
         blackboxSDCard.logDirectory = directory;
 
-        afatfs_findFirst(blackboxSDCard.logDirectory, &blackboxSDCard.logDirectoryFinder);
-
-        blackboxSDCard.state = BLACKBOX_SDCARD_ENUMERATE_FILES;
+        blackboxSDCard.state = BLACKBOX_SDCARD_CHANGE_INTO_LOG_DIRECTORY;
     } else {
         // Retry
         blackboxSDCard.state = BLACKBOX_SDCARD_INITIAL;
@@ -421,6 +420,35 @@ static bool blackboxSDCardBeginLog(void)
         // Waiting for directory entry to be created
         break;
 
+    case BLACKBOX_SDCARD_CHANGE_INTO_LOG_DIRECTORY:
+        // Change into the log directory:
+        if (afatfs_chdir(blackboxSDCard.logDirectory)) {
+            blackboxSDCard.state = BLACKBOX_SDCARD_FIND_LARGEST_LOG_NUMBER;
+            goto doMore;
+        }
+        break;
+
+    case BLACKBOX_SDCARD_FIND_LARGEST_LOG_NUMBER:
+        // The filesystem keeps track of the numbered files in the current directory, so usually we don't need to search it ourselves
+        switch (afatfs_findLargestFileNumber(LOGFILE_PREFIX, LOGFILE_SUFFIX, &blackboxSDCard.largestLogFileNumber)) {
+        case AFATFS_OPERATION_SUCCESS:
+            // We no longer need our open handle on the log directory
+            afatfs_fclose(blackboxSDCard.logDirectory, NULL);
+            blackboxSDCard.logDirectory = NULL;
+
+            blackboxSDCard.state = BLACKBOX_SDCARD_READY_TO_CREATE_LOG;
+            goto doMore;
+        case AFATFS_OPERATION_FAILURE:
+            // The filesystem can't number them for us
+            afatfs_findFirst(blackboxSDCard.logDirectory, &blackboxSDCard.logDirectoryFinder);
+
+            blackboxSDCard.state = BLACKBOX_SDCARD_ENUMERATE_FILES;
+            goto doMore;
+        default:
+            ;
+        }
+        break;
+
     case BLACKBOX_SDCARD_ENUMERATE_FILES:
         while (afatfs_findNext(blackboxSDCard.logDirectory, &blackboxSDCard.logDirectoryFinder, &directoryEntry) == AFATFS_OPERATION_SUCCESS) {
             if (directoryEntry && !fat_isDirectoryEntryTerminator(directoryEntry)) {
@@ -438,24 +466,15 @@ static bool blackboxSDCardBeginLog(void)
                 // We're done checking all the files on the card, now we can create a new log file
                 afatfs_findLast(blackboxSDCard.logDirectory);
 
-                blackboxSDCard.state = BLACKBOX_SDCARD_CHANGE_INTO_LOG_DIRECTORY;
+                afatfs_fclose(blackboxSDCard.logDirectory, NULL);
+                blackboxSDCard.logDirectory = NULL;
+
+                blackboxSDCard.state = BLACKBOX_SDCARD_READY_TO_CREATE_LOG;
                 goto doMore;
             }
         }
         break;
 
-    case BLACKBOX_SDCARD_CHANGE_INTO_LOG_DIRECTORY:
-        // Change into the log directory:
-        if (afatfs_chdir(blackboxSDCard.logDirectory)) {
-            // We no longer need our open handle on the log directory
-            afatfs_fclose(blackboxSDCard.logDirectory, NULL);
-            blackboxSDCard.logDirectory = NULL;
-
-            blackboxSDCard.state = BLACKBOX_SDCARD_READY_TO_CREATE_LOG;
-            goto doMore;
-        }
-        break;
-
     case BLACKBOX_SDCARD_READY_TO_CREATE_LOG:
         blackboxCreateLogFile();
         break;
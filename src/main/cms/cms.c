@@ -131,7 +131,8 @@ bool cmsDisplayPortSelect(displayPort_t *instance)
 }
 
 #define CMS_UPDATE_INTERVAL_US  50000   // Interval of key scans (microsec)
-#define CMS_POLL_INTERVAL_US   100000   // Interval of polling dynamic values (microsec)
+#define CMS_POLL_INTERVAL_US   (CMS_POLL_INTERVAL_MS * 1000) // Interval of polling dynamic values (microsec)
+#define CMS_POLL_COUNT_PERIOD  720720  // Least common multiple of the poll intervals 1 to 16, so each stays regular as the count wraps
 
 // XXX LEFT_MENU_COLUMN and RIGHT_MENU_COLUMN must be adjusted
 // dynamically depending on size of the active output device,
@@ -176,6 +177,7 @@ static uint8_t menuStackIdx = 0;
 static int8_t pageCount;         // Number of pages in the current menu
 static OSD_Entry *pageTop;       // First entry for the current page
 static uint8_t pageMaxRow;       // Max row in the current page
+static bool cmsPageRedraw;       // Page changed, every line is due
 
 static cmsCtx_t currentCtx;
 
@@ -237,7 +239,8 @@ static void cmsPageSelect(displayPort_t *instance, int8_t newpage)
     currentCtx.page = (newpage + pageCount) % pageCount;
     pageTop = &currentCtx.menu->entries[currentCtx.page * maxMenuItems];
     cmsUpdateMaxRow(instance);
-    displayClearScreen(instance);
+    // Lines the new page has in common with what is shown are not sent again
+    cmsPageRedraw = true;
 }
 
 static void cmsPageNext(displayPort_t *instance)
@@ -329,89 +332,61 @@ static void cmsPadToSize(char *buf, int size)
 #endif
 }
 
-static int cmsDrawMenuItemValue(displayPort_t *pDisplay, char *buff, uint8_t row, uint8_t maxSize)
-{
-    int colpos;
-    int cnt;
-
-    cmsPadToSize(buff, maxSize);
-#ifdef CMS_OSD_RIGHT_ALIGNED_VALUES
-    colpos = rightMenuColumn - maxSize;
-#else
-    colpos = smallScreen ? rightMenuColumn - maxSize : rightMenuColumn;
-#endif
-    cnt = displayWrite(pDisplay, colpos, row, buff);
-    return cnt;
-}
+#define CMS_DRAW_BUFFER_LEN 12
+#define CMS_NUM_FIELD_LEN 5
 
-static int cmsDrawMenuEntry(displayPort_t *pDisplay, OSD_Entry *p, uint8_t row)
+// Formats the value of an entry into buff, returns the width of its field or 0 if it has none
+static uint8_t cmsFormatMenuValue(const OSD_Entry *p, char *buff)
 {
-    #define CMS_DRAW_BUFFER_LEN 12
-    #define CMS_NUM_FIELD_LEN 5
-
-    char buff[CMS_DRAW_BUFFER_LEN +1]; // Make room for null terminator.
-    int cnt = 0;
-
-    if (smallScreen) {
-        row++;
-    }
+    uint8_t size = 0;
 
     switch (p->type) {
     case OME_String:
-        if (IS_PRINTVALUE(p) && p->data) {
+        if (p->data) {
             strncpy(buff, p->data, CMS_DRAW_BUFFER_LEN);
-            cnt = cmsDrawMenuItemValue(pDisplay, buff, row, CMS_DRAW_BUFFER_LEN);
-            CLR_PRINTVALUE(p);
+            size = CMS_DRAW_BUFFER_LEN;
         }
         break;
 
     case OME_Submenu:
     case OME_Funcall:
-        if (IS_PRINTVALUE(p))  {
-
-            buff[0]= 0x0;
+        buff[0] = 0x0;
 
-            if ((p->type == OME_Submenu) && p->func && (p->flags & OPTSTRING)) {
+        if ((p->type == OME_Submenu) && p->func && (p->flags & OPTSTRING)) {
 
-                // Special case of sub menu entry with optional value display.
+            // Special case of sub menu entry with optional value display.
 
-                char *str = ((CMSMenuOptFuncPtr)p->func)();
-                strncpy( buff, str, CMS_DRAW_BUFFER_LEN);
-            }
-            strncat(buff, ">", CMS_DRAW_BUFFER_LEN);
-
-            row = smallScreen  ? row - 1  : row;
-            cnt = cmsDrawMenuItemValue(pDisplay, buff, row, strlen(buff));
-            CLR_PRINTVALUE(p);
+            char *str = ((CMSMenuOptFuncPtr)(void (*)(void))p->func)();
+            strncpy(buff, str, CMS_DRAW_BUFFER_LEN - 1);
+            buff[CMS_DRAW_BUFFER_LEN - 1] = 0x0;
         }
+        strcat(buff, ">");
+        size = strlen(buff);
         break;
 
     case OME_Bool:
-        if (IS_PRINTVALUE(p) && p->data) {
+        if (p->data) {
             if (*((uint8_t *)(p->data))) {
               strcpy(buff, "YES");
             } else {
               strcpy(buff, "NO ");
             }
-
-            cnt = cmsDrawMenuItemValue(pDisplay, buff, row, 3);
-            CLR_PRINTVALUE(p);
+            size = 3;
         }
         break;
 
     case OME_TAB:
-        if (IS_PRINTVALUE(p)) {
+        {
             OSD_TAB_t *ptr = p->data;
             char * str = (char *)ptr->names[*ptr->val];
             strncpy(buff, str, CMS_DRAW_BUFFER_LEN);
-            cnt = cmsDrawMenuItemValue(pDisplay, buff, row, CMS_DRAW_BUFFER_LEN);
-            CLR_PRINTVALUE(p);
+            size = CMS_DRAW_BUFFER_LEN;
         }
         break;
 
 #ifdef USE_OSD
     case OME_VISIBLE:
-        if (IS_PRINTVALUE(p) && p->data) {
+        if (p->data) {
             uint16_t *val = (uint16_t *)p->data;
 
             if (VISIBLE(*val)) {
@@ -419,65 +394,52 @@ static int cmsDrawMenuEntry(displayPort_t *pDisplay, OSD_Entry *p, uint8_t row)
             } else {
               strcpy(buff, "NO ");
             }
-            cnt = cmsDrawMenuItemValue(pDisplay, buff, row, 3);
-            CLR_PRINTVALUE(p);
+            size = 3;
         }
         break;
 #endif
 
     case OME_UINT8:
-        if (IS_PRINTVALUE(p) && p->data) {
+        if (p->data) {
             OSD_UINT8_t *ptr = p->data;
             itoa(*ptr->val, buff, 10);
-            cnt = cmsDrawMenuItemValue(pDisplay, buff, row, CMS_NUM_FIELD_LEN);
-            CLR_PRINTVALUE(p);
+            size = CMS_NUM_FIELD_LEN;
         }
         break;
 
     case OME_INT8:
-        if (IS_PRINTVALUE(p) && p->data) {
+        if (p->data) {
             OSD_INT8_t *ptr = p->data;
             itoa(*ptr->val, buff, 10);
-            cnt = cmsDrawMenuItemValue(pDisplay, buff, row, CMS_NUM_FIELD_LEN);
-            CLR_PRINTVALUE(p);
+            size = CMS_NUM_FIELD_LEN;
         }
         break;
 
     case OME_UINT16:
-        if (IS_PRINTVALUE(p) && p->data) {
+        if (p->data) {
             OSD_UINT16_t *ptr = p->data;
             itoa(*ptr->val, buff, 10);
-            cnt = cmsDrawMenuItemValue(pDisplay, buff, row, CMS_NUM_FIELD_LEN);
-            CLR_PRINTVALUE(p);
+            size = CMS_NUM_FIELD_LEN;
         }
         break;
 
     case OME_INT16:
-        if (IS_PRINTVALUE(p) && p->data) {
+        if (p->data) {
             OSD_UINT16_t *ptr = p->data;
             itoa(*ptr->val, buff, 10);
-            cnt = cmsDrawMenuItemValue(pDisplay, buff, row, CMS_NUM_FIELD_LEN);
-            CLR_PRINTVALUE(p);
+            size = CMS_NUM_FIELD_LEN;
         }
         break;
 
     case OME_FLOAT:
-        if (IS_PRINTVALUE(p) && p->data) {
+        if (p->data) {
             OSD_FLOAT_t *ptr = p->data;
             cmsFormatFloat(*ptr->val * ptr->multipler, buff);
-            cnt = cmsDrawMenuItemValue(pDisplay, buff, row, CMS_NUM_FIELD_LEN);
-            CLR_PRINTVALUE(p);
+            size = CMS_NUM_FIELD_LEN;
         }
         break;
 
     case OME_Label:
-        if (IS_PRINTVALUE(p) && p->data) {
-            // A label with optional string, immediately following text
-            cnt = displayWrite(pDisplay, leftMenuColumn + 1 + (uint8_t)strlen(p->text), row, p->data);
-            CLR_PRINTVALUE(p);
-        }
-        break;
-
     case OME_OSD_Exit:
     case OME_END:
     case OME_Back:
@@ -488,16 +450,100 @@ static int cmsDrawMenuEntry(displayPort_t *pDisplay, OSD_Entry *p, uint8_t row)
     default:
 #ifdef CMS_MENU_DEBUG
         // Shouldn't happen. Notify creator of this menu content
-#ifdef CMS_OSD_RIGHT_ALIGNED_VALUES
-        cnt = displayWrite(pDisplay, rightMenuColumn - 6, row, "BADENT");
-#else.
-        cnt = displayWrite(pDisplay, rightMenuColumn, row, "BADENT");
-#endif
+        strcpy(buff, "BADENT");
+        size = 6;
 #endif
         break;
     }
 
-    return cnt;
+    if (size) {
+        cmsPadToSize(buff, size);
+    }
+    return size;
+}
+
+// Every line of the screen is drawn in full, but only sent when it differs from what was last sent
+
+#define CMS_LINES_MAX 16
+#define CMS_LINE_LENGTH_MAX 32
+
+static char cmsLines[CMS_LINES_MAX][CMS_LINE_LENGTH_MAX];
+
+static uint8_t cmsLineLength(const displayPort_t *pDisplay)
+{
+    return MIN(pDisplay->cols, CMS_LINE_LENGTH_MAX);
+}
+
+static void cmsLinePut(char *line, uint8_t length, int col, const char *text)
+{
+    for (; *text && col < length; col++, text++) {
+        if (col >= 0) {
+            line[col] = *text;
+        }
+    }
+}
+
+static void cmsLinesCleared(void)
+{
+    memset(cmsLines, ' ', sizeof(cmsLines));
+}
+
+// Composes one line of an entry, the one with cursor and label or on small screens the one below with the value
+static void cmsComposeEntryLine(char *line, uint8_t length, const OSD_Entry *p, uint8_t part, bool cursor)
+{
+    // Sub menus and function calls show their '>' on the label line, other values go below it on small screens
+    const bool valueBelow = smallScreen && p->type != OME_Submenu && p->type != OME_Funcall;
+
+    if (part == 0) {
+        if (cursor) {
+            cmsLinePut(line, length, leftMenuColumn, ">");
+        }
+        cmsLinePut(line, length, leftMenuColumn + (p->type == OME_Label ? 0 : 1), p->text);
+    }
+
+    if (part != (valueBelow ? 1 : 0)) {
+        return;
+    }
+
+    if (p->type == OME_Label) {
+        // A label with optional string, immediately following text
+        if (p->data) {
+            cmsLinePut(line, length, leftMenuColumn + 1 + strlen(p->text), p->data);
+        }
+        return;
+    }
+
+    char buff[CMS_DRAW_BUFFER_LEN + 1]; // Make room for null terminator.
+    const uint8_t size = cmsFormatMenuValue(p, buff);
+    if (size) {
+#ifdef CMS_OSD_RIGHT_ALIGNED_VALUES
+        const int colpos = rightMenuColumn - size;
+#else
+        const int colpos = smallScreen ? rightMenuColumn - size : rightMenuColumn;
+#endif
+        cmsLinePut(line, length, colpos, buff);
+    }
+}
+
+// Draws a line of the menu, p is NULL for lines without an entry
+static int cmsDrawLine(displayPort_t *pDisplay, uint8_t row, const OSD_Entry *p, uint8_t part, bool cursor)
+{
+    char line[CMS_LINE_LENGTH_MAX + 1];
+    const uint8_t length = cmsLineLength(pDisplay);
+
+    memset(line, ' ', length);
+    line[length] = 0;
+    if (p) {
+        cmsComposeEntryLine(line, length, p, part, cursor);
+    }
+
+    if (row < CMS_LINES_MAX) {
+        if (memcmp(line, cmsLines[row], length) == 0) {
+            return 0;
+        }
+        memcpy(cmsLines[row], line, length);
+    }
+    return displayWrite(pDisplay, 0, row, line);
 }
 
 static void cmsDrawMenu(displayPort_t *pDisplay, uint32_t currentTimeUs)
@@ -513,23 +559,23 @@ static void cmsDrawMenu(displayPort_t *pDisplay, uint32_t currentTimeUs)
 
     bool drawPolled = false;
     static uint32_t lastPolledUs = 0;
+    static uint32_t pollCount = 0;
 
     if (currentTimeUs > lastPolledUs + CMS_POLL_INTERVAL_US) {
         drawPolled = true;
         lastPolledUs = currentTimeUs;
+        pollCount = (pollCount + 1) % CMS_POLL_COUNT_PERIOD;
     }
 
     uint32_t room = displayTxBytesFree(pDisplay);
 
     if (pDisplay->cleared) {
-        for (p = pageTop, i= 0; p->type != OME_END; p++, i++) {
-            SET_PRINTLABEL(p);
-            SET_PRINTVALUE(p);
-        }
+        cmsLinesCleared();
+        cmsPageRedraw = true;
         pDisplay->cleared = false;
     } else if (drawPolled) {
         for (p = pageTop ; p <= pageTop + pageMaxRow ; p++) {
-            if (IS_DYNAMIC(p))
+            if (IS_DYNAMIC(p) && pollCount % DYNAMIC_POLL_INTERVALS(p) == 0)
                 SET_PRINTVALUE(p);
         }
     }
@@ -541,42 +587,46 @@ static void cmsDrawMenu(displayPort_t *pDisplay, uint32_t currentTimeUs)
 
     cmsPageDebug();
 
-    if (pDisplay->cursorRow >= 0 && currentCtx.cursorRow != pDisplay->cursorRow) {
-        room -= displayWrite(pDisplay, leftMenuColumn, top + pDisplay->cursorRow * linesPerMenuItem, " ");
-    }
-
-    if (room < 30)
-        return;
-
     if (pDisplay->cursorRow != currentCtx.cursorRow) {
-        room -= displayWrite(pDisplay, leftMenuColumn, top + currentCtx.cursorRow * linesPerMenuItem, ">");
+        // The lines the cursor leaves and moves to
+        if (pDisplay->cursorRow >= 0 && pDisplay->cursorRow <= pageMaxRow) {
+            SET_PRINTLABEL(pageTop + pDisplay->cursorRow);
+        }
+        SET_PRINTLABEL(pageTop + currentCtx.cursorRow);
         pDisplay->cursorRow = currentCtx.cursorRow;
     }
 
     if (room < 30)
         return;
 
-    // Print text labels
-    for (i = 0, p = pageTop; i < maxMenuItems && p->type != OME_END; i++, p++) {
-        if (IS_PRINTLABEL(p)) {
-            uint8_t coloff = leftMenuColumn;
-            coloff += (p->type == OME_Label) ? 0 : 1;
-            room -= displayWrite(pDisplay, coloff, top + i * linesPerMenuItem, p->text);
-            CLR_PRINTLABEL(p);
+    // Print the entries that changed, lines that are the same as on screen are skipped
+
+    for (i = 0, p = pageTop; i <= pageMaxRow; i++, p++) {
+        if (!cmsPageRedraw && !IS_PRINTLABEL(p) && !IS_PRINTVALUE(p)) {
+            continue;
+        }
+
+        for (uint8_t part = 0; part < linesPerMenuItem; part++) {
+            room -= cmsDrawLine(pDisplay, top + i * linesPerMenuItem + part, p, part, i == currentCtx.cursorRow);
             if (room < 30)
                 return;
         }
+        CLR_PRINTLABEL(p);
+        CLR_PRINTVALUE(p);
+    }
 
-    // Print values
-
-    // XXX Polled values at latter positions in the list may not be
-    // XXX printed if not enough room in the middle of the list.
+    // Blank what the previous page left outside of this one
 
-        if (IS_PRINTVALUE(p)) {
-            room -= cmsDrawMenuEntry(pDisplay, p, top + i * linesPerMenuItem);
-            if (room < 30)
-                return;
+    if (cmsPageRedraw) {
+        const uint8_t bottom = top + (pageMaxRow + 1) * linesPerMenuItem;
+        for (uint8_t row = 0; row < pDisplay->rows; row++) {
+            if (row < top || row >= bottom) {
+                room -= cmsDrawLine(pDisplay, row, NULL, 0, false);
+                if (room < 30)
+                    return;
+            }
         }
+        cmsPageRedraw = false;
     }
 }
 
@@ -685,6 +735,7 @@ void cmsMenuOpen(void)
         }
     }
     displayGrab(pCurrentDisplay); // grab the display for use by the CMS
+    displayClearScreen(pCurrentDisplay);
 
     if ( pCurrentDisplay->cols < NORMAL_SCREEN_MIN_COLS) {
       smallScreen       = true;
@@ -719,7 +770,7 @@ static void cmsTraverseGlobalExit(const CMS_Menu *pMenu)
 
 long cmsMenuExit(displayPort_t *pDisplay, const void *ptr)
 {
-    int exitType = (int)ptr;
+    int exitType = (intptr_t)ptr;
     switch (exitType) {
     case CMS_EXIT_SAVE:
     case CMS_EXIT_SAVEREBOOT:
@@ -1103,6 +1154,11 @@ void cmsUpdate(uint32_t currentTimeUs)
 
         cmsDrawMenu(pCurrentDisplay, currentTimeUs);
 
+        // Send the changes to displays that buffer their writes
+        if (!displayIsTransferInProgress(pCurrentDisplay)) {
+            displayDrawScreen(pCurrentDisplay);
+        }
+
         if (currentTimeMs > lastCmsHeartBeatMs + 500) {
             // Heart beat for external CMS display device @ 500msec
             // (Timeout @ 1000msec)
@@ -97,7 +97,7 @@ CMS_Menu cmsx_menuRcPreview = {
 
 static uint16_t motorConfig_minthrottle;
 static uint8_t motorConfig_digitalIdleOffsetValue;
-static debugType_e systemConfig_debug_mode;
+static uint8_t systemConfig_debug_mode;
 
 static long cmsx_menuMiscOnEnter(void)
 {
@@ -39,8 +39,8 @@
 
 #include "fc/config.h"
 
-voltageMeterSource_e batteryConfig_voltageMeterSource;
-currentMeterSource_e batteryConfig_currentMeterSource;
+uint8_t batteryConfig_voltageMeterSource;
+uint8_t batteryConfig_currentMeterSource;
 
 uint8_t batteryConfig_vbatmaxcellvoltage;
 
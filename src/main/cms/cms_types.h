@@ -81,6 +81,13 @@ typedef struct
 
 #define IS_DYNAMIC(p) ((p)->flags & DYNAMIC)
 
+// Dynamic values are polled every CMS_POLL_INTERVAL_MS. Values that change slowly, or are costly to show, can ask for
+// a longer interval of up to 16 polls with DYNAMIC_EVERY(ms) in place of DYNAMIC.
+#define CMS_POLL_INTERVAL_MS 100
+#define DYNAMIC_POLL_SHIFT 4
+#define DYNAMIC_EVERY(ms) (DYNAMIC | ((((ms) / CMS_POLL_INTERVAL_MS - 1) & 0x0F) << DYNAMIC_POLL_SHIFT))
+#define DYNAMIC_POLL_INTERVALS(p) (((p)->flags >> DYNAMIC_POLL_SHIFT) + 1)
+
 typedef long (*CMSMenuFuncPtr)(void);
 
 // Special return value(s) for function chaining by CMSMenuFuncPtr
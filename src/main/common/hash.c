@@ -0,0 +1,46 @@
+/*
+ * This file is part of Cleanflight and Betaflight.
+ *
+ * Cleanflight and Betaflight are free software. You can redistribute
+ * this software and/or modify this software under the terms of the
+ * GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Cleanflight and Betaflight are distributed in the hope that they
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software.
+ *
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+
+#include "hash.h"
+
+#define FNV1A_PRIME         16777619u
+
+uint32_t fnv1a_update(uint32_t hash, const void *data, uint32_t length)
+{
+    const uint8_t *p = (const uint8_t *)data;
+    const uint8_t *pend = p + length;
+
+    for (; p != pend; p++) {
+        hash = (hash ^ *p) * FNV1A_PRIME;
+    }
+    return hash;
+}
+
+uint32_t fnv1a_string(const char *str)
+{
+    uint32_t hash = FNV1A_OFFSET_BASIS;
+
+    while (*str) {
+        hash = (hash ^ (uint8_t)*str++) * FNV1A_PRIME;
+    }
+    return hash;
+}
@@ -68,6 +68,20 @@ int huffmanEncodeBuf(uint8_t *outBuf, int outBufLen, const uint8_t *inBuf, int i
     return ret;
 }
 
+/*
+ * Return the number of bytes that huffmanEncodeBuf() would produce for the given input, without encoding it.
+ */
+int huffmanEncodedLength(const uint8_t *inBuf, int inLen, const huffmanTable_t *huffmanTable)
+{
+    uint32_t bitCount = 0;
+
+    for (const uint8_t *pos = inBuf, *end = inBuf + inLen; pos < end; ++pos) {
+        bitCount += huffmanTable[*pos].codeLen;
+    }
+
+    return (bitCount + 7) / 8;
+}
+
 int huffmanEncodeBufStreaming(huffmanState_t *state, const uint8_t *inBuf, int inLen, const huffmanTable_t *huffmanTable)
 {
     uint8_t *savedOutBytePtr = state->outByte;
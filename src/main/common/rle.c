@@ -0,0 +1,84 @@
+/*
+ * This file is part of Cleanflight and Betaflight.
+ *
+ * Cleanflight and Betaflight are free software. You can redistribute
+ * this software and/or modify this software under the terms of the
+ * GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Cleanflight and Betaflight are distributed in the hope that they
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software.
+ *
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "platform.h"
+
+#include "rle.h"
+
+// Shorter runs than this are cheaper to send as part of a literal packet
+#define RLE_MIN_REPEAT_LENGTH 3
+
+static bool rleRepeatStartsAt(const uint8_t *inBuf, int remaining)
+{
+    return remaining >= RLE_MIN_REPEAT_LENGTH && inBuf[0] == inBuf[1] && inBuf[1] == inBuf[2];
+}
+
+/*
+ * Encode inBuf into outBuf, returning the encoded length, or -1 if that would exceed outBufLen.
+ *
+ * Pass NULL for outBuf to find the encoded length without encoding anything.
+ */
+int rleEncodeBuf(uint8_t *outBuf, int outBufLen, const uint8_t *inBuf, int inLen)
+{
+    const uint8_t *end = inBuf + inLen;
+    int outLen = 0;
+
+    while (inBuf < end) {
+        if (rleRepeatStartsAt(inBuf, end - inBuf)) {
+            int repeatLen = RLE_MIN_REPEAT_LENGTH;
+
+            while (repeatLen < RLE_MAX_PACKET_LENGTH && inBuf + repeatLen < end && inBuf[repeatLen] == inBuf[0]) {
+                repeatLen++;
+            }
+
+            if (outBuf) {
+                if (outLen + 2 > outBufLen) {
+                    return -1;
+                }
+                outBuf[outLen] = 257 - repeatLen;
+                outBuf[outLen + 1] = inBuf[0];
+            }
+            outLen += 2;
+            inBuf += repeatLen;
+        } else {
+            int literalLen = 1;
+
+            while (literalLen < RLE_MAX_PACKET_LENGTH && inBuf + literalLen < end && !rleRepeatStartsAt(inBuf + literalLen, end - inBuf - literalLen)) {
+                literalLen++;
+            }
+
+            if (outBuf) {
+                if (outLen + 1 + literalLen > outBufLen) {
+                    return -1;
+                }
+                outBuf[outLen] = literalLen - 1;
+                memcpy(outBuf + outLen + 1, inBuf, literalLen);
+            }
+            outLen += 1 + literalLen;
+            inBuf += literalLen;
+        }
+    }
+
+    return outLen;
+}
@@ -0,0 +1,34 @@
+/*
+ * This file is part of Cleanflight and Betaflight.
+ *
+ * Cleanflight and Betaflight are free software. You can redistribute
+ * this software and/or modify this software under the terms of the
+ * GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Cleanflight and Betaflight are distributed in the hope that they
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software.
+ *
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+/*
+ * PackBits run-length encoding. Each packet begins with a control byte n:
+ *
+ *     0..127   - n + 1 literal bytes follow
+ *     129..255 - the following byte is repeated 257 - n times
+ *     128      - no-op
+ */
+#define RLE_MAX_PACKET_LENGTH 128
+
+int rleEncodeBuf(uint8_t *outBuf, int outBufLen, const uint8_t *inBuf, int inLen);
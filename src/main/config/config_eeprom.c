@@ -27,6 +27,7 @@
 #include "build/build_config.h"
 
 #include "common/crc.h"
+#include "common/maths.h"
 #include "common/utils.h"
 
 #include "config/config_eeprom.h"
@@ -41,6 +42,24 @@ extern uint8_t __config_start;   // configured via linker script when building b
 extern uint8_t __config_end;
 #endif
 
+/*
+ * The config is stored as a log of PG records. Each save appends only the PGs whose contents differ from the newest
+ * stored copy, followed by a commit record, so a save normally programs a few words instead of erasing and rewriting
+ * the whole config sector. Loading replays the newest committed record for each PG.
+ *
+ * When the log is full it is compacted by writing a snapshot of all PGs into a fresh bank. If the config region spans
+ * at least two flash pages it is split into two banks that are used alternately, so the previous config stays intact
+ * until the new bank has been committed. Otherwise the single bank is erased and rewritten in place.
+ *
+ * Every record carries a sequence number that continues across banks, so stale records left behind in a reused bank
+ * are never mistaken for the continuation of the log.
+ *
+ * Each scan indexes the newest committed record of every PG, so loads and saves are a single pass over the log.
+ *
+ * A config saved before the log was introduced is a single snapshot checked by one CRC. It is still loaded, and the
+ * next save replaces it with a log.
+ */
+
 static uint16_t eepromConfigSize;
 
 typedef enum {
@@ -49,33 +68,55 @@ typedef enum {
 } configRecordFlags_e;
 
 #define CR_CLASSIFICATION_MASK  (0x3)
+#define CR_FLAG_COMMIT          (0x80)  // marks the end of a save, records after the last commit are ignored
 #define CRC_START_VALUE         0xFFFF
-#define CRC_CHECK_VALUE         0x1D0F  // pre-calculated value of CRC that includes the CRC itself
 
-// Header for the saved copy.
+#define CONFIG_ALIGN(size)      (((size) + sizeof(uint32_t) - 1) & ~(sizeof(uint32_t) - 1))
+#define CONFIG_ERASED_WORD      0xFFFFFFFF
+
+// Header at the start of each bank.
 typedef struct {
     uint8_t eepromConfigVersion;
     uint8_t magic_be;           // magic number, should be 0xBE
+    uint16_t crc;               // CRC of the header, calculated with this field set to 0
+    uint32_t generation;        // incremented each time the config is compacted into a bank
+    uint32_t size;              // size of the bank, including this header
 } PG_PACKED configHeader_t;
 
 // Header for each stored PG.
 typedef struct {
     // split up.
-    uint16_t size;
+    uint16_t size;              // size of the record, excluding the padding to the next word boundary
+
     pgn_t pgn;
     uint8_t version;
 
     // lower 2 bits used to indicate system or profile number, see CR_CLASSIFICATION_MASK
     uint8_t flags;
 
+    uint16_t crc;               // CRC of the record, calculated with this field set to 0
+    uint32_t sequence;
+
     uint8_t pg[];
 } PG_PACKED configRecord_t;
 
-// Footer for the saved copy.
+// Header for the saved copy, in the format before the log.
 typedef struct {
-    uint16_t terminator;
-} PG_PACKED configFooter_t;
-// checksum is appended just after footer. It is not included in footer to make checksum calculation consistent
+    uint8_t eepromConfigVersion;
+    uint8_t magic_be;           // magic number, should be 0xBE
+} PG_PACKED legacyConfigHeader_t;
+
+// Header for each stored PG, in the format before the log. The records end with a zero size, followed by the CRC.
+typedef struct {
+    uint16_t size;
+    pgn_t pgn;
+    uint8_t version;
+    uint8_t flags;
+
+    uint8_t pg[];
+} PG_PACKED legacyConfigRecord_t;
+
+#define LEGACY_CRC_CHECK_VALUE  0x1D0F  // pre-calculated value of CRC that includes the CRC itself
 
 // Used to check the compiler packing at build time.
 typedef struct {
@@ -83,6 +124,18 @@ typedef struct {
     uint32_t word;
 } PG_PACKED packingTest_t;
 
+// Location of the current config, as found by the last scan.
+static struct {
+    const uint8_t *bank;        // NULL if no bank holds a committed config
+    uint32_t bankSize;
+    uint32_t generation;
+    uint32_t committedSize;     // offset just past the last commit record
+    uint32_t usedSize;          // offset just past the last intact record
+    uint32_t nextSequence;
+    uint32_t legacySize;        // size of a config saved in the format before the log, 0 if there is none or a log
+    uint16_t newestRecord[PG_REGISTRY_MAX_SIZE];    // offset of the newest record for each PG by registry index, 0 if none
+} configLog;
+
 void initEEPROM(void)
 {
     // Verify that this architecture packs as expected.
@@ -90,30 +143,129 @@ void initEEPROM(void)
     STATIC_ASSERT(offsetof(packingTest_t, word) == 1, word_packing_test_failed);
     STATIC_ASSERT(sizeof(packingTest_t) == 5, overall_packing_test_failed);
 
-    STATIC_ASSERT(sizeof(configFooter_t) == 2, footer_size_failed);
-    STATIC_ASSERT(sizeof(configRecord_t) == 6, record_size_failed);
+    STATIC_ASSERT(sizeof(configHeader_t) == 12, header_size_failed);
+    STATIC_ASSERT(sizeof(configRecord_t) == 12, record_size_failed);
+    STATIC_ASSERT(sizeof(legacyConfigRecord_t) == 6, legacy_record_size_failed);
 }
 
-bool isEEPROMVersionValid(void)
+static uint32_t configRegionSize(void)
 {
-    const uint8_t *p = &__config_start;
-    const configHeader_t *header = (const configHeader_t *)p;
+    return &__config_end - &__config_start;
+}
 
-    if (header->eepromConfigVersion != EEPROM_CONF_VERSION) {
+static uint16_t headerCrc(const configHeader_t *header)
+{
+    configHeader_t copy = *header;
+    copy.crc = 0;
+
+    return crc16_ccitt_update(CRC_START_VALUE, &copy, sizeof(copy));
+}
+
+static uint16_t recordCrc(const configRecord_t *record, const void *pg)
+{
+    configRecord_t copy = *record;
+    copy.crc = 0;
+
+    const uint16_t crc = crc16_ccitt_update(CRC_START_VALUE, &copy, sizeof(copy));
+    return crc16_ccitt_update(crc, pg, record->size - sizeof(copy));
+}
+
+static const configHeader_t *validBankHeader(const uint8_t *bank)
+{
+    const configHeader_t *header = (const configHeader_t *)bank;
+    const uint32_t available = &__config_end - bank;
+
+    if (header->magic_be != 0xBE
+        || header->size > available
+        || header->size < sizeof(*header)
+        || header->crc != headerCrc(header)) {
+        return NULL;
+    }
+
+    return header;
+}
+
+// Walk the records of a bank, recording how far the log extends. Returns true if the bank holds a committed config.
+static bool scanBank(const uint8_t *bank)
+{
+    const configHeader_t *header = validBankHeader(bank);
+    if (!header) {
         return false;
     }
 
+    uint32_t offset = sizeof(*header);
+    uint32_t committedSize = 0;
+    uint32_t sequence = 0;
+    bool first = true;
+
+    while (offset + sizeof(configRecord_t) <= header->size) {
+        const configRecord_t *record = (const configRecord_t *)(bank + offset);
+
+        if (record->size < sizeof(*record)
+            || offset + record->size > header->size
+            || (!first && record->sequence != sequence)
+            || record->crc != recordCrc(record, record->pg)) {
+            // Erased space, a torn write or stale data from an earlier use of the bank.
+            break;
+        }
+
+        first = false;
+        sequence = record->sequence + 1;
+        offset += CONFIG_ALIGN(record->size);
+
+        if (record->flags & CR_FLAG_COMMIT) {
+            committedSize = offset;
+        }
+    }
+
+    if (committedSize == 0 || (configLog.bank && header->generation <= configLog.generation)) {
+        return false;
+    }
+
+    configLog.bank = bank;
+    configLog.bankSize = header->size;
+    configLog.generation = header->generation;
+    configLog.committedSize = committedSize;
+    configLog.usedSize = offset;
+    configLog.nextSequence = sequence;
+
     return true;
 }
 
-// Scan the EEPROM config. Returns true if the config is valid.
-bool isEEPROMStructureValid(void)
+static bool configRegionHasTwoBanks(void)
+{
+    return configRegionSize() >= 2 * FLASH_PAGE_SIZE;
+}
+
+static uint32_t configBankSize(void)
+{
+    return (configRegionSize() / 2) & ~(FLASH_PAGE_SIZE - 1);
+}
+
+static void indexRecords(void)
+{
+    uint32_t offset = sizeof(configHeader_t);
+    while (offset < configLog.committedSize) {
+        const configRecord_t *record = (const configRecord_t *)(configLog.bank + offset);
+
+        if (!(record->flags & CR_FLAG_COMMIT) && (record->flags & CR_CLASSIFICATION_MASK) == CR_CLASSICATION_SYSTEM) {
+            const pgRegistry_t *reg = pgFind(record->pgn);
+            if (reg && pgIndex(reg) < PG_REGISTRY_MAX_SIZE) {
+                configLog.newestRecord[pgIndex(reg)] = offset;
+            }
+        }
+        offset += CONFIG_ALIGN(record->size);
+    }
+}
+
+// Returns the size of a config saved in the format before the log, 0 if there is none
+static uint32_t scanLegacyConfig(void)
 {
     const uint8_t *p = &__config_start;
-    const configHeader_t *header = (const configHeader_t *)p;
+    const legacyConfigHeader_t *header = (const legacyConfigHeader_t *)p;
 
     if (header->magic_be != 0xBE) {
-        return false;
+        return 0;
     }
 
     uint16_t crc = CRC_START_VALUE;
@@ -121,8 +273,11 @@ bool isEEPROMStructureValid(void)
     p += sizeof(*header);
 
     for (;;) {
-        const configRecord_t *record = (const configRecord_t *)p;
+        const legacyConfigRecord_t *record = (const legacyConfigRecord_t *)p;
 
+        if (p + sizeof(record->size) > &__config_end) {
+            return 0;
+        }
         if (record->size == 0) {
             // Found the end.  Stop scanning.
             break;
@@ -130,7 +285,7 @@ bool isEEPROMStructureValid(void)
         if (p + record->size >= &__config_end
             || record->size < sizeof(*record)) {
             // Too big or too small.
-            return false;
+            return 0;
         }
 
         crc = crc16_ccitt_update(crc, p, record->size);
@@ -138,19 +293,60 @@ bool isEEPROMStructureValid(void)
         p += record->size;
     }
 
-    const configFooter_t *footer = (const configFooter_t *)p;
-    crc = crc16_ccitt_update(crc, footer, sizeof(*footer));
-    p += sizeof(*footer);
+    // the terminator and the stored CRC, including the CRC in the calculation gives a constant value
+    const uint32_t trailerSize = sizeof(uint16_t) + sizeof(uint16_t);
+    if (p + trailerSize > &__config_end) {
+        return 0;
+    }
+    crc = crc16_ccitt_update(crc, p, trailerSize);
+    p += trailerSize;
 
-    // include stored CRC in the CRC calculation
-    const uint16_t *storedCrc = (const uint16_t *)p;
-    crc = crc16_ccitt_update(crc, storedCrc, sizeof(*storedCrc));
-    p += sizeof(storedCrc);
+    return crc == LEGACY_CRC_CHECK_VALUE ? p - &__config_start : 0;
+}
 
-    eepromConfigSize = p - &__config_start;
+// Find the newest committed config
+static void scanEEPROM(void)
+{
+    memset(&configLog, 0, sizeof(configLog));
+
+    scanBank(&__config_start);
+    if (configRegionHasTwoBanks()) {
+        scanBank(&__config_start + configBankSize());
+    }
 
-    // CRC has the property that if the CRC itself is included in the calculation the resulting CRC will have constant value
-    return crc == CRC_CHECK_VALUE;
+    if (configLog.bank) {
+        indexRecords();
+
+        eepromConfigSize = configLog.committedSize;
+    } else {
+        configLog.legacySize = scanLegacyConfig();
+
+        eepromConfigSize = configLog.legacySize;
+    }
+}
+
+static bool isConfigVersionCurrent(void)
+{
+    if (configLog.legacySize) {
+        return ((const legacyConfigHeader_t *)&__config_start)->eepromConfigVersion == EEPROM_CONF_VERSION;
+    }
+
+    return configLog.bank && ((const configHeader_t *)configLog.bank)->eepromConfigVersion == EEPROM_CONF_VERSION;
+}
+
+bool isEEPROMVersionValid(void)
+{
+    scanEEPROM();
+
+    return isConfigVersionCurrent();
+}
+
+// Scan the EEPROM config. Returns true if the config is valid.
+bool isEEPROMStructureValid(void)
+{
+    scanEEPROM();
+
+    return configLog.bank || configLog.legacySize;
 }
 
 uint16_t getEEPROMConfigSize(void)
@@ -158,41 +354,83 @@ uint16_t getEEPROMConfigSize(void)
     return eepromConfigSize;
 }
 
-// find config record for reg + classification (profile info) in EEPROM
+// find the newest committed config record for reg + classification (profile info) in EEPROM
 // return NULL when record is not found
-// this function assumes that EEPROM content is valid
+// this function assumes that the log has been scanned
 static const configRecord_t *findEEPROM(const pgRegistry_t *reg, configRecordFlags_e classification)
 {
-    const uint8_t *p = &__config_start;
-    p += sizeof(configHeader_t);             // skip header
+    const configRecord_t *found = NULL;
+
+    if (!configLog.bank) {
+        return NULL;
+    }
+
+    if (pgIndex(reg) < PG_REGISTRY_MAX_SIZE && classification == CR_CLASSICATION_SYSTEM) {
+        const uint16_t offset = configLog.newestRecord[pgIndex(reg)];
+        return offset ? (const configRecord_t *)(configLog.bank + offset) : NULL;
+    }
+
+    uint32_t offset = sizeof(configHeader_t);
+    while (offset < configLog.committedSize) {
+        const configRecord_t *record = (const configRecord_t *)(configLog.bank + offset);
+
+        if (!(record->flags & CR_FLAG_COMMIT)
+            && pgN(reg) == record->pgn
+            && (record->flags & CR_CLASSIFICATION_MASK) == classification) {
+            found = record;
+        }
+        offset += CONFIG_ALIGN(record->size);
+    }
+
+    return found;
+}
+
+// find config record for reg in a config saved in the format before the log
+// return NULL when record is not found
+static const legacyConfigRecord_t *findLegacyEEPROM(const pgRegistry_t *reg)
+{
+    if (!configLog.legacySize) {
+        return NULL;
+    }
+
+    const uint8_t *p = &__config_start + sizeof(legacyConfigHeader_t);
     while (true) {
-        const configRecord_t *record = (const configRecord_t *)p;
-        if (record->size == 0
-            || p + record->size >= &__config_end
-            || record->size < sizeof(*record))
+        const legacyConfigRecord_t *record = (const legacyConfigRecord_t *)p;
+        if (record->size == 0) {
             break;
+        }
         if (pgN(reg) == record->pgn
-            && (record->flags & CR_CLASSIFICATION_MASK) == classification)
+            && (record->flags & CR_CLASSIFICATION_MASK) == CR_CLASSICATION_SYSTEM) {
             return record;
+        }
         p += record->size;
     }
-    // record not found
+
     return NULL;
 }
 
 // Initialize all PG records from EEPROM.
-// This functions processes all PGs sequentially, scanning EEPROM for each one. This is suboptimal,
-//   but each PG is loaded/initialized exactly once and in defined order.
+// Each PG is loaded/initialized exactly once and in defined order.
 bool loadEEPROM(void)
 {
     bool success = true;
 
+    scanEEPROM();
+
     PG_FOREACH(reg) {
         const configRecord_t *rec = findEEPROM(reg, CR_CLASSICATION_SYSTEM);
+        const legacyConfigRecord_t *legacyRec;
         if (rec) {
             // config from EEPROM is available, use it to initialize PG. pgLoad will handle version mismatch
             if (!pgLoad(reg, rec->pg, rec->size - offsetof(configRecord_t, pg), rec->version)) {
                 success = false;
+            } else if (rec->size == sizeof(*rec) + pgSize(reg)) {
+                pgMarkClean(reg);
+            }
+        } else if ((legacyRec = findLegacyEEPROM(reg))) {
+            // left dirty, it has yet to be written to the log
+            if (!pgLoad(reg, legacyRec->pg, legacyRec->size - offsetof(legacyConfigRecord_t, pg), legacyRec->version)) {
+                success = false;
             }
         } else {
             pgReset(reg);
@@ -204,69 +442,216 @@ bool loadEEPROM(void)
     return success;
 }
 
-static bool writeSettingsToEEPROM(void)
+static uint32_t recordSize(const pgRegistry_t *reg)
+{
+    return CONFIG_ALIGN(sizeof(configRecord_t) + pgSize(reg));
+}
+
+static bool isStoredRecordCurrent(const pgRegistry_t *reg)
+{
+    const configRecord_t *record = findEEPROM(reg, CR_CLASSICATION_SYSTEM);
+
+    return record
+        && record->version == pgVersion(reg)
+        && record->size == sizeof(*record) + pgSize(reg)
+        && memcmp(record->pg, reg->address, pgSize(reg)) == 0;
+}
+
+static void writeRecord(config_streamer_t *streamer, const pgRegistry_t *reg, uint32_t sequence)
+{
+    static const uint8_t padding[sizeof(uint32_t)] = { 0 };
+
+    const uint16_t regSize = reg ? pgSize(reg) : 0;
+    const uint8_t *pg = reg ? reg->address : NULL;
+
+    configRecord_t record = {
+        .size = sizeof(configRecord_t) + regSize,
+        .pgn = reg ? pgN(reg) : 0,
+        .version = reg ? pgVersion(reg) : 0,
+        .flags = reg ? CR_CLASSICATION_SYSTEM : CR_FLAG_COMMIT,
+        .sequence = sequence,
+    };
+    record.crc = recordCrc(&record, pg);
+
+    config_streamer_write(streamer, (uint8_t *)&record, sizeof(record));
+    config_streamer_write(streamer, pg, regSize);
+    config_streamer_write(streamer, padding, CONFIG_ALIGN(record.size) - record.size);
+}
+
+/*
+ * A PG needs a new record if it differs from the newest stored one. Only the in-flight adjustments mark the PGs they
+ * change, so regular saves compare all of them and only the in-flight saves go by the dirty flags.
+ */
+static bool isRecordNeeded(const pgRegistry_t *reg, bool dirtyOnly)
+{
+    return (!dirtyOnly || pgIsDirty(reg)) && !isStoredRecordCurrent(reg);
+}
+
+// Bytes needed to append all changed PGs and a commit record, 0 if nothing has changed
+static uint32_t changedRecordsSize(bool dirtyOnly)
+{
+    uint32_t size = 0;
+
+    PG_FOREACH(reg) {
+        if (isRecordNeeded(reg, dirtyOnly)) {
+            size += recordSize(reg);
+        }
+    }
+
+    return size ? size + sizeof(configRecord_t) : 0;
+}
+
+// Appending is only possible if the log ends with a commit and the space after it has not been written to
+static bool canAppend(uint32_t size, bool allowErase)
+{
+    if (!configLog.bank
+        || configLog.usedSize != configLog.committedSize
+        || configLog.usedSize + size > configLog.bankSize) {
+        return false;
+    }
+
+    // The streamer erases each page as it reaches the start of it, the rest of the current page must already be erased
+    const uintptr_t address = (uintptr_t)(configLog.bank + configLog.usedSize);
+    const uintptr_t pageEnd = MIN(address - (address % FLASH_PAGE_SIZE) + FLASH_PAGE_SIZE, (uintptr_t)(configLog.bank + configLog.bankSize));
+
+    if (!allowErase && (address % FLASH_PAGE_SIZE == 0 || address + size > pageEnd)) {
+        return false;
+    }
+
+    if (address % FLASH_PAGE_SIZE != 0) {
+        for (const uint32_t *word = (const uint32_t *)address; (uintptr_t)word < pageEnd; word++) {
+            if (*word != CONFIG_ERASED_WORD) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+static bool appendChangedRecords(bool dirtyOnly)
 {
     config_streamer_t streamer;
     config_streamer_init(&streamer);
 
-    config_streamer_start(&streamer, (uintptr_t)&__config_start, &__config_end - &__config_start);
+    config_streamer_start(&streamer, (uintptr_t)(configLog.bank + configLog.usedSize), configLog.bankSize - configLog.usedSize);
+
+    uint32_t sequence = configLog.nextSequence;
+    PG_FOREACH(reg) {
+        if (isRecordNeeded(reg, dirtyOnly)) {
+            writeRecord(&streamer, reg, sequence++);
+        }
+    }
+    writeRecord(&streamer, NULL, sequence);
+
+    config_streamer_flush(&streamer);
+
+    return config_streamer_finish(&streamer) == 0;
+}
+
+// Write all PGs into a fresh bank, this erases the flash
+static bool writeSnapshot(void)
+{
+    uint32_t size = sizeof(configHeader_t) + sizeof(configRecord_t);
+    PG_FOREACH(reg) {
+        size += recordSize(reg);
+    }
+
+    const uint8_t *bank = &__config_start;
+    uint32_t bankSize = configRegionSize();
+
+    if (configRegionHasTwoBanks() && size <= configBankSize()) {
+        bankSize = configBankSize();
+        // a config in the old format is kept until the log replacing it has been committed, if it fits in the first bank
+        if (configLog.bank == &__config_start || (configLog.legacySize && configLog.legacySize <= bankSize)) {
+            bank += bankSize;
+        }
+    }
+
+    if (size > bankSize) {
+        return false;
+    }
+
+    config_streamer_t streamer;
+    config_streamer_init(&streamer);
+
+    config_streamer_start(&streamer, (uintptr_t)bank, bankSize);
 
     configHeader_t header = {
         .eepromConfigVersion =  EEPROM_CONF_VERSION,
         .magic_be =             0xBE,
+        .generation =           configLog.generation + 1,
+        .size =                 bankSize,
     };
+    header.crc = headerCrc(&header);
 
     config_streamer_write(&streamer, (uint8_t *)&header, sizeof(header));
-    uint16_t crc = CRC_START_VALUE;
-    crc = crc16_ccitt_update(crc, (uint8_t *)&header, sizeof(header));
+
+    uint32_t sequence = configLog.nextSequence;
     PG_FOREACH(reg) {
-        const uint16_t regSize = pgSize(reg);
-        configRecord_t record = {
-            .size = sizeof(configRecord_t) + regSize,
-            .pgn = pgN(reg),
-            .version = pgVersion(reg),
-            .flags = 0
-        };
-
-        record.flags |= CR_CLASSICATION_SYSTEM;
-        config_streamer_write(&streamer, (uint8_t *)&record, sizeof(record));
-        crc = crc16_ccitt_update(crc, (uint8_t *)&record, sizeof(record));
-        config_streamer_write(&streamer, reg->address, regSize);
-        crc = crc16_ccitt_update(crc, reg->address, regSize);
-    }
-
-    configFooter_t footer = {
-        .terminator = 0,
-    };
+        writeRecord(&streamer, reg, sequence++);
+    }
+    writeRecord(&streamer, NULL, sequence);
 
-    config_streamer_write(&streamer, (uint8_t *)&footer, sizeof(footer));
-    crc = crc16_ccitt_update(crc, (uint8_t *)&footer, sizeof(footer));
+    config_streamer_flush(&streamer);
 
-    // include inverted CRC in big endian format in the CRC
-    const uint16_t invertedBigEndianCrc = ~(((crc & 0xFF) << 8) | (crc >> 8));
-    config_streamer_write(&streamer, (uint8_t *)&invertedBigEndianCrc, sizeof(crc));
+    return config_streamer_finish(&streamer) == 0;
+}
 
-    config_streamer_flush(&streamer);
+static bool writeSettingsToEEPROM(void)
+{
+    scanEEPROM();
 
-    const bool success = config_streamer_finish(&streamer) == 0;
+    if (isConfigVersionCurrent()) {
+        const uint32_t size = changedRecordsSize(false);
+        if (size == 0) {
+            return true;
+        }
+        if (canAppend(size, true)) {
+            return appendChangedRecords(false);
+        }
+    }
 
-    return success;
+    return writeSnapshot();
 }
 
 void writeConfigToEEPROM(void)
 {
-    bool success = false;
-    // write it
-    for (int attempt = 0; attempt < 3 && !success; attempt++) {
-        if (writeSettingsToEEPROM()) {
-            success = true;
+    // write it, and check that every PG reads back from the newest committed records
+    for (int attempt = 0; attempt < 3; attempt++) {
+        if (writeSettingsToEEPROM() && isEEPROMVersionValid() && changedRecordsSize(false) == 0) {
+            pgMarkAllClean();
+            return;
         }
     }
 
-    if (success && isEEPROMVersionValid() && isEEPROMStructureValid()) {
-        return;
-    }
-
     // Flash write failed - just die now
     failureMode(FAILURE_FLASH_WRITE_FAILED);
 }
+
+// Append the PGs marked dirty that have changed, without erasing any flash. Returns false, leaving the flash
+// untouched, if that is not possible and a full write is needed.
+bool writeConfigChangesToEEPROM(void)
+{
+    if (!isEEPROMVersionValid()) {
+        return false;
+    }
+
+    const uint32_t size = changedRecordsSize(true);
+    if (size == 0) {
+        return true;
+    }
+
+    if (!canAppend(size, false)) {
+        return false;
+    }
+
+    const uint32_t committedSize = configLog.committedSize;
+
+    if (appendChangedRecords(true) && isEEPROMStructureValid() && configLog.committedSize == committedSize + size) {
+        pgMarkAllClean();
+        return true;
+    }
+
+    return false;
+}
@@ -29,4 +29,5 @@ bool isEEPROMVersionValid(void);
 bool isEEPROMStructureValid(void);
 bool loadEEPROM(void);
 void writeConfigToEEPROM(void);
+bool writeConfigChangesToEEPROM(void);
 uint16_t getEEPROMConfigSize(void);
@@ -21,6 +21,7 @@
 #include <stdbool.h>
 #include <stdint.h>
 #include <string.h>
+#include <strings.h>
 
 #include "platform.h"
 
@@ -123,3 +124,88 @@ void displayInit(displayPort_t *instance, const displayPortVTable_t *vTable)
     instance->grabCount = 0;
     instance->cursorRow = -1;
 }
+
+static uint32_t displayDirtyColumnMask(uint8_t x, uint8_t length)
+{
+    const uint32_t below = (x + length >= DISPLAY_DIRTY_COLS_MAX) ? UINT32_MAX : (1U << (x + length)) - 1;
+    return below & ~((1U << x) - 1);
+}
+
+void displayDirtyMark(displayDirty_t *dirty, uint8_t x, uint8_t y, uint8_t length)
+{
+    if (y >= DISPLAY_DIRTY_ROWS_MAX || x >= DISPLAY_DIRTY_COLS_MAX || !length) {
+        return;
+    }
+    dirty->cols[y] |= displayDirtyColumnMask(x, length);
+    dirty->rows |= 1 << y;
+}
+
+void displayDirtyMarkAll(displayDirty_t *dirty, uint8_t rows, uint8_t cols)
+{
+    for (int y = 0; y < rows; y++) {
+        displayDirtyMark(dirty, 0, y, cols);
+    }
+}
+
+void displayDirtyClear(displayDirty_t *dirty)
+{
+    memset(dirty, 0, sizeof(*dirty));
+}
+
+bool displayDirtyIsClear(const displayDirty_t *dirty)
+{
+    return !dirty->rows;
+}
+
+/*
+ * Takes the first dirty span off the bitmap. Runs of dirty columns separated by at most mergeGap clean ones are
+ * returned as one span, for transports where starting a new write costs more than resending a few characters.
+ */
+bool displayDirtyNextSpan(displayDirty_t *dirty, uint8_t mergeGap, displaySpan_t *span)
+{
+    if (!dirty->rows) {
+        return false;
+    }
+
+    const int y = ffs(dirty->rows) - 1;
+    const uint32_t cols = dirty->cols[y];
+    const int x = ffs(cols) - 1;
+
+    int end = x + 1;
+    int gap = 0;
+    for (int col = end; col < DISPLAY_DIRTY_COLS_MAX && gap <= mergeGap; col++) {
+        if (cols & (1U << col)) {
+            end = col + 1;
+            gap = 0;
+        } else {
+            gap++;
+        }
+    }
+
+    span->x = x;
+    span->y = y;
+    span->length = end - x;
+
+    dirty->cols[y] &= ~displayDirtyColumnMask(span->x, span->length);
+    if (!dirty->cols[y]) {
+        dirty->rows &= ~(1 << y);
+    }
+
+    return true;
+}
+
+// Copies text into a rows * cols screen buffer, clipped to the screen, and marks the characters that changed
+void displayBufferWrite(displayDirty_t *dirty, char *buffer, uint8_t rows, uint8_t cols, uint8_t x, uint8_t y, const char *text)
+{
+    if (y >= rows) {
+        return;
+    }
+
+    char *row = &buffer[y * cols];
+    for (; *text && x < cols; text++, x++) {
+        if (row[x] != *text) {
+            row[x] = *text;
+            displayDirtyMark(dirty, x, y, 1);
+        }
+    }
+}
@@ -38,6 +38,22 @@ typedef struct displayPort_s {
 
 // displayPort_t is used as a parameter group in 'displayport_msp.h' and 'displayport_max7456`.h'. Treat accordingly!
 
+// Characters changed but not sent yet, a bit per column for each row. Backends with a screen buffer mark what their
+// writes change and send the coalesced spans when the screen is drawn.
+#define DISPLAY_DIRTY_ROWS_MAX 16
+#define DISPLAY_DIRTY_COLS_MAX 32
+
+typedef struct displayDirty_s {
+    uint16_t rows;                          // rows with any dirty column
+    uint32_t cols[DISPLAY_DIRTY_ROWS_MAX];
+} displayDirty_t;
+
+typedef struct displaySpan_s {
+    uint8_t x;
+    uint8_t y;
+    uint8_t length;
+} displaySpan_t;
+
 typedef struct displayPortVTable_s {
     int (*grab)(displayPort_t *displayPort);
     int (*release)(displayPort_t *displayPort);
@@ -79,3 +95,10 @@ void displayResync(displayPort_t *instance);
 bool displayIsSynced(const displayPort_t *instance);
 uint16_t displayTxBytesFree(const displayPort_t *instance);
 void displayInit(displayPort_t *instance, const displayPortVTable_t *vTable);
+
+void displayDirtyMark(displayDirty_t *dirty, uint8_t x, uint8_t y, uint8_t length);
+void displayDirtyMarkAll(displayDirty_t *dirty, uint8_t rows, uint8_t cols);
+void displayDirtyClear(displayDirty_t *dirty);
+bool displayDirtyIsClear(const displayDirty_t *dirty);
+bool displayDirtyNextSpan(displayDirty_t *dirty, uint8_t mergeGap, displaySpan_t *span);
+void displayBufferWrite(displayDirty_t *dirty, char *buffer, uint8_t rows, uint8_t cols, uint8_t x, uint8_t y, const char *text);
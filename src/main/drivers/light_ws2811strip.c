@@ -38,6 +38,7 @@
 
 #include "common/color.h"
 #include "common/colorconversion.h"
+#include "common/utils.h"
 
 #include "drivers/dma.h"
 #include "drivers/io.h"
@@ -59,9 +60,18 @@ uint16_t BIT_COMPARE_0 = 0;
 
 static hsvColor_t ledColorBuffer[WS2811_LED_STRIP_LENGTH];
 
+// Colours as encoded in the DMA buffer, only LEDs written since the last update are compared and encoded again
+static hsvColor_t ledColorEncoded[WS2811_LED_STRIP_LENGTH];
+static uint32_t ledColorWritten;
+static bool ledStripEncoded;
+static ledStripFormatRGB_e ledStripEncodedFormat;
+
+STATIC_ASSERT(WS2811_LED_STRIP_LENGTH <= sizeof(ledColorWritten) * 8, ledColorWritten_too_small);
+
 void setLedHsv(uint16_t index, const hsvColor_t *color)
 {
     ledColorBuffer[index] = *color;
+    ledColorWritten |= BIT(index);
 }
 
 void getLedHsv(uint16_t index, hsvColor_t *color)
@@ -72,11 +82,13 @@ void getLedHsv(uint16_t index, hsvColor_t *color)
 void setLedValue(uint16_t index, const uint8_t value)
 {
     ledColorBuffer[index].v = value;
+    ledColorWritten |= BIT(index);
 }
 
 void scaleLedValue(uint16_t index, const uint8_t scalePercent)
 {
     ledColorBuffer[index].v = ((uint16_t)ledColorBuffer[index].v * scalePercent / 100);
+    ledColorWritten |= BIT(index);
 }
 
 void setStripColor(const hsvColor_t *color)
@@ -98,6 +110,7 @@ void setStripColors(const hsvColor_t *colors)
 void ws2811LedStripInit(ioTag_t ioTag)
 {
     memset(ledStripDMABuffer, 0, sizeof(ledStripDMABuffer));
+    ledStripEncoded = false;
     ws2811LedStripHardwareInit(ioTag);
 
     const hsvColor_t hsv_white = { 0, 255, 255 };
@@ -156,9 +169,18 @@ STATIC_UNIT_TESTED void updateLEDDMABuffer(uint8_t componentValue)
 }
 #endif
 
+static bool ledColorChanged(int index)
+{
+    const hsvColor_t *color = &ledColorBuffer[index];
+    const hsvColor_t *encoded = &ledColorEncoded[index];
+
+    return color->h != encoded->h || color->s != encoded->s || color->v != encoded->v;
+}
+
 /*
  * This method is non-blocking unless an existing LED update is in progress.
  * it does not wait until all the LEDs have been updated, that happens in the background.
+ * Only LEDs that changed colour are converted and encoded, nothing is sent if none did.
  */
 void ws2811UpdateStrip(ledStripFormatRGB_e ledFormat)
 {
@@ -169,14 +191,18 @@ void ws2811UpdateStrip(ledStripFormatRGB_e ledFormat)
         return;
     }
 
-    dmaBufferOffset = 0;                // reset buffer memory index
-    ledIndex = 0;                       // reset led index
+    const bool encodeAll = !ledStripEncoded || ledFormat != ledStripEncodedFormat;
+    bool changed = false;
 
     // fill transmit buffer with correct compare values to achieve
     // correct pulse widths according to color values
-    while (ledIndex < WS2811_LED_STRIP_LENGTH)
-    {
+    for (ledIndex = 0; ledIndex < WS2811_LED_STRIP_LENGTH; ledIndex++) {
+        if (!encodeAll && (!(ledColorWritten & BIT(ledIndex)) || !ledColorChanged(ledIndex))) {
+            continue;
+        }
+
         rgb24 = hsvToRgb24(&ledColorBuffer[ledIndex]);
+        dmaBufferOffset = ledIndex * WS2811_BITS_PER_LED;
 
 #ifdef USE_FAST_DMA_BUFFER_IMPL
         fastUpdateLEDDMABuffer(ledFormat, rgb24);
@@ -197,7 +223,17 @@ void ws2811UpdateStrip(ledStripFormatRGB_e ledFormat)
         updateLEDDMABuffer(rgb24->rgb.b);
 #endif
 
-        ledIndex++;
+        ledColorEncoded[ledIndex] = ledColorBuffer[ledIndex];
+        changed = true;
+    }
+
+    ledColorWritten = 0;
+    ledStripEncoded = true;
+    ledStripEncodedFormat = ledFormat;
+
+    // the LEDs keep showing what they were last sent
+    if (!changed) {
+        return;
     }
 
     ws2811LedDataTransferInProgress = 1;
@@ -34,10 +34,12 @@
 #include "pg/vcd.h"
 
 #include "drivers/bus_spi.h"
+#include "drivers/display.h"
 #include "drivers/dma.h"
 #include "drivers/io.h"
 #include "drivers/light_led.h"
 #include "drivers/max7456.h"
+#include "drivers/max7456_stream.h"
 #include "drivers/max7456_symbols.h"
 #include "drivers/nvic.h"
 #include "drivers/time.h"
@@ -122,23 +124,11 @@
 
 #define MAX7456_SIGNAL_CHECK_INTERVAL_MS 1000 // msec
 
-// DMM special bits
-#define CLEAR_DISPLAY 0x04
-#define CLEAR_DISPLAY_VERT 0x06
-#define INVERT_PIXEL_COLOR 0x08
-
-// Special address for terminating incremental write
-#define END_STRING 0xff
-
 #define MAX7456ADD_READ         0x80
 #define MAX7456ADD_VM0          0x00  //0b0011100// 00 // 00             ,0011100
 #define MAX7456ADD_VM1          0x01
 #define MAX7456ADD_HOS          0x02
 #define MAX7456ADD_VOS          0x03
-#define MAX7456ADD_DMM          0x04
-#define MAX7456ADD_DMAH         0x05
-#define MAX7456ADD_DMAL         0x06
-#define MAX7456ADD_DMDI         0x07
 #define MAX7456ADD_CMM          0x08
 #define MAX7456ADD_CMAH         0x09
 #define MAX7456ADD_CMAL         0x0a
@@ -200,18 +190,26 @@ uint16_t maxScreenSize = VIDEO_BUFFER_CHARS_PAL;
 // We write everything in screenBuffer and then compare
 // screenBuffer with shadowBuffer to upgrade only changed chars.
 // This solution is faster then redrawing entire screen.
+// Only the spans marked in screenDirty are compared.
 
 static uint8_t screenBuffer[VIDEO_BUFFER_CHARS_PAL+40]; // For faster writes we use memcpy so we need some space to don't overwrite buffer
 static uint8_t shadowBuffer[VIDEO_BUFFER_CHARS_PAL];
+static displayDirty_t screenDirty;
 
-//Max chars to update in one idle
-
-#define MAX_CHARS2UPDATE    100
 #ifdef MAX7456_DMA_CHANNEL_TX
 volatile bool dmaTransactionInProgress = false;
+
+// Double buffered, the next frame is composed while the previous one is sent.
+// A frame composed while DMA is busy is queued and started by the next max7456DrawScreen.
+
+#define MAX7456_STREAM_BUFFERS 2
+static uint16_t spiBuffQueued;
+#else
+#define MAX7456_STREAM_BUFFERS 1
 #endif
 
-static uint8_t spiBuff[MAX_CHARS2UPDATE*6];
+static uint8_t spiBuff[MAX7456_STREAM_BUFFERS][MAX7456_STREAM_SIZE];
+static uint8_t spiBuffIndex;
 
 static uint8_t  videoSignalCfg;
 static uint8_t  videoSignalReg  = OSD_ENABLE; // OSD_ENABLE required to trigger first ReInit
@@ -405,6 +403,7 @@ void max7456ReInit(void)
 
     // Clear shadow to force redraw all screen in non-dma mode.
     memset(shadowBuffer, 0, maxScreenSize);
+    displayDirtyMarkAll(&screenDirty, VIDEO_LINES_PAL, CHARS_PER_LINE);
     if (firstInit) {
         max7456DrawScreenSlow();
         firstInit = false;
@@ -503,6 +502,9 @@ void max7456Invert(bool invert)
         displayMemoryModeReg &= ~INVERT_PIXEL_COLOR;
     }
 
+#ifdef MAX7456_DMA_CHANNEL_TX
+    while (dmaTransactionInProgress);
+#endif
     __spiBusTransactionBegin(busdev);
     max7456Send(MAX7456ADD_DMM, displayMemoryModeReg);
     __spiBusTransactionEnd(busdev);
@@ -518,6 +520,9 @@ void max7456Brightness(uint8_t black, uint8_t white)
 {
     const uint8_t reg = (black << 2) | (3 - white);
 
+#ifdef MAX7456_DMA_CHANNEL_TX
+    while (dmaTransactionInProgress);
+#endif
     __spiBusTransactionBegin(busdev);
     for (int i = MAX7456ADD_RB0; i <= MAX7456ADD_RB15; i++) {
         max7456Send(i, reg);
@@ -529,6 +534,7 @@ void max7456Brightness(uint8_t black, uint8_t white)
 void max7456ClearScreen(void)
 {
     memset(screenBuffer, 0x20, VIDEO_BUFFER_CHARS_PAL);
+    displayDirtyMarkAll(&screenDirty, VIDEO_LINES_PAL, CHARS_PER_LINE);
 }
 
 uint8_t* max7456GetScreenBuffer(void)
@@ -538,16 +544,14 @@ uint8_t* max7456GetScreenBuffer(void)
 
 void max7456WriteChar(uint8_t x, uint8_t y, uint8_t c)
 {
-    screenBuffer[y*CHARS_PER_LINE+x] = c;
+    const char buff[2] = { c, 0 };
+    max7456Write(x, y, buff);
 }
 
 void max7456Write(uint8_t x, uint8_t y, const char *buff)
 {
-    for (int i = 0; *(buff+i); i++) {
-        if (x+i < CHARS_PER_LINE) {// Do not write over screen
-            screenBuffer[y*CHARS_PER_LINE+x+i] = *(buff+i);
-        }
-    }
+    // Do not write over screen
+    displayBufferWrite(&screenDirty, (char *)screenBuffer, VIDEO_LINES_PAL, CHARS_PER_LINE, x, y, buff);
 }
 
 bool max7456DmaInProgress(void)
@@ -559,14 +563,19 @@ bool max7456DmaInProgress(void)
 #endif
 }
 
+// Both frame buffers in use, one being sent and the next one waiting for it
+bool max7456FrameQueued(void)
+{
+#ifdef MAX7456_DMA_CHANNEL_TX
+    return dmaTransactionInProgress && spiBuffQueued;
+#else
+    return false;
+#endif
+}
+
 bool max7456BuffersSynced(void)
 {
-    for (int i = 0; i < maxScreenSize; i++) {
-        if (screenBuffer[i] != shadowBuffer[i]) {
-            return false;
-        }
-    }
-    return true;
+    return displayDirtyIsClear(&screenDirty);
 }
 
 void max7456ReInitIfRequired(void)
@@ -619,44 +628,65 @@ void max7456ReInitIfRequired(void)
     //------------   end of (re)init-------------------------------------
 }
 
-void max7456DrawScreen(void)
+static uint16_t max7456ComposeFrame(bool refresh)
 {
-    static uint16_t pos = 0;
+    const max7456Screen_t screen = {
+        .buffer = screenBuffer,
+        .shadow = shadowBuffer,
+        .dirty = &screenDirty,
+        .size = maxScreenSize,
+        .cols = CHARS_PER_LINE,
+        .dmm = displayMemoryModeReg,
+    };
+
+    return max7456StreamBuild(&screen, spiBuff[spiBuffIndex], MAX7456_STREAM_SIZE, refresh);
+}
 
+static void max7456SendFrame(uint16_t length)
+{
+#ifdef MAX7456_DMA_CHANNEL_TX
+    max7456SendDma(spiBuff[spiBuffIndex], NULL, length);
+    spiBuffIndex = (spiBuffIndex + 1) % MAX7456_STREAM_BUFFERS;
+#else
+    __spiBusTransactionBegin(busdev);
+    spiTransfer(busdev->busdev_u.spi.instance, spiBuff[spiBuffIndex], NULL, length);
+    __spiBusTransactionEnd(busdev);
+#endif
+}
+
+void max7456DrawScreen(void)
+{
     if (!max7456Lock && !fontIsLoading) {
+        max7456Lock = true;
 
-        // (Re)Initialize MAX7456 at startup or stall is detected.
+#ifdef MAX7456_DMA_CHANNEL_TX
+        if (dmaTransactionInProgress) {
+            // Compose the next frame while this one is sent
+            if (!spiBuffQueued) {
+                spiBuffQueued = max7456ComposeFrame(false);
+            }
+            max7456Lock = false;
+            return;
+        }
+#endif
 
-        max7456Lock = true;
+        // (Re)Initialize MAX7456 at startup or stall is detected.
 
         max7456ReInitIfRequired();
 
-        int buff_len = 0;
-        for (int k = 0; k < MAX_CHARS2UPDATE; k++) {
-            if (screenBuffer[pos] != shadowBuffer[pos]) {
-                spiBuff[buff_len++] = MAX7456ADD_DMAH;
-                spiBuff[buff_len++] = pos >> 8;
-                spiBuff[buff_len++] = MAX7456ADD_DMAL;
-                spiBuff[buff_len++] = pos & 0xff;
-                spiBuff[buff_len++] = MAX7456ADD_DMDI;
-                spiBuff[buff_len++] = screenBuffer[pos];
-                shadowBuffer[pos] = screenBuffer[pos];
-            }
-
-            if (++pos >= maxScreenSize) {
-                pos = 0;
-                break;
-            }
+        uint16_t length;
+#ifdef MAX7456_DMA_CHANNEL_TX
+        if (spiBuffQueued) {
+            length = spiBuffQueued;
+            spiBuffQueued = 0;
+        } else
+#endif
+        {
+            length = max7456ComposeFrame(false);
         }
 
-        if (buff_len) {
-#ifdef MAX7456_DMA_CHANNEL_TX
-            max7456SendDma(spiBuff, NULL, buff_len);
-#else
-            __spiBusTransactionBegin(busdev);
-            spiTransfer(busdev->busdev_u.spi.instance, spiBuff, NULL, buff_len);
-            __spiBusTransactionEnd(busdev);
-#endif // MAX7456_DMA_CHANNEL_TX
+        if (length) {
+            max7456SendFrame(length);
         }
         max7456Lock = false;
     }
@@ -664,41 +694,18 @@ void max7456DrawScreen(void)
 
 static void max7456DrawScreenSlow(void)
 {
-    bool escapeCharFound;
-
-    __spiBusTransactionBegin(busdev);
-
-    // Enable auto-increment mode and update every character in the screenBuffer.
-    // The "escape" character 0xFF must be skipped as it causes the MAX7456 to exit auto-increment mode.
-    max7456Send(MAX7456ADD_DMAH, 0);
-    max7456Send(MAX7456ADD_DMAL, 0);
-    max7456Send(MAX7456ADD_DMM, displayMemoryModeReg | 1);
-
-    for (int xx = 0; xx < maxScreenSize; xx++) {
-        if (screenBuffer[xx] == END_STRING) {
-            escapeCharFound = true;
-            max7456Send(MAX7456ADD_DMDI, ' ');  // replace the 0xFF character with a blank in the first pass to avoid terminating auto-increment
-        } else {
-            max7456Send(MAX7456ADD_DMDI, screenBuffer[xx]);
-        }
-        shadowBuffer[xx] = screenBuffer[xx];
-    }
+#ifdef MAX7456_DMA_CHANNEL_TX
+    // Everything is sent again, including what the queued frame would have changed
+    spiBuffQueued = 0;
+#endif
 
-    max7456Send(MAX7456ADD_DMDI, END_STRING);
-    max7456Send(MAX7456ADD_DMM, displayMemoryModeReg);
+    displayDirtyMarkAll(&screenDirty, VIDEO_LINES_PAL, CHARS_PER_LINE);
 
-    // If we found any of the "escape" character 0xFF, then make a second pass
-    // to update them with direct addressing
-    if (escapeCharFound) {
-        for (int xx = 0; xx < maxScreenSize; xx++) {
-            if (screenBuffer[xx] == END_STRING) {
-                max7456Send(MAX7456ADD_DMAH, xx >> 8);
-                max7456Send(MAX7456ADD_DMAL, xx & 0xFF);
-                max7456Send(MAX7456ADD_DMDI, END_STRING);
-            }
-        }
+    __spiBusTransactionBegin(busdev);
+    while (!displayDirtyIsClear(&screenDirty)) {
+        const uint16_t length = max7456ComposeFrame(true);
+        spiTransfer(busdev->busdev_u.spi.instance, spiBuff[spiBuffIndex], NULL, length);
     }
-
     __spiBusTransactionEnd(busdev);
 }
 
@@ -43,4 +43,5 @@ void    max7456ClearScreen(void);
 void    max7456RefreshAll(void);
 uint8_t* max7456GetScreenBuffer(void);
 bool    max7456DmaInProgress(void);
+bool    max7456FrameQueued(void);
 bool    max7456BuffersSynced(void);
@@ -0,0 +1,167 @@
+/*
+ * This file is part of Cleanflight and Betaflight.
+ *
+ * Cleanflight and Betaflight are free software. You can redistribute
+ * this software and/or modify this software under the terms of the
+ * GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Cleanflight and Betaflight are distributed in the hope that they
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software.
+ *
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "platform.h"
+
+#ifdef USE_MAX7456
+
+#include "drivers/display.h"
+#include "drivers/max7456_stream.h"
+
+/*
+ * Builds the SPI transfer that brings display memory up to date with the screen buffer.
+ *
+ * A run of changed characters is addressed once and then written in auto-increment mode, costing the DMDI register
+ * write for each character. As the datasheet asks, the address is set before entering auto-increment mode, and the
+ * mode is ended before the next run is addressed. Characters on their own are addressed and written without it. Runs
+ * separated by a few unchanged characters are joined by sending those again, which is cheaper than ending the run and
+ * addressing the next one. The whole transfer goes out with a single DMA or SPI transaction.
+ */
+
+typedef struct max7456Stream_s {
+    uint8_t *buf;
+    uint16_t length;
+    uint16_t limit;             // less the bytes to end auto-increment mode
+    int nextPos;                // where the chip writes the next character, -1 when not in auto-increment mode
+} max7456Stream_t;
+
+static void streamPut(max7456Stream_t *stream, uint8_t add, uint8_t data)
+{
+    stream->buf[stream->length++] = add;
+    stream->buf[stream->length++] = data;
+}
+
+static void streamEndAutoIncrement(max7456Stream_t *stream, uint8_t dmm)
+{
+    if (stream->nextPos >= 0) {
+        streamPut(stream, MAX7456ADD_DMDI, END_STRING);
+        streamPut(stream, MAX7456ADD_DMM, dmm);
+        stream->nextPos = -1;
+    }
+}
+
+static bool streamCanJoin(const max7456Stream_t *stream, const uint8_t *buffer, int pos)
+{
+    if (stream->nextPos < 0 || pos - stream->nextPos > MAX7456_STREAM_MERGE_GAP) {
+        return false;
+    }
+    for (int i = stream->nextPos; i < pos; i++) {
+        if (buffer[i] == END_STRING) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Whether another character close enough to join follows, making auto-increment mode worth entering
+static bool streamRunFollows(const max7456Screen_t *screen, int pos, bool refresh)
+{
+    for (int i = pos + 1; i <= pos + 1 + MAX7456_STREAM_MERGE_GAP && i < screen->size; i++) {
+        if (screen->buffer[i] == END_STRING) {
+            return false;
+        }
+        if (refresh || screen->buffer[i] != screen->shadow[i]) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Returns false if the character did not fit
+static bool streamChar(max7456Stream_t *stream, const max7456Screen_t *screen, int pos, bool refresh)
+{
+    const uint8_t c = screen->buffer[pos];
+    const int endBytes = stream->nextPos >= 0 ? MAX7456_STREAM_END_BYTES : 0;
+
+    if (streamCanJoin(stream, screen->buffer, pos) && c != END_STRING) {
+        if (stream->length + (pos - stream->nextPos + 1) * 2 > stream->limit) {
+            return false;
+        }
+        for (int i = stream->nextPos; i < pos; i++) {
+            streamPut(stream, MAX7456ADD_DMDI, screen->buffer[i]);
+            screen->shadow[i] = screen->buffer[i];
+        }
+        streamPut(stream, MAX7456ADD_DMDI, c);
+        stream->nextPos = pos + 1;
+    } else if (c != END_STRING && streamRunFollows(screen, pos, refresh)) {
+        // The address is set before entering auto-increment mode, the chip can't be re-addressed in it
+        if (stream->length + endBytes + 8 > stream->limit) {
+            return false;
+        }
+        streamEndAutoIncrement(stream, screen->dmm);
+        streamPut(stream, MAX7456ADD_DMAH, pos >> 8);
+        streamPut(stream, MAX7456ADD_DMAL, pos & 0xff);
+        streamPut(stream, MAX7456ADD_DMM, screen->dmm | AUTO_INCREMENT);
+        streamPut(stream, MAX7456ADD_DMDI, c);
+        stream->nextPos = pos + 1;
+    } else {
+        // On its own, END_STRING always is as it would end auto-increment mode
+        if (stream->length + endBytes + 6 > stream->limit) {
+            return false;
+        }
+        streamEndAutoIncrement(stream, screen->dmm);
+        streamPut(stream, MAX7456ADD_DMAH, pos >> 8);
+        streamPut(stream, MAX7456ADD_DMAL, pos & 0xff);
+        streamPut(stream, MAX7456ADD_DMDI, c);
+    }
+    screen->shadow[pos] = c;
+
+    return true;
+}
+
+// Takes the dirty spans of the screen, anything that does not fit the buffer is left dirty for the next call.
+// With refresh set every dirty character is sent, not only those that differ from the shadow.
+uint16_t max7456StreamBuild(const max7456Screen_t *screen, uint8_t *buf, uint16_t bufSize, bool refresh)
+{
+    max7456Stream_t stream = {
+        .buf = buf,
+        .limit = bufSize - MAX7456_STREAM_END_BYTES,
+        .nextPos = -1,
+    };
+    displaySpan_t span;
+    bool full = false;
+
+    // Spans are joined by streamChar, which also joins across rows
+    while (!full && displayDirtyNextSpan(screen->dirty, 0, &span)) {
+        for (int i = 0; i < span.length; i++) {
+            const int pos = span.y * screen->cols + span.x + i;
+            if (pos >= screen->size) {
+                // Not on screen in NTSC, sent after a switch to PAL as that redraws everything
+                break;
+            }
+            if (!refresh && screen->buffer[pos] == screen->shadow[pos]) {
+                continue;
+            }
+            if (!streamChar(&stream, screen, pos, refresh)) {
+                displayDirtyMark(screen->dirty, span.x + i, span.y, span.length - i);
+                full = true;
+                break;
+            }
+        }
+    }
+    streamEndAutoIncrement(&stream, screen->dmm);
+
+    return stream.length;
+}
+
+#endif // USE_MAX7456
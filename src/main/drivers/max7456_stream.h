@@ -0,0 +1,70 @@
+/*
+ * This file is part of Cleanflight and Betaflight.
+ *
+ * Cleanflight and Betaflight are free software. You can redistribute
+ * this software and/or modify this software under the terms of the
+ * GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Cleanflight and Betaflight are distributed in the hope that they
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software.
+ *
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "drivers/display.h"
+#include "drivers/max7456.h"
+
+// Display memory registers
+#define MAX7456ADD_DMM          0x04
+#define MAX7456ADD_DMAH         0x05
+#define MAX7456ADD_DMAL         0x06
+#define MAX7456ADD_DMDI         0x07
+
+// DMM special bits
+#define AUTO_INCREMENT          0x01
+#define CLEAR_DISPLAY           0x04
+#define CLEAR_DISPLAY_VERT      0x06
+#define INVERT_PIXEL_COLOR      0x08
+
+// Special address for terminating incremental write
+#define END_STRING              0xff
+
+// Changed characters cost two bytes each plus the address of each run. F3 keeps to the 600 bytes the driver used
+// before across both DMA buffers, a frame that doesn't fit is finished by the next draw. Elsewhere it holds a full
+// redraw.
+#if defined(STM32F3)
+#define MAX7456_STREAM_SIZE         300
+#else
+#define MAX7456_STREAM_SIZE         (VIDEO_BUFFER_CHARS_PAL * 2 + 64)
+#endif
+
+// Unchanged characters sent to continue a run rather than ending it and addressing the next one. Each costs a 2 byte
+// DMDI write. Ending the run and addressing the next character costs 8 bytes more than writing it in the run
+// (END_STRING, DMM, DMAH and DMAL), 10 if it starts another run, so joining a gap of up to 4 is never dearer.
+#define MAX7456_STREAM_MERGE_GAP    4
+
+// Terminating auto-increment mode and restoring DMM
+#define MAX7456_STREAM_END_BYTES    4
+
+typedef struct max7456Screen_s {
+    const uint8_t *buffer;      // as written
+    uint8_t *shadow;            // as in display memory
+    displayDirty_t *dirty;
+    uint16_t size;              // characters shown, fewer in NTSC
+    uint8_t cols;
+    uint8_t dmm;                // DMM register value outside of auto-increment mode
+} max7456Screen_t;
+
+uint16_t max7456StreamBuild(const max7456Screen_t *screen, uint8_t *buf, uint16_t bufSize, bool refresh);
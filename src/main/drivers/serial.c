@@ -20,9 +20,12 @@
 
 #include <stdbool.h>
 #include <stdint.h>
+#include <string.h>
 
 #include "platform.h"
 
+#include "common/maths.h"
+
 #include "serial.h"
 
 void serialPrint(serialPort_t *instance, const char *str)
@@ -123,3 +126,95 @@ void serialEndWrite(serialPort_t *instance)
     if (instance->vTable->endWrite)
         instance->vTable->endWrite(instance);
 }
+
+/*
+ * Received data that is contiguous in the port's receive buffer, starting with the next byte to be read. The data is
+ * left in the buffer until it is consumed with serialRxAdvance(), so parsers can scan it in place and stop part way
+ * through. Returns the number of bytes at data, which may be fewer than serialRxBytesWaiting() when the data wraps
+ * around the end of the buffer, the rest follows in the next span.
+ */
+uint32_t serialRxSpan(const serialPort_t *instance, const uint8_t **data)
+{
+    return instance->vTable->rxSpan(instance, data);
+}
+
+/*
+ * Consume count bytes of received data, no more than serialRxBytesWaiting().
+ */
+void serialRxAdvance(serialPort_t *instance, uint32_t count)
+{
+    instance->vTable->rxAdvance(instance, count);
+}
+
+/*
+ * Read up to count bytes of received data, returns the number of bytes read.
+ */
+uint32_t serialReadBuf(serialPort_t *instance, uint8_t *data, uint32_t count)
+{
+    uint32_t bytesRead = 0;
+
+    while (bytesRead < count) {
+        const uint8_t *span;
+        const uint32_t spanSize = MIN(serialRxSpan(instance, &span), count - bytesRead);
+        if (spanSize == 0) {
+            break;
+        }
+
+        memcpy(data + bytesRead, span, spanSize);
+        serialRxAdvance(instance, spanSize);
+        bytesRead += spanSize;
+    }
+
+    return bytesRead;
+}
+
+uint32_t serialRingRxSpan(const serialPort_t *instance, const uint8_t **data)
+{
+    const uint32_t head = instance->rxBufferHead;
+    const uint32_t tail = instance->rxBufferTail;
+
+    *data = (const uint8_t *)&instance->rxBuffer[tail];
+
+    return head >= tail ? head - tail : instance->rxBufferSize - tail;
+}
+
+void serialRingRxAdvance(serialPort_t *instance, uint32_t count)
+{
+    uint32_t tail = instance->rxBufferTail + count;
+    if (tail >= instance->rxBufferSize) {
+        tail -= instance->rxBufferSize;
+    }
+
+    instance->rxBufferTail = tail;
+}
+
+/*
+ * Receive by circular DMA into the rxBuffer ring. The DMA's data counter counts down from the buffer size as bytes are
+ * written and reloads when it reaches zero, so it gives the ring's head, only the tail is moved by the reader.
+ */
+void serialRxDmaSync(serialPort_t *instance, uint32_t dmaDataCounter)
+{
+    const uint32_t head = instance->rxBufferSize - dmaDataCounter;
+
+    // The counter reads zero for a moment before it reloads
+    instance->rxBufferHead = head < instance->rxBufferSize ? head : 0;
+}
+
+/*
+ * Pass the data received by DMA since the last call to the port's receive callback, as the receive interrupt does a
+ * byte at a time without DMA. Called from the idle line and DMA transfer interrupts, so once per burst of data.
+ */
+void serialRxDmaDeliver(serialPort_t *instance, uint32_t dmaDataCounter)
+{
+    serialRxDmaSync(instance, dmaDataCounter);
+
+    uint32_t tail = instance->rxBufferTail;
+    while (tail != instance->rxBufferHead) {
+        instance->rxCallback(instance->rxBuffer[tail], instance->rxCallbackData);
+        if (++tail >= instance->rxBufferSize) {
+            tail = 0;
+        }
+    }
+
+    instance->rxBufferTail = tail;
+}
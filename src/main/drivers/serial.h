@@ -120,6 +120,10 @@ struct serialPortVTable {
     // Optional functions used to buffer large writes.
     void (*beginWrite)(serialPort_t *instance);
     void (*endWrite)(serialPort_t *instance);
+
+    // Direct access to the received data, see serialRxSpan().
+    uint32_t (*rxSpan)(const serialPort_t *instance, const uint8_t **data);
+    void (*rxAdvance)(serialPort_t *instance, uint32_t count);
 };
 
 void serialWrite(serialPort_t *instance, uint8_t ch);
@@ -139,3 +143,15 @@ uint32_t serialGetBaudRate(serialPort_t *instance);
 void serialWriteBufShim(void *instance, const uint8_t *data, int count);
 void serialBeginWrite(serialPort_t *instance);
 void serialEndWrite(serialPort_t *instance);
+
+uint32_t serialRxSpan(const serialPort_t *instance, const uint8_t **data);
+void serialRxAdvance(serialPort_t *instance, uint32_t count);
+uint32_t serialReadBuf(serialPort_t *instance, uint8_t *data, uint32_t count);
+
+// rxSpan and rxAdvance for drivers that receive into the rxBuffer ring of serialPort_t
+uint32_t serialRingRxSpan(const serialPort_t *instance, const uint8_t **data);
+void serialRingRxAdvance(serialPort_t *instance, uint32_t count);
+
+// For drivers that receive into the rxBuffer ring by circular DMA
+void serialRxDmaSync(serialPort_t *instance, uint32_t dmaDataCounter);
+void serialRxDmaDeliver(serialPort_t *instance, uint32_t dmaDataCounter);
@@ -849,7 +849,9 @@ const struct serialPortVTable escSerialVTable[] = {
         .setBaudRateCb = NULL,
         .writeBuf = NULL,
         .beginWrite = NULL,
-        .endWrite = NULL
+        .endWrite = NULL,
+        .rxSpan = serialRingRxSpan,
+        .rxAdvance = serialRingRxAdvance
     }
 };
 
@@ -0,0 +1,231 @@
+/*
+ * This file is part of Cleanflight and Betaflight.
+ *
+ * Cleanflight and Betaflight are free software. You can redistribute
+ * this software and/or modify this software under the terms of the
+ * GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Cleanflight and Betaflight are distributed in the hope that they
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software.
+ *
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <sys/mman.h>
+
+#include "platform.h"
+
+#ifdef SIMULATOR_SERIAL_SHM
+
+#include "common/maths.h"
+#include "common/utils.h"
+
+#include "io/serial.h"
+
+#include "serial_shm.h"
+
+typedef struct shmPort_s {
+    serialPort_t port;
+    shmSerialRegion_t *region;
+} shmPort_t;
+
+static const struct serialPortVTable shmVTable; // Forward
+static shmPort_t shmSerialPorts[SERIAL_PORT_COUNT];
+
+// The tool moves the receive head and the transmit tail, bring the port's copies up to date.
+// They come from another process, so are kept inside the ring whatever it writes there.
+static void shmSyncRx(const shmPort_t *s)
+{
+    ((shmPort_t *)s)->port.rxBufferHead = __atomic_load_n(&s->region->rx.head, __ATOMIC_ACQUIRE) % SHM_SERIAL_BUFFER_SIZE;
+}
+
+static void shmSyncTx(const shmPort_t *s)
+{
+    ((shmPort_t *)s)->port.txBufferTail = __atomic_load_n(&s->region->tx.tail, __ATOMIC_ACQUIRE) % SHM_SERIAL_BUFFER_SIZE;
+}
+
+static uint32_t shmTotalRxBytesWaiting(const serialPort_t *instance)
+{
+    const shmPort_t *s = (const shmPort_t *)instance;
+    shmSyncRx(s);
+
+    if (s->port.rxBufferHead >= s->port.rxBufferTail) {
+        return s->port.rxBufferHead - s->port.rxBufferTail;
+    } else {
+        return s->port.rxBufferSize + s->port.rxBufferHead - s->port.rxBufferTail;
+    }
+}
+
+static uint32_t shmTotalTxBytesFree(const serialPort_t *instance)
+{
+    const shmPort_t *s = (const shmPort_t *)instance;
+    shmSyncTx(s);
+
+    uint32_t bytesUsed;
+    if (s->port.txBufferHead >= s->port.txBufferTail) {
+        bytesUsed = s->port.txBufferHead - s->port.txBufferTail;
+    } else {
+        bytesUsed = s->port.txBufferSize + s->port.txBufferHead - s->port.txBufferTail;
+    }
+
+    return (s->port.txBufferSize - 1) - bytesUsed;
+}
+
+static bool isShmTransmitBufferEmpty(const serialPort_t *instance)
+{
+    const shmPort_t *s = (const shmPort_t *)instance;
+    shmSyncTx(s);
+
+    return s->port.txBufferTail == s->port.txBufferHead;
+}
+
+static uint8_t shmRead(serialPort_t *instance)
+{
+    shmPort_t *s = (shmPort_t *)instance;
+
+    const uint8_t ch = s->region->rx.data[s->port.rxBufferTail];
+    s->port.rxBufferTail = (s->port.rxBufferTail + 1) % s->port.rxBufferSize;
+    __atomic_store_n(&s->region->rx.tail, s->port.rxBufferTail, __ATOMIC_RELEASE);
+
+    return ch;
+}
+
+static uint32_t shmRxSpan(const serialPort_t *instance, const uint8_t **data)
+{
+    shmSyncRx((const shmPort_t *)instance);
+
+    return serialRingRxSpan(instance, data);
+}
+
+static void shmRxAdvance(serialPort_t *instance, uint32_t count)
+{
+    shmPort_t *s = (shmPort_t *)instance;
+
+    serialRingRxAdvance(instance, count);
+    __atomic_store_n(&s->region->rx.tail, s->port.rxBufferTail, __ATOMIC_RELEASE);
+}
+
+static void shmWrite(serialPort_t *instance, uint8_t ch)
+{
+    shmPort_t *s = (shmPort_t *)instance;
+
+    s->region->tx.data[s->port.txBufferHead] = ch;
+    s->port.txBufferHead = (s->port.txBufferHead + 1) % s->port.txBufferSize;
+    __atomic_store_n(&s->region->tx.head, s->port.txBufferHead, __ATOMIC_RELEASE);
+}
+
+static void shmWriteBuf(serialPort_t *instance, const void *data, int count)
+{
+    shmPort_t *s = (shmPort_t *)instance;
+    const uint8_t *p = data;
+
+    while (count > 0) {
+        const int chunk = MIN(count, (int)(s->port.txBufferSize - s->port.txBufferHead));
+        memcpy(&s->region->tx.data[s->port.txBufferHead], p, chunk);
+        s->port.txBufferHead = (s->port.txBufferHead + chunk) % s->port.txBufferSize;
+        p += chunk;
+        count -= chunk;
+    }
+    __atomic_store_n(&s->region->tx.head, s->port.txBufferHead, __ATOMIC_RELEASE);
+}
+
+static shmSerialRegion_t *shmMap(int id)
+{
+    char name[32];
+    snprintf(name, sizeof(name), SHM_SERIAL_NAME_FORMAT, (unsigned)id + 1);
+
+    const int fd = shm_open(name, O_CREAT | O_RDWR, 0600);
+    if (fd < 0) {
+        fprintf(stderr, "shm_open %s for UART%u failed - %d\n", name, (unsigned)id + 1, errno);
+        return NULL;
+    }
+
+    void *region = MAP_FAILED;
+    if (ftruncate(fd, sizeof(shmSerialRegion_t)) == 0) {
+        region = mmap(NULL, sizeof(shmSerialRegion_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    close(fd);
+
+    if (region == MAP_FAILED) {
+        fprintf(stderr, "mapping %s for UART%u failed - %d\n", name, (unsigned)id + 1, errno);
+        return NULL;
+    }
+    fprintf(stderr, "shared memory %s for UART%u\n", name, (unsigned)id + 1);
+
+    return region;
+}
+
+serialPort_t *serShmOpen(int id, serialReceiveCallbackPtr rxCallback, void *rxCallbackData, uint32_t baudRate, portMode_e mode, portOptions_e options)
+{
+    if (id < 0 || id >= SERIAL_PORT_COUNT) {
+        return NULL;
+    }
+
+    shmPort_t *s = &shmSerialPorts[id];
+    if (!s->region) {
+        s->region = shmMap(id);
+        if (!s->region) {
+            return NULL;
+        }
+    }
+
+    // Anything left over from a previous run or opening is dropped
+    shmSerialRegion_t *region = s->region;
+    __atomic_store_n(&region->magic, 0, __ATOMIC_RELEASE);
+    region->bufferSize = SHM_SERIAL_BUFFER_SIZE;
+    region->rx.head = region->rx.tail = 0;
+    region->tx.head = region->tx.tail = 0;
+
+    s->port.vTable = &shmVTable;
+
+    s->port.rxBufferHead = s->port.rxBufferTail = 0;
+    s->port.txBufferHead = s->port.txBufferTail = 0;
+    s->port.rxBufferSize = SHM_SERIAL_BUFFER_SIZE;
+    s->port.txBufferSize = SHM_SERIAL_BUFFER_SIZE;
+    s->port.rxBuffer = region->rx.data;
+    s->port.txBuffer = region->tx.data;
+
+    // there is no receive interrupt, the callback is not supported
+    s->port.rxCallback = rxCallback;
+    s->port.rxCallbackData = rxCallbackData;
+    s->port.mode = mode;
+    s->port.baudRate = baudRate;
+    s->port.options = options;
+
+    __atomic_store_n(&region->magic, SHM_SERIAL_MAGIC, __ATOMIC_RELEASE);
+
+    return (serialPort_t *)s;
+}
+
+static const struct serialPortVTable shmVTable = {
+        .serialWrite = shmWrite,
+        .serialTotalRxWaiting = shmTotalRxBytesWaiting,
+        .serialTotalTxFree = shmTotalTxBytesFree,
+        .serialRead = shmRead,
+        .serialSetBaudRate = NULL,
+        .isSerialTransmitBufferEmpty = isShmTransmitBufferEmpty,
+        .setMode = NULL,
+        .setCtrlLineStateCb = NULL,
+        .setBaudRateCb = NULL,
+        .writeBuf = shmWriteBuf,
+        .beginWrite = NULL,
+        .endWrite = NULL,
+        .rxSpan = shmRxSpan,
+        .rxAdvance = shmRxAdvance,
+};
+#endif
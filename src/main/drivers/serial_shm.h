@@ -0,0 +1,55 @@
+/*
+ * This file is part of Cleanflight and Betaflight.
+ *
+ * Cleanflight and Betaflight are free software. You can redistribute
+ * this software and/or modify this software under the terms of the
+ * GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Cleanflight and Betaflight are distributed in the hope that they
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software.
+ *
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include "drivers/serial.h"
+
+/*
+ * Serial ports as rings in POSIX shared memory, for tools running on the same host as SITL.
+ *
+ * Each port is a shared memory object named after SHM_SERIAL_NAME_FORMAT holding a shmSerialRegion_t. Every ring has a
+ * single producer, which writes at head and then advances it, and a single consumer, which reads at tail and then
+ * advances it. Head and tail are indexes into data, wrapping at SHM_SERIAL_BUFFER_SIZE, and are accessed with acquire
+ * loads and release stores. The ring is empty when they are equal, at most SHM_SERIAL_BUFFER_SIZE - 1 bytes are used.
+ *
+ * The firmware reads received data directly from rx.data and writes its output directly into tx.data.
+ */
+
+#define SHM_SERIAL_NAME_FORMAT  "/betaflight_uart%u"
+#define SHM_SERIAL_MAGIC        0x48534642 // "BFSH"
+#define SHM_SERIAL_BUFFER_SIZE  8192
+
+typedef struct shmSerialRing_s {
+    uint32_t head;
+    uint32_t tail;
+    uint8_t data[SHM_SERIAL_BUFFER_SIZE];
+} shmSerialRing_t;
+
+typedef struct shmSerialRegion_s {
+    uint32_t magic;         // set once the region is initialised
+    uint32_t bufferSize;
+    shmSerialRing_t rx;     // tool to firmware
+    shmSerialRing_t tx;     // firmware to tool
+} shmSerialRegion_t;
+
+serialPort_t *serShmOpen(int id, serialReceiveCallbackPtr rxCallback, void *rxCallbackData, uint32_t baudRate, portMode_e mode, portOptions_e options);
@@ -601,6 +601,15 @@ uint8_t softSerialReadByte(serialPort_t *instance)
     return ch;
 }
 
+static uint32_t softSerialRxSpan(const serialPort_t *instance, const uint8_t **data)
+{
+    if ((instance->mode & MODE_RX) == 0) {
+        return 0;
+    }
+
+    return serialRingRxSpan(instance, data);
+}
+
 void softSerialWriteByte(serialPort_t *s, uint8_t ch)
 {
     if ((s->mode & MODE_TX) == 0) {
@@ -642,7 +651,9 @@ static const struct serialPortVTable softSerialVTable = {
     .setBaudRateCb = NULL,
     .writeBuf = NULL,
     .beginWrite = NULL,
-    .endWrite = NULL
+    .endWrite = NULL,
+    .rxSpan = softSerialRxSpan,
+    .rxAdvance = serialRingRxAdvance
 };
 
 #endif
@@ -27,12 +27,21 @@
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <errno.h>
+#include <unistd.h>
+
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
 
 #include "platform.h"
 
 #include "build/build_config.h"
 
+#include "common/maths.h"
 #include "common/utils.h"
 
 #include "io/serial.h"
@@ -40,43 +49,262 @@
 
 #define BASE_PORT 5760
 
+#define TCP_MAX_EVENTS 16
+
+// epoll event data, the port id and what the file descriptor is
+#define TCP_EVENT_SERVER 0
+#define TCP_EVENT_CLIENT 1
+#define TCP_EVENT_WAKE   0xFFFFFFFF
+#define TCP_EVENT(id, kind) (((uint32_t)(id) << 1) | (kind))
+
 static const struct serialPortVTable tcpVTable; // Forward
 static tcpPort_t tcpSerialPorts[SERIAL_PORT_COUNT];
 static bool tcpPortInitialized[SERIAL_PORT_COUNT];
 static bool tcpStart = false;
+static int epollFd = -1;
+static int wakeFd = -1;
+
 bool tcpIsStart(void) {
     return tcpStart;
 }
-static void onData(dyad_Event *e) {
-    tcpPort_t* s = (tcpPort_t*)(e->udata);
-    tcpDataIn(s, (uint8_t*)e->data, e->size);
+
+bool tcpServerInit(void)
+{
+    epollFd = epoll_create1(EPOLL_CLOEXEC);
+    wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (epollFd < 0 || wakeFd < 0) {
+        fprintf(stderr, "epoll init failed - %d\n", errno);
+        return false;
+    }
+
+    struct epoll_event event = { .events = EPOLLIN, .data.u32 = TCP_EVENT_WAKE };
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, wakeFd, &event);
+
+    return true;
+}
+
+// Wake the I/O thread to send what has been written, once per batch of writes
+static void tcpSignalTx(tcpPort_t *s)
+{
+    pthread_mutex_lock(&s->txLock);
+    const bool signal = !s->txSignalled && s->writeDepth == 0;
+    if (signal) {
+        s->txSignalled = true;
+    }
+    pthread_mutex_unlock(&s->txLock);
+
+    if (signal) {
+        const uint64_t one = 1;
+        if (write(wakeFd, &one, sizeof(one)) < 0) {
+            // The counter is already non zero, the I/O thread is awake
+        }
+    }
+}
+
+static void tcpWatchWritable(tcpPort_t *s, bool writable)
+{
+    struct epoll_event event = { .events = EPOLLIN | (writable ? EPOLLOUT : 0), .data.u32 = TCP_EVENT(s->id, TCP_EVENT_CLIENT) };
+    epoll_ctl(epollFd, EPOLL_CTL_MOD, s->clientFd, &event);
+    s->txBlocked = writable;
 }
-static void onClose(dyad_Event *e) {
-    tcpPort_t* s = (tcpPort_t*)(e->udata);
+
+// Send the whole of txBuffer from where it is, with one system call
+static void tcpDataOut(tcpPort_t *s)
+{
+    // Kept until a client connects, leaving txSignalled set so writers don't wake this thread meanwhile
+    if (s->clientFd < 0) {
+        return;
+    }
+
+    pthread_mutex_lock(&s->txLock);
+    s->txSignalled = false;
+    const uint32_t head = s->port.txBufferHead;
+    uint32_t tail = s->port.txBufferTail;
+    pthread_mutex_unlock(&s->txLock);
+
+    if (head == tail) {
+        return;
+    }
+
+    // Writers only move the head, the data between tail and head stays in place
+    struct iovec iov[2];
+    int iovcnt = 1;
+    iov[0].iov_base = &s->txBuffer[tail];
+    if (head > tail) {
+        iov[0].iov_len = head - tail;
+    } else {
+        iov[0].iov_len = s->port.txBufferSize - tail;
+        iov[1].iov_base = &s->txBuffer[0];
+        iov[1].iov_len = head;
+        iovcnt = head ? 2 : 1;
+    }
+
+    const struct msghdr msg = { .msg_iov = iov, .msg_iovlen = iovcnt };
+    const ssize_t sent = sendmsg(s->clientFd, &msg, MSG_NOSIGNAL);
+    if (sent < 0) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            tcpWatchWritable(s, true);
+        }
+        // Otherwise the connection is closed when reading from it fails
+        return;
+    }
+
+    tail = (tail + sent) % s->port.txBufferSize;
+    if (s->txBlocked != (tail != head)) {
+        tcpWatchWritable(s, tail != head);
+    }
+
+    pthread_mutex_lock(&s->txLock);
+    s->port.txBufferTail = tail;
+    pthread_mutex_unlock(&s->txLock);
+}
+
+static void tcpClose(tcpPort_t *s)
+{
+    epoll_ctl(epollFd, EPOLL_CTL_DEL, s->clientFd, NULL);
+    close(s->clientFd);
+    s->clientFd = -1;
+    s->txBlocked = false;
     s->clientCount--;
-    s->conn = NULL;
     fprintf(stderr, "[CLS]UART%u: %d,%d\n", s->id + 1, s->connected, s->clientCount);
     if (s->clientCount == 0) {
         s->connected = false;
     }
 }
-static void onAccept(dyad_Event *e) {
-    tcpPort_t* s = (tcpPort_t*)(e->udata);
+
+// Receive straight into the free part of rxBuffer
+static void tcpDataIn(tcpPort_t *s)
+{
+    pthread_mutex_lock(&s->rxLock);
+    const uint32_t tail = s->port.rxBufferTail;
+    pthread_mutex_unlock(&s->rxLock);
+
+    // Only this thread moves the head
+    const uint32_t head = s->port.rxBufferHead;
+    const uint32_t size = s->port.rxBufferSize;
+
+    struct iovec iov[2];
+    int iovcnt = 1;
+    uint8_t overrun[64];
+    iov[0].iov_base = &s->rxBuffer[head];
+    if (tail > head) {
+        iov[0].iov_len = tail - head - 1;
+    } else {
+        iov[0].iov_len = size - head - (tail == 0 ? 1 : 0);
+        iov[1].iov_base = &s->rxBuffer[0];
+        iov[1].iov_len = tail ? tail - 1 : 0;
+        iovcnt = iov[1].iov_len ? 2 : 1;
+    }
+    if (iov[0].iov_len == 0) {
+        // Full, the data is lost as on an overrun UART
+        iov[0].iov_base = overrun;
+        iov[0].iov_len = sizeof(overrun);
+    }
+
+    const ssize_t received = readv(s->clientFd, iov, iovcnt);
+    if (received == 0 || (received < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+        tcpClose(s);
+        return;
+    }
+    if (received < 0 || iov[0].iov_base == overrun) {
+        return;
+    }
+
+    pthread_mutex_lock(&s->rxLock);
+    s->port.rxBufferHead = (head + received) % size;
+    pthread_mutex_unlock(&s->rxLock);
+}
+
+static void tcpAccept(tcpPort_t *s)
+{
+    const int fd = accept4(s->serverFd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if (fd < 0) {
+        return;
+    }
     fprintf(stderr, "New connection on UART%u, %d\n", s->id + 1, s->clientCount);
 
     s->connected = true;
     if (s->clientCount > 0) {
-        dyad_close(e->remote);
+        close(fd);
         return;
     }
     s->clientCount++;
     fprintf(stderr, "[NEW]UART%u: %d,%d\n", s->id + 1, s->connected, s->clientCount);
-    s->conn = e->remote;
-    dyad_setNoDelay(e->remote, 1);
-    dyad_setTimeout(e->remote, 120);
-    dyad_addListener(e->remote, DYAD_EVENT_DATA, onData, e->udata);
-    dyad_addListener(e->remote, DYAD_EVENT_CLOSE, onClose, e->udata);
+
+    const int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    s->clientFd = fd;
+    struct epoll_event event = { .events = EPOLLIN, .data.u32 = TCP_EVENT(s->id, TCP_EVENT_CLIENT) };
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event);
+
+    // Anything written while nobody was connected
+    tcpDataOut(s);
 }
+
+void tcpServerUpdate(int timeoutMs)
+{
+    struct epoll_event events[TCP_MAX_EVENTS];
+
+    const int count = epoll_wait(epollFd, events, TCP_MAX_EVENTS, timeoutMs);
+    for (int i = 0; i < count; i++) {
+        const uint32_t data = events[i].data.u32;
+
+        if (data == TCP_EVENT_WAKE) {
+            uint64_t value;
+            if (read(wakeFd, &value, sizeof(value)) < 0) {
+                continue;
+            }
+            for (int id = 0; id < SERIAL_PORT_COUNT; id++) {
+                // A blocked port continues when its socket becomes writable
+                if (tcpPortInitialized[id] && !tcpSerialPorts[id].txBlocked) {
+                    tcpDataOut(&tcpSerialPorts[id]);
+                }
+            }
+            continue;
+        }
+
+        tcpPort_t *s = &tcpSerialPorts[data >> 1];
+        if ((data & 1) == TCP_EVENT_SERVER) {
+            tcpAccept(s);
+            continue;
+        }
+
+        if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+            tcpDataIn(s);
+        }
+        if (s->clientFd >= 0 && (events[i].events & EPOLLOUT)) {
+            tcpDataOut(s);
+        }
+    }
+}
+
+static bool tcpListen(tcpPort_t *s, int port)
+{
+    const int one = 1;
+    struct sockaddr_in addr = {
+        .sin_family = AF_INET,
+        .sin_port = htons(port),
+        .sin_addr.s_addr = htonl(INADDR_ANY),
+    };
+
+    s->serverFd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (s->serverFd < 0) {
+        return false;
+    }
+    setsockopt(s->serverFd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    if (bind(s->serverFd, (const struct sockaddr *)&addr, sizeof(addr)) < 0 || listen(s->serverFd, 10) < 0) {
+        close(s->serverFd);
+        s->serverFd = -1;
+        return false;
+    }
+
+    struct epoll_event event = { .events = EPOLLIN, .data.u32 = TCP_EVENT(s->id, TCP_EVENT_SERVER) };
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, s->serverFd, &event);
+
+    return true;
+}
+
 static tcpPort_t* tcpReconfigure(tcpPort_t *s, int id)
 {
     if (tcpPortInitialized[id]) {
@@ -101,12 +329,14 @@ static tcpPort_t* tcpReconfigure(tcpPort_t *s, int id)
     s->connected = false;
     s->clientCount = 0;
     s->id = id;
-    s->conn = NULL;
-    s->serv = dyad_newStream();
-    dyad_setNoDelay(s->serv, 1);
-    dyad_addListener(s->serv, DYAD_EVENT_ACCEPT, onAccept, s);
+    s->clientFd = -1;
+    // Set before the I/O thread can accept a client
+    s->port.rxBufferSize = RX_BUFFER_SIZE;
+    s->port.txBufferSize = TX_BUFFER_SIZE;
+    s->port.rxBuffer = s->rxBuffer;
+    s->port.txBuffer = s->txBuffer;
 
-    if (dyad_listenEx(s->serv, NULL, BASE_PORT + id + 1, 10) == 0) {
+    if (tcpListen(s, BASE_PORT + id + 1)) {
         fprintf(stderr, "bind port %u for UART%u\n", (unsigned)BASE_PORT + id + 1, (unsigned)id + 1);
     } else {
         fprintf(stderr, "bind port %u for UART%u failed!!\n", (unsigned)BASE_PORT + id + 1, (unsigned)id + 1);
@@ -131,10 +361,6 @@ serialPort_t *serTcpOpen(int id, serialReceiveCallbackPtr rxCallback, void *rxCa
     // common serial initialisation code should move to serialPort::init()
     s->port.rxBufferHead = s->port.rxBufferTail = 0;
     s->port.txBufferHead = s->port.txBufferTail = 0;
-    s->port.rxBufferSize = RX_BUFFER_SIZE;
-    s->port.txBufferSize = TX_BUFFER_SIZE;
-    s->port.rxBuffer = s->rxBuffer;
-    s->port.txBuffer = s->txBuffer;
 
     // callback works for IRQ-based RX ONLY
     s->port.rxCallback = rxCallback;
@@ -204,6 +430,24 @@ uint8_t tcpRead(serialPort_t *instance)
     return ch;
 }
 
+uint32_t tcpRxSpan(const serialPort_t *instance, const uint8_t **data)
+{
+    tcpPort_t *s = (tcpPort_t *)instance;
+    pthread_mutex_lock(&s->rxLock);
+    const uint32_t count = serialRingRxSpan(instance, data);
+    pthread_mutex_unlock(&s->rxLock);
+
+    return count;
+}
+
+void tcpRxAdvance(serialPort_t *instance, uint32_t count)
+{
+    tcpPort_t *s = (tcpPort_t *)instance;
+    pthread_mutex_lock(&s->rxLock);
+    serialRingRxAdvance(instance, count);
+    pthread_mutex_unlock(&s->rxLock);
+}
+
 void tcpWrite(serialPort_t *instance, uint8_t ch)
 {
     tcpPort_t *s = (tcpPort_t *)instance;
@@ -217,45 +461,44 @@ void tcpWrite(serialPort_t *instance, uint8_t ch)
     }
     pthread_mutex_unlock(&s->txLock);
 
-    tcpDataOut(s);
+    tcpSignalTx(s);
 }
 
-void tcpDataOut(tcpPort_t *instance)
+static void tcpWriteBuf(serialPort_t *instance, const void *data, int count)
 {
     tcpPort_t *s = (tcpPort_t *)instance;
-    if (s->conn == NULL) return;
+    const uint8_t *p = data;
     pthread_mutex_lock(&s->txLock);
 
-    if (s->port.txBufferHead < s->port.txBufferTail) {
-        // send data till end of buffer
-        int chunk = s->port.txBufferSize - s->port.txBufferTail;
-        dyad_write(s->conn, (const void *)&s->port.txBuffer[s->port.txBufferTail], chunk);
-        s->port.txBufferTail = 0;
+    while (count > 0) {
+        const int chunk = MIN(count, (int)(s->port.txBufferSize - s->port.txBufferHead));
+        memcpy(&s->txBuffer[s->port.txBufferHead], p, chunk);
+        s->port.txBufferHead = (s->port.txBufferHead + chunk) % s->port.txBufferSize;
+        p += chunk;
+        count -= chunk;
     }
-    int chunk = s->port.txBufferHead - s->port.txBufferTail;
-    if (chunk)
-        dyad_write(s->conn, (const void*)&s->port.txBuffer[s->port.txBufferTail], chunk);
-    s->port.txBufferTail = s->port.txBufferHead;
+    pthread_mutex_unlock(&s->txLock);
 
+    tcpSignalTx(s);
+}
+
+// Writes between beginWrite and endWrite go out together, in as few TCP segments as possible
+static void tcpBeginWrite(serialPort_t *instance)
+{
+    tcpPort_t *s = (tcpPort_t *)instance;
+    pthread_mutex_lock(&s->txLock);
+    s->writeDepth++;
     pthread_mutex_unlock(&s->txLock);
 }
 
-void tcpDataIn(tcpPort_t *instance, uint8_t* ch, int size)
+static void tcpEndWrite(serialPort_t *instance)
 {
     tcpPort_t *s = (tcpPort_t *)instance;
-    pthread_mutex_lock(&s->rxLock);
+    pthread_mutex_lock(&s->txLock);
+    s->writeDepth--;
+    pthread_mutex_unlock(&s->txLock);
 
-    while (size--) {
-//        printf("%c", *ch);
-        s->port.rxBuffer[s->port.rxBufferHead] = *(ch++);
-        if (s->port.rxBufferHead + 1 >= s->port.rxBufferSize) {
-            s->port.rxBufferHead = 0;
-        } else {
-            s->port.rxBufferHead++;
-        }
-    }
-    pthread_mutex_unlock(&s->rxLock);
-//    printf("\n");
+    tcpSignalTx(s);
 }
 
 static const struct serialPortVTable tcpVTable = {
@@ -268,7 +511,9 @@ static const struct serialPortVTable tcpVTable = {
         .setMode = NULL,
         .setCtrlLineStateCb = NULL,
         .setBaudRateCb = NULL,
-        .writeBuf = NULL,
-        .beginWrite = NULL,
-        .endWrite = NULL,
+        .writeBuf = tcpWriteBuf,
+        .beginWrite = tcpBeginWrite,
+        .endWrite = tcpEndWrite,
+        .rxSpan = tcpRxSpan,
+        .rxAdvance = tcpRxAdvance,
 };
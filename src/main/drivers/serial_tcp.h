@@ -22,7 +22,6 @@
 
 #include <netinet/in.h>
 #include <pthread.h>
-#include "dyad.h"
 
 #define RX_BUFFER_SIZE    1400
 #define TX_BUFFER_SIZE    1400
@@ -32,20 +31,23 @@ typedef struct {
     uint8_t rxBuffer[RX_BUFFER_SIZE];
     uint8_t txBuffer[TX_BUFFER_SIZE];
 
-    dyad_Stream *serv;
-    dyad_Stream *conn;
+    int serverFd;
+    int clientFd;
     pthread_mutex_t txLock;
     pthread_mutex_t rxLock;
     bool connected;
+    bool txSignalled;       // the I/O thread has been woken for the data in txBuffer
+    bool txBlocked;         // the socket is full, sending continues when it is writable
+    uint8_t writeDepth;     // nesting of beginWrite/endWrite, the data is sent at the end
     uint16_t clientCount;
     uint8_t id;
 } tcpPort_t;
 
 serialPort_t *serTcpOpen(int id, serialReceiveCallbackPtr rxCallback, void *rxCallbackData, uint32_t baudRate, portMode_e mode, portOptions_e options);
 
-// tcpPort API
-void tcpDataIn(tcpPort_t *instance, uint8_t* ch, int size);
-void tcpDataOut(tcpPort_t *instance);
+// The sockets of all ports are served by one I/O thread, which calls tcpServerUpdate() in a loop
+bool tcpServerInit(void);
+void tcpServerUpdate(int timeoutMs);
 
 bool tcpIsStart(void);
 bool* tcpGetUsed(void);
@@ -141,22 +141,30 @@ void uartTryStartTxDMA(uartPort_t *s)
     }
 }
 
-static uint32_t uartTotalRxBytesWaiting(const serialPort_t *instance)
+// Bring the receive ring's head up to date with what the receive DMA has written
+static void uartRxDmaSync(uartPort_t *s)
 {
-    const uartPort_t *s = (const uartPort_t*)instance;
+    // With a receive callback the data is passed on from the interrupt handler instead
+    if (s->port.rxCallback) {
+        return;
+    }
+
 #ifdef STM32F4
     if (s->rxDMAStream) {
-        uint32_t rxDMAHead = s->rxDMAStream->NDTR;
+        serialRxDmaSync(&s->port, s->rxDMAStream->NDTR);
+    }
 #else
     if (s->rxDMAChannel) {
-        uint32_t rxDMAHead = s->rxDMAChannel->CNDTR;
-#endif
-        if (rxDMAHead >= s->rxDMAPos) {
-            return rxDMAHead - s->rxDMAPos;
-        } else {
-            return s->port.rxBufferSize + rxDMAHead - s->rxDMAPos;
-        }
+        serialRxDmaSync(&s->port, s->rxDMAChannel->CNDTR);
     }
+#endif
+}
+
+static uint32_t uartTotalRxBytesWaiting(const serialPort_t *instance)
+{
+    uartPort_t *s = (uartPort_t *)instance;
+
+    uartRxDmaSync(s);
 
     if (s->port.rxBufferHead >= s->port.rxBufferTail) {
         return s->port.rxBufferHead - s->port.rxBufferTail;
@@ -226,26 +234,23 @@ static uint8_t uartRead(serialPort_t *instance)
     uint8_t ch;
     uartPort_t *s = (uartPort_t *)instance;
 
-#ifdef STM32F4
-    if (s->rxDMAStream) {
-#else
-    if (s->rxDMAChannel) {
-#endif
-        ch = s->port.rxBuffer[s->port.rxBufferSize - s->rxDMAPos];
-        if (--s->rxDMAPos == 0)
-            s->rxDMAPos = s->port.rxBufferSize;
+    ch = s->port.rxBuffer[s->port.rxBufferTail];
+    if (s->port.rxBufferTail + 1 >= s->port.rxBufferSize) {
+        s->port.rxBufferTail = 0;
     } else {
-        ch = s->port.rxBuffer[s->port.rxBufferTail];
-        if (s->port.rxBufferTail + 1 >= s->port.rxBufferSize) {
-            s->port.rxBufferTail = 0;
-        } else {
-            s->port.rxBufferTail++;
-        }
+        s->port.rxBufferTail++;
     }
 
     return ch;
 }
 
+static uint32_t uartRxSpan(const serialPort_t *instance, const uint8_t **data)
+{
+    uartRxDmaSync((uartPort_t *)instance);
+
+    return serialRingRxSpan(instance, data);
+}
+
 static void uartWrite(serialPort_t *instance, uint8_t ch)
 {
     uartPort_t *s = (uartPort_t *)instance;
@@ -282,6 +287,8 @@ const struct serialPortVTable uartVTable[] = {
         .writeBuf = NULL,
         .beginWrite = NULL,
         .endWrite = NULL,
+        .rxSpan = uartRxSpan,
+        .rxAdvance = serialRingRxAdvance,
     }
 };
 
@@ -61,8 +61,6 @@ typedef struct uartPort_s {
     uint32_t rxDMAIrq;
     uint32_t txDMAIrq;
 
-    uint32_t rxDMAPos;
-
     uint32_t txDMAPeripheralBaseAddr;
     uint32_t rxDMAPeripheralBaseAddr;
 
@@ -138,8 +138,11 @@ void uartReconfigure(uartPort_t *uartPort)
 
             HAL_UART_Receive_DMA(&uartPort->Handle, (uint8_t*)uartPort->port.rxBuffer, uartPort->port.rxBufferSize);
 
-            uartPort->rxDMAPos = __HAL_DMA_GET_COUNTER(&uartPort->rxDMAHandle);
-
+            if (uartPort->port.rxCallback) {
+                // Deliver on an idle line, the DMA interrupts cover a half or completely filled buffer
+                __HAL_UART_CLEAR_IT(&uartPort->Handle, UART_CLEAR_IDLEF);
+                __HAL_UART_ENABLE_IT(&uartPort->Handle, UART_IT_IDLE);
+            }
         }
         else
         {
@@ -204,7 +207,7 @@ serialPort_t *uartOpen(UARTDevice_e device, serialReceiveCallbackPtr callback, v
     // common serial initialisation code should move to serialPort::init()
     s->port.rxBufferHead = s->port.rxBufferTail = 0;
     s->port.txBufferHead = s->port.txBufferTail = 0;
-    // callback works for IRQ-based RX ONLY
+    // with receive DMA the callback gets the data at the end of each burst
     s->port.rxCallback = callback;
     s->port.rxCallbackData = callbackData;
     s->port.mode = mode;
@@ -252,19 +255,20 @@ void uartStartTxDMA(uartPort_t *s)
     HAL_UART_Transmit_DMA(&s->Handle, (uint8_t *)&s->port.txBuffer[fromwhere], size);
 }
 
+// Bring the receive ring's head up to date with what the receive DMA has written
+static void uartRxDmaSync(uartPort_t *s)
+{
+    // With a receive callback the data is passed on from the interrupt handlers instead
+    if (s->rxDMAStream && !s->port.rxCallback) {
+        serialRxDmaSync(&s->port, __HAL_DMA_GET_COUNTER(s->Handle.hdmarx));
+    }
+}
+
 uint32_t uartTotalRxBytesWaiting(const serialPort_t *instance)
 {
     uartPort_t *s = (uartPort_t*)instance;
 
-    if (s->rxDMAStream) {
-        uint32_t rxDMAHead = __HAL_DMA_GET_COUNTER(s->Handle.hdmarx);
-
-        if (rxDMAHead >= s->rxDMAPos) {
-            return rxDMAHead - s->rxDMAPos;
-        } else {
-            return s->port.rxBufferSize + rxDMAHead - s->rxDMAPos;
-        }
-    }
+    uartRxDmaSync(s);
 
     if (s->port.rxBufferHead >= s->port.rxBufferTail) {
         return s->port.rxBufferHead - s->port.rxBufferTail;
@@ -322,22 +326,23 @@ uint8_t uartRead(serialPort_t *instance)
     uint8_t ch;
     uartPort_t *s = (uartPort_t *)instance;
 
-    if (s->rxDMAStream) {
-        ch = s->port.rxBuffer[s->port.rxBufferSize - s->rxDMAPos];
-        if (--s->rxDMAPos == 0)
-            s->rxDMAPos = s->port.rxBufferSize;
+    ch = s->port.rxBuffer[s->port.rxBufferTail];
+    if (s->port.rxBufferTail + 1 >= s->port.rxBufferSize) {
+        s->port.rxBufferTail = 0;
     } else {
-        ch = s->port.rxBuffer[s->port.rxBufferTail];
-        if (s->port.rxBufferTail + 1 >= s->port.rxBufferSize) {
-            s->port.rxBufferTail = 0;
-        } else {
-            s->port.rxBufferTail++;
-        }
+        s->port.rxBufferTail++;
     }
 
     return ch;
 }
 
+static uint32_t uartRxSpan(const serialPort_t *instance, const uint8_t **data)
+{
+    uartRxDmaSync((uartPort_t *)instance);
+
+    return serialRingRxSpan(instance, data);
+}
+
 void uartWrite(serialPort_t *instance, uint8_t ch)
 {
     uartPort_t *s = (uartPort_t *)instance;
@@ -370,6 +375,8 @@ const struct serialPortVTable uartVTable[] = {
         .writeBuf = NULL,
         .beginWrite = NULL,
         .endWrite = NULL,
+        .rxSpan = uartRxSpan,
+        .rxAdvance = serialRingRxAdvance,
     }
 };
 
@@ -126,7 +126,7 @@ serialPort_t *uartOpen(UARTDevice_e device, serialReceiveCallbackPtr rxCallback,
     // common serial initialisation code should move to serialPort::init()
     s->port.rxBufferHead = s->port.rxBufferTail = 0;
     s->port.txBufferHead = s->port.txBufferTail = 0;
-    // callback works for IRQ-based RX ONLY
+    // with receive DMA the callback is only supported on F4, data is passed on at the end of each burst
     s->port.rxCallback = rxCallback;
     s->port.rxCallbackData = rxCallbackData;
     s->port.mode = mode;
@@ -173,7 +173,11 @@ serialPort_t *uartOpen(UARTDevice_e device, serialReceiveCallbackPtr rxCallback,
             DMA_Init(s->rxDMAStream, &DMA_InitStructure);
             DMA_Cmd(s->rxDMAStream, ENABLE);
             USART_DMACmd(s->USARTx, USART_DMAReq_Rx, ENABLE);
-            s->rxDMAPos = DMA_GetCurrDataCounter(s->rxDMAStream);
+            if (rxCallback) {
+                // Deliver on an idle line and when the buffer is half or completely filled
+                USART_ITConfig(s->USARTx, USART_IT_IDLE, ENABLE);
+                DMA_ITConfig(s->rxDMAStream, DMA_IT_HT | DMA_IT_TC, ENABLE);
+            }
 #else
             DMA_InitStructure.DMA_DIR = DMA_DIR_PeripheralSRC;
             DMA_InitStructure.DMA_Mode = DMA_Mode_Circular;
@@ -182,7 +186,6 @@ serialPort_t *uartOpen(UARTDevice_e device, serialReceiveCallbackPtr rxCallback,
             DMA_Init(s->rxDMAChannel, &DMA_InitStructure);
             DMA_Cmd(s->rxDMAChannel, ENABLE);
             USART_DMACmd(s->USARTx, USART_DMAReq_Rx, ENABLE);
-            s->rxDMAPos = DMA_GetCurrDataCounter(s->rxDMAChannel);
 #endif
         } else {
             USART_ClearITPendingBit(s->USARTx, USART_IT_RXNE);
@@ -195,6 +195,16 @@ void dmaIRQHandler(dmaChannelDescriptor_t* descriptor)
     }
 }
 
+// Receive DMA half and full transfer, only enabled when the port has a receive callback
+static void dmaRxIRQHandler(dmaChannelDescriptor_t* descriptor)
+{
+    uartPort_t *s = &(((uartDevice_t*)(descriptor->userParam))->port);
+    DMA_CLEAR_FLAG(descriptor, DMA_IT_HTIF);
+    DMA_CLEAR_FLAG(descriptor, DMA_IT_TCIF);
+
+    serialRxDmaDeliver(&s->port, DMA_GetCurrDataCounter(s->rxDMAStream));
+}
+
 // XXX Should serialUART be consolidated?
 
 uartPort_t *serialUART(UARTDevice_e device, uint32_t baudRate, portMode_e mode, portOptions_e options)
@@ -219,7 +229,9 @@ uartPort_t *serialUART(UARTDevice_e device, uint32_t baudRate, portMode_e mode,
     s->USARTx = hardware->reg;
 
     if (hardware->rxDMAStream) {
-        dmaInit(dmaGetIdentifier(hardware->rxDMAStream), OWNER_SERIAL_RX, RESOURCE_INDEX(device));
+        const dmaIdentifier_e identifier = dmaGetIdentifier(hardware->rxDMAStream);
+        dmaInit(identifier, OWNER_SERIAL_RX, RESOURCE_INDEX(device));
+        dmaSetHandler(identifier, dmaRxIRQHandler, hardware->rxPriority, (uint32_t)uart);
         s->rxDMAChannel = hardware->DMAChannel;
         s->rxDMAStream = hardware->rxDMAStream;
         s->rxDMAPeripheralBaseAddr = (uint32_t)&s->USARTx->DR;
@@ -256,15 +268,14 @@ uartPort_t *serialUART(UARTDevice_e device, uint32_t baudRate, portMode_e mode,
         }
     }
 
-    if (!(s->rxDMAChannel)) {
-        NVIC_InitTypeDef NVIC_InitStructure;
+    // Also needed with receive DMA, for the idle line interrupt
+    NVIC_InitTypeDef NVIC_InitStructure;
 
-        NVIC_InitStructure.NVIC_IRQChannel = hardware->irqn;
-        NVIC_InitStructure.NVIC_IRQChannelPreemptionPriority = NVIC_PRIORITY_BASE(hardware->rxPriority);
-        NVIC_InitStructure.NVIC_IRQChannelSubPriority = NVIC_PRIORITY_SUB(hardware->rxPriority);
-        NVIC_InitStructure.NVIC_IRQChannelCmd = ENABLE;
-        NVIC_Init(&NVIC_InitStructure);
-    }
+    NVIC_InitStructure.NVIC_IRQChannel = hardware->irqn;
+    NVIC_InitStructure.NVIC_IRQChannelPreemptionPriority = NVIC_PRIORITY_BASE(hardware->rxPriority);
+    NVIC_InitStructure.NVIC_IRQChannelSubPriority = NVIC_PRIORITY_SUB(hardware->rxPriority);
+    NVIC_InitStructure.NVIC_IRQChannelCmd = ENABLE;
+    NVIC_Init(&NVIC_InitStructure);
 
     return s;
 }
@@ -280,6 +291,12 @@ void uartIrqHandler(uartPort_t *s)
         }
     }
 
+    if (s->rxDMAStream && (USART_GetITStatus(s->USARTx, USART_IT_IDLE) == SET)) {
+        // Reading the data register after the status register clears the idle flag
+        (void)s->USARTx->DR;
+        serialRxDmaDeliver(&s->port, DMA_GetCurrDataCounter(s->rxDMAStream));
+    }
+
     if (!s->txDMAStream && (USART_GetITStatus(s->USARTx, USART_IT_TXE) == SET)) {
         if (s->port.txBufferTail != s->port.txBufferHead) {
             USART_SendData(s->USARTx, s->port.txBuffer[s->port.txBufferTail]);
@@ -334,6 +334,12 @@ void uartIrqHandler(uartPort_t *s)
         __HAL_UART_SEND_REQ(huart, UART_RXDATA_FLUSH_REQUEST);
     }
 
+    /* UART idle line with receive DMA ----------------------------------------*/
+    if (s->rxDMAStream && (__HAL_UART_GET_IT(huart, UART_IT_IDLE) != RESET)) {
+        __HAL_UART_CLEAR_IT(huart, UART_CLEAR_IDLEF);
+        serialRxDmaDeliver(&s->port, __HAL_DMA_GET_COUNTER(huart->hdmarx));
+    }
+
     /* UART parity error interrupt occurred -------------------------------------*/
     if ((__HAL_UART_GET_IT(huart, UART_IT_PE) != RESET)) {
         __HAL_UART_CLEAR_IT(huart, UART_CLEAR_PEF);
@@ -398,6 +404,17 @@ void dmaIRQHandler(dmaChannelDescriptor_t* descriptor)
     HAL_DMA_IRQHandler(&s->txDMAHandle);
 }
 
+static void dmaRxIRQHandler(dmaChannelDescriptor_t* descriptor)
+{
+    uartPort_t *s = &(((uartDevice_t*)(descriptor->userParam))->port);
+    HAL_DMA_IRQHandler(&s->rxDMAHandle);
+
+    // Half or completely filled buffer, the idle line interrupt covers the rest
+    if (s->port.rxCallback) {
+        serialRxDmaDeliver(&s->port, __HAL_DMA_GET_COUNTER(&s->rxDMAHandle));
+    }
+}
+
 // XXX Should serialUART be consolidated?
 
 uartPort_t *serialUART(UARTDevice_e device, uint32_t baudRate, portMode_e mode, portOptions_e options)
@@ -425,6 +442,11 @@ uartPort_t *serialUART(UARTDevice_e device, uint32_t baudRate, portMode_e mode,
     if (hardware->rxDMAStream) {
         s->rxDMAChannel = hardware->DMAChannel;
         s->rxDMAStream = hardware->rxDMAStream;
+
+        // DMA RX Interrupt
+        const dmaIdentifier_e identifier = dmaGetIdentifier(hardware->rxDMAStream);
+        dmaInit(identifier, OWNER_SERIAL_RX, RESOURCE_INDEX(device));
+        dmaSetHandler(identifier, dmaRxIRQHandler, hardware->rxPriority, (uint32_t)uartdev);
     }
 
     if (hardware->txDMAStream) {
@@ -466,10 +488,9 @@ uartPort_t *serialUART(UARTDevice_e device, uint32_t baudRate, portMode_e mode,
         }
     }
 
-    if (!s->rxDMAChannel) {
-        HAL_NVIC_SetPriority(hardware->rxIrq, NVIC_PRIORITY_BASE(hardware->rxPriority), NVIC_PRIORITY_SUB(hardware->rxPriority));
-        HAL_NVIC_EnableIRQ(hardware->rxIrq);
-    }
+    // Also needed with receive DMA, for the idle line interrupt
+    HAL_NVIC_SetPriority(hardware->rxIrq, NVIC_PRIORITY_BASE(hardware->rxPriority), NVIC_PRIORITY_SUB(hardware->rxPriority));
+    HAL_NVIC_EnableIRQ(hardware->rxIrq);
 
     return s;
 }
@@ -122,6 +122,20 @@ static uint8_t usbVcpRead(serialPort_t *instance)
     }
 }
 
+static uint32_t usbVcpRxSpan(const serialPort_t *instance, const uint8_t **data)
+{
+    UNUSED(instance);
+
+    return CDC_Receive_Span(data);
+}
+
+static void usbVcpRxAdvance(serialPort_t *instance, uint32_t count)
+{
+    UNUSED(instance);
+
+    CDC_Receive_Skip(count);
+}
+
 static void usbVcpWriteBuf(serialPort_t *instance, const void *data, int count)
 {
     UNUSED(instance);
@@ -212,7 +226,9 @@ static const struct serialPortVTable usbVTable[] = {
         .setBaudRateCb = usbVcpSetBaudRateCb,
         .writeBuf = usbVcpWriteBuf,
         .beginWrite = usbVcpBeginWrite,
-        .endWrite = usbVcpEndWrite
+        .endWrite = usbVcpEndWrite,
+        .rxSpan = usbVcpRxSpan,
+        .rxAdvance = usbVcpRxAdvance
     }
 };
 
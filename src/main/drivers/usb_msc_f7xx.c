@@ -142,6 +142,7 @@ void mscWaitForButton(void)
     delay(DEBOUNCE_TIME_MS);
     while (true) {
         asm("NOP");
+        mscStorageIdle();
         if (mscCheckButton()) {
             *((uint32_t *)0x2001FFF0) = 0xFFFFFFFF;
             delay(1);
@@ -42,6 +42,7 @@ typedef struct systemConfig_s {
     uint8_t cpu_overclock;
     uint8_t powerOnArmingGraceTime; // in seconds
     char boardIdentifier[sizeof(TARGET_BOARD_IDENTIFIER) + 1];
+    uint8_t inflightAdjustmentSave; // persist in-flight adjustments without waiting for a save
 } systemConfig_t;
 
 PG_DECLARE(systemConfig_t, systemConfig);
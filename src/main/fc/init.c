@@ -126,6 +126,7 @@
 #include "io/pidaudio.h"
 #include "io/piniobox.h"
 #include "io/displayport_msp.h"
+#include "io/displayport_sim.h"
 #include "io/vtx.h"
 #include "io/vtx_rtc6705.h"
 #include "io/vtx_control.h"
@@ -562,6 +563,9 @@ void init(void)
 #if defined(USE_MAX7456)
         // If there is a max7456 chip for the OSD then use it
         osdDisplayPort = max7456DisplayPortInit(vcdProfile());
+#elif defined(USE_SIM_DISPLAYPORT)
+        // Virtual PAL screen, costed as a MAX7456
+        osdDisplayPort = displayPortSimInit(DISPLAYPORT_SIM_TRANSPORT_MAX7456, 16, 30);
 #elif defined(USE_CMS) && defined(USE_MSP_DISPLAYPORT) && defined(USE_OSD_OVER_MSP_DISPLAYPORT) // OSD over MSP; not supported (yet)
         osdDisplayPort = displayPortMspInit();
 #endif
@@ -629,6 +633,9 @@ void init(void)
 #ifdef USE_FLASHFS
 #if defined(USE_FLASH)
     flashInit(flashConfig());
+#endif
+#ifdef USE_BLACKBOX
+    flashfsSetEraseAhead(blackboxConfig()->flash_erase_ahead_kb * 1024, blackboxConfig()->flash_circular);
 #endif
     flashfsInit();
 #endif
@@ -37,6 +37,7 @@
 
 #include "drivers/time.h"
 
+#include "config/config_eeprom.h"
 #include "config/feature.h"
 #include "pg/pg.h"
 #include "pg/pg_ids.h"
@@ -53,6 +54,7 @@
 #include "fc/rc_adjustments.h"
 #include "fc/rc_controls.h"
 #include "fc/rc.h"
+#include "fc/runtime_config.h"
 
 #include "rx/rx.h"
 
@@ -666,6 +668,34 @@ static uint8_t applySelectAdjustment(adjustmentFunction_e adjustmentFunction, ui
 
 #define RESET_FREQUENCY_2HZ (1000 / 2)
 
+// Adjustments are persisted once the pilot has stopped changing them for this long, and has disarmed
+#define ADJUSTMENT_SAVE_DELAY_MS 2000
+
+static bool adjustmentSavePending;
+static uint32_t adjustmentSaveAt;
+
+static void scheduleAdjustmentSave(uint32_t now)
+{
+    pgMarkDirty(pgFind(PG_PID_PROFILE));
+    pgMarkDirty(pgFind(PG_CONTROL_RATE_PROFILES));
+
+    if (systemConfig()->inflightAdjustmentSave) {
+        adjustmentSavePending = true;
+        adjustmentSaveAt = now + ADJUSTMENT_SAVE_DELAY_MS;
+    }
+}
+
+static void processAdjustmentSave(uint32_t now)
+{
+    // Writing the config takes too long to do while armed
+    if (adjustmentSavePending && cmp32(now, adjustmentSaveAt) >= 0 && !ARMING_FLAG(ARMED)) {
+        // Only appends the changed settings to the config log. If that would need a flash erase the changes are kept
+        // in RAM until the next regular save.
+        writeConfigChangesToEEPROM();
+        adjustmentSavePending = false;
+    }
+}
+
 void processRcAdjustments(controlRateConfig_t *controlRateConfig)
 {
     const uint32_t now = millis();
@@ -719,6 +749,7 @@ void processRcAdjustments(controlRateConfig_t *controlRateConfig)
 
             newValue = applyStepAdjustment(controlRateConfig, adjustmentFunction, delta);
             pidInitConfig(pidProfile);
+            scheduleAdjustmentSave(now);
         } else if (adjustmentState->config->mode == ADJUSTMENT_MODE_SELECT) {
             int switchPositions = adjustmentState->config->data.switchPositions;
             if (adjustmentFunction == ADJUSTMENT_RATE_PROFILE && systemConfig()->rateProfile6PosSwitch) {
@@ -758,8 +789,11 @@ void processRcAdjustments(controlRateConfig_t *controlRateConfig)
             lastRcData[index] = rcData[channelIndex];
             applyAbsoluteAdjustment(controlRateConfig, adjustmentRange->adjustmentFunction, value);
             pidInitConfig(pidProfile);
+            scheduleAdjustmentSave(now);
         }
     }
+
+    processAdjustmentSave(now);
 }
 
 void resetAdjustmentStates(void)
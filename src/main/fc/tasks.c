@@ -24,11 +24,14 @@
 
 #include "platform.h"
 
+#include "blackbox/blackbox.h"
+
 #include "build/debug.h"
 
 #include "cms/cms.h"
 
 #include "common/color.h"
+#include "common/maths.h"
 #include "common/utils.h"
 
 #include "config/feature.h"
@@ -62,6 +65,7 @@
 #include "io/asyncfatfs/asyncfatfs.h"
 #include "io/beeper.h"
 #include "io/dashboard.h"
+#include "io/flashfs.h"
 #include "io/gps.h"
 #include "io/ledstrip.h"
 #include "io/osd.h"
@@ -110,6 +114,11 @@
 
 #include "tasks.h"
 
+// While a stream of MSP frames is being pushed out, run often enough to keep the port's transmit buffer topped up
+#define TASK_SERIAL_STREAMING_PERIOD TASK_PERIOD_HZ(1000)
+
+static timeDelta_t serialTaskIdlePeriod;
+
 static void taskMain(timeUs_t currentTimeUs)
 {
     UNUSED(currentTimeUs);
@@ -137,6 +146,15 @@ static void taskHandleSerial(timeUs_t currentTimeUs)
 #endif
     bool evaluateMspData = ARMING_FLAG(ARMED) ? MSP_SKIP_NON_MSP_DATA : MSP_EVALUATE_NON_MSP_DATA;
     mspSerialProcess(evaluateMspData, mspFcProcessCommand, mspFcProcessReply);
+
+    const bool streaming = mspSerialIsStreaming();
+    if (streaming && !serialTaskIdlePeriod) {
+        serialTaskIdlePeriod = cfTasks[TASK_SERIAL].desiredPeriod;
+        rescheduleTask(TASK_SELF, MIN(serialTaskIdlePeriod, TASK_SERIAL_STREAMING_PERIOD));
+    } else if (!streaming && serialTaskIdlePeriod) {
+        rescheduleTask(TASK_SELF, serialTaskIdlePeriod);
+        serialTaskIdlePeriod = 0;
+    }
 }
 
 static void taskBatteryAlerts(timeUs_t currentTimeUs)
@@ -219,6 +237,42 @@ static void taskCameraControl(uint32_t currentTime)
 }
 #endif
 
+#ifdef USE_FLASHFS
+static void taskFlashfsErase(timeUs_t currentTimeUs)
+{
+    UNUSED(currentTimeUs);
+
+    // An erase in progress would stall blackbox writes, so only prepare space while disarmed and not logging, which
+    // blackbox_mode ALWAYS does while disarmed too
+    if (ARMING_FLAG(ARMED)) {
+        return;
+    }
+#ifdef USE_BLACKBOX
+    if (!blackboxMayEditConfig()) {
+        return;
+    }
+#endif
+
+    flashfsEraseAheadUpdate();
+}
+#endif
+
+#ifdef USE_MSP_SUBSCRIPTIONS
+static void taskMspSubscriptions(timeUs_t currentTimeUs)
+{
+    UNUSED(currentTimeUs);
+
+#ifdef USE_CLI
+    // The port belongs to the cli now
+    if (cliMode) {
+        return;
+    }
+#endif
+
+    mspSerialProcessSubscriptions(mspFcProcessCommand);
+}
+#endif
+
 void fcTasksInit(void)
 {
     schedulerInit();
@@ -323,6 +377,14 @@ void fcTasksInit(void)
     setTaskEnabled(TASK_PINIOBOX, true);
 #endif
 
+#if defined(USE_FLASHFS) && defined(USE_BLACKBOX)
+    setTaskEnabled(TASK_FLASHFS_ERASE, flashfsIsSupported() && blackboxConfig()->flash_erase_ahead_kb > 0);
+#endif
+
+#ifdef USE_MSP_SUBSCRIPTIONS
+    setTaskEnabled(TASK_MSP_SUBSCRIPTIONS, true);
+#endif
+
 #ifdef USE_CMS
 #ifdef USE_MSP_DISPLAYPORT
     setTaskEnabled(TASK_CMS, true);
@@ -597,4 +659,22 @@ cfTask_t cfTasks[TASK_COUNT] = {
         .staticPriority = TASK_PRIORITY_IDLE
     },
 #endif
+
+#ifdef USE_FLASHFS
+    [TASK_FLASHFS_ERASE] = {
+        .taskName = "FLASHFS_ERASE",
+        .taskFunc = taskFlashfsErase,
+        .desiredPeriod = TASK_PERIOD_HZ(100),
+        .staticPriority = TASK_PRIORITY_IDLE
+    },
+#endif
+
+#ifdef USE_MSP_SUBSCRIPTIONS
+    [TASK_MSP_SUBSCRIPTIONS] = {
+        .taskName = "MSP_SUBSCRIBE",
+        .taskFunc = taskMspSubscriptions,
+        .desiredPeriod = TASK_PERIOD_HZ(100),
+        .staticPriority = TASK_PRIORITY_LOW
+    },
+#endif
 };
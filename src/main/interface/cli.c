@@ -495,6 +495,69 @@ static bool valuePtrEqualsDefault(const clivalue_t *var, const void *ptr, const
     return result;
 }
 
+#ifdef USE_CLI_SETTINGS_INDEX
+static bool valueTableNameIndexBuilt = false;
+
+static void buildValueTableNameIndex(void)
+{
+    // Insertion sort, only done once and the table is too small for anything cleverer to be worth the code size
+    for (unsigned i = 0; i < valueTableEntryCount; i++) {
+        unsigned j = i;
+        while (j > 0 && strcasecmp(valueTable[valueTableNameIndex[j - 1]].name, valueTable[i].name) > 0) {
+            valueTableNameIndex[j] = valueTableNameIndex[j - 1];
+            j--;
+        }
+        valueTableNameIndex[j] = i;
+    }
+
+    valueTableNameIndexBuilt = true;
+}
+
+// Compares the first length characters of name, taken as the whole name, with the name of the value
+static int compareValueName(const char *name, unsigned length, const clivalue_t *value)
+{
+    const int result = strncasecmp(name, value->name, length);
+
+    return result == 0 && value->name[length] != '\0' ? -1 : result;
+}
+#endif
+
+// Find the setting with the given name, which is length characters long and needs no terminator
+STATIC_UNIT_TESTED const clivalue_t *cliFindValue(const char *name, unsigned length)
+{
+#ifdef USE_CLI_SETTINGS_INDEX
+    if (!valueTableNameIndexBuilt) {
+        buildValueTableNameIndex();
+    }
+
+    int low = 0;
+    int high = valueTableEntryCount - 1;
+    while (low <= high) {
+        const int middle = (low + high) / 2;
+        const clivalue_t *value = &valueTable[valueTableNameIndex[middle]];
+        const int result = compareValueName(name, length, value);
+
+        if (result == 0) {
+            return value;
+        } else if (result < 0) {
+            high = middle - 1;
+        } else {
+            low = middle + 1;
+        }
+    }
+#else
+    for (uint32_t i = 0; i < valueTableEntryCount; i++) {
+        const clivalue_t *value = &valueTable[i];
+
+        if (strncasecmp(name, value->name, length) == 0 && strlen(value->name) == length) {
+            return value;
+        }
+    }
+#endif
+
+    return NULL;
+}
+
 static uint8_t getPidProfileIndexToUse()
 {
     return pidProfileIndexToUse == CURRENT_PROFILE_INDEX ? getCurrentPidProfileIndex() : pidProfileIndexToUse;
@@ -535,7 +598,7 @@ const void *cliGetDefaultPointer(const clivalue_t *value)
     return rec->address + getValueOffset(value);
 }
 
-static void dumpPgValue(const clivalue_t *value, uint8_t dumpMask)
+STATIC_UNIT_TESTED void dumpPgValue(const clivalue_t *value, uint8_t dumpMask)
 {
     const pgRegistry_t *pg = pgFind(value->pgn);
 #ifdef DEBUG
@@ -562,12 +625,50 @@ static void dumpPgValue(const clivalue_t *value, uint8_t dumpMask)
     }
 }
 
-static void dumpAllValues(uint16_t valueSection, uint8_t dumpMask)
+// Compare the part of a PG that holds the values of a section, that is the current profile for the profile sections
+static bool pgSectionEqualsDefault(const pgRegistry_t *pg, uint16_t valueSection)
+{
+    uint16_t offset = 0;
+    uint16_t size = pgSize(pg);
+
+    switch (valueSection) {
+    case PROFILE_VALUE:
+        offset = sizeof(pidProfile_t) * getPidProfileIndexToUse();
+        size = sizeof(pidProfile_t);
+
+        break;
+    case PROFILE_RATE_VALUE:
+        offset = sizeof(controlRateConfig_t) * getRateProfileIndexToUse();
+        size = sizeof(controlRateConfig_t);
+
+        break;
+    }
+
+    return offset + size <= pgSize(pg) && memcmp(pg->copy + offset, pg->address + offset, size) == 0;
+}
+
+STATIC_UNIT_TESTED void dumpAllValues(uint16_t valueSection, uint8_t dumpMask)
 {
+    // The values of a PG are next to each other in the table, and none of them can differ from its default if the
+    // PG as a whole doesn't, so a diff only looks at the individual values of the PGs that have been changed
+    pgn_t comparedPgn = 0;
+    bool pgEqualsDefault = false;
+
     for (uint32_t i = 0; i < valueTableEntryCount; i++) {
         const clivalue_t *value = &valueTable[i];
         bufWriterFlush(cliWriter);
         if ((value->type & VALUE_SECTION_MASK) == valueSection) {
+            if (dumpMask & DO_DIFF) {
+                if (value->pgn != comparedPgn) {
+                    const pgRegistry_t *pg = pgFind(value->pgn);
+
+                    comparedPgn = value->pgn;
+                    pgEqualsDefault = pg && pgSectionEqualsDefault(pg, valueSection);
+                }
+                if (pgEqualsDefault) {
+                    continue;
+                }
+            }
             dumpPgValue(value, dumpMask);
         }
     }
@@ -3301,9 +3402,33 @@ void cliPrintVarDefault(const clivalue_t *value)
     }
 }
 
+static void cliGetVar(const clivalue_t *val, int matchedCommands)
+{
+    if (matchedCommands > 0) {
+        cliPrintLinefeed();
+    }
+    cliPrintf("%s = ", val->name);
+    cliPrintVar(val, 0);
+    cliPrintLinefeed();
+    switch (val->type & VALUE_SECTION_MASK) {
+    case PROFILE_VALUE:
+        cliProfile("");
+
+        break;
+    case PROFILE_RATE_VALUE:
+        cliRateProfile("");
+
+        break;
+    default:
+
+        break;
+    }
+    cliPrintVarRange(val);
+    cliPrintVarDefault(val);
+}
+
 STATIC_UNIT_TESTED void cliGet(char *cmdline)
 {
-    const clivalue_t *val;
     int matchedCommands = 0;
 
     pidProfileIndexToUse = getCurrentPidProfileIndex();
@@ -3311,31 +3436,17 @@ STATIC_UNIT_TESTED void cliGet(char *cmdline)
 
     backupAndResetConfigs();
 
-    for (uint32_t i = 0; i < valueTableEntryCount; i++) {
-        if (strcasestr(valueTable[i].name, cmdline)) {
-            val = &valueTable[i];
-            if (matchedCommands > 0) {
-                cliPrintLinefeed();
-            }
-            cliPrintf("%s = ", valueTable[i].name);
-            cliPrintVar(val, 0);
-            cliPrintLinefeed();
-            switch (val->type & VALUE_SECTION_MASK) {
-            case PROFILE_VALUE:
-                cliProfile("");
-
-                break;
-            case PROFILE_RATE_VALUE:
-                cliRateProfile("");
-
-                break;
-            default:
-
-                break;
+    // a whole setting name only shows that setting, anything else shows every setting containing it
+    const clivalue_t *val = cliFindValue(cmdline, strlen(cmdline));
+    if (val) {
+        cliGetVar(val, matchedCommands);
+        matchedCommands++;
+    } else {
+        for (uint32_t i = 0; i < valueTableEntryCount; i++) {
+            if (strcasestr(valueTable[i].name, cmdline)) {
+                cliGetVar(&valueTable[i], matchedCommands);
+                matchedCommands++;
             }
-            cliPrintVarRange(val);
-            cliPrintVarDefault(val);
-            matchedCommands++;
         }
     }
 
@@ -3383,11 +3494,10 @@ STATIC_UNIT_TESTED void cliSet(char *cmdline)
         eqptr++;
         eqptr = skipSpace(eqptr);
 
-        for (uint32_t i = 0; i < valueTableEntryCount; i++) {
-            const clivalue_t *val = &valueTable[i];
-
-            // ensure exact match when setting to prevent setting variables with shorter names
-            if (strncasecmp(cmdline, val->name, strlen(val->name)) == 0 && variableNameLength == strlen(val->name)) {
+        {
+            // exact match only, to prevent setting variables with shorter names
+            const clivalue_t *val = cliFindValue(cmdline, variableNameLength);
+            if (val) {
 
                 bool valueChanged = false;
                 int16_t value  = 0;
@@ -79,7 +79,10 @@
 
 #include "interface/msp.h"
 #include "interface/msp_box.h"
+#include "interface/msp_dataflash.h"
+#include "interface/msp_dispatch.h"
 #include "interface/msp_protocol.h"
+#include "interface/msp_settings.h"
 
 #include "io/asyncfatfs/asyncfatfs.h"
 #include "io/beeper.h"
@@ -338,11 +341,6 @@ static void serializeDataflashSummaryReply(sbuf_t *dst)
 }
 
 #ifdef USE_FLASHFS
-enum compressionType_e {
-    NO_COMPRESSION,
-    HUFFMAN
-};
-
 static void serializeDataflashReadReply(sbuf_t *dst, uint32_t address, const uint16_t size, bool useLegacyFormat, bool allowCompression)
 {
     STATIC_ASSERT(MSP_PORT_DATAFLASH_INFO_SIZE >= 16, MSP_PORT_DATAFLASH_INFO_SIZE_invalid);
@@ -375,7 +373,7 @@ static void serializeDataflashReadReply(sbuf_t *dst, uint32_t address, const uin
             sbufWriteU8(dst, 0); // placeholder for compression format
         }
 
-        const int bytesRead = flashfsReadAbs(address, sbufPtr(dst), readLen);
+        const int bytesRead = flashfsReadLog(address, sbufPtr(dst), readLen);
 
         sbufAdvance(dst, bytesRead);
 
@@ -402,7 +400,7 @@ static void serializeDataflashReadReply(sbuf_t *dst, uint32_t address, const uin
         uint16_t bytesReadTotal = 0;
         // read until output buffer overflows or flash is exhausted
         while (state.bytesWritten < state.outBufLen && address + bytesReadTotal < flashfsSize) {
-            const int bytesRead = flashfsReadAbs(address + bytesReadTotal, readBuffer,
+            const int bytesRead = flashfsReadLog(address + bytesReadTotal, readBuffer,
                 MIN(sizeof(readBuffer), flashfsSize - address - bytesReadTotal));
 
             const int status = huffmanEncodeBufStreaming(&state, readBuffer, bytesRead, huffmanTable);
@@ -427,6 +425,7 @@ static void serializeDataflashReadReply(sbuf_t *dst, uint32_t address, const uin
 #endif
     }
 }
+
 #endif // USE_FLASHFS
 
 /*
@@ -1380,12 +1379,58 @@ static bool mspProcessOutCommand(uint8_t cmdMSP, sbuf_t *dst)
 
         break;
 #endif
+#ifdef USE_MSP_SETTINGS
+    case MSP_SETTINGS_INFO:
+        mspSettingsSerializeInfo(dst);
+
+        break;
+#endif
     default:
         unsupportedCommand = true;
     }
     return !unsupportedCommand;
 }
 
+#ifdef USE_MSP_SUBSCRIPTIONS
+/*
+ * Replace the subscriptions of the port the request arrived on, an empty request ends them.
+ *
+ * Request: (u8 command, u16 interval in ms) for each subscription
+ * Reply:   u8 subscription count
+ *
+ * Only commands that take no arguments and only report state can be subscribed to. The replies are pushed as they
+ * would be sent to a request, with the port's MSP version, at most every interval.
+ */
+static mspResult_e mspFcSubscribeCommand(sbuf_t *dst, sbuf_t *src)
+{
+    const int subscriptionSize = sizeof(uint8_t) + sizeof(uint16_t);
+    const int count = sbufBytesRemaining(src) / subscriptionSize;
+    if (sbufBytesRemaining(src) % subscriptionSize || count > MSP_MAX_SUBSCRIPTIONS) {
+        return MSP_RESULT_ERROR;
+    }
+
+    mspSubscription_t subscriptions[MSP_MAX_SUBSCRIPTIONS];
+    for (int i = 0; i < count; i++) {
+        subscriptions[i].cmd = sbufReadU8(src);
+        subscriptions[i].intervalMs = sbufReadU16(src);
+
+        const mspCommand_t *command = mspFindCommand(subscriptions[i].cmd);
+        if (!command || (command->handler != MSP_HANDLER_COMMON_OUT && command->handler != MSP_HANDLER_OUT)
+            || subscriptions[i].intervalMs < MSP_SUBSCRIPTION_MIN_INTERVAL_MS) {
+            return MSP_RESULT_ERROR;
+        }
+    }
+
+    if (!mspSerialSetSubscriptions(subscriptions, count)) {
+        return MSP_RESULT_ERROR;
+    }
+
+    sbufWriteU8(dst, count);
+
+    return MSP_RESULT_ACK;
+}
+#endif
+
 static mspResult_e mspFcProcessOutCommandWithArg(uint8_t cmdMSP, sbuf_t *src, sbuf_t *dst, mspPostProcessFnPtr *mspPostProcessFn)
 {
 
@@ -1438,38 +1483,35 @@ static mspResult_e mspFcProcessOutCommandWithArg(uint8_t cmdMSP, sbuf_t *src, sb
         break;
     case MSP_MULTIPLE_MSP:
         {
-            uint8_t maxMSPs = 0;
-            if (sbufBytesRemaining(src) == 0) {
-                return MSP_RESULT_ERROR;
-            }
-            int bytesRemaining = sbufBytesRemaining(dst) - 1; // need to keep one byte for checksum
+            // Each reply is preceded by its length, and a byte is kept for the checksum
+            uint8_t *end = dst->end - 1;
             mspPacket_t packetIn, packetOut;
             sbufInit(&packetIn.buf, src->end, src->end);
-            uint8_t* resetInputPtr = src->ptr;
-            while (sbufBytesRemaining(src) && bytesRemaining > 0) {
-                uint8_t newMSP = sbufReadU8(src);
-                sbufInit(&packetOut.buf, dst->ptr, dst->end);
-                packetIn.cmd = newMSP;
-                mspFcProcessCommand(&packetIn, &packetOut, NULL);
-                uint8_t mspSize = sbufPtr(&packetOut.buf) - dst->ptr;
-                mspSize++; // need to add length information for each MSP
-                bytesRemaining -= mspSize;
-                if (bytesRemaining >= 0) {
-                    maxMSPs++;
-                }
-            }
-            src->ptr = resetInputPtr;
-            sbufInit(&packetOut.buf, dst->ptr, dst->end);
-            for (int i = 0; i < maxMSPs; i++) {
-                uint8_t* sizePtr = sbufPtr(&packetOut.buf);
-                sbufWriteU8(&packetOut.buf, 0); // dummy
+            while (sbufBytesRemaining(src) && dst->ptr < end) {
+                uint8_t *sizePtr = dst->ptr;
                 packetIn.cmd = sbufReadU8(src);
+                sbufInit(&packetOut.buf, sizePtr + 1, end);
                 mspFcProcessCommand(&packetIn, &packetOut, NULL);
-                (*sizePtr) = sbufPtr(&packetOut.buf) - (sizePtr + 1);
+                const int mspSize = sbufPtr(&packetOut.buf) - (sizePtr + 1);
+                if (sbufPtr(&packetOut.buf) > end || mspSize > UINT8_MAX) {
+                    // Doesn't fit, leave it and the ones after it out
+                    break;
+                }
+                *sizePtr = mspSize;
+                dst->ptr = sbufPtr(&packetOut.buf);
             }
-            dst->ptr = packetOut.buf.ptr;
         }
         break;
+#ifdef USE_MSP_SETTINGS
+    case MSP_SETTINGS_SCHEMA:
+        return mspSettingsSerializeSchema(dst, src);
+    case MSP_SETTINGS_READ:
+        return mspSettingsRead(dst, src);
+#endif
+#ifdef USE_MSP_SUBSCRIPTIONS
+    case MSP_SUBSCRIBE:
+        return mspFcSubscribeCommand(dst, src);
+#endif
     default:
         return MSP_RESULT_CMD_UNKNOWN;
     }
@@ -1505,6 +1547,10 @@ static mspResult_e mspProcessInCommand(uint8_t cmdMSP, sbuf_t *src)
     uint8_t value;
     const unsigned int dataSize = sbufBytesRemaining(src);
     switch (cmdMSP) {
+#ifdef USE_MSP_SETTINGS
+    case MSP_SET_SETTINGS:
+        return mspSettingsWrite(src);
+#endif
     case MSP_SELECT_SETTING:
         value = sbufReadU8(src);
         if ((value & RATEPROFILE_MASK) == 0) {
@@ -1914,27 +1960,19 @@ static mspResult_e mspProcessInCommand(uint8_t cmdMSP, sbuf_t *src)
         break;
 
     case MSP_RESET_CONF:
-        if (!ARMING_FLAG(ARMED)) {
-            resetEEPROM();
-            readEEPROM();
-        }
+        resetEEPROM();
+        readEEPROM();
         break;
 
     case MSP_ACC_CALIBRATION:
-        if (!ARMING_FLAG(ARMED))
-            accSetCalibrationCycles(CALIBRATING_ACC_CYCLES);
+        accSetCalibrationCycles(CALIBRATING_ACC_CYCLES);
         break;
 
     case MSP_MAG_CALIBRATION:
-        if (!ARMING_FLAG(ARMED))
-            ENABLE_STATE(CALIBRATE_MAG);
+        ENABLE_STATE(CALIBRATE_MAG);
         break;
 
     case MSP_EEPROM_WRITE:
-        if (ARMING_FLAG(ARMED)) {
-            return MSP_RESULT_ERROR;
-        }
-
         if (featureMaskIsCopied) {
             writeEEPROMWithFeatures(featureMaskCopy);
         } else {
@@ -2005,10 +2043,6 @@ static mspResult_e mspProcessInCommand(uint8_t cmdMSP, sbuf_t *src)
 #ifdef USE_CAMERA_CONTROL
     case MSP_CAMERA_CONTROL:
         {
-            if (ARMING_FLAG(ARMED)) {
-                return MSP_RESULT_ERROR;
-            }
-
             const uint8_t key = sbufReadU8(src);
             cameraControlKeyPress(key, 0);
         }
@@ -2506,36 +2540,66 @@ static mspResult_e mspCommonProcessInCommand(uint8_t cmdMSP, sbuf_t *src, mspPos
     return MSP_RESULT_ACK;
 }
 
+static mspResult_e mspFcDispatchCommand(const mspCommand_t *command, sbuf_t *dst, sbuf_t *src, mspPostProcessFnPtr *mspPostProcessFn)
+{
+    const uint8_t cmdMSP = command->cmd;
+
+    switch (command->handler) {
+    case MSP_HANDLER_COMMON_OUT:
+        return mspCommonProcessOutCommand(cmdMSP, dst, mspPostProcessFn) ? MSP_RESULT_ACK : MSP_RESULT_ERROR;
+    case MSP_HANDLER_OUT:
+        return mspProcessOutCommand(cmdMSP, dst) ? MSP_RESULT_ACK : MSP_RESULT_ERROR;
+    case MSP_HANDLER_OUT_WITH_ARG: {
+        const mspResult_e ret = mspFcProcessOutCommandWithArg(cmdMSP, src, dst, mspPostProcessFn);
+
+        return ret == MSP_RESULT_CMD_UNKNOWN ? MSP_RESULT_ERROR : ret;
+    }
+#ifdef USE_SERIAL_4WAY_BLHELI_INTERFACE
+    case MSP_HANDLER_4WAY_IF:
+        mspFc4waySerialCommand(dst, src, mspPostProcessFn);
+
+        return MSP_RESULT_ACK;
+#endif
+#ifdef USE_FLASHFS
+    case MSP_HANDLER_DATAFLASH_READ:
+        mspFcDataFlashReadCommand(dst, src);
+
+        return MSP_RESULT_ACK;
+#endif
+#ifdef USE_MSP_DATAFLASH_STREAM
+    case MSP_HANDLER_DATAFLASH_READ_STREAM:
+        return mspDataflashReadStreamCommand(dst, src);
+#endif
+    case MSP_HANDLER_COMMON_IN:
+    case MSP_HANDLER_IN:
+        return command->handler == MSP_HANDLER_COMMON_IN ? mspCommonProcessInCommand(cmdMSP, src, mspPostProcessFn) : mspProcessInCommand(cmdMSP, src);
+    default:
+        return MSP_RESULT_ERROR;
+    }
+}
+
 /*
  * Returns MSP_RESULT_ACK, MSP_RESULT_ERROR or MSP_RESULT_NO_REPLY
  */
 mspResult_e mspFcProcessCommand(mspPacket_t *cmd, mspPacket_t *reply, mspPostProcessFnPtr *mspPostProcessFn)
 {
-    int ret = MSP_RESULT_ACK;
+    mspResult_e ret;
     sbuf_t *dst = &reply->buf;
     sbuf_t *src = &cmd->buf;
     const uint8_t cmdMSP = cmd->cmd;
     // initialize reply by default
     reply->cmd = cmd->cmd;
 
-    if (mspCommonProcessOutCommand(cmdMSP, dst, mspPostProcessFn)) {
-        ret = MSP_RESULT_ACK;
-    } else if (mspProcessOutCommand(cmdMSP, dst)) {
-        ret = MSP_RESULT_ACK;
-    } else if ((ret = mspFcProcessOutCommandWithArg(cmdMSP, src, dst, mspPostProcessFn)) != MSP_RESULT_CMD_UNKNOWN) {
-        /* ret */;
-#ifdef USE_SERIAL_4WAY_BLHELI_INTERFACE
-    } else if (cmdMSP == MSP_SET_4WAY_IF) {
-        mspFc4waySerialCommand(dst, src, mspPostProcessFn);
-        ret = MSP_RESULT_ACK;
-#endif
-#ifdef USE_FLASHFS
-    } else if (cmdMSP == MSP_DATAFLASH_READ) {
-        mspFcDataFlashReadCommand(dst, src);
-        ret = MSP_RESULT_ACK;
-#endif
+    const mspCommand_t *command = mspFindCommand(cmdMSP);
+    if (!command) {
+        // we do not know how to handle the (valid) message, indicate error MSP $M!
+        ret = MSP_RESULT_ERROR;
+    } else if (sbufBytesRemaining(src) < command->minPayloadSize) {
+        ret = MSP_RESULT_ERROR;
+    } else if ((command->flags & MSP_COMMAND_DISARMED_ONLY) && ARMING_FLAG(ARMED)) {
+        ret = MSP_RESULT_ERROR;
     } else {
-        ret = mspCommonProcessInCommand(cmdMSP, src, mspPostProcessFn);
+        ret = mspFcDispatchCommand(command, dst, src, mspPostProcessFn);
     }
     reply->result = ret;
     return ret;
@@ -58,6 +58,9 @@ struct serialPort_s;
 typedef void (*mspPostProcessFnPtr)(struct serialPort_s *port); // msp post process function, used for gracefully handling reboots, etc.
 typedef mspResult_e (*mspProcessCommandFnPtr)(mspPacket_t *cmd, mspPacket_t *reply, mspPostProcessFnPtr *mspPostProcessFn);
 typedef void (*mspProcessReplyFnPtr)(mspPacket_t *cmd);
+// Fill in the next frame of a stream that's being pushed to the client. Returns MSP_RESULT_ACK to send the frame,
+// MSP_RESULT_NO_REPLY if there's nothing to send yet, or MSP_RESULT_ERROR once the stream has ended.
+typedef mspResult_e (*mspStreamFnPtr)(mspPacket_t *frame);
 
 
 void mspInit(void);
@@ -0,0 +1,235 @@
+/*
+ * This file is part of Cleanflight and Betaflight.
+ *
+ * Cleanflight and Betaflight are free software. You can redistribute
+ * this software and/or modify this software under the terms of the
+ * GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Cleanflight and Betaflight are distributed in the hope that they
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software.
+ *
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "platform.h"
+
+#ifdef USE_MSP_DATAFLASH_STREAM
+
+#include "common/huffman.h"
+#include "common/maths.h"
+#include "common/rle.h"
+#include "common/streambuf.h"
+#include "common/utils.h"
+
+#include "fc/runtime_config.h"
+
+#include "interface/msp_dataflash.h"
+#include "interface/msp_protocol.h"
+
+#include "io/flashfs.h"
+
+#include "msp/msp_serial.h"
+
+// Small frames keep the acknowledgements flowing and the frames fitting in the port's transmit buffer
+#define DATAFLASH_STREAM_CHUNK_SIZE 1024
+#define DATAFLASH_STREAM_MAX_WINDOW 16
+#define DATAFLASH_STREAM_FRAME_HEADER_SIZE 9
+
+enum {
+    DATAFLASH_STREAM_START,
+    DATAFLASH_STREAM_ACK,
+    DATAFLASH_STREAM_STOP
+};
+
+static struct {
+    bool active;
+    uint32_t address;           // Where the next frame's content comes from
+    uint32_t endAddress;
+    uint16_t sequence;          // Sequence number of the next frame
+    uint16_t acknowledged;      // The client has received every frame before this one
+    uint8_t window;             // How many frames may be awaiting acknowledgement
+    uint8_t compressionMethods; // Bitmask of the compressionType_e the client can decode
+} dataflashStream;
+
+static uint8_t dataflashStreamBuffer[DATAFLASH_STREAM_CHUNK_SIZE];
+
+static uint8_t dataflashStreamSupportedCompression(void)
+{
+    uint8_t methods = BIT(NO_COMPRESSION) | BIT(RUN_LENGTH);
+#ifdef USE_HUFFMAN
+    methods |= BIT(HUFFMAN);
+#endif
+    return methods;
+}
+
+/*
+ * Write the chunk using whichever of the client's compression methods makes it smallest. The static encodings let us
+ * work that out cheaply before committing to one.
+ */
+static void serializeDataflashStreamChunk(sbuf_t *dst, const uint8_t *data, int len)
+{
+    uint8_t compressionMethod = NO_COMPRESSION;
+    int encodedLen = len;
+
+#ifdef USE_HUFFMAN
+    if (dataflashStream.compressionMethods & BIT(HUFFMAN)) {
+        const int huffmanLen = huffmanEncodedLength(data, len, huffmanTable);
+
+        if (huffmanLen < encodedLen) {
+            compressionMethod = HUFFMAN;
+            encodedLen = huffmanLen;
+        }
+    }
+#endif
+
+    if (dataflashStream.compressionMethods & BIT(RUN_LENGTH)) {
+        const int runLengthLen = rleEncodeBuf(NULL, 0, data, len);
+
+        if (runLengthLen < encodedLen) {
+            compressionMethod = RUN_LENGTH;
+            encodedLen = runLengthLen;
+        }
+    }
+
+    sbufWriteU8(dst, compressionMethod);
+
+    switch (compressionMethod) {
+#ifdef USE_HUFFMAN
+    case HUFFMAN:
+        huffmanEncodeBuf(sbufPtr(dst), encodedLen, data, len, huffmanTable);
+        break;
+#endif
+    case RUN_LENGTH:
+        rleEncodeBuf(sbufPtr(dst), encodedLen, data, len);
+        break;
+    default:
+        memcpy(sbufPtr(dst), data, len);
+        break;
+    }
+
+    sbufAdvance(dst, encodedLen);
+}
+
+/*
+ * Produce the next frame of the dataflash stream:
+ *
+ *     u16 sequence, u32 address, u16 uncompressed length, u8 compression method, content
+ *
+ * A frame with no content marks the end of the stream.
+ */
+static mspResult_e mspFcDataflashStreamFrame(mspPacket_t *frame)
+{
+    sbuf_t *dst = &frame->buf;
+
+    if (!dataflashStream.active || ARMING_FLAG(ARMED)) {
+        dataflashStream.active = false;
+        return MSP_RESULT_ERROR;
+    }
+
+    if ((uint16_t)(dataflashStream.sequence - dataflashStream.acknowledged) >= dataflashStream.window) {
+        // Wait for the client to catch up
+        return MSP_RESULT_NO_REPLY;
+    }
+
+    int readLen = MIN(DATAFLASH_STREAM_CHUNK_SIZE, sbufBytesRemaining(dst) - DATAFLASH_STREAM_FRAME_HEADER_SIZE);
+    if ((uint32_t)readLen > dataflashStream.endAddress - dataflashStream.address) {
+        readLen = dataflashStream.endAddress - dataflashStream.address;
+    }
+
+    const int bytesRead = readLen > 0 ? flashfsReadLog(dataflashStream.address, dataflashStreamBuffer, readLen) : 0;
+
+    frame->cmd = MSP_DATAFLASH_READ_STREAM;
+    sbufWriteU16(dst, dataflashStream.sequence++);
+    sbufWriteU32(dst, dataflashStream.address);
+    sbufWriteU16(dst, bytesRead);
+
+    if (bytesRead > 0) {
+        serializeDataflashStreamChunk(dst, dataflashStreamBuffer, bytesRead);
+
+        dataflashStream.address += bytesRead;
+    } else {
+        sbufWriteU8(dst, NO_COMPRESSION);
+
+        dataflashStream.active = false;
+    }
+
+    return MSP_RESULT_ACK;
+}
+
+/*
+ * Rather than the client requesting each chunk in turn, the content is pushed to it in a stream of frames. The client
+ * acknowledges frames as they arrive, and up to "window" frames are sent ahead of the acknowledgements.
+ *
+ * Start: u8 0, u32 address, u32 length, u8 window, u8 bitmask of compression methods the client can decode
+ *        Replies with u16 maximum content per frame, u8 window, u8 bitmask of compression methods we support
+ * Ack:   u8 1, u16 sequence number of the next frame expected (no reply)
+ * Stop:  u8 2
+ */
+mspResult_e mspDataflashReadStreamCommand(sbuf_t *dst, sbuf_t *src)
+{
+    if (sbufBytesRemaining(src) < 1) {
+        return MSP_RESULT_ERROR;
+    }
+
+    switch (sbufReadU8(src)) {
+    case DATAFLASH_STREAM_START: {
+        if (sbufBytesRemaining(src) < 10 || !flashfsIsReady() || ARMING_FLAG(ARMED)) {
+            return MSP_RESULT_ERROR;
+        }
+
+        const uint32_t address = sbufReadU32(src);
+        const uint32_t length = sbufReadU32(src);
+        const uint8_t window = sbufReadU8(src);
+        const uint8_t compressionMethods = sbufReadU8(src);
+        const uint32_t flashfsSize = flashfsGetSize();
+
+        if (address > flashfsSize || !mspSerialBeginStream(mspFcDataflashStreamFrame)) {
+            return MSP_RESULT_ERROR;
+        }
+
+        dataflashStream.address = address;
+        dataflashStream.endAddress = address + MIN(length, flashfsSize - address);
+        dataflashStream.sequence = 0;
+        dataflashStream.acknowledged = 0;
+        dataflashStream.window = constrain(window, 1, DATAFLASH_STREAM_MAX_WINDOW);
+        dataflashStream.compressionMethods = compressionMethods & dataflashStreamSupportedCompression();
+        dataflashStream.active = true;
+
+        sbufWriteU16(dst, DATAFLASH_STREAM_CHUNK_SIZE);
+        sbufWriteU8(dst, dataflashStream.window);
+        sbufWriteU8(dst, dataflashStreamSupportedCompression());
+
+        return MSP_RESULT_ACK;
+    }
+    case DATAFLASH_STREAM_ACK:
+        if (sbufBytesRemaining(src) >= 2) {
+            const uint16_t nextSequence = sbufReadU16(src);
+
+            // Ignore stale acknowledgements, and ones for frames we haven't sent
+            if ((uint16_t)(nextSequence - dataflashStream.acknowledged) <= (uint16_t)(dataflashStream.sequence - dataflashStream.acknowledged)) {
+                dataflashStream.acknowledged = nextSequence;
+            }
+        }
+
+        return MSP_RESULT_NO_REPLY;
+    case DATAFLASH_STREAM_STOP:
+        dataflashStream.active = false;
+
+        return MSP_RESULT_ACK;
+    default:
+        return MSP_RESULT_ERROR;
+    }
+}
+
+#endif // USE_MSP_DATAFLASH_STREAM
@@ -0,0 +1,34 @@
+/*
+ * This file is part of Cleanflight and Betaflight.
+ *
+ * Cleanflight and Betaflight are free software. You can redistribute
+ * this software and/or modify this software under the terms of the
+ * GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Cleanflight and Betaflight are distributed in the hope that they
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software.
+ *
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "interface/msp.h"
+
+// How flash content is coded in MSP_DATAFLASH_READ replies and MSP_DATAFLASH_READ_STREAM frames
+enum compressionType_e {
+    NO_COMPRESSION,
+    HUFFMAN,
+    RUN_LENGTH
+};
+
+struct sbuf_s;
+
+mspResult_e mspDataflashReadStreamCommand(struct sbuf_s *dst, struct sbuf_s *src);
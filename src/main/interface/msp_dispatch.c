@@ -0,0 +1,237 @@
+/*
+ * This file is part of Cleanflight and Betaflight.
+ *
+ * Cleanflight and Betaflight are free software. You can redistribute
+ * this software and/or modify this software under the terms of the
+ * GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Cleanflight and Betaflight are distributed in the hope that they
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software.
+ *
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "platform.h"
+
+#include "build/build_config.h"
+
+#include "common/utils.h"
+
+#include "flight/pid.h"
+
+#include "interface/msp_dispatch.h"
+#include "interface/msp_protocol.h"
+
+#include "io/ledstrip.h"
+
+#include "pg/board.h"
+
+/*
+ * Every command the flight controller handles, sorted by command id so it can be looked up with a binary search
+ * instead of trying each handler's switch in turn.
+ *
+ * Commands that are compiled out are left in the table, their handler refuses them with an error, as it did before.
+ * The minimum payload size is what the handler reads unconditionally, optional trailing fields aren't included.
+ */
+STATIC_UNIT_TESTED const mspCommand_t mspCommandTable[] = {
+    { MSP_API_VERSION,                 MSP_HANDLER_COMMON_OUT,              0,         0 },
+    { MSP_FC_VARIANT,                  MSP_HANDLER_COMMON_OUT,              0,         0 },
+    { MSP_FC_VERSION,                  MSP_HANDLER_COMMON_OUT,              0,         0 },
+    { MSP_BOARD_INFO,                  MSP_HANDLER_COMMON_OUT,              0,         0 },
+    { MSP_BUILD_INFO,                  MSP_HANDLER_COMMON_OUT,              0,         0 },
+    { MSP_NAME,                        MSP_HANDLER_OUT,                     0,         0 },
+    { MSP_SET_NAME,                    MSP_HANDLER_IN,                      0,         0 },
+    { MSP_BATTERY_CONFIG,              MSP_HANDLER_COMMON_OUT,              0,         0 },
+    { MSP_SET_BATTERY_CONFIG,          MSP_HANDLER_COMMON_IN,               7,         0 },
+    { MSP_MODE_RANGES,                 MSP_HANDLER_OUT,                     0,         0 },
+    { MSP_SET_MODE_RANGE,              MSP_HANDLER_IN,                      5,         0 },
+    { MSP_FEATURE_CONFIG,              MSP_HANDLER_COMMON_OUT,              0,         0 },
+    { MSP_SET_FEATURE_CONFIG,          MSP_HANDLER_IN,                      4,         0 },
+    { MSP_BOARD_ALIGNMENT_CONFIG,      MSP_HANDLER_OUT,                     0,         0 },
+    { MSP_SET_BOARD_ALIGNMENT_CONFIG,  MSP_HANDLER_IN,                      6,         0 },
+    { MSP_CURRENT_METER_CONFIG,        MSP_HANDLER_COMMON_OUT,              0,         0 },
+    { MSP_SET_CURRENT_METER_CONFIG,    MSP_HANDLER_COMMON_IN,               5,         0 },
+    { MSP_MIXER_CONFIG,                MSP_HANDLER_OUT,                     0,         0 },
+    { MSP_SET_MIXER_CONFIG,            MSP_HANDLER_IN,                      1,         0 },
+    { MSP_RX_CONFIG,                   MSP_HANDLER_OUT,                     0,         0 },
+    { MSP_SET_RX_CONFIG,               MSP_HANDLER_IN,                      8,         0 },
+    { MSP_LED_COLORS,                  MSP_HANDLER_OUT,                     0,         0 },
+    { MSP_SET_LED_COLORS,              MSP_HANDLER_IN,                      LED_CONFIGURABLE_COLOR_COUNT * 4, 0 },
+    { MSP_LED_STRIP_CONFIG,            MSP_HANDLER_OUT,                     0,         0 },
+    { MSP_SET_LED_STRIP_CONFIG,        MSP_HANDLER_IN,                      5,         0 },
+    { MSP_RSSI_CONFIG,                 MSP_HANDLER_OUT,                     0,         0 },
+    { MSP_SET_RSSI_CONFIG,             MSP_HANDLER_IN,                      1,         0 },
+    { MSP_ADJUSTMENT_RANGES,           MSP_HANDLER_OUT,                     0,         0 },
+    { MSP_SET_ADJUSTMENT_RANGE,        MSP_HANDLER_IN,                      7,         0 },
+    { MSP_CF_SERIAL_CONFIG,            MSP_HANDLER_OUT,                     0,         0 },
+    { MSP_SET_CF_SERIAL_CONFIG,        MSP_HANDLER_IN,                      0,         0 },
+    { MSP_VOLTAGE_METER_CONFIG,        MSP_HANDLER_COMMON_OUT,              0,         0 },
+    { MSP_SET_VOLTAGE_METER_CONFIG,    MSP_HANDLER_COMMON_IN,               4,         0 },
+    { MSP_SONAR_ALTITUDE,              MSP_HANDLER_OUT,                     0,         0 },
+    { MSP_PID_CONTROLLER,              MSP_HANDLER_OUT,                     0,         0 },
+    { MSP_SET_PID_CONTROLLER,          MSP_HANDLER_IN,                      0,         0 },
+    { MSP_ARMING_CONFIG,               MSP_HANDLER_OUT,                     0,         0 },
+    { MSP_SET_ARMING_CONFIG,           MSP_HANDLER_IN,                      2,         0 },
+    { MSP_RX_MAP,                      MSP_HANDLER_OUT,                     0,         0 },
+    { MSP_SET_RX_MAP,                  MSP_HANDLER_IN,                      RX_MAPPABLE_CHANNEL_COUNT, 0 },
+    { MSP_REBOOT,                      MSP_HANDLER_OUT_WITH_ARG,            0,         MSP_COMMAND_DISARMED_ONLY },
+    { MSP_DATAFLASH_SUMMARY,           MSP_HANDLER_OUT,                     0,         0 },
+    { MSP_DATAFLASH_READ,              MSP_HANDLER_DATAFLASH_READ,          4,         0 },
+    { MSP_DATAFLASH_ERASE,             MSP_HANDLER_IN,                      0,         MSP_COMMAND_DISARMED_ONLY },
+    { MSP_FAILSAFE_CONFIG,             MSP_HANDLER_OUT,                     0,         0 },
+    { MSP_SET_FAILSAFE_CONFIG,         MSP_HANDLER_IN,                      8,         0 },
+    { MSP_RXFAIL_CONFIG,               MSP_HANDLER_OUT,                     0,         0 },
+    { MSP_SET_RXFAIL_CONFIG,           MSP_HANDLER_IN,                      4,         0 },
+    { MSP_SDCARD_SUMMARY,              MSP_HANDLER_OUT,                     0,         0 },
+    { MSP_BLACKBOX_CONFIG,             MSP_HANDLER_OUT,                     0,         0 },
+    { MSP_SET_BLACKBOX_CONFIG,         MSP_HANDLER_IN,                      3,         0 },
+    { MSP_TRANSPONDER_CONFIG,          MSP_HANDLER_COMMON_OUT,              0,         0 },
+    { MSP_SET_TRANSPONDER_CONFIG,      MSP_HANDLER_COMMON_IN,               1,         0 },
+    { MSP_OSD_CONFIG,                  MSP_HANDLER_COMMON_OUT,              0,         0 },
+    { MSP_SET_OSD_CONFIG,              MSP_HANDLER_COMMON_IN,               1,         0 },
+    { MSP_OSD_CHAR_WRITE,              MSP_HANDLER_COMMON_IN,               55,        0 },
+    { MSP_VTX_CONFIG,                  MSP_HANDLER_OUT,                     0,         0 },
+    { MSP_SET_VTX_CONFIG,              MSP_HANDLER_IN,                      2,         0 },
+    { MSP_ADVANCED_CONFIG,             MSP_HANDLER_OUT,                     0,         0 },
+    { MSP_SET_ADVANCED_CONFIG,         MSP_HANDLER_IN,                      6,         0 },
+    { MSP_FILTER_CONFIG,               MSP_HANDLER_OUT,                     0,         0 },
+    { MSP_SET_FILTER_CONFIG,           MSP_HANDLER_IN,                      5,         0 },
+    { MSP_PID_ADVANCED,                MSP_HANDLER_OUT,                     0,         0 },
+    { MSP_SET_PID_ADVANCED,            MSP_HANDLER_IN,                      17,        0 },
+    { MSP_SENSOR_CONFIG,               MSP_HANDLER_OUT,                     0,         0 },
+    { MSP_SET_SENSOR_CONFIG,           MSP_HANDLER_IN,                      3,         0 },
+    { MSP_CAMERA_CONTROL,              MSP_HANDLER_IN,                      1,         MSP_COMMAND_DISARMED_ONLY },
+    { MSP_SET_ARMING_DISABLED,         MSP_HANDLER_IN,                      1,         0 },
+    { MSP_STATUS,                      MSP_HANDLER_OUT,                     0,         0 },
+    { MSP_RAW_IMU,                     MSP_HANDLER_OUT,                     0,         0 },
+    { MSP_SERVO,                       MSP_HANDLER_OUT,                     0,         0 },
+    { MSP_MOTOR,                       MSP_HANDLER_OUT,                     0,         0 },
+    { MSP_RC,                          MSP_HANDLER_OUT,                     0,         0 },
+    { MSP_RAW_GPS,                     MSP_HANDLER_OUT,                     0,         0 },
+    { MSP_COMP_GPS,                    MSP_HANDLER_OUT,                     0,         0 },
+    { MSP_ATTITUDE,                    MSP_HANDLER_OUT,                     0,         0 },
+    { MSP_ALTITUDE,                    MSP_HANDLER_OUT,                     0,         0 },
+    { MSP_ANALOG,                      MSP_HANDLER_COMMON_OUT,              0,         0 },
+    { MSP_RC_TUNING,                   MSP_HANDLER_OUT,                     0,         0 },
+    { MSP_PID,                         MSP_HANDLER_OUT,                     0,         0 },
+    { MSP_BOXNAMES,                    MSP_HANDLER_OUT_WITH_ARG,            0,         0 },
+    { MSP_PIDNAMES,                    MSP_HANDLER_OUT,                     0,         0 },
+    { MSP_BOXIDS,                      MSP_HANDLER_OUT_WITH_ARG,            0,         0 },
+    { MSP_SERVO_CONFIGURATIONS,        MSP_HANDLER_OUT,                     0,         0 },
+    { MSP_MOTOR_3D_CONFIG,             MSP_HANDLER_OUT,                     0,         0 },
+    { MSP_RC_DEADBAND,                 MSP_HANDLER_OUT,                     0,         0 },
+    { MSP_SENSOR_ALIGNMENT,            MSP_HANDLER_OUT,                     0,         0 },
+    { MSP_LED_STRIP_MODECOLOR,         MSP_HANDLER_OUT,                     0,         0 },
+    { MSP_VOLTAGE_METERS,              MSP_HANDLER_COMMON_OUT,              0,         0 },
+    { MSP_CURRENT_METERS,              MSP_HANDLER_COMMON_OUT,              0,         0 },
+    { MSP_BATTERY_STATE,               MSP_HANDLER_COMMON_OUT,              0,         0 },
+    { MSP_MOTOR_CONFIG,                MSP_HANDLER_OUT,                     0,         0 },
+    { MSP_GPS_CONFIG,                  MSP_HANDLER_OUT,                     0,         0 },
+    { MSP_COMPASS_CONFIG,              MSP_HANDLER_OUT,                     0,         0 },
+    { MSP_ESC_SENSOR_DATA,             MSP_HANDLER_OUT,                     0,         0 },
+    { MSP_GPS_RESCUE,                  MSP_HANDLER_OUT,                     0,         0 },
+    { MSP_GPS_RESCUE_PIDS,             MSP_HANDLER_OUT,                     0,         0 },
+    { MSP_DATAFLASH_READ_STREAM,       MSP_HANDLER_DATAFLASH_READ_STREAM,   1,         0 },
+    { MSP_SETTINGS_INFO,               MSP_HANDLER_OUT,                     0,         0 },
+    { MSP_SETTINGS_SCHEMA,             MSP_HANDLER_OUT_WITH_ARG,            2,         0 },
+    { MSP_SETTINGS_READ,               MSP_HANDLER_OUT_WITH_ARG,            2,         0 },
+    { MSP_SUBSCRIBE,                   MSP_HANDLER_OUT_WITH_ARG,            0,         0 },
+    { MSP_STATUS_EX,                   MSP_HANDLER_OUT,                     0,         0 },
+    { MSP_UID,                         MSP_HANDLER_COMMON_OUT,              0,         0 },
+    { MSP_GPSSVINFO,                   MSP_HANDLER_OUT,                     0,         0 },
+    { MSP_COPY_PROFILE,                MSP_HANDLER_IN,                      3,         0 },
+    { MSP_BEEPER_CONFIG,               MSP_HANDLER_COMMON_OUT,              0,         0 },
+    { MSP_SET_BEEPER_CONFIG,           MSP_HANDLER_IN,                      4,         0 },
+    { MSP_SET_TX_INFO,                 MSP_HANDLER_IN,                      1,         0 },
+    { MSP_TX_INFO,                     MSP_HANDLER_OUT,                     0,         0 },
+    { MSP_SET_RAW_RC,                  MSP_HANDLER_IN,                      0,         0 },
+    { MSP_SET_RAW_GPS,                 MSP_HANDLER_IN,                      14,        0 },
+    { MSP_SET_PID,                     MSP_HANDLER_IN,                      PID_ITEM_COUNT * 3, 0 },
+    { MSP_SET_RC_TUNING,               MSP_HANDLER_IN,                      10,        0 },
+    { MSP_ACC_CALIBRATION,             MSP_HANDLER_IN,                      0,         MSP_COMMAND_DISARMED_ONLY },
+    { MSP_MAG_CALIBRATION,             MSP_HANDLER_IN,                      0,         MSP_COMMAND_DISARMED_ONLY },
+    { MSP_RESET_CONF,                  MSP_HANDLER_IN,                      0,         MSP_COMMAND_DISARMED_ONLY },
+    { MSP_SELECT_SETTING,              MSP_HANDLER_IN,                      1,         0 },
+    { MSP_SET_HEADING,                 MSP_HANDLER_IN,                      2,         0 },
+    { MSP_SET_SERVO_CONFIGURATION,     MSP_HANDLER_IN,                      13,        0 },
+    { MSP_SET_MOTOR,                   MSP_HANDLER_IN,                      0,         0 },
+    { MSP_SET_MOTOR_3D_CONFIG,         MSP_HANDLER_IN,                      6,         0 },
+    { MSP_SET_RC_DEADBAND,             MSP_HANDLER_IN,                      5,         0 },
+    { MSP_SET_RESET_CURR_PID,          MSP_HANDLER_IN,                      0,         0 },
+    { MSP_SET_SENSOR_ALIGNMENT,        MSP_HANDLER_IN,                      3,         0 },
+    { MSP_SET_LED_STRIP_MODECOLOR,     MSP_HANDLER_IN,                      3,         0 },
+    { MSP_SET_MOTOR_CONFIG,            MSP_HANDLER_IN,                      6,         0 },
+    { MSP_SET_GPS_CONFIG,              MSP_HANDLER_IN,                      4,         0 },
+    { MSP_SET_COMPASS_CONFIG,          MSP_HANDLER_IN,                      2,         0 },
+    { MSP_SET_GPS_RESCUE,              MSP_HANDLER_IN,                      16,        0 },
+    { MSP_SET_GPS_RESCUE_PIDS,         MSP_HANDLER_IN,                      14,        0 },
+    { MSP_SET_SETTINGS,                MSP_HANDLER_IN,                      2,         0 },
+    { MSP_MULTIPLE_MSP,                MSP_HANDLER_OUT_WITH_ARG,            1,         0 },
+    { MSP_SET_ACC_TRIM,                MSP_HANDLER_IN,                      4,         0 },
+    { MSP_ACC_TRIM,                    MSP_HANDLER_OUT,                     0,         0 },
+    { MSP_SERVO_MIX_RULES,             MSP_HANDLER_OUT,                     0,         0 },
+    { MSP_SET_SERVO_MIX_RULE,          MSP_HANDLER_IN,                      8,         0 },
+    { MSP_SET_4WAY_IF,                 MSP_HANDLER_4WAY_IF,                 0,         MSP_COMMAND_DISARMED_ONLY },
+    { MSP_SET_RTC,                     MSP_HANDLER_IN,                      6,         0 },
+    { MSP_RTC,                         MSP_HANDLER_OUT,                     0,         0 },
+    { MSP_SET_BOARD_INFO,              MSP_HANDLER_IN,                      2,         0 },
+    { MSP_SET_SIGNATURE,               MSP_HANDLER_IN,                      SIGNATURE_LENGTH, 0 },
+    { MSP_EEPROM_WRITE,                MSP_HANDLER_IN,                      0,         MSP_COMMAND_DISARMED_ONLY },
+    { MSP_DEBUG,                       MSP_HANDLER_COMMON_OUT,              0,         0 },
+};
+
+STATIC_UNIT_TESTED const unsigned mspCommandCount = ARRAYLEN(mspCommandTable);
+
+const mspCommand_t *mspFindCommand(uint8_t cmd)
+{
+    unsigned low = 0;
+    unsigned high = mspCommandCount;
+
+    while (low < high) {
+        const unsigned mid = (low + high) / 2;
+        if (mspCommandTable[mid].cmd < cmd) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+
+    if (low < mspCommandCount && mspCommandTable[low].cmd == cmd) {
+        return &mspCommandTable[low];
+    }
+
+    return NULL;
+}
+
+/*
+ * Returns true if running the command again gives the same reply and changes nothing, the serial port relies on
+ * that to answer a query again when its reply didn't fit the first time. Unknown commands only get an error reply.
+ */
+bool mspCommandIsQuery(uint8_t cmd)
+{
+    const mspCommand_t *command = mspFindCommand(cmd);
+
+    if (!command) {
+        return true;
+    }
+
+    switch (command->handler) {
+    case MSP_HANDLER_COMMON_IN:
+    case MSP_HANDLER_IN:
+    case MSP_HANDLER_4WAY_IF:
+    case MSP_HANDLER_DATAFLASH_READ_STREAM:
+        return false;
+    default:
+        return true;
+    }
+}
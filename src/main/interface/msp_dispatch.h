@@ -0,0 +1,49 @@
+/*
+ * This file is part of Cleanflight and Betaflight.
+ *
+ * Cleanflight and Betaflight are free software. You can redistribute
+ * this software and/or modify this software under the terms of the
+ * GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Cleanflight and Betaflight are distributed in the hope that they
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software.
+ *
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// The function in msp.c that handles a command
+typedef enum {
+    MSP_HANDLER_COMMON_OUT = 0,
+    MSP_HANDLER_OUT,
+    MSP_HANDLER_OUT_WITH_ARG,
+    MSP_HANDLER_COMMON_IN,
+    MSP_HANDLER_IN,
+    MSP_HANDLER_4WAY_IF,
+    MSP_HANDLER_DATAFLASH_READ,
+    MSP_HANDLER_DATAFLASH_READ_STREAM,
+    MSP_HANDLER_COUNT
+} mspHandler_e;
+
+#define MSP_COMMAND_DISARMED_ONLY   (1 << 0)    // refused with an error while armed
+
+typedef struct mspCommand_s {
+    uint8_t cmd;
+    uint8_t handler;            // mspHandler_e
+    uint8_t minPayloadSize;     // shorter requests are refused before the handler sees them
+    uint8_t flags;
+} mspCommand_t;
+
+const mspCommand_t *mspFindCommand(uint8_t cmd);
+bool mspCommandIsQuery(uint8_t cmd);
@@ -281,6 +281,11 @@
 #define MSP_ESC_SENSOR_DATA      134    //out message         Extra ESC data from 32-Bit ESCs (Temperature, RPM)
 #define MSP_GPS_RESCUE           135    //out message         GPS Rescues's angle, initialAltitude, descentDistance, rescueGroundSpeed, sanityChecks and minSats
 #define MSP_GPS_RESCUE_PIDS      136    //out message         GPS Rescues's throttleP and velocity PIDS + yaw P
+#define MSP_DATAFLASH_READ_STREAM 137   //out message         Start, acknowledge or stop a stream of pushed dataflash content
+#define MSP_SETTINGS_INFO        138    //out message         Number of CLI settings and the hash of their schema
+#define MSP_SETTINGS_SCHEMA      139    //out message         Type, range and name of the CLI settings from a given id
+#define MSP_SETTINGS_READ        140    //out message         Values of a list of CLI settings
+#define MSP_SUBSCRIBE            141    //out message         Set the out messages pushed at regular intervals on this port
 
 #define MSP_SET_RAW_RC           200    //in message          8 rc chan
 #define MSP_SET_RAW_GPS          201    //in message          fix, numsat, lat, lon, alt, speed
@@ -309,6 +314,7 @@
 #define MSP_SET_COMPASS_CONFIG   224    //out message         Compass configuration
 #define MSP_SET_GPS_RESCUE       225    //in message          GPS Rescues's angle, initialAltitude, descentDistance, rescueGroundSpeed, sanityChecks and minSats
 #define MSP_SET_GPS_RESCUE_PIDS  226    //in message          GPS Rescues's throttleP and velocity PIDS + yaw P
+#define MSP_SET_SETTINGS         227    //in message          Values of a list of CLI settings
 
 // #define MSP_BIND                 240    //in message          no param
 // #define MSP_ALARMS               242
@@ -0,0 +1,464 @@
+/*
+ * This file is part of Cleanflight and Betaflight.
+ *
+ * Cleanflight and Betaflight are free software. You can redistribute
+ * this software and/or modify this software under the terms of the
+ * GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Cleanflight and Betaflight are distributed in the hope that they
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software.
+ *
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "platform.h"
+
+#ifdef USE_MSP_SETTINGS
+
+#include "common/hash.h"
+#include "common/maths.h"
+#include "common/streambuf.h"
+
+#include "fc/config.h"
+#include "fc/controlrate_profile.h"
+
+#include "flight/pid.h"
+
+#include "interface/msp_settings.h"
+#include "interface/settings.h"
+
+#include "pg/pg.h"
+
+typedef struct schemaWriter_s {
+    sbuf_t *dst;                // NULL to only measure and hash the schema
+    uint32_t hash;
+    int size;
+} schemaWriter_t;
+
+static uint32_t schemaHash;
+static bool schemaHashValid = false;
+
+static int settingElementSize(const clivalue_t *value)
+{
+    switch (value->type & VALUE_TYPE_MASK) {
+    case VAR_UINT16:
+    case VAR_INT16:
+        return 2;
+    case VAR_UINT32:
+        return 4;
+    default:
+        return 1;
+    }
+}
+
+static int settingElementCount(const clivalue_t *value)
+{
+    return (value->type & VALUE_MODE_MASK) == MODE_ARRAY ? value->config.array.length : 1;
+}
+
+static int settingWireSize(const clivalue_t *value)
+{
+    if ((value->type & VALUE_MODE_MASK) == MODE_BITSET) {
+        return 1;
+    }
+
+    return settingElementSize(value) * settingElementCount(value);
+}
+
+// Range of each element of the setting as accepted by MSP_SET_SETTINGS
+static void settingRange(const clivalue_t *value, int32_t *min, int32_t *max)
+{
+    switch (value->type & VALUE_MODE_MASK) {
+    case MODE_DIRECT:
+        *min = value->config.minmax.min;
+        *max = value->config.minmax.max;
+
+        break;
+    case MODE_LOOKUP:
+        *min = 0;
+        *max = lookupTables[value->config.lookup.tableIndex].valueCount - 1;
+
+        break;
+    case MODE_BITSET:
+        *min = 0;
+        *max = 1;
+
+        break;
+    case MODE_ARRAY:
+    default:
+        switch (value->type & VALUE_TYPE_MASK) {
+        case VAR_INT8:
+            *min = INT8_MIN;
+            *max = INT8_MAX;
+
+            break;
+        case VAR_UINT16:
+            *min = 0;
+            *max = UINT16_MAX;
+
+            break;
+        case VAR_INT16:
+            *min = INT16_MIN;
+            *max = INT16_MAX;
+
+            break;
+        case VAR_UINT32:
+            *min = 0;
+            *max = INT32_MAX;
+
+            break;
+        default:
+            *min = 0;
+            *max = UINT8_MAX;
+
+            break;
+        }
+
+        break;
+    }
+}
+
+static void schemaWrite(schemaWriter_t *writer, const uint8_t *data, int len)
+{
+    writer->hash = fnv1a_update(writer->hash, data, len);
+    writer->size += len;
+
+    if (writer->dst) {
+        sbufWriteData(writer->dst, data, len);
+    }
+}
+
+static void schemaWriteU8(schemaWriter_t *writer, uint8_t value)
+{
+    schemaWrite(writer, &value, sizeof(value));
+}
+
+static void schemaWriteU32(schemaWriter_t *writer, uint32_t value)
+{
+    const uint8_t data[] = { value, value >> 8, value >> 16, value >> 24 };
+
+    schemaWrite(writer, data, sizeof(data));
+}
+
+static void schemaWriteString(schemaWriter_t *writer, const char *string)
+{
+    const uint8_t len = string ? MIN(strlen(string), (size_t)UINT8_MAX) : 0;
+
+    schemaWriteU8(writer, len);
+    schemaWrite(writer, (const uint8_t *)string, len);
+}
+
+static void serializeSettingSchema(schemaWriter_t *writer, const clivalue_t *value)
+{
+    int32_t min;
+    int32_t max;
+    settingRange(value, &min, &max);
+
+    schemaWriteU8(writer, value->type);
+    schemaWriteU8(writer, settingElementCount(value));
+    schemaWriteU32(writer, min);
+    schemaWriteU32(writer, max);
+    schemaWriteString(writer, value->name);
+
+    if ((value->type & VALUE_MODE_MASK) == MODE_LOOKUP) {
+        const lookupTableEntry_t *table = &lookupTables[value->config.lookup.tableIndex];
+
+        schemaWriteU8(writer, table->valueCount);
+        for (unsigned i = 0; i < table->valueCount; i++) {
+            schemaWriteString(writer, table->values[i]);
+        }
+    } else {
+        schemaWriteU8(writer, 0);
+    }
+}
+
+static int settingSchemaSize(const clivalue_t *value)
+{
+    schemaWriter_t writer = { .dst = NULL };
+
+    serializeSettingSchema(&writer, value);
+
+    return writer.size;
+}
+
+uint32_t mspSettingsSchemaHash(void)
+{
+    // The table is fixed at build time, so this only needs to be worked out once
+    if (!schemaHashValid) {
+        schemaWriter_t writer = { .dst = NULL, .hash = FNV1A_OFFSET_BASIS };
+
+        for (unsigned id = 0; id < valueTableEntryCount; id++) {
+            serializeSettingSchema(&writer, &valueTable[id]);
+        }
+
+        schemaHash = writer.hash;
+        schemaHashValid = true;
+    }
+
+    return schemaHash;
+}
+
+void mspSettingsSerializeInfo(sbuf_t *dst)
+{
+    sbufWriteU16(dst, valueTableEntryCount);
+    sbufWriteU32(dst, mspSettingsSchemaHash());
+}
+
+mspResult_e mspSettingsSerializeSchema(sbuf_t *dst, sbuf_t *src)
+{
+    if (sbufBytesRemaining(src) < 2) {
+        return MSP_RESULT_ERROR;
+    }
+
+    const uint16_t firstId = sbufReadU16(src);
+    if (firstId > valueTableEntryCount) {
+        return MSP_RESULT_ERROR;
+    }
+
+    sbufWriteU16(dst, firstId);
+    uint8_t *entryCount = sbufPtr(dst);
+    sbufWriteU8(dst, 0);
+
+    schemaWriter_t writer = { .dst = dst };
+    for (unsigned id = firstId; id < valueTableEntryCount && *entryCount < UINT8_MAX; id++) {
+        if (settingSchemaSize(&valueTable[id]) > sbufBytesRemaining(dst)) {
+            break;
+        }
+        serializeSettingSchema(&writer, &valueTable[id]);
+        (*entryCount)++;
+    }
+
+    return MSP_RESULT_ACK;
+}
+
+static bool readProfileIndexes(sbuf_t *src, uint8_t *pidProfileIndex, uint8_t *rateProfileIndex)
+{
+    if (sbufBytesRemaining(src) < 2) {
+        return false;
+    }
+
+    *pidProfileIndex = sbufReadU8(src);
+    if (*pidProfileIndex == MSP_SETTINGS_CURRENT_PROFILE) {
+        *pidProfileIndex = getCurrentPidProfileIndex();
+    }
+    *rateProfileIndex = sbufReadU8(src);
+    if (*rateProfileIndex == MSP_SETTINGS_CURRENT_PROFILE) {
+        *rateProfileIndex = getCurrentControlRateProfileIndex();
+    }
+
+    return *pidProfileIndex < MAX_PROFILE_COUNT && *rateProfileIndex < CONTROL_RATE_PROFILE_COUNT;
+}
+
+static uint8_t *settingPointer(const clivalue_t *value, uint8_t pidProfileIndex, uint8_t rateProfileIndex)
+{
+    const pgRegistry_t *pg = pgFind(value->pgn);
+    if (!pg) {
+        return NULL;
+    }
+
+    uint16_t offset = value->offset;
+    switch (value->type & VALUE_SECTION_MASK) {
+    case PROFILE_VALUE:
+        offset += sizeof(pidProfile_t) * pidProfileIndex;
+
+        break;
+    case PROFILE_RATE_VALUE:
+        offset += sizeof(controlRateConfig_t) * rateProfileIndex;
+
+        break;
+    }
+
+    return pg->address + offset;
+}
+
+static uint32_t settingElement(const clivalue_t *value, const uint8_t *ptr, int index)
+{
+    switch (value->type & VALUE_TYPE_MASK) {
+    case VAR_UINT16:
+    case VAR_INT16:
+        return ((uint16_t *)ptr)[index];
+    case VAR_UINT32:
+        return ((uint32_t *)ptr)[index];
+    default:
+        return ptr[index];
+    }
+}
+
+static void setSettingElement(const clivalue_t *value, uint8_t *ptr, int index, uint32_t element)
+{
+    switch (value->type & VALUE_TYPE_MASK) {
+    case VAR_UINT16:
+    case VAR_INT16:
+        ((uint16_t *)ptr)[index] = element;
+
+        break;
+    case VAR_UINT32:
+        ((uint32_t *)ptr)[index] = element;
+
+        break;
+    default:
+        ptr[index] = element;
+
+        break;
+    }
+}
+
+mspResult_e mspSettingsRead(sbuf_t *dst, sbuf_t *src)
+{
+    uint8_t pidProfileIndex;
+    uint8_t rateProfileIndex;
+    if (!readProfileIndexes(src, &pidProfileIndex, &rateProfileIndex)) {
+        return MSP_RESULT_ERROR;
+    }
+
+    uint8_t *valueCount = sbufPtr(dst);
+    sbufWriteU16(dst, 0);
+
+    uint16_t count = 0;
+    while (sbufBytesRemaining(src) >= 2) {
+        const uint16_t id = sbufReadU16(src);
+        if (id >= valueTableEntryCount) {
+            return MSP_RESULT_ERROR;
+        }
+
+        const clivalue_t *value = &valueTable[id];
+        const uint8_t *ptr = settingPointer(value, pidProfileIndex, rateProfileIndex);
+        if (!ptr) {
+            return MSP_RESULT_ERROR;
+        }
+        if (settingWireSize(value) > sbufBytesRemaining(dst)) {
+            break;
+        }
+
+        if ((value->type & VALUE_MODE_MASK) == MODE_BITSET) {
+            sbufWriteU8(dst, (settingElement(value, ptr, 0) >> value->config.bitpos) & 1);
+        } else {
+            for (int i = 0; i < settingElementCount(value); i++) {
+                const uint32_t element = settingElement(value, ptr, i);
+
+                switch (settingElementSize(value)) {
+                case 4:
+                    sbufWriteU32(dst, element);
+
+                    break;
+                case 2:
+                    sbufWriteU16(dst, element);
+
+                    break;
+                default:
+                    sbufWriteU8(dst, element);
+
+                    break;
+                }
+            }
+        }
+        count++;
+    }
+
+    valueCount[0] = count & 0xff;
+    valueCount[1] = count >> 8;
+
+    return MSP_RESULT_ACK;
+}
+
+static int32_t readSettingElement(sbuf_t *src, const clivalue_t *value)
+{
+    switch (value->type & VALUE_TYPE_MASK) {
+    case VAR_INT8:
+        return (int8_t)sbufReadU8(src);
+    case VAR_UINT16:
+        return sbufReadU16(src);
+    case VAR_INT16:
+        return (int16_t)sbufReadU16(src);
+    case VAR_UINT32:
+        return sbufReadU32(src);
+    default:
+        return sbufReadU8(src);
+    }
+}
+
+// Walks the (id, value) pairs of a write request, only changing the settings if apply is set
+static bool processSettingWrites(sbuf_t *src, uint8_t pidProfileIndex, uint8_t rateProfileIndex, bool apply)
+{
+    while (sbufBytesRemaining(src) > 0) {
+        if (sbufBytesRemaining(src) < 2) {
+            return false;
+        }
+
+        const uint16_t id = sbufReadU16(src);
+        if (id >= valueTableEntryCount) {
+            return false;
+        }
+
+        const clivalue_t *value = &valueTable[id];
+        uint8_t *ptr = settingPointer(value, pidProfileIndex, rateProfileIndex);
+        if (!ptr || settingWireSize(value) > sbufBytesRemaining(src)) {
+            return false;
+        }
+
+        int32_t min;
+        int32_t max;
+        settingRange(value, &min, &max);
+
+        if ((value->type & VALUE_MODE_MASK) == MODE_BITSET) {
+            const uint8_t bit = sbufReadU8(src);
+            if (bit > 1) {
+                return false;
+            }
+
+            if (apply) {
+                const uint32_t mask = 1u << value->config.bitpos;
+                const uint32_t element = settingElement(value, ptr, 0);
+
+                setSettingElement(value, ptr, 0, bit ? element | mask : element & ~mask);
+            }
+        } else {
+            for (int i = 0; i < settingElementCount(value); i++) {
+                const int32_t element = readSettingElement(src, value);
+                if (element < min || element > max) {
+                    return false;
+                }
+
+                if (apply) {
+                    setSettingElement(value, ptr, i, element);
+                }
+            }
+        }
+
+        if (apply) {
+            pgMarkDirty(pgFind(value->pgn));
+        }
+    }
+
+    return true;
+}
+
+mspResult_e mspSettingsWrite(sbuf_t *src)
+{
+    uint8_t pidProfileIndex;
+    uint8_t rateProfileIndex;
+    if (!readProfileIndexes(src, &pidProfileIndex, &rateProfileIndex)) {
+        return MSP_RESULT_ERROR;
+    }
+
+    sbuf_t validation = *src;
+    if (!processSettingWrites(&validation, pidProfileIndex, rateProfileIndex, false)) {
+        return MSP_RESULT_ERROR;
+    }
+
+    processSettingWrites(src, pidProfileIndex, rateProfileIndex, true);
+
+    return MSP_RESULT_ACK;
+}
+#endif // USE_MSP_SETTINGS
@@ -0,0 +1,57 @@
+/*
+ * This file is part of Cleanflight and Betaflight.
+ *
+ * Cleanflight and Betaflight are free software. You can redistribute
+ * this software and/or modify this software under the terms of the
+ * GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Cleanflight and Betaflight are distributed in the hope that they
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software.
+ *
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include "interface/msp.h"
+
+/*
+ * Bulk access to the CLI settings over MSP, by their index in the value table.
+ *
+ * MSP_SETTINGS_INFO       reply: u16 setting count, u32 schema hash
+ * MSP_SETTINGS_SCHEMA     request: u16 first id
+ *                         reply: u16 first id, u8 entry count, entries
+ *                         entry: u8 type, u8 element count, i32 min, i32 max, u8 name length, name,
+ *                                u8 lookup value count, lookup values as (u8 length, name)
+ * MSP_SETTINGS_READ       request: u8 pid profile, u8 rate profile, u16 ids
+ *                         reply: u16 value count, values
+ * MSP_SET_SETTINGS        request: u8 pid profile, u8 rate profile, (u16 id, value) pairs
+ *
+ * Values are little endian, one element of the setting's type per array element, bitset values are a single byte
+ * of 0 or 1. A profile of MSP_SETTINGS_CURRENT_PROFILE selects the active one.
+ *
+ * Replies hold as many entries or values as fit, the client continues with the next id. The schema hash covers
+ * everything in the schema, so clients can cache it across connections and firmware versions.
+ *
+ * Writes are validated in full before anything is changed, an invalid id, value or a truncated request leaves the
+ * config untouched and returns an error.
+ */
+
+#define MSP_SETTINGS_CURRENT_PROFILE 0xFF
+
+struct sbuf_s;
+
+uint32_t mspSettingsSchemaHash(void);
+void mspSettingsSerializeInfo(struct sbuf_s *dst);
+mspResult_e mspSettingsSerializeSchema(struct sbuf_s *dst, struct sbuf_s *src);
+mspResult_e mspSettingsRead(struct sbuf_s *dst, struct sbuf_s *src);
+mspResult_e mspSettingsWrite(struct sbuf_s *src);
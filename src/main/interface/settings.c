@@ -628,6 +628,10 @@ const clivalue_t valueTable[] = {
     { "blackbox_device",            VAR_UINT8  | MASTER_VALUE | MODE_LOOKUP, .config.lookup = { TABLE_BLACKBOX_DEVICE }, PG_BLACKBOX_CONFIG, offsetof(blackboxConfig_t, device) },
     { "blackbox_record_acc",        VAR_UINT8  | MASTER_VALUE | MODE_LOOKUP, .config.lookup = { TABLE_OFF_ON }, PG_BLACKBOX_CONFIG, offsetof(blackboxConfig_t, record_acc) },
     { "blackbox_mode",              VAR_UINT8  | MASTER_VALUE | MODE_LOOKUP, .config.lookup = { TABLE_BLACKBOX_MODE }, PG_BLACKBOX_CONFIG, offsetof(blackboxConfig_t, mode) },
+#ifdef USE_FLASHFS
+    { "blackbox_flash_circular",    VAR_UINT8  | MASTER_VALUE | MODE_LOOKUP, .config.lookup = { TABLE_OFF_ON }, PG_BLACKBOX_CONFIG, offsetof(blackboxConfig_t, flash_circular) },
+    { "blackbox_flash_erase_ahead_kb", VAR_UINT16 | MASTER_VALUE, .config.minmax = { 0, 16384 }, PG_BLACKBOX_CONFIG, offsetof(blackboxConfig_t, flash_erase_ahead_kb) },
+#endif
 #endif
 
 // PG_MOTOR_CONFIG
@@ -914,6 +918,7 @@ const clivalue_t valueTable[] = {
 #endif
 #if defined(USE_TELEMETRY_SMARTPORT)
     { "smartport_use_extra_sensors", VAR_UINT8 | MASTER_VALUE | MODE_LOOKUP, .config.lookup = { TABLE_OFF_ON }, PG_TELEMETRY_CONFIG, offsetof(telemetryConfig_t, smartport_use_extra_sensors)},
+    { "smartport_sensor_rates",     VAR_UINT8  | MASTER_VALUE | MODE_ARRAY, .config.array.length = SMARTPORT_SENSOR_COUNT, PG_TELEMETRY_CONFIG, offsetof(telemetryConfig_t, smartport_sensor_rates)},
 #endif
 #ifdef USE_TELEMETRY_MAVLINK
     // Support for misusing the heading field in MAVlink to indicate mAh drawn for Connex Prosight OSD
@@ -1050,6 +1055,7 @@ const clivalue_t valueTable[] = {
     { "cpu_overclock",              VAR_UINT8  | MASTER_VALUE | MODE_LOOKUP, .config.lookup = { TABLE_OVERCLOCK }, PG_SYSTEM_CONFIG, offsetof(systemConfig_t, cpu_overclock) },
 #endif
     { "pwr_on_arm_grace",           VAR_UINT8  | MASTER_VALUE, .config.minmax = { 0, 30 }, PG_SYSTEM_CONFIG, offsetof(systemConfig_t, powerOnArmingGraceTime) },
+    { "inflight_adjustment_save",   VAR_UINT8  | MASTER_VALUE | MODE_LOOKUP, .config.lookup = { TABLE_OFF_ON }, PG_SYSTEM_CONFIG, offsetof(systemConfig_t, inflightAdjustmentSave) },
 
 // PG_VTX_CONFIG
 #ifdef USE_VTX_COMMON
@@ -1157,6 +1163,10 @@ const clivalue_t valueTable[] = {
 
 const uint16_t valueTableEntryCount = ARRAYLEN(valueTable);
 
+#ifdef USE_CLI_SETTINGS_INDEX
+uint16_t valueTableNameIndex[ARRAYLEN(valueTable)];
+#endif
+
 void settingsBuildCheck() {
     STATIC_ASSERT(LOOKUP_TABLE_COUNT == ARRAYLEN(lookupTables), LOOKUP_TABLE_COUNT_incorrect);
 }
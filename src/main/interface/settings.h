@@ -191,6 +191,11 @@ extern const lookupTableEntry_t lookupTables[];
 extern const uint16_t valueTableEntryCount;
 
 extern const clivalue_t valueTable[];
+
+#ifdef USE_CLI_SETTINGS_INDEX
+// Indexes into valueTable in order of the setting names, filled in by the CLI
+extern uint16_t valueTableNameIndex[];
+#endif
 //extern const uint8_t lookupTablesEntryCount;
 
 extern const char * const lookupTableGyroHardware[];
@@ -58,7 +58,13 @@
     #define ONLY_EXPOSE_FOR_TESTING static
 #endif
 
+/*
+ * Number of 512-byte sectors in the cache. Targets with RAM to spare can raise this to ride out longer SD card write
+ * latency spikes, and to give the flusher longer runs of consecutive sectors to combine into multi-block writes.
+ */
+#ifndef AFATFS_NUM_CACHE_SECTORS
 #define AFATFS_NUM_CACHE_SECTORS 8
+#endif
 
 // FAT filesystems are allowed to differ from these parameters, but we choose not to support those weird filesystems:
 #define AFATFS_SECTOR_SIZE  512
@@ -75,8 +81,19 @@
  */
 #define AFATFS_MIN_MULTIPLE_BLOCK_WRITE_COUNT 4
 
+/*
+ * How many consecutive dirty sectors need to be waiting in the cache before we flush them with a single multi-block
+ * write (only used when AFATFS_MIN_MULTIPLE_BLOCK_WRITE_COUNT is defined).
+ */
+#define AFATFS_MIN_COMBINED_WRITE_COUNT 2
+
 #define AFATFS_FILES_PER_DIRECTORY_SECTOR (AFATFS_SECTOR_SIZE / sizeof(fatDirectoryEntry_t))
 
+// Numbered files are named <prefix>N.<extension>, with N filling out the rest of the 8 character filename
+#define AFATFS_NUMBERED_FILE_PREFIX_MAX_LENGTH 7
+#define AFATFS_FILENAME_BASE_LENGTH 8
+#define AFATFS_FILENAME_EXTENSION_LENGTH 3
+
 #define AFATFS_FAT32_FAT_ENTRIES_PER_SECTOR  (AFATFS_SECTOR_SIZE / sizeof(uint32_t))
 #define AFATFS_FAT16_FAT_ENTRIES_PER_SECTOR (AFATFS_SECTOR_SIZE / sizeof(uint16_t))
 
@@ -213,6 +230,43 @@ typedef struct afatfsCacheBlockDescriptor_t {
     unsigned discardable:1;
 } afatfsCacheBlockDescriptor_t;
 
+typedef enum {
+    AFATFS_DIRECTORY_CACHE_STATE_EMPTY,
+    AFATFS_DIRECTORY_CACHE_STATE_PENDING,  // Waiting for the chance to scan the current directory
+    AFATFS_DIRECTORY_CACHE_STATE_BUILDING,
+    AFATFS_DIRECTORY_CACHE_STATE_READY
+} afatfsDirectoryCacheState_e;
+
+/*
+ * A saved position of the directory cursor, which lets us resume a search of the directory from the middle without
+ * walking the cluster chain from the start again.
+ */
+typedef struct afatfsDirectoryPosition_t {
+    uint32_t cursorOffset;
+    uint32_t cursorCluster;
+    uint32_t cursorPreviousCluster;
+    int16_t entryIndex; // The finder's entryIndex, i.e. findNext() will return the entry after this one
+    bool valid;
+} afatfsDirectoryPosition_t;
+
+/*
+ * What we learned about the current directory by reading it through once in the background. This is enough to create
+ * a numbered file (e.g. the next log) without searching the directory again, however many entries it has.
+ */
+typedef struct afatfsDirectoryCache_t {
+    afatfsDirectoryCacheState_e state;
+
+    // Where to start searching for a free directory entry (no entries before this point are free)
+    afatfsDirectoryPosition_t freeEntry;
+
+    afatfsFinder_t buildFinder;
+
+    // The numbered files we keep track of, and the largest number among them in the directory (0 for none)
+    char numberedPrefix[AFATFS_NUMBERED_FILE_PREFIX_MAX_LENGTH + 1];
+    char numberedExtension[AFATFS_FILENAME_EXTENSION_LENGTH + 1];
+    uint32_t largestFileNumber;
+} afatfsDirectoryCache_t;
+
 typedef enum {
     AFATFS_FAT_PATTERN_UNTERMINATED_CHAIN,
     AFATFS_FAT_PATTERN_TERMINATED_CHAIN,
@@ -463,6 +517,8 @@ typedef struct afatfs_t {
 
     int cacheDirtyEntries; // The number of cache entries in the AFATFS_CACHE_STATE_DIRTY state
     bool cacheFlushInProgress;
+    uint32_t cacheNextFlushSector; // The sector after the one we last flushed, flushing it next keeps the card's writes sequential
+    bool cacheNextFlushSectorValid; // False when there is no such sector to continue on from
 
     afatfsFile_t openFiles[AFATFS_MAX_OPEN_FILES];
 
@@ -480,6 +536,7 @@ typedef struct afatfs_t {
 
     // The current working directory:
     afatfsFile_t currentDirectory;
+    afatfsDirectoryCache_t directoryCache;
 
     uint32_t partitionStartSector; // The physical sector that the first partition on the device begins at
 
@@ -509,7 +566,11 @@ typedef struct afatfs_t {
 
 static afatfs_t afatfs;
 
+// The cache indexes held by open files are stored as int8_t
+STATIC_ASSERT(AFATFS_NUM_CACHE_SECTORS <= INT8_MAX, afatfs_too_many_cache_sectors);
+
 static void afatfs_fileOperationContinue(afatfsFile_t *file);
+static void afatfs_directoryCacheEntryDeleted(void);
 static uint8_t* afatfs_fileLockCursorSectorForWrite(afatfsFilePtr_t file);
 static uint8_t* afatfs_fileRetainCursorSectorForRead(afatfsFilePtr_t file);
 
@@ -694,6 +755,39 @@ static void afatfs_sdcardWriteComplete(sdcardBlockOperation_e operation, uint32_
     }
 }
 
+/**
+ * Find the cache entry holding the given physical sector if it is dirty and not locked (so it could be flushed right
+ * now), or return -1 otherwise.
+ */
+static int afatfs_findFlushableCacheSector(uint32_t sectorIndex)
+{
+    for (int i = 0; i < AFATFS_NUM_CACHE_SECTORS; i++) {
+        if (afatfs.cacheDescriptor[i].sectorIndex == sectorIndex
+            && afatfs.cacheDescriptor[i].state == AFATFS_CACHE_STATE_DIRTY && !afatfs.cacheDescriptor[i].locked
+        ) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+#ifdef AFATFS_MIN_MULTIPLE_BLOCK_WRITE_COUNT
+/**
+ * Count the flushable dirty sectors in the cache which are consecutive on disk, starting from the given sector.
+ */
+static uint32_t afatfs_cacheFlushableRunLength(uint32_t sectorIndex)
+{
+    uint32_t runLength = 0;
+
+    while (runLength < AFATFS_NUM_CACHE_SECTORS && afatfs_findFlushableCacheSector(sectorIndex + runLength) != -1) {
+        runLength++;
+    }
+
+    return runLength;
+}
+#endif
+
 /**
  * Attempt to flush the dirty cache entry with the given index to the SDcard.
  */
@@ -704,6 +798,17 @@ static void afatfs_cacheFlushSector(int cacheIndex)
 #ifdef AFATFS_MIN_MULTIPLE_BLOCK_WRITE_COUNT
     if (cacheDescriptor->consecutiveEraseBlockCount) {
         sdcard_beginWriteBlocks(cacheDescriptor->sectorIndex, cacheDescriptor->consecutiveEraseBlockCount);
+    } else {
+        /*
+         * Even without an erase hint, a run of consecutive dirty sectors is much cheaper for the card to accept as one
+         * multi-block write than as a series of single-block writes. If the card is already in the middle of a
+         * multi-block write that this sector continues, this just carries on with that one.
+         */
+        const uint32_t runLength = afatfs_cacheFlushableRunLength(cacheDescriptor->sectorIndex);
+
+        if (runLength >= AFATFS_MIN_COMBINED_WRITE_COUNT) {
+            sdcard_beginWriteBlocks(cacheDescriptor->sectorIndex, runLength);
+        }
     }
 #endif
 
@@ -713,15 +818,25 @@ static void afatfs_cacheFlushSector(int cacheIndex)
             afatfs.cacheDirtyEntries--;
             cacheDescriptor->state = AFATFS_CACHE_STATE_WRITING;
             afatfs.cacheFlushInProgress = true;
+            afatfs.cacheNextFlushSector = cacheDescriptor->sectorIndex + 1;
+            afatfs.cacheNextFlushSectorValid = true;
             break;
 
         case SDCARD_OPERATION_SUCCESS:
             // Buffer is already transmitted
             afatfs.cacheDirtyEntries--;
             cacheDescriptor->state = AFATFS_CACHE_STATE_IN_SYNC;
+            afatfs.cacheNextFlushSector = cacheDescriptor->sectorIndex + 1;
+            afatfs.cacheNextFlushSectorValid = true;
             break;
 
         case SDCARD_OPERATION_BUSY:
+            /*
+             * We may have just interrupted a multi-block write in order to write this sector. Don't go back to
+             * continuing that sequence next time, or this sector could be starved of flushes.
+             */
+            afatfs.cacheNextFlushSectorValid = false;
+            break;
         case SDCARD_OPERATION_FAILURE:
         default:
             ;
@@ -831,21 +946,31 @@ static int afatfs_allocateCacheSector(uint32_t sectorIndex)
 bool afatfs_flush(void)
 {
     if (afatfs.cacheDirtyEntries > 0) {
-        // Flush the oldest flushable sector
-        uint32_t earliestSectorTime = 0xFFFFFFFF;
-        int earliestSectorIndex = -1;
+        // Prefer to continue on from the sector we flushed last, so the card sees one long sequential write
+        int flushIndex = afatfs.cacheNextFlushSectorValid ? afatfs_findFlushableCacheSector(afatfs.cacheNextFlushSector) : -1;
+
+        if (flushIndex == -1) {
+            // Otherwise flush the oldest flushable sector
+            uint32_t earliestSectorTime = 0xFFFFFFFF;
+
+            for (int i = 0; i < AFATFS_NUM_CACHE_SECTORS; i++) {
+                if (afatfs.cacheDescriptor[i].state == AFATFS_CACHE_STATE_DIRTY && !afatfs.cacheDescriptor[i].locked
+                    && (flushIndex == -1 || afatfs.cacheDescriptor[i].writeTimestamp < earliestSectorTime)
+                ) {
+                    flushIndex = i;
+                    earliestSectorTime = afatfs.cacheDescriptor[i].writeTimestamp;
+                }
+            }
 
-        for (int i = 0; i < AFATFS_NUM_CACHE_SECTORS; i++) {
-            if (afatfs.cacheDescriptor[i].state == AFATFS_CACHE_STATE_DIRTY && !afatfs.cacheDescriptor[i].locked
-                && (earliestSectorIndex == -1 || afatfs.cacheDescriptor[i].writeTimestamp < earliestSectorTime)
-            ) {
-                earliestSectorIndex = i;
-                earliestSectorTime = afatfs.cacheDescriptor[i].writeTimestamp;
+            // But begin with any dirty sectors which directly precede it on disk, so the whole run is written in order
+            for (int previousIndex = flushIndex; previousIndex > -1; ) {
+                flushIndex = previousIndex;
+                previousIndex = afatfs_findFlushableCacheSector(afatfs.cacheDescriptor[flushIndex].sectorIndex - 1);
             }
         }
 
-        if (earliestSectorIndex > -1) {
-            afatfs_cacheFlushSector(earliestSectorIndex);
+        if (flushIndex > -1) {
+            afatfs_cacheFlushSector(flushIndex);
 
             // That flush will take time to complete so we may as well tell caller to come back later
             return false;
@@ -1491,6 +1616,10 @@ static afatfsOperationStatus_e afatfs_saveDirectoryEntry(afatfsFilePtr_t file, a
 
             entry->firstClusterHigh = file->firstCluster >> 16;
             entry->firstClusterLow = file->firstCluster & 0xFFFF;
+
+            if (mode == AFATFS_SAVE_DIRECTORY_DELETED) {
+                afatfs_directoryCacheEntryDeleted();
+            }
         } else {
             return AFATFS_OPERATION_FAILURE;
         }
@@ -2208,6 +2337,275 @@ void afatfs_findFirst(afatfsFilePtr_t directory, afatfsFinder_t *finder)
     finder->entryIndex = -1;
 }
 
+static void afatfs_directorySavePosition(afatfsDirectoryPosition_t *position, afatfsFilePtr_t directory, afatfsFinder_t *finder)
+{
+    position->cursorOffset = directory->cursorOffset;
+    position->cursorCluster = directory->cursorCluster;
+    position->cursorPreviousCluster = directory->cursorPreviousCluster;
+    position->entryIndex = finder->entryIndex;
+    position->valid = true;
+}
+
+static void afatfs_directoryRestorePosition(const afatfsDirectoryPosition_t *position, afatfsFilePtr_t directory, afatfsFinder_t *finder)
+{
+    afatfs_fileUnlockCacheSector(directory);
+
+    directory->cursorOffset = position->cursorOffset;
+    directory->cursorCluster = position->cursorCluster;
+    directory->cursorPreviousCluster = position->cursorPreviousCluster;
+    finder->entryIndex = position->entryIndex;
+}
+
+/**
+ * Is the directory cache up to date with the current directory?
+ */
+static bool afatfs_directoryCacheIsReady(void)
+{
+    return afatfs.directoryCache.state == AFATFS_DIRECTORY_CACHE_STATE_READY;
+}
+
+/**
+ * Read the current directory through again, when what we know about it is out of date.
+ */
+static void afatfs_directoryCacheInvalidate(void)
+{
+    afatfsDirectoryCache_t *cache = &afatfs.directoryCache;
+
+    if (cache->state == AFATFS_DIRECTORY_CACHE_STATE_BUILDING) {
+        // Release the directory sector that the scan was holding
+        afatfs_findLast(&afatfs.currentDirectory);
+    }
+
+    cache->state = AFATFS_DIRECTORY_CACHE_STATE_PENDING;
+}
+
+/**
+ * Call when the current directory is about to change to the given directory (NULL for the root), so that the cache
+ * will be rebuilt if that's a different directory.
+ */
+static void afatfs_directoryCacheChangeDirectory(afatfsFilePtr_t directory)
+{
+    afatfsFilePtr_t current = &afatfs.currentDirectory;
+    bool sameDirectory;
+
+    if (directory) {
+        // A brand new subdirectory has no clusters yet, so we can't tell it apart from others like it
+        sameDirectory = directory->firstCluster != 0 && current->type == AFATFS_FILE_TYPE_DIRECTORY
+            && current->firstCluster == directory->firstCluster;
+    } else if (afatfs.filesystemType == FAT_FILESYSTEM_TYPE_FAT16) {
+        sameDirectory = current->type == AFATFS_FILE_TYPE_FAT16_ROOT_DIRECTORY;
+    } else {
+        sameDirectory = current->type == AFATFS_FILE_TYPE_DIRECTORY && current->firstCluster == afatfs.rootDirectoryCluster;
+    }
+
+    if (afatfs_directoryCacheIsReady() && sameDirectory) {
+        return;
+    }
+
+    afatfs_directoryCacheInvalidate();
+}
+
+/**
+ * If the given FAT-style filename is one of the numbered files we keep track of, get its number.
+ */
+static bool afatfs_directoryCacheFileNumber(const uint8_t *filename, uint32_t *number)
+{
+    const afatfsDirectoryCache_t *cache = &afatfs.directoryCache;
+    const int prefixLength = strlen(cache->numberedPrefix);
+    const int extensionLength = strlen(cache->numberedExtension);
+    int digits = 0;
+
+    if (prefixLength == 0 || memcmp(filename, cache->numberedPrefix, prefixLength) != 0) {
+        return false;
+    }
+
+    for (int i = 0; i < AFATFS_FILENAME_EXTENSION_LENGTH; i++) {
+        if (filename[AFATFS_FILENAME_BASE_LENGTH + i] != (i < extensionLength ? cache->numberedExtension[i] : ' ')) {
+            return false;
+        }
+    }
+
+    *number = 0;
+
+    for (int i = prefixLength; i < AFATFS_FILENAME_BASE_LENGTH && filename[i] != ' '; i++, digits++) {
+        if (filename[i] < '0' || filename[i] > '9') {
+            return false;
+        }
+        *number = *number * 10 + (filename[i] - '0');
+    }
+
+    // The name can only be padded with spaces after the number
+    for (int i = prefixLength + digits; i < AFATFS_FILENAME_BASE_LENGTH; i++) {
+        if (filename[i] != ' ') {
+            return false;
+        }
+    }
+
+    return digits > 0;
+}
+
+static void afatfs_directoryCacheAddEntry(const fatDirectoryEntry_t *entry)
+{
+    uint32_t fileNumber;
+
+    if (afatfs_directoryCacheFileNumber((const uint8_t *) entry->filename, &fileNumber)) {
+        afatfs.directoryCache.largestFileNumber = MAX(afatfs.directoryCache.largestFileNumber, fileNumber);
+    }
+}
+
+/**
+ * Call when a directory entry has been deleted. That might have been the largest numbered file, or have left a free
+ * entry before the one we search from, so the current directory has to be read through again.
+ */
+static void afatfs_directoryCacheEntryDeleted(void)
+{
+    if (afatfs.directoryCache.state != AFATFS_DIRECTORY_CACHE_STATE_EMPTY) {
+        afatfs_directoryCacheInvalidate();
+    }
+}
+
+/**
+ * Make progress on reading the current directory into the directory cache.
+ */
+static void afatfs_directoryCacheBuildContinue(void)
+{
+    afatfsDirectoryCache_t *cache = &afatfs.directoryCache;
+    afatfsFilePtr_t directory = &afatfs.currentDirectory;
+    afatfsDirectoryPosition_t position;
+    fatDirectoryEntry_t *entry;
+
+    if (cache->state == AFATFS_DIRECTORY_CACHE_STATE_PENDING) {
+        // File creation shares the directory's cursor with us, so wait for any of those to finish first
+        if (afatfs_fileIsBusy(directory)) {
+            return;
+        }
+
+        for (int i = 0; i < AFATFS_MAX_OPEN_FILES; i++) {
+            if (afatfs.openFiles[i].operation.operation == AFATFS_FILE_OPERATION_CREATE_FILE) {
+                return;
+            }
+        }
+
+        cache->largestFileNumber = 0;
+        cache->freeEntry.valid = false;
+
+        afatfs_findFirst(directory, &cache->buildFinder);
+
+        cache->state = AFATFS_DIRECTORY_CACHE_STATE_BUILDING;
+    }
+
+    if (cache->state != AFATFS_DIRECTORY_CACHE_STATE_BUILDING) {
+        return;
+    }
+
+    while (true) {
+        // Remember where we were before this entry, in case it turns out to be the first free one
+        afatfs_directorySavePosition(&position, directory, &cache->buildFinder);
+
+        if (afatfs_findNext(directory, &cache->buildFinder, &entry) != AFATFS_OPERATION_SUCCESS) {
+            // Wait for the next directory sector to be read
+            return;
+        }
+
+        if (entry == NULL || fat_isDirectoryEntryTerminator(entry)) {
+            if (!cache->freeEntry.valid) {
+                cache->freeEntry = position;
+            }
+
+            afatfs_findLast(directory);
+
+            cache->state = AFATFS_DIRECTORY_CACHE_STATE_READY;
+            return;
+        }
+
+        if (fat_isDirectoryEntryEmpty(entry)) {
+            if (!cache->freeEntry.valid) {
+                cache->freeEntry = position;
+            }
+        } else {
+            afatfs_directoryCacheAddEntry(entry);
+        }
+    }
+}
+
+/**
+ * Position the finder so that searching the current directory for a free entry begins from the first entry which
+ * could be free.
+ */
+static void afatfs_findFirstFreeEntry(afatfsFinder_t *finder)
+{
+    if (afatfs_directoryCacheIsReady() && afatfs.directoryCache.freeEntry.valid) {
+        afatfs_directoryRestorePosition(&afatfs.directoryCache.freeEntry, &afatfs.currentDirectory, finder);
+    } else {
+        afatfs_findFirst(&afatfs.currentDirectory, finder);
+    }
+}
+
+/**
+ * Record a newly created entry in the current directory (the directory's cursor must still point at its sector).
+ */
+static void afatfs_directoryCacheAddCreatedEntry(const fatDirectoryEntry_t *entry, afatfsFinder_t *finder)
+{
+    if (!afatfs_directoryCacheIsReady()) {
+        return;
+    }
+
+    afatfs_directoryCacheAddEntry(entry);
+
+    // That entry was the first free one, so the next search for a free entry can begin right after it
+    afatfs_directorySavePosition(&afatfs.directoryCache.freeEntry, &afatfs.currentDirectory, finder);
+}
+
+/**
+ * Is the file with the given FAT-style filename numbered past every numbered file in the current directory, so that
+ * we know it doesn't exist without searching the directory?
+ */
+static bool afatfs_directoryCacheFileIsNew(const uint8_t *filename)
+{
+    uint32_t fileNumber;
+
+    return afatfs_directoryCacheIsReady() && afatfs_directoryCacheFileNumber(filename, &fileNumber)
+        && fileNumber > afatfs.directoryCache.largestFileNumber;
+}
+
+/**
+ * Find the largest number N such that a file named <prefix>N.<extension> exists in the current directory (with N
+ * zero-padded to fill out the 8 character filename, e.g. LOG00042.BFL), without having to search the disk.
+ *
+ * The first call for a prefix and extension reads the current directory through in the background. After that the
+ * number is kept up to date as files are created, so creating the next numbered file doesn't search the directory.
+ *
+ * Returns:
+ *     AFATFS_OPERATION_SUCCESS     - *number has been set (to zero if there are no such files)
+ *     AFATFS_OPERATION_IN_PROGRESS - The directory is still being read, call again later
+ *     AFATFS_OPERATION_FAILURE     - There is no current directory, or the prefix is too long, search using afatfs_findNext()
+ */
+afatfsOperationStatus_e afatfs_findLargestFileNumber(const char *prefix, const char *extension, uint32_t *number)
+{
+    afatfsDirectoryCache_t *cache = &afatfs.directoryCache;
+
+    if (cache->state == AFATFS_DIRECTORY_CACHE_STATE_EMPTY
+        || strlen(prefix) > AFATFS_NUMBERED_FILE_PREFIX_MAX_LENGTH || strlen(extension) > AFATFS_FILENAME_EXTENSION_LENGTH) {
+        return AFATFS_OPERATION_FAILURE;
+    }
+
+    if (strcmp(prefix, cache->numberedPrefix) != 0 || strcmp(extension, cache->numberedExtension) != 0) {
+        // We haven't been keeping track of these files, so read the directory through again to number them
+        strcpy(cache->numberedPrefix, prefix);
+        strcpy(cache->numberedExtension, extension);
+
+        afatfs_directoryCacheInvalidate();
+    }
+
+    if (!afatfs_directoryCacheIsReady()) {
+        return AFATFS_OPERATION_IN_PROGRESS;
+    }
+
+    *number = cache->largestFileNumber;
+
+    return AFATFS_OPERATION_SUCCESS;
+}
+
 static afatfsOperationStatus_e afatfs_extendSubdirectoryContinue(afatfsFile_t *directory)
 {
     afatfsExtendSubdirectory_t *opState = &directory->operation.state.extendSubdirectory;
@@ -2567,6 +2965,23 @@ static void afatfs_createFileContinue(afatfsFile_t *file)
 
     switch (opState->phase) {
         case AFATFS_CREATEFILE_PHASE_INITIAL:
+            if (afatfs.directoryCache.state == AFATFS_DIRECTORY_CACHE_STATE_BUILDING) {
+                // The directory is being read through, which may let us skip searching it ourselves
+                break;
+            }
+
+            if (afatfs_directoryCacheFileIsNew(opState->filename)) {
+                // Numbered past the files in the directory, so it doesn't exist yet
+                if ((file->mode & AFATFS_FILE_MODE_CREATE) != 0) {
+                    afatfs_findFirstFreeEntry(&file->directoryEntryPos);
+
+                    opState->phase = AFATFS_CREATEFILE_PHASE_CREATE_NEW_FILE;
+                } else {
+                    opState->phase = AFATFS_CREATEFILE_PHASE_FAILURE;
+                }
+                goto doMore;
+            }
+
             afatfs_findFirst(&afatfs.currentDirectory, &file->directoryEntryPos);
             opState->phase = AFATFS_CREATEFILE_PHASE_FIND_FILE;
             goto doMore;
@@ -2583,7 +2998,7 @@ static void afatfs_createFileContinue(afatfsFile_t *file)
 
                             if ((file->mode & AFATFS_FILE_MODE_CREATE) != 0) {
                                 // The file didn't already exist, so we can create it. Allocate a new directory entry
-                                afatfs_findFirst(&afatfs.currentDirectory, &file->directoryEntryPos);
+                                afatfs_findFirstFreeEntry(&file->directoryEntryPos);
 
                                 opState->phase = AFATFS_CREATEFILE_PHASE_CREATE_NEW_FILE;
                                 goto doMore;
@@ -2641,6 +3056,8 @@ static void afatfs_createFileContinue(afatfsFile_t *file)
                 entry->lastWriteDate = fileDate;
                 entry->lastWriteTime = fileTime;
 
+                afatfs_directoryCacheAddCreatedEntry(entry, &file->directoryEntryPos);
+
 #ifdef AFATFS_DEBUG_VERBOSE
                 fprintf(stderr, "Adding directory entry for %.*s to sector %u\n", FAT_FILENAME_LENGTH, opState->filename, file->directoryEntryPos.sectorNumberPhysical);
 #endif
@@ -2940,9 +3357,13 @@ bool afatfs_chdir(afatfsFilePtr_t directory)
             return false;
         }
 
+        afatfs_directoryCacheChangeDirectory(directory);
+
         memcpy(&afatfs.currentDirectory, directory, sizeof(*directory));
         return true;
     } else {
+        afatfs_directoryCacheChangeDirectory(NULL);
+
         afatfs_initFileHandle(&afatfs.currentDirectory);
 
         afatfs.currentDirectory.mode = AFATFS_FILE_MODE_READ | AFATFS_FILE_MODE_WRITE;
@@ -3251,6 +3672,8 @@ static void afatfs_fileOperationsPoll(void)
 {
     afatfs_fileOperationContinue(&afatfs.currentDirectory);
 
+    afatfs_directoryCacheBuildContinue();
+
 #ifdef AFATFS_USE_INTROSPECTIVE_LOGGING
     afatfs_fileOperationContinue(&afatfs.introSpecLog);
 #endif
@@ -81,6 +81,7 @@ bool afatfs_chdir(afatfsFilePtr_t dirHandle);
 void afatfs_findFirst(afatfsFilePtr_t directory, afatfsFinder_t *finder);
 afatfsOperationStatus_e afatfs_findNext(afatfsFilePtr_t directory, afatfsFinder_t *finder, fatDirectoryEntry_t **dirEntry);
 void afatfs_findLast(afatfsFilePtr_t directory);
+afatfsOperationStatus_e afatfs_findLargestFileNumber(const char *prefix, const char *extension, uint32_t *number);
 
 bool afatfs_flush(void);
 void afatfs_init(void);
@@ -27,7 +27,6 @@
 
 #include "cms/cms.h"
 #include "common/maths.h"
-#include "common/printf.h"
 #include "common/time.h"
 #include "drivers/display.h"
 #include "drivers/time.h"
@@ -50,7 +49,7 @@ static int crsfClearScreen(displayPort_t *displayPort)
 {
     UNUSED(displayPort);
     memset(crsfScreen.buffer, ' ', sizeof(crsfScreen.buffer));
-    memset(crsfScreen.pendingTransport, 0, sizeof(crsfScreen.pendingTransport));
+    displayDirtyClear(&crsfScreen.pendingTransport);
     crsfScreen.reset = true;
     delayTransportUntilMs = millis() + CRSF_DISPLAY_PORT_CLEAR_DELAY_MS;
     return 0;
@@ -77,22 +76,14 @@ static int crsfScreenSize(const displayPort_t *displayPort)
 static int crsfWriteString(displayPort_t *displayPort, uint8_t col, uint8_t row, const char *s)
 {
     UNUSED(displayPort);
-    if (row >= crsfScreen.rows || col >= crsfScreen.cols) {
-        return 0;
-    }
-    const size_t truncLen = MIN((int)strlen(s), crsfScreen.cols-col);  // truncate at colCount
-    char *rowStart = &crsfScreen.buffer[row * crsfScreen.cols + col];
-    crsfScreen.pendingTransport[row] = memcmp(rowStart, s, truncLen);
-    if (crsfScreen.pendingTransport[row]) {
-        memcpy(rowStart, s, truncLen);
-    }
+    // Only rows that changed are sent
+    displayBufferWrite(&crsfScreen.pendingTransport, crsfScreen.buffer, crsfScreen.rows, crsfScreen.cols, col, row, s);
     return 0;
 }
 
 static int crsfWriteChar(displayPort_t *displayPort, uint8_t col, uint8_t row, uint8_t c)
 {
-    char s[1];
-    tfp_sprintf(s, "%c", c);
+    const char s[2] = { c, 0 };
     return crsfWriteString(displayPort, col, row, s);
 }
 
@@ -179,21 +170,21 @@ void crsfDisplayPortRefresh(void)
         crsfDisplayPortMenuOpen();
         return;
     }
-    memset(crsfScreen.pendingTransport, 1, crsfScreen.rows);
+    displayDirtyMarkAll(&crsfScreen.pendingTransport, crsfScreen.rows, crsfScreen.cols);
     crsfScreen.reset = true;
     delayTransportUntilMs = millis() + CRSF_DISPLAY_PORT_CLEAR_DELAY_MS;
 }
 
+// Takes the next row to send, a row is always sent whole
 int crsfDisplayPortNextRow(void)
 {
     const timeMs_t currentTimeMs = millis();
     if (currentTimeMs < delayTransportUntilMs) {
         return -1;
     }
-    for(unsigned int i=0; i<CRSF_DISPLAY_PORT_ROWS_MAX; i++) {
-        if (crsfScreen.pendingTransport[i]) {
-            return i;
-        }
+    displaySpan_t span;
+    if (displayDirtyNextSpan(&crsfScreen.pendingTransport, CRSF_DISPLAY_PORT_COLS_MAX, &span)) {
+        return span.y;
     }
     return -1;
 }
@@ -28,7 +28,7 @@
 
 typedef struct crsfDisplayPortScreen_s {
     char buffer[CRSF_DISPLAY_PORT_MAX_BUFFER_SIZE];
-    bool pendingTransport[CRSF_DISPLAY_PORT_ROWS_MAX];
+    displayDirty_t pendingTransport;
     uint8_t rows;
     uint8_t cols;
     bool reset;
@@ -119,7 +119,7 @@ static int writeChar(displayPort_t *displayPort, uint8_t x, uint8_t y, uint8_t c
 static bool isTransferInProgress(const displayPort_t *displayPort)
 {
     UNUSED(displayPort);
-    return max7456DmaInProgress();
+    return max7456FrameQueued();
 }
 
 static bool isSynced(const displayPort_t *displayPort)
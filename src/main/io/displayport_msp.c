@@ -27,6 +27,7 @@
 
 #ifdef USE_MSP_DISPLAYPORT
 
+#include "common/maths.h"
 #include "common/utils.h"
 
 #include "pg/pg.h"
@@ -46,6 +47,16 @@ PG_REGISTER(displayPortProfile_t, displayPortProfileMsp, PG_DISPLAY_PORT_MSP_CON
 
 static displayPort_t mspDisplayPort;
 
+// Writes go into a copy of the screen, drawing the screen sends the spans that changed
+#define MSP_DISPLAYPORT_ROWS_MAX    DISPLAY_DIRTY_ROWS_MAX
+#define MSP_DISPLAYPORT_COLS_MAX    DISPLAY_DIRTY_COLS_MAX
+// MSP v1 framing and the write string header, resending fewer unchanged chars than that is cheaper than another write
+#define MSP_DISPLAYPORT_WRITE_OVERHEAD  10
+
+static char mspScreen[MSP_DISPLAYPORT_ROWS_MAX * MSP_DISPLAYPORT_COLS_MAX];
+static displayDirty_t mspScreenDirty;
+static bool mspScreenDrawPending;
+
 #ifdef USE_CLI
 extern uint8_t cliMode;
 #endif
@@ -89,13 +100,45 @@ static int clearScreen(displayPort_t *displayPort)
 {
     uint8_t subcmd[] = { 2 };
 
+    memset(mspScreen, ' ', sizeof(mspScreen));
+    displayDirtyClear(&mspScreenDirty);
+    mspScreenDrawPending = true;
+
     return output(displayPort, MSP_DISPLAYPORT, subcmd, sizeof(subcmd));
 }
 
+static int writeSpan(displayPort_t *displayPort, const displaySpan_t *span)
+{
+    uint8_t buf[MSP_DISPLAYPORT_COLS_MAX + 4];
+
+    buf[0] = 3;
+    buf[1] = span->y;
+    buf[2] = span->x;
+    buf[3] = 0;
+    memcpy(&buf[4], &mspScreen[span->y * displayPort->cols + span->x], span->length);
+
+    return output(displayPort, MSP_DISPLAYPORT, buf, span->length + 4);
+}
+
 static int drawScreen(displayPort_t *displayPort)
 {
-    uint8_t subcmd[] = { 4 };
-    return output(displayPort, MSP_DISPLAYPORT, subcmd, sizeof(subcmd));
+    int ret = 0;
+    displaySpan_t span;
+
+    // Whatever does not fit into the serial buffer is sent on the next call
+    while (mspSerialTxBytesFree() >= MSP_DISPLAYPORT_WRITE_OVERHEAD + MSP_DISPLAYPORT_COLS_MAX
+        && displayDirtyNextSpan(&mspScreenDirty, MSP_DISPLAYPORT_WRITE_OVERHEAD, &span)) {
+        ret += writeSpan(displayPort, &span);
+        mspScreenDrawPending = true;
+    }
+
+    if (mspScreenDrawPending && displayDirtyIsClear(&mspScreenDirty)) {
+        uint8_t subcmd[] = { 4 };
+        ret += output(displayPort, MSP_DISPLAYPORT, subcmd, sizeof(subcmd));
+        mspScreenDrawPending = false;
+    }
+
+    return ret;
 }
 
 static int screenSize(const displayPort_t *displayPort)
@@ -105,21 +148,8 @@ static int screenSize(const displayPort_t *displayPort)
 
 static int writeString(displayPort_t *displayPort, uint8_t col, uint8_t row, const char *string)
 {
-#define MSP_OSD_MAX_STRING_LENGTH 30 // FIXME move this
-    uint8_t buf[MSP_OSD_MAX_STRING_LENGTH + 4];
-
-    int len = strlen(string);
-    if (len >= MSP_OSD_MAX_STRING_LENGTH) {
-        len = MSP_OSD_MAX_STRING_LENGTH;
-    }
-
-    buf[0] = 3;
-    buf[1] = row;
-    buf[2] = col;
-    buf[3] = 0;
-    memcpy(&buf[4], string, len);
-
-    return output(displayPort, MSP_DISPLAYPORT, buf, len + 4);
+    displayBufferWrite(&mspScreenDirty, mspScreen, displayPort->rows, displayPort->cols, col, row, string);
+    return 0;
 }
 
 static int writeChar(displayPort_t *displayPort, uint8_t col, uint8_t row, uint8_t c)
@@ -128,7 +158,7 @@ static int writeChar(displayPort_t *displayPort, uint8_t col, uint8_t row, uint8
 
     buf[0] = c;
     buf[1] = 0;
-    return writeString(displayPort, col, row, buf); //!!TODO - check if there is a direct MSP command to do this
+    return writeString(displayPort, col, row, buf);
 }
 
 static bool isTransferInProgress(const displayPort_t *displayPort)
@@ -140,13 +170,20 @@ static bool isTransferInProgress(const displayPort_t *displayPort)
 static bool isSynced(const displayPort_t *displayPort)
 {
     UNUSED(displayPort);
-    return true;
+    return displayDirtyIsClear(&mspScreenDirty);
+}
+
+static void setDimensions(displayPort_t *displayPort)
+{
+    displayPort->rows = MIN(13 + displayPortProfileMsp()->rowAdjust, MSP_DISPLAYPORT_ROWS_MAX); // XXX Will reflect NTSC/PAL in the future
+    displayPort->cols = MIN(30 + displayPortProfileMsp()->colAdjust, MSP_DISPLAYPORT_COLS_MAX);
 }
 
 static void resync(displayPort_t *displayPort)
 {
-    displayPort->rows = 13 + displayPortProfileMsp()->rowAdjust; // XXX Will reflect NTSC/PAL in the future
-    displayPort->cols = 30 + displayPortProfileMsp()->colAdjust;
+    setDimensions(displayPort);
+    // The remote display may have lost what was sent, send it all again
+    displayDirtyMarkAll(&mspScreenDirty, displayPort->rows, displayPort->cols);
     drawScreen(displayPort);
 }
 
@@ -174,7 +211,8 @@ static const displayPortVTable_t mspDisplayPortVTable = {
 displayPort_t *displayPortMspInit(void)
 {
     displayInit(&mspDisplayPort, &mspDisplayPortVTable);
-    resync(&mspDisplayPort);
+    setDimensions(&mspDisplayPort);
+    drawScreen(&mspDisplayPort);
     return &mspDisplayPort;
 }
 #endif // USE_MSP_DISPLAYPORT
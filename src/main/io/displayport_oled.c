@@ -20,6 +20,7 @@
 
 #include <stdbool.h>
 #include <stdint.h>
+#include <string.h>
 
 #include "platform.h"
 
@@ -30,6 +31,10 @@
 
 static displayPort_t oledDisplayPort;
 
+// What the display shows, writes only send the characters they change
+static char oledScreen[SCREEN_CHARACTER_ROW_COUNT * SCREEN_CHARACTER_COLUMN_COUNT];
+static displayDirty_t oledScreenDirty;
+
 static int oledGrab(displayPort_t *displayPort)
 {
     UNUSED(displayPort);
@@ -45,6 +50,8 @@ static int oledRelease(displayPort_t *displayPort)
 static int oledClearScreen(displayPort_t *displayPort)
 {
     i2c_OLED_clear_display_quick(displayPort->device);
+    memset(oledScreen, ' ', sizeof(oledScreen));
+    displayDirtyClear(&oledScreenDirty);
     return 0;
 }
 
@@ -61,16 +68,24 @@ static int oledScreenSize(const displayPort_t *displayPort)
 
 static int oledWriteString(displayPort_t *displayPort, uint8_t x, uint8_t y, const char *s)
 {
-    i2c_OLED_set_xy(displayPort->device, x, y);
-    i2c_OLED_send_string(displayPort->device, s);
+    displayBufferWrite(&oledScreenDirty, oledScreen, SCREEN_CHARACTER_ROW_COUNT, SCREEN_CHARACTER_COLUMN_COUNT, x, y, s);
+
+    // Positioning costs less than sending a single glyph, so spans are not joined
+    displaySpan_t span;
+    while (displayDirtyNextSpan(&oledScreenDirty, 0, &span)) {
+        char text[SCREEN_CHARACTER_COLUMN_COUNT + 1];
+        memcpy(text, &oledScreen[span.y * SCREEN_CHARACTER_COLUMN_COUNT + span.x], span.length);
+        text[span.length] = '\0';
+        i2c_OLED_set_xy(displayPort->device, span.x, span.y);
+        i2c_OLED_send_string(displayPort->device, text);
+    }
     return 0;
 }
 
 static int oledWriteChar(displayPort_t *displayPort, uint8_t x, uint8_t y, uint8_t c)
 {
-    i2c_OLED_set_xy(displayPort->device, x, y);
-    i2c_OLED_send_char(displayPort->device, c);
-    return 0;
+    const char s[2] = { c, 0 };
+    return oledWriteString(displayPort, x, y, s);
 }
 
 static bool oledIsTransferInProgress(const displayPort_t *displayPort)
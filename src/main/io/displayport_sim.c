@@ -0,0 +1,307 @@
+/*
+ * This file is part of Cleanflight and Betaflight.
+ *
+ * Cleanflight and Betaflight are free software. You can redistribute
+ * this software and/or modify this software under the terms of the
+ * GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Cleanflight and Betaflight are distributed in the hope that they
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software.
+ *
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "platform.h"
+
+#ifdef USE_SIM_DISPLAYPORT
+
+#include "common/maths.h"
+#include "common/utils.h"
+
+#include "drivers/display.h"
+#include "drivers/max7456_stream.h"
+
+#include "io/displayport_sim.h"
+
+typedef struct simTransport_s {
+    const char *name;
+    uint8_t spanOverhead;       // bytes to address a span
+    uint8_t charBytes;          // bytes per character sent
+    uint8_t mergeGap;           // unchanged characters sent instead of starting another span
+    bool wholeRows;             // spans are widened to the full row
+    uint8_t clearBytes;         // 0 if clearing sends the whole screen again
+    uint8_t drawBytes;          // to show what was sent, once per frame
+    uint8_t commandBytes;       // grab, release and heartbeat
+    uint16_t frameBudget;       // span bytes sent per draw, 0 for no limit
+} simTransport_t;
+
+static const simTransport_t simTransports[DISPLAYPORT_SIM_TRANSPORT_COUNT] = {
+    // Auto-increment runs, address high and low for each, entering auto-increment mode and leaving it again, then a
+    // data register write per character, at most a buffer per draw
+    [DISPLAYPORT_SIM_TRANSPORT_MAX7456] = {
+        .name = "MAX7456",
+        .spanOverhead = 4 + 2 + MAX7456_STREAM_END_BYTES,
+        .charBytes = 2,
+        .mergeGap = MAX7456_STREAM_MERGE_GAP,
+        .frameBudget = MAX7456_STREAM_SIZE,
+    },
+    // MSP header, size, command and checksum, then subcommand, row, column and attribute for a write
+    [DISPLAYPORT_SIM_TRANSPORT_MSP] = {
+        .name = "MSP",
+        .spanOverhead = 10,
+        .charBytes = 1,
+        .mergeGap = 10,
+        .clearBytes = 7,
+        .drawBytes = 7,
+        .commandBytes = 7,
+    },
+    // Sync, length, type, destination, origin, subcommand and crc, plus the row for an update
+    [DISPLAYPORT_SIM_TRANSPORT_CRSF] = {
+        .name = "CRSF",
+        .spanOverhead = 8,
+        .charBytes = 1,
+        .mergeGap = DISPLAY_DIRTY_COLS_MAX,
+        .wholeRows = true,
+        .clearBytes = 7,
+    },
+};
+
+static displayPort_t simDisplayPort;
+static const simTransport_t *simTransport;
+
+static char simScreen[DISPLAY_DIRTY_ROWS_MAX * DISPLAY_DIRTY_COLS_MAX];  // as written
+static char simShown[DISPLAY_DIRTY_ROWS_MAX * DISPLAY_DIRTY_COLS_MAX];   // as on the remote screen
+static displayDirty_t simScreenDirty;
+static bool simDrawPending;
+static uint32_t simPendingBytes;    // commands sent since the last frame
+
+static displayPortSimStats_t simStats;
+static displayPortSimFrameFn *simFrameFn;
+
+static int simCommand(void)
+{
+    simPendingBytes += simTransport->commandBytes;
+    return simTransport->commandBytes;
+}
+
+static int simGrab(displayPort_t *displayPort)
+{
+    UNUSED(displayPort);
+    return simCommand();
+}
+
+static int simRelease(displayPort_t *displayPort)
+{
+    UNUSED(displayPort);
+    return simCommand();
+}
+
+static int simHeartbeat(displayPort_t *displayPort)
+{
+    UNUSED(displayPort);
+    return simCommand();
+}
+
+static int simClearScreen(displayPort_t *displayPort)
+{
+    memset(simScreen, ' ', sizeof(simScreen));
+    simStats.clears++;
+
+    if (simTransport->clearBytes) {
+        memset(simShown, ' ', sizeof(simShown));
+        displayDirtyClear(&simScreenDirty);
+        simPendingBytes += simTransport->clearBytes;
+        simDrawPending = true;
+    } else {
+        displayDirtyMarkAll(&simScreenDirty, displayPort->rows, displayPort->cols);
+    }
+    return 0;
+}
+
+static int simDrawScreen(displayPort_t *displayPort)
+{
+    uint32_t spanBytes = 0;
+    displaySpan_t span;
+
+    simStats.draws++;
+
+    while (displayDirtyNextSpan(&simScreenDirty, simTransport->mergeGap, &span)) {
+        if (simTransport->wholeRows) {
+            span.x = 0;
+            span.length = displayPort->cols;
+        }
+
+        uint8_t length = span.length;
+        if (simTransport->frameBudget) {
+            const int budget = simTransport->frameBudget - (int)spanBytes - simTransport->spanOverhead;
+            length = constrain(budget / simTransport->charBytes, 0, span.length);
+            if (length < span.length) {
+                // the rest goes with the next draw
+                displayDirtyMark(&simScreenDirty, span.x + length, span.y, span.length - length);
+            }
+            if (!length) {
+                break;
+            }
+        }
+
+        const int offset = span.y * displayPort->cols + span.x;
+        memcpy(&simShown[offset], &simScreen[offset], length);
+        spanBytes += simTransport->spanOverhead + length * simTransport->charBytes;
+        simStats.spans++;
+        simStats.charsSent += length;
+        simDrawPending = true;
+    }
+
+    uint32_t frameBytes = simPendingBytes + spanBytes;
+    simPendingBytes = 0;
+    if (simDrawPending && displayDirtyIsClear(&simScreenDirty)) {
+        frameBytes += simTransport->drawBytes;
+        simDrawPending = false;
+    }
+
+    if (frameBytes) {
+        simStats.frames++;
+        simStats.bytesSent += frameBytes;
+        simStats.lastFrameBytes = frameBytes;
+        simStats.maxFrameBytes = MAX(simStats.maxFrameBytes, frameBytes);
+        if (simFrameFn) {
+            simFrameFn(displayPort);
+        }
+    }
+    return frameBytes;
+}
+
+static int simScreenSize(const displayPort_t *displayPort)
+{
+    return displayPort->rows * displayPort->cols;
+}
+
+static int simWriteString(displayPort_t *displayPort, uint8_t x, uint8_t y, const char *s)
+{
+    simStats.writes++;
+    simStats.charsWritten += strlen(s);
+    displayBufferWrite(&simScreenDirty, simScreen, displayPort->rows, displayPort->cols, x, y, s);
+    return 0;
+}
+
+static int simWriteChar(displayPort_t *displayPort, uint8_t x, uint8_t y, uint8_t c)
+{
+    const char s[2] = { c, 0 };
+    return simWriteString(displayPort, x, y, s);
+}
+
+static bool simIsTransferInProgress(const displayPort_t *displayPort)
+{
+    UNUSED(displayPort);
+    return false;
+}
+
+static void simResync(displayPort_t *displayPort)
+{
+    displayDirtyMarkAll(&simScreenDirty, displayPort->rows, displayPort->cols);
+    simDrawScreen(displayPort);
+}
+
+static bool simIsSynced(const displayPort_t *displayPort)
+{
+    UNUSED(displayPort);
+    return displayDirtyIsClear(&simScreenDirty);
+}
+
+static uint32_t simTxBytesFree(const displayPort_t *displayPort)
+{
+    UNUSED(displayPort);
+    return UINT32_MAX;
+}
+
+static const displayPortVTable_t simVTable = {
+    .grab = simGrab,
+    .release = simRelease,
+    .clearScreen = simClearScreen,
+    .drawScreen = simDrawScreen,
+    .screenSize = simScreenSize,
+    .writeString = simWriteString,
+    .writeChar = simWriteChar,
+    .isTransferInProgress = simIsTransferInProgress,
+    .heartbeat = simHeartbeat,
+    .resync = simResync,
+    .isSynced = simIsSynced,
+    .txBytesFree = simTxBytesFree
+};
+
+displayPort_t *displayPortSimInit(displayPortSimTransport_e transport, uint8_t rows, uint8_t cols)
+{
+    simTransport = &simTransports[transport];
+
+    memset(simScreen, ' ', sizeof(simScreen));
+    memset(simShown, ' ', sizeof(simShown));
+    displayDirtyClear(&simScreenDirty);
+    simDrawPending = false;
+    simPendingBytes = 0;
+    displayPortSimResetStats();
+
+    displayInit(&simDisplayPort, &simVTable);
+    simDisplayPort.rows = MIN(rows, DISPLAY_DIRTY_ROWS_MAX);
+    simDisplayPort.cols = MIN(cols, DISPLAY_DIRTY_COLS_MAX);
+    return &simDisplayPort;
+}
+
+const char *displayPortSimTransportName(displayPortSimTransport_e transport)
+{
+    return simTransports[transport].name;
+}
+
+// Called after each draw that sent something, e.g. to show the screen
+void displayPortSimSetFrameCallback(displayPortSimFrameFn *frameFn)
+{
+    simFrameFn = frameFn;
+}
+
+const displayPortSimStats_t *displayPortSimGetStats(void)
+{
+    return &simStats;
+}
+
+void displayPortSimResetStats(void)
+{
+    memset(&simStats, 0, sizeof(simStats));
+}
+
+uint8_t displayPortSimGetChar(uint8_t x, uint8_t y)
+{
+    if (x >= simDisplayPort.cols || y >= simDisplayPort.rows) {
+        return ' ';
+    }
+    return simShown[y * simDisplayPort.cols + x];
+}
+
+// The remote screen as text, a line per row, font symbols outside of printable ASCII show as '.'
+size_t displayPortSimDumpFrame(char *buf, size_t size)
+{
+    size_t length = 0;
+
+    if (!size) {
+        return 0;
+    }
+    for (int y = 0; y < simDisplayPort.rows; y++) {
+        for (int x = 0; x <= simDisplayPort.cols && length + 1 < size; x++) {
+            const uint8_t c = x < simDisplayPort.cols ? displayPortSimGetChar(x, y) : '\n';
+            buf[length++] = (c == '\n' || (c >= ' ' && c <= '~')) ? c : '.';
+        }
+    }
+    buf[length] = '\0';
+    return length;
+}
+
+#endif // USE_SIM_DISPLAYPORT
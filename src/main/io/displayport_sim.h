@@ -0,0 +1,64 @@
+/*
+ * This file is part of Cleanflight and Betaflight.
+ *
+ * Cleanflight and Betaflight are free software. You can redistribute
+ * this software and/or modify this software under the terms of the
+ * GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Cleanflight and Betaflight are distributed in the hope that they
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software.
+ *
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "drivers/display.h"
+
+/*
+ * Virtual display for SITL and unit tests.
+ *
+ * Writes go to a character buffer, drawing the screen sends the changed spans to a second buffer that stands in for
+ * the remote screen. What would go over the wire is costed with the model of a real transport, so OSD and CMS
+ * changes can be measured in bytes sent per refresh without hardware.
+ */
+
+typedef enum {
+    DISPLAYPORT_SIM_TRANSPORT_MAX7456 = 0,  // SPI register writes in auto-increment mode, one transfer per frame
+    DISPLAYPORT_SIM_TRANSPORT_MSP,          // MSP_DISPLAYPORT frames, one per span
+    DISPLAYPORT_SIM_TRANSPORT_CRSF,         // CRSF display port frames, one per row
+    DISPLAYPORT_SIM_TRANSPORT_COUNT
+} displayPortSimTransport_e;
+
+typedef struct displayPortSimStats_s {
+    uint32_t writes;            // writeString and writeChar calls
+    uint32_t charsWritten;      // characters passed to the display port
+    uint32_t clears;
+    uint32_t draws;             // drawScreen calls
+    uint32_t frames;            // draws that sent anything
+    uint32_t spans;
+    uint32_t charsSent;
+    uint32_t bytesSent;         // including clear and draw commands
+    uint32_t lastFrameBytes;
+    uint32_t maxFrameBytes;
+} displayPortSimStats_t;
+
+typedef void displayPortSimFrameFn(const displayPort_t *displayPort);
+
+displayPort_t *displayPortSimInit(displayPortSimTransport_e transport, uint8_t rows, uint8_t cols);
+const char *displayPortSimTransportName(displayPortSimTransport_e transport);
+void displayPortSimSetFrameCallback(displayPortSimFrameFn *frameFn);
+const displayPortSimStats_t *displayPortSimGetStats(void);
+void displayPortSimResetStats(void);
+uint8_t displayPortSimGetChar(uint8_t x, uint8_t y);
+size_t displayPortSimDumpFrame(char *buf, size_t size);
@@ -36,6 +36,9 @@
 #include <stdbool.h>
 #include <string.h>
 
+#include "common/bitarray.h"
+#include "common/maths.h"
+
 #include "drivers/flash.h"
 
 #include "io/flashfs.h"
@@ -54,6 +57,23 @@ static uint8_t bufferHead = 0, bufferTail = 0;
 // The position of the buffer's tail in the overall flash address space:
 static uint32_t tailAddress = 0;
 
+// Where the oldest data on the device starts, this only moves off the start of the device in circular mode
+static uint32_t headAddress = 0;
+
+/* Background erase state.
+ *
+ * A set bit in flashfsCleanSectors means the whole sector is known to be erased, so the tail may enter it and
+ * write without first waiting for an erase. Bits are set by erasing (or by verifying a sector reads back as
+ * erased) and cleared as soon as anything is programmed into the sector.
+ */
+static uint32_t flashfsCleanSectors[(FLASHFS_MAX_SECTORS + 31) / 32];
+static uint32_t eraseAheadSize = 0;
+static bool circularMode = false;
+
+// Progress through the sector the background eraser is currently checking for erased contents
+static int eraseAheadVerifySector = -1;
+static uint32_t eraseAheadVerifyOffset = 0;
+
 static void flashfsClearBuffer(void)
 {
     bufferTail = bufferHead = 0;
@@ -69,13 +89,61 @@ static void flashfsSetTailAddress(uint32_t address)
     tailAddress = address;
 }
 
+/**
+ * Number of sectors whose erase state is tracked, or 0 if the device is too large (or absent) to track.
+ */
+static int flashfsGetTrackedSectorCount(void)
+{
+    const flashGeometry_t *geometry = flashGetGeometry();
+
+    if (geometry->sectorSize == 0) {
+        return 0;
+    }
+
+    const uint32_t sectorCount = geometry->totalSize / geometry->sectorSize;
+
+    return sectorCount <= FLASHFS_MAX_SECTORS ? sectorCount : 0;
+}
+
+static bool flashfsSectorIsClean(int sector)
+{
+    return sector < flashfsGetTrackedSectorCount() && bitArrayGet(flashfsCleanSectors, sector);
+}
+
+static void flashfsMarkSectorsClean(int startSector, int endSector)
+{
+    const int sectorCount = flashfsGetTrackedSectorCount();
+
+    for (int i = startSector; i < endSector && i < sectorCount; i++) {
+        bitArraySet(flashfsCleanSectors, i);
+    }
+
+    eraseAheadVerifySector = -1;
+}
+
+static void flashfsMarkSectorDirty(uint32_t address)
+{
+    const int sectorCount = flashfsGetTrackedSectorCount();
+
+    if (sectorCount > 0) {
+        const int sector = address / flashGetGeometry()->sectorSize;
+
+        if (sector < sectorCount) {
+            bitArrayClr(flashfsCleanSectors, sector);
+        }
+    }
+}
+
 void flashfsEraseCompletely(void)
 {
     flashEraseCompletely();
 
+    flashfsMarkSectorsClean(0, FLASHFS_MAX_SECTORS);
+
     flashfsClearBuffer();
 
     flashfsSetTailAddress(0);
+    headAddress = 0;
 }
 
 /**
@@ -103,6 +171,8 @@ void flashfsEraseRange(uint32_t start, uint32_t end)
     for (int i = startSector; i < endSector; i++) {
         flashEraseSector(i * geometry->sectorSize);
     }
+
+    flashfsMarkSectorsClean(startSector, endSector);
 }
 
 /**
@@ -211,6 +281,8 @@ static uint32_t flashfsWriteBuffers(uint8_t const **buffers, uint32_t *bufferSiz
             break;
         }
 
+        flashfsMarkSectorDirty(tailAddress);
+
         flashPageProgramBegin(tailAddress);
 
         bytesRemainThisIteration = bytesTotalThisIteration;
@@ -245,6 +317,11 @@ static uint32_t flashfsWriteBuffers(uint8_t const **buffers, uint32_t *bufferSiz
         // Advance the cursor in the file system to match the bytes we wrote
         flashfsSetTailAddress(tailAddress + bytesTotalThisIteration);
 
+        // In circular mode the oldest data at the start of the device is overwritten next
+        if (circularMode && tailAddress >= flashfsGetSize()) {
+            flashfsSetTailAddress(0);
+        }
+
         /*
          * We'll have to wait for that write to complete before we can issue the next one, so if
          * the user requested asynchronous writes, break now.
@@ -277,7 +354,8 @@ static void flashfsGetDirtyDataBuffers(uint8_t const *buffers[], uint32_t buffer
 }
 
 /**
- * Get the current offset of the file pointer within the volume.
+ * Get the number of bytes of data stored on the device, which is where the next byte will go in the order that
+ * flashfsReadLog() reads them.
  */
 uint32_t flashfsGetOffset(void)
 {
@@ -288,7 +366,10 @@ uint32_t flashfsGetOffset(void)
 
     flashfsGetDirtyDataBuffers(buffers, bufferSizes);
 
-    return tailAddress + bufferSizes[0] + bufferSizes[1];
+    const uint32_t end = tailAddress + bufferSizes[0] + bufferSizes[1];
+
+    // Once a circular log wraps, its data runs from the head to the end of the device, then from the start to the tail
+    return end >= headAddress ? end - headAddress : flashfsGetSize() - headAddress + end;
 }
 
 /**
@@ -491,60 +572,104 @@ int flashfsReadAbs(uint32_t address, uint8_t *buffer, unsigned int len)
 }
 
 /**
- * Find the offset of the start of the free space on the device (or the size of the device if it is full).
+ * Read the data on the device in the order it was written, starting at the given offset from the oldest byte. This
+ * is the same as flashfsReadAbs() until a circular log wraps, then it starts from the oldest data still on the
+ * device and carries on around the end of the device to the newest.
  */
-int flashfsIdentifyStartOfFreeSpace(void)
+int flashfsReadLog(uint32_t offset, uint8_t *buffer, unsigned int len)
 {
-    /* Find the start of the free space on the device by examining the beginning of blocks with a binary search,
-     * looking for ones that appear to be erased. We can achieve this with good accuracy because an erased block
-     * is all bits set to 1, which pretty much never appears in reasonable size substrings of blackbox logs.
-     *
-     * To do better we might write a volume header instead, which would mark how much free space remains. But keeping
-     * a header up to date while logging would incur more writes to the flash, which would consume precious write
-     * bandwidth and block more often.
-     */
+    const uint32_t size = flashfsGetSize();
 
-    enum {
-        /* We can choose whatever power of 2 size we like, which determines how much wastage of free space we'll have
-         * at the end of the last written data. But smaller blocksizes will require more searching.
-         */
-        FREE_BLOCK_SIZE = 2048, // XXX This can't be smaller than page size for underlying flash device.
+    if (offset >= size) {
+        return 0;
+    }
 
-        /* We don't expect valid data to ever contain this many consecutive uint32_t's of all 1 bits: */
-        FREE_BLOCK_TEST_SIZE_INTS = 4, // i.e. 16 bytes
-        FREE_BLOCK_TEST_SIZE_BYTES = FREE_BLOCK_TEST_SIZE_INTS * sizeof(uint32_t)
-    };
+    if (len > size - offset) {
+        len = size - offset;
+    }
+
+    const uint32_t address = offset < size - headAddress ? headAddress + offset : offset - (size - headAddress);
+    const unsigned int firstPart = MIN(len, size - address);
+
+    int bytesRead = flashfsReadAbs(address, buffer, firstPart);
+
+    if (bytesRead == (int)firstPart && len > firstPart) {
+        bytesRead += flashfsReadAbs(0, buffer + firstPart, len - firstPart);
+    }
+
+    return bytesRead;
+}
+
+/* Find the start of the free space on the device by examining the beginning of blocks, looking for ones that appear
+ * to be erased. We can achieve this with good accuracy because an erased block is all bits set to 1, which never
+ * appears in a whole page of a blackbox log (shorter runs of 0xFF can, and would be mistaken for the free space).
+ *
+ * To do better we might write a volume header instead, which would mark how much free space remains. But keeping
+ * a header up to date while logging would incur more writes to the flash, which would consume precious write
+ * bandwidth and block more often.
+ */
+enum {
+    /* We can choose whatever power of 2 size we like, which determines how much wastage of free space we'll have
+     * at the end of the last written data. But smaller blocksizes will require more searching.
+     */
+    FREE_BLOCK_SIZE = 2048, // XXX This can't be smaller than page size for underlying flash device.
 
-    STATIC_ASSERT(FREE_BLOCK_SIZE >= FLASH_MAX_PAGE_SIZE, FREE_BLOCK_SIZE_too_small);
+    /* The first page of a block is tested for all 1 bits, this many bytes at a time: */
+    FREE_BLOCK_TEST_SIZE_INTS = 16, // i.e. 64 bytes
+    FREE_BLOCK_TEST_SIZE_BYTES = FREE_BLOCK_TEST_SIZE_INTS * sizeof(uint32_t)
+};
 
+STATIC_ASSERT(FREE_BLOCK_SIZE >= FLASH_MAX_PAGE_SIZE, FREE_BLOCK_SIZE_too_small);
+
+/**
+ * Check whether the block with the given index appears to be erased, i.e. its whole first page is.
+ *
+ * Returns false if the flash could not be read.
+ */
+static bool flashfsTestBlockErased(int block, bool *blockErased)
+{
     union {
         uint8_t bytes[FREE_BLOCK_TEST_SIZE_BYTES];
         uint32_t ints[FREE_BLOCK_TEST_SIZE_INTS];
     } testBuffer;
 
-    int left = 0; // Smallest block index in the search region
-    int right = flashfsGetSize() / FREE_BLOCK_SIZE; // One past the largest block index in the search region
-    int mid;
-    int result = right;
-    int i;
-    bool blockErased;
+    const uint32_t testSize = MAX(flashGetGeometry()->pageSize, (uint32_t)FREE_BLOCK_TEST_SIZE_BYTES);
 
-    while (left < right) {
-        mid = (left + right) / 2;
+    *blockErased = true;
 
-        if (flashReadBytes(mid * FREE_BLOCK_SIZE, testBuffer.bytes, FREE_BLOCK_TEST_SIZE_BYTES) < FREE_BLOCK_TEST_SIZE_BYTES) {
-            // Unexpected timeout from flash, so bail early (reporting the device fuller than it really is)
-            break;
+    for (uint32_t offset = 0; offset < testSize && *blockErased; offset += FREE_BLOCK_TEST_SIZE_BYTES) {
+        if (flashReadBytes(block * FREE_BLOCK_SIZE + offset, testBuffer.bytes, FREE_BLOCK_TEST_SIZE_BYTES) < FREE_BLOCK_TEST_SIZE_BYTES) {
+            return false;
         }
 
         // Checking the buffer 4 bytes at a time like this is probably faster than byte-by-byte, but I didn't benchmark it :)
-        blockErased = true;
-        for (i = 0; i < FREE_BLOCK_TEST_SIZE_INTS; i++) {
+        for (int i = 0; i < FREE_BLOCK_TEST_SIZE_INTS; i++) {
             if (testBuffer.ints[i] != 0xFFFFFFFF) {
-                blockErased = false;
+                *blockErased = false;
                 break;
             }
         }
+    }
+
+    return true;
+}
+
+/**
+ * Binary search the blocks [left...right) for the leftmost erased block, assuming that all the erased blocks in
+ * the region follow all the written ones. Returns `right` if no erased block is found.
+ */
+static int flashfsFindFirstErasedBlock(int left, int right)
+{
+    int result = right;
+    bool blockErased;
+
+    while (left < right) {
+        const int mid = (left + right) / 2;
+
+        if (!flashfsTestBlockErased(mid, &blockErased)) {
+            // Unexpected timeout from flash, so bail early (reporting the device fuller than it really is)
+            break;
+        }
 
         if (blockErased) {
             /* This erased block might be the leftmost erased block in the volume, but we'll need to continue the
@@ -558,17 +683,215 @@ int flashfsIdentifyStartOfFreeSpace(void)
         }
     }
 
-    return result * FREE_BLOCK_SIZE;
+    return result;
+}
+
+/**
+ * Once a circular log has wrapped, the device holds the newest data, then the erased space, then the oldest data,
+ * so a binary search over the whole volume no longer works. Instead find the erased sector which follows a written
+ * one, then binary search inside the written sector for where its data ends.
+ *
+ * The tail never takes the last erased sector (see flashfsIsEOF()), so a wrapped log always has an erased sector
+ * between its newest and oldest data. Without one the log hasn't wrapped, and its oldest data is at the start.
+ */
+static int flashfsIdentifyStartOfFreeSpaceCircular(void)
+{
+    const int sectorCount = flashfsGetTrackedSectorCount();
+    const int blocksPerSector = MAX(flashGetGeometry()->sectorSize / FREE_BLOCK_SIZE, 1U);
+    bool previousErased;
+    bool erased;
+
+    if (!flashfsTestBlockErased((sectorCount - 1) * blocksPerSector, &previousErased)) {
+        return 0;
+    }
+
+    for (int sector = 0; sector < sectorCount; sector++) {
+        if (!flashfsTestBlockErased(sector * blocksPerSector, &erased)) {
+            return 0;
+        }
+
+        if (erased && !previousErased) {
+            const int previousSector = (sector > 0 ? sector : sectorCount) - 1;
+            const int block = flashfsFindFirstErasedBlock(previousSector * blocksPerSector, (previousSector + 1) * blocksPerSector);
+            const uint32_t address = block * FREE_BLOCK_SIZE;
+
+            return address < flashfsGetSize() ? address : 0;
+        }
+
+        previousErased = erased;
+    }
+
+    // Either the whole device is erased, or a log that never wrapped filled it and the start is reclaimed first
+    return 0;
+}
+
+/**
+ * Find where the oldest data in a circular log starts, given the tail: the first written sector after the erased
+ * space that follows the tail. Until the log wraps that is the start of the device.
+ */
+static uint32_t flashfsIdentifyStartOfOldestData(void)
+{
+    const int sectorCount = flashfsGetTrackedSectorCount();
+    const uint32_t sectorSize = flashGetGeometry()->sectorSize;
+    const int blocksPerSector = MAX(sectorSize / FREE_BLOCK_SIZE, 1U);
+    const int tailSector = tailAddress / sectorSize;
+    bool erased;
+
+    for (int i = 1; i < sectorCount; i++) {
+        const int sector = (tailSector + i) % sectorCount;
+
+        if (!flashfsTestBlockErased(sector * blocksPerSector, &erased)) {
+            return 0;
+        }
+
+        if (!erased) {
+            return sector * sectorSize;
+        }
+    }
+
+    // Everything is in the tail's sector
+    return tailSector * sectorSize;
+}
+
+/**
+ * Find the offset of the start of the free space on the device (or the size of the device if it is full).
+ */
+int flashfsIdentifyStartOfFreeSpace(void)
+{
+    if (circularMode) {
+        return flashfsIdentifyStartOfFreeSpaceCircular();
+    }
+
+    return flashfsFindFirstErasedBlock(0, flashfsGetSize() / FREE_BLOCK_SIZE) * FREE_BLOCK_SIZE;
 }
 
 /**
  * Returns true if the file pointer is at the end of the device.
+ *
+ * In circular mode the end of the device wraps around to the start, so the tail is only stuck when it needs to move
+ * into a sector which hasn't been erased yet. It also doesn't move into the last erased sector ahead of it, which
+ * keeps the boundary between the newest and the oldest data findable after a restart.
  */
 bool flashfsIsEOF(void)
 {
+    if (circularMode) {
+        const uint32_t sectorSize = flashGetGeometry()->sectorSize;
+        const int sector = tailAddress / sectorSize;
+        const int nextSector = (sector + 1) % flashfsGetTrackedSectorCount();
+
+        return tailAddress % sectorSize == 0 && !(flashfsSectorIsClean(sector) && flashfsSectorIsClean(nextSector));
+    }
+
     return tailAddress >= flashfsGetSize();
 }
 
+/**
+ * Erase the given sector unless it already reads back as erased, in which case just mark it clean. Only checks
+ * FLASHFS_ERASE_VERIFY_CHUNK_SIZE bytes per call, so it takes several calls to verify a whole sector.
+ */
+static void flashfsEraseAheadSector(int sector)
+{
+    const uint32_t sectorSize = flashGetGeometry()->sectorSize;
+
+    if (sector != eraseAheadVerifySector) {
+        eraseAheadVerifySector = sector;
+        eraseAheadVerifyOffset = 0;
+    }
+
+    union {
+        uint8_t bytes[FLASHFS_ERASE_VERIFY_CHUNK_SIZE];
+        uint32_t ints[FLASHFS_ERASE_VERIFY_CHUNK_SIZE / sizeof(uint32_t)];
+    } verifyBuffer;
+
+    const int chunkSize = MIN(sectorSize - eraseAheadVerifyOffset, sizeof(verifyBuffer));
+    bool erased = flashReadBytes(sector * sectorSize + eraseAheadVerifyOffset, verifyBuffer.bytes, chunkSize) == chunkSize;
+
+    for (int i = 0; erased && i < chunkSize / (int)sizeof(uint32_t); i++) {
+        erased = verifyBuffer.ints[i] == 0xFFFFFFFF;
+    }
+
+    if (!erased) {
+        // The device stays busy until the erase completes, the next call will find it not ready and return
+        flashEraseSector(sector * sectorSize);
+        flashfsMarkSectorsClean(sector, sector + 1);
+
+        // That was the oldest data, so what is left now starts at the next sector
+        if (headAddress != tailAddress && headAddress / sectorSize == (uint32_t)sector) {
+            headAddress = (sector + 1) % flashfsGetTrackedSectorCount() * sectorSize;
+        }
+
+        return;
+    }
+
+    eraseAheadVerifyOffset += chunkSize;
+
+    if (eraseAheadVerifyOffset >= sectorSize) {
+        flashfsMarkSectorsClean(sector, sector + 1);
+    }
+}
+
+/**
+ * Do a bounded amount of background erase work: keep the configured amount of space ahead of the tail erased, so
+ * that logging never has to wait for an erase. In circular mode the space ahead of the tail holds the oldest logs,
+ * so they are reclaimed oldest-first.
+ *
+ * Each call issues at most one sector erase or verifies a small chunk of one sector, and returns immediately while
+ * the device is busy. Must not be called while logging, since writes can't proceed until an erase completes.
+ */
+void flashfsEraseAheadUpdate(void)
+{
+    const int sectorCount = flashfsGetTrackedSectorCount();
+
+    if (eraseAheadSize == 0 || sectorCount == 0 || !flashfsBufferIsEmpty() || !flashIsReady()) {
+        return;
+    }
+
+    if (!circularMode && tailAddress >= flashfsGetSize()) {
+        return;
+    }
+
+    const uint32_t sectorSize = flashGetGeometry()->sectorSize;
+    const int tailSector = tailAddress / sectorSize;
+    // A partially written tail sector can't be erased, so start with the one after it
+    const int firstSector = tailAddress % sectorSize == 0 ? tailSector : tailSector + 1;
+    const int windowSectors = (eraseAheadSize + sectorSize - 1) / sectorSize;
+
+    for (int i = 0; i < windowSectors; i++) {
+        int sector = firstSector + i;
+
+        if (sector >= sectorCount) {
+            if (!circularMode) {
+                break;
+            }
+            sector -= sectorCount;
+        }
+
+        if (sector == tailSector && (i > 0 || firstSector != tailSector)) {
+            // Wrapped all the way around the device
+            break;
+        }
+
+        if (!flashfsSectorIsClean(sector)) {
+            flashfsEraseAheadSector(sector);
+
+            return;
+        }
+    }
+}
+
+/**
+ * Set how much space ahead of the tail flashfsEraseAheadUpdate() keeps erased (0 to disable it), and whether the
+ * tail should wrap around to the start of the device when it reaches the end. Circular mode requires the background
+ * eraser, since the tail will only move into sectors which are known to be erased.
+ *
+ * Call after initialising the flash chip and before flashfsInit().
+ */
+void flashfsSetEraseAhead(uint32_t eraseAheadBytes, bool circular)
+{
+    eraseAheadSize = eraseAheadBytes;
+    circularMode = circular && eraseAheadBytes > 0 && flashfsGetTrackedSectorCount() > 0;
+}
+
 void flashfsClose(void)
 {
     switch(flashfsGetGeometry()->flashType) {
@@ -595,5 +918,7 @@ void flashfsInit(void)
     if (flashfsGetSize() > 0) {
         // Start the file pointer off at the beginning of free space so caller can start writing immediately
         flashfsSeekAbs(flashfsIdentifyStartOfFreeSpace());
+
+        headAddress = circularMode ? flashfsIdentifyStartOfOldestData() : 0;
     }
 }
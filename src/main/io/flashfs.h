@@ -26,8 +26,16 @@
 // Automatically trigger a flush when this much data is in the buffer
 #define FLASHFS_WRITE_BUFFER_AUTO_FLUSH_LEN 64
 
+// Largest number of sectors the background eraser can keep track of
+#define FLASHFS_MAX_SECTORS 1024
+
+// Number of bytes the background eraser reads per call when checking whether a sector is already erased
+#define FLASHFS_ERASE_VERIFY_CHUNK_SIZE 256
+
 void flashfsEraseCompletely(void);
 void flashfsEraseRange(uint32_t start, uint32_t end);
+void flashfsSetEraseAhead(uint32_t eraseAheadBytes, bool circular);
+void flashfsEraseAheadUpdate(void);
 
 uint32_t flashfsGetSize(void);
 uint32_t flashfsGetOffset(void);
@@ -44,6 +52,7 @@ void flashfsWriteByte(uint8_t byte);
 void flashfsWrite(const uint8_t *data, unsigned int len, bool sync);
 
 int flashfsReadAbs(uint32_t offset, uint8_t *data, unsigned int len);
+int flashfsReadLog(uint32_t offset, uint8_t *data, unsigned int len);
 
 bool flashfsFlushAsync(void);
 void flashfsFlushSync(void);
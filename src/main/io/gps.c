@@ -498,8 +498,14 @@ void gpsUpdate(timeUs_t currentTimeUs)
 {
     // read out available GPS bytes
     if (gpsPort) {
-        while (serialRxBytesWaiting(gpsPort))
-            gpsNewData(serialRead(gpsPort));
+        const uint8_t *data;
+        uint32_t dataSize;
+        while ((dataSize = serialRxSpan(gpsPort, &data))) {
+            for (uint32_t i = 0; i < dataSize; i++) {
+                gpsNewData(data[i]);
+            }
+            serialRxAdvance(gpsPort, dataSize);
+        }
     } else if (GPS_update & GPS_MSP_UPDATE) { // GPS data received via MSP
         gpsSetState(GPS_RECEIVING_DATA);
         gpsData.lastMessage = millis();
@@ -47,6 +47,7 @@
 #include "cms/cms_types.h"
 
 #include "common/axis.h"
+#include "common/hash.h"
 #include "common/maths.h"
 #include "common/printf.h"
 #include "common/typeconversion.h"
@@ -174,7 +175,10 @@ static const char compassBar[] = {
   SYM_HEADING_LINE, SYM_HEADING_DIVIDED_LINE, SYM_HEADING_LINE
 };
 
+// Elements drawn later go on top where they overlap
 static const uint8_t osdElementDisplayOrder[] = {
+    OSD_ARTIFICIAL_HORIZON,
+    OSD_G_FORCE,
     OSD_MAIN_BATT_VOLTAGE,
     OSD_RSSI_VALUE,
     OSD_CROSSHAIRS,
@@ -215,8 +219,60 @@ static const uint8_t osdElementDisplayOrder[] = {
 #ifdef USE_ADC_INTERNAL
     OSD_CORE_TEMPERATURE,
 #endif
+#ifdef USE_GPS
+    OSD_GPS_SATS,
+    OSD_GPS_SPEED,
+    OSD_GPS_LAT,
+    OSD_GPS_LON,
+    OSD_HOME_DIST,
+    OSD_HOME_DIR,
+#endif
+#ifdef USE_ESC_SENSOR
+    OSD_ESC_TMP,
+    OSD_ESC_RPM,
+#endif
+#ifdef USE_BLACKBOX
+    OSD_LOG_STATUS,
+#endif
 };
 
+/*
+ * Incremental drawing. The screen is only cleared when something else has used it, after that each element is only
+ * written when its text changed, and what it leaves behind is blanked. Elements with cheap inputs are not even
+ * formatted again while those stay the same. The elements are drawn in passes over osdElementDisplayOrder, a pass is
+ * spread over several osdUpdate() calls when it takes longer than OSD_ELEMENT_DRAW_BUDGET_US.
+ */
+#ifndef OSD_ELEMENT_DRAW_BUDGET_US
+#define OSD_ELEMENT_DRAW_BUDGET_US      100
+#endif
+// Everything is written again this often, in case the display lost it
+#define OSD_ELEMENT_REFRESH_INTERVAL_US (2 * REFRESH_1S)
+
+typedef struct osdElementState_s {
+    uint32_t inputKey;      // see osdElementInputKey()
+    uint32_t textHash;
+    uint16_t pos;           // item_pos the element was drawn at
+    int8_t x;               // screen area the element covers
+    int8_t y;
+    uint8_t width;
+    uint8_t height;
+    uint8_t rank;           // index in osdElementDisplayOrder
+    bool drawn;
+    bool dirty;             // drawn over or blanked by another element
+} osdElementState_t;
+
+static osdElementState_t osdElementState[OSD_ITEM_COUNT];
+static uint8_t osdElementPassIndex;
+static bool osdElementPassActive;
+static bool osdElementsStale = true;       // screen content unknown, clear before the next pass
+static uint8_t osdElementsUnits;
+static timeUs_t osdElementsRefreshAt;
+
+// Horizon bar symbol drawn in each of the artificial horizon's columns, 0 for none
+#define AH_COLUMN_COUNT 9
+static uint8_t ahColumnRow[AH_COLUMN_COUNT];
+static uint8_t ahColumnSymbol[AH_COLUMN_COUNT];
+
 PG_REGISTER_WITH_RESET_FN(osdConfig_t, osdConfig, PG_OSD_CONFIG, 3);
 
 /**
@@ -243,7 +299,7 @@ static int osdGetBatteryAverageCellVoltage(void)
 static char osdGetBatterySymbol(int cellVoltage)
 {
     if (getBatteryState() == BATTERY_CRITICAL) {
-        return SYM_MAIN_BATT; // FIXME: currently the BAT- symbol, ideally replace with a battery with exclamation mark
+        return (char)SYM_MAIN_BATT; // FIXME: currently the BAT- symbol, ideally replace with a battery with exclamation mark
     } else {
         // Calculate a symbol offset using cell voltage over full cell voltage range
         const int symOffset = scaleRange(cellVoltage, batteryConfig()->vbatmincellvoltage * 10, batteryConfig()->vbatmaxcellvoltage * 10, 0, 7);
@@ -332,10 +388,10 @@ static char osdGetTimerSymbol(osd_timer_source_e src)
 {
     switch (src) {
     case OSD_TIMER_SRC_ON:
-        return SYM_ON_M;
+        return (char)SYM_ON_M;
     case OSD_TIMER_SRC_TOTAL_ARMED:
     case OSD_TIMER_SRC_LAST_ARMED:
-        return SYM_FLY_M;
+        return (char)SYM_FLY_M;
     default:
         return ' ';
     }
@@ -463,16 +519,140 @@ bool osdWarnGetState(uint8_t warningIndex)
     return osdConfig()->enabledWarnings & (1 << warningIndex);
 }
 
-static bool osdDrawSingleElement(uint8_t item)
+static bool osdElementIsActive(uint8_t item)
 {
-    if (!VISIBLE(osdConfig()->item_pos[item]) || BLINK(item)) {
-        return false;
+    switch (item) {
+    case OSD_ARTIFICIAL_HORIZON:
+    case OSD_G_FORCE:
+        return sensors(SENSOR_ACC);
+
+#ifdef USE_GPS
+    case OSD_GPS_SATS:
+    case OSD_GPS_SPEED:
+    case OSD_GPS_LAT:
+    case OSD_GPS_LON:
+    case OSD_HOME_DIST:
+    case OSD_HOME_DIR:
+        return sensors(SENSOR_GPS);
+#endif
+
+#ifdef USE_ESC_SENSOR
+    case OSD_ESC_TMP:
+    case OSD_ESC_RPM:
+        return featureIsEnabled(FEATURE_ESC_SENSOR);
+#endif
+
+#ifdef USE_BLACKBOX
+    case OSD_LOG_STATUS:
+        return IS_RC_MODE_ACTIVE(BOXBLACKBOX);
+#endif
+
+    default:
+        return true;
     }
+}
 
-    uint8_t elemPosX = OSD_X(osdConfig()->item_pos[item]);
-    uint8_t elemPosY = OSD_Y(osdConfig()->item_pos[item]);
-    char buff[OSD_ELEMENT_BUFFER_LENGTH] = "";
+/*
+ * For elements whose text only depends on a few values, packs those into a key, an unchanged key means unchanged text
+ * so formatting can be skipped. Units are not part of the key, changing them redraws everything.
+ */
+static bool osdElementInputKey(uint8_t item, uint32_t *key)
+{
+    switch (item) {
+    case OSD_RSSI_VALUE:
+        *key = getRssi();
+        return true;
+
+    case OSD_MAIN_BATT_VOLTAGE:
+        *key = (uint32_t)getBatteryVoltage() << 16 | osdGetBatteryAverageCellVoltage();
+        return true;
+
+    case OSD_AVG_CELL_VOLTAGE:
+        *key = osdGetBatteryAverageCellVoltage();
+        return true;
 
+    case OSD_CURRENT_DRAW:
+        *key = getAmperage();
+        return true;
+
+    case OSD_MAH_DRAWN:
+        *key = getMAhDrawn();
+        return true;
+
+    case OSD_POWER:
+        *key = getAmperage() * getBatteryVoltage();
+        return true;
+
+    case OSD_ALTITUDE:
+        *key = getEstimatedAltitudeCm();
+        return true;
+
+    case OSD_NUMERICAL_VARIO:
+        *key = getEstimatedVario();
+        return true;
+
+    case OSD_THROTTLE_POS:
+        *key = rcData[THROTTLE];
+        return true;
+
+    case OSD_PITCH_ANGLE:
+        *key = attitude.values.pitch;
+        return true;
+
+    case OSD_ROLL_ANGLE:
+        *key = attitude.values.roll;
+        return true;
+
+    case OSD_NUMERICAL_HEADING:
+    case OSD_COMPASS_BAR:
+        *key = attitude.values.yaw;
+        return true;
+
+    case OSD_ROLL_PIDS:
+    case OSD_PITCH_PIDS:
+    case OSD_YAW_PIDS:
+        {
+            const pidf_t *pid = &currentPidProfile->pid[item - OSD_ROLL_PIDS];
+            *key = pid->P | pid->I << 8 | pid->D << 16;
+            return true;
+        }
+
+    case OSD_PIDRATE_PROFILE:
+        *key = getCurrentPidProfileIndex() << 8 | getCurrentControlRateProfileIndex();
+        return true;
+
+#ifdef USE_GPS
+    case OSD_GPS_SATS:
+        *key = gpsSol.numSat;
+        return true;
+
+    case OSD_GPS_SPEED:
+        *key = gpsSol.groundSpeed;
+        return true;
+
+    case OSD_GPS_LAT:
+        *key = gpsSol.llh.lat;
+        return true;
+
+    case OSD_GPS_LON:
+        *key = gpsSol.llh.lon;
+        return true;
+#endif
+
+#ifdef USE_ADC_INTERNAL
+    case OSD_CORE_TEMPERATURE:
+        *key = getCoreTemperatureCelsius();
+        return true;
+#endif
+
+    default:
+        return false;
+    }
+}
+
+// Formats the text of a single line element, returns false for elements that are not text
+static bool osdFormatElement(uint8_t item, char *buff)
+{
     switch (item) {
     case OSD_FLIP_ARROW: 
         {
@@ -652,8 +832,7 @@ static bool osdDrawSingleElement(uint8_t item)
         }
 
     case OSD_CRAFT_NAME:
-        // This does not strictly support iterative updating if the craft name changes at run time. But since the craft name is not supposed to be changing this should not matter, and blanking the entire length of the craft name string on update will make it impossible to configure elements to be displayed on the right hand side of the craft name.
-        //TODO: When iterative updating is implemented, change this so the craft name is only printed once whenever the OSD 'flight' screen is entered.
+        // Only written again when it changes, a shorter name blanks the rest of the previous one
 
         if (strlen(pilotConfig()->name) == 0) {
             strcpy(buff, "CRAFT_NAME");
@@ -699,44 +878,6 @@ static bool osdDrawSingleElement(uint8_t item)
         buff[3] = 0;
         break;
 
-    case OSD_ARTIFICIAL_HORIZON:
-        {
-            // Get pitch and roll limits in tenths of degrees
-            const int maxPitch = osdConfig()->ahMaxPitch * 10;
-            const int maxRoll = osdConfig()->ahMaxRoll * 10;
-            const int rollAngle = constrain(attitude.values.roll, -maxRoll, maxRoll);
-            int pitchAngle = constrain(attitude.values.pitch, -maxPitch, maxPitch);
-            // Convert pitchAngle to y compensation value
-            // (maxPitch / 25) divisor matches previous settings of fixed divisor of 8 and fixed max AHI pitch angle of 20.0 degrees
-            pitchAngle = ((pitchAngle * 25) / maxPitch) - 41; // 41 = 4 * AH_SYMBOL_COUNT + 5
-
-            for (int x = -4; x <= 4; x++) {
-                const int y = ((-rollAngle * x) / 64) - pitchAngle;
-                if (y >= 0 && y <= 81) {
-                    displayWriteChar(osdDisplayPort, elemPosX + x, elemPosY + (y / AH_SYMBOL_COUNT), (SYM_AH_BAR9_0 + (y % AH_SYMBOL_COUNT)));
-                }
-            }
-
-            return true;
-        }
-
-    case OSD_HORIZON_SIDEBARS:
-        {
-            // Draw AH sides
-            const int8_t hudwidth = AH_SIDEBAR_WIDTH_POS;
-            const int8_t hudheight = AH_SIDEBAR_HEIGHT_POS;
-            for (int y = -hudheight; y <= hudheight; y++) {
-                displayWriteChar(osdDisplayPort, elemPosX - hudwidth, elemPosY + y, SYM_AH_DECORATION);
-                displayWriteChar(osdDisplayPort, elemPosX + hudwidth, elemPosY + y, SYM_AH_DECORATION);
-            }
-
-            // AH level indicators
-            displayWriteChar(osdDisplayPort, elemPosX - hudwidth + 1, elemPosY, SYM_AH_LEFT);
-            displayWriteChar(osdDisplayPort, elemPosX + hudwidth - 1, elemPosY, SYM_AH_RIGHT);
-
-            return true;
-        }
-
     case OSD_G_FORCE:
         {
             osdGForce = 0.0f;
@@ -775,7 +916,7 @@ static bool osdDrawSingleElement(uint8_t item)
 #define OSD_WARNINGS_MAX_SIZE 11
 #define OSD_FORMAT_MESSAGE_BUFFER_SIZE (OSD_WARNINGS_MAX_SIZE + 1)
 
-            STATIC_ASSERT(OSD_FORMAT_MESSAGE_BUFFER_SIZE <= sizeof(buff), osd_warnings_size_exceeds_buffer_size);
+            STATIC_ASSERT(OSD_FORMAT_MESSAGE_BUFFER_SIZE <= OSD_ELEMENT_BUFFER_LENGTH, osd_warnings_size_exceeds_buffer_size);
 
             const batteryState_e batteryState = getBatteryState();
 
@@ -948,13 +1089,13 @@ static bool osdDrawSingleElement(uint8_t item)
             const uint8_t mAhUsedProgress = ceilf((value / (batteryConfig()->batteryCapacity / MAIN_BATT_USAGE_STEPS)));
 
             // Create empty battery indicator bar
-            buff[0] = SYM_PB_START;
+            buff[0] = (char)SYM_PB_START;
             for (int i = 1; i <= MAIN_BATT_USAGE_STEPS; i++) {
                 buff[i] = i <= mAhUsedProgress ? SYM_PB_FULL : SYM_PB_EMPTY;
             }
-            buff[MAIN_BATT_USAGE_STEPS + 1] = SYM_PB_CLOSE;
+            buff[MAIN_BATT_USAGE_STEPS + 1] = (char)SYM_PB_CLOSE;
             if (mAhUsedProgress > 0 && mAhUsedProgress < MAIN_BATT_USAGE_STEPS) {
-                buff[1 + mAhUsedProgress] = SYM_PB_END;
+                buff[1 + mAhUsedProgress] = (char)SYM_PB_END;
             }
             buff[MAIN_BATT_USAGE_STEPS+2] = '\0';
             break;
@@ -1035,53 +1176,291 @@ static bool osdDrawSingleElement(uint8_t item)
         return false;
     }
 
-    displayWrite(osdDisplayPort, elemPosX, elemPosY, buff);
-
     return true;
 }
 
-static void osdDrawElements(void)
+static bool osdElementCovers(uint8_t item, int x, int y, int width)
 {
-    displayClearScreen(osdDisplayPort);
+    const osdElementState_t *state = &osdElementState[item];
 
-    // Hide OSD when OSDSW mode is active
-    if (IS_RC_MODE_ACTIVE(BOXOSD)) {
-        return;
+    if (y < state->y || y >= state->y + state->height) {
+        return false;
     }
 
-    if (sensors(SENSOR_ACC)) {
-        osdDrawSingleElement(OSD_ARTIFICIAL_HORIZON);
-        osdDrawSingleElement(OSD_G_FORCE);
+    if (item == OSD_HORIZON_SIDEBARS) {
+        // Only the two bars and the level indicators next to them
+        const int left = state->x;
+        const int right = state->x + state->width - 1;
+        const bool centre = (y == state->y + state->height / 2);
+        return (left >= x && left < x + width) || (right >= x && right < x + width)
+            || (centre && left + 1 < x + width && right - 1 >= x);
     }
 
+    return x < state->x + state->width && state->x < x + width;
+}
+
+/*
+ * Writing over other elements means those on top of the writer must be drawn again. Blanking (erase) reveals what
+ * is underneath, so everything there is drawn again too, elements already visited in this pass get it in the next one.
+ */
+static void osdElementsMarkDirty(uint8_t item, int x, int y, int width, bool erase)
+{
+    const uint8_t rank = osdElementState[item].rank;
 
     for (unsigned i = 0; i < sizeof(osdElementDisplayOrder); i++) {
-        osdDrawSingleElement(osdElementDisplayOrder[i]);
+        const uint8_t other = osdElementDisplayOrder[i];
+        if (other != item && osdElementState[other].drawn && (erase || i > rank) && osdElementCovers(other, x, y, width)) {
+            osdElementState[other].dirty = true;
+        }
     }
+}
 
-#ifdef USE_GPS
-    if (sensors(SENSOR_GPS)) {
-        osdDrawSingleElement(OSD_GPS_SATS);
-        osdDrawSingleElement(OSD_GPS_SPEED);
-        osdDrawSingleElement(OSD_GPS_LAT);
-        osdDrawSingleElement(OSD_GPS_LON);
-        osdDrawSingleElement(OSD_HOME_DIST);
-        osdDrawSingleElement(OSD_HOME_DIR);
+static void osdWriteElementChar(uint8_t item, int x, int y, uint8_t c)
+{
+    displayWriteChar(osdDisplayPort, x, y, c);
+    osdElementsMarkDirty(item, x, y, 1, c == ' ');
+}
+
+static void osdSetElementArea(uint8_t item, int x, int y, int width, int height)
+{
+    osdElementState_t *state = &osdElementState[item];
+
+    state->x = x;
+    state->y = y;
+    state->width = width;
+    state->height = height;
+    state->drawn = true;
+    state->dirty = false;
+}
+
+static void osdDrawArtificialHorizon(int elemPosX, int elemPosY)
+{
+    const bool redraw = !osdElementState[OSD_ARTIFICIAL_HORIZON].drawn || osdElementState[OSD_ARTIFICIAL_HORIZON].dirty;
+
+    // Get pitch and roll limits in tenths of degrees
+    const int maxPitch = osdConfig()->ahMaxPitch * 10;
+    const int maxRoll = osdConfig()->ahMaxRoll * 10;
+    const int rollAngle = constrain(attitude.values.roll, -maxRoll, maxRoll);
+    int pitchAngle = constrain(attitude.values.pitch, -maxPitch, maxPitch);
+    // Convert pitchAngle to y compensation value
+    // (maxPitch / 25) divisor matches previous settings of fixed divisor of 8 and fixed max AHI pitch angle of 20.0 degrees
+    pitchAngle = ((pitchAngle * 25) / maxPitch) - 41; // 41 = 4 * AH_SYMBOL_COUNT + 5
+
+    for (int x = -4; x <= 4; x++) {
+        const int column = x + 4;
+        const int y = ((-rollAngle * x) / 64) - pitchAngle;
+        uint8_t row = 0;
+        uint8_t symbol = 0;
+        if (y >= 0 && y <= 81) {
+            row = elemPosY + (y / AH_SYMBOL_COUNT);
+            symbol = SYM_AH_BAR9_0 + (y % AH_SYMBOL_COUNT);
+        }
+
+        if (ahColumnSymbol[column] && (!symbol || row != ahColumnRow[column])) {
+            osdWriteElementChar(OSD_ARTIFICIAL_HORIZON, elemPosX + x, ahColumnRow[column], ' ');
+        }
+        if (symbol && (redraw || row != ahColumnRow[column] || symbol != ahColumnSymbol[column])) {
+            osdWriteElementChar(OSD_ARTIFICIAL_HORIZON, elemPosX + x, row, symbol);
+        }
+        ahColumnRow[column] = row;
+        ahColumnSymbol[column] = symbol;
     }
-#endif // GPS
 
-#ifdef USE_ESC_SENSOR
-    if (featureIsEnabled(FEATURE_ESC_SENSOR)) {
-        osdDrawSingleElement(OSD_ESC_TMP);
-        osdDrawSingleElement(OSD_ESC_RPM);
+    osdSetElementArea(OSD_ARTIFICIAL_HORIZON, elemPosX - 4, elemPosY, AH_COLUMN_COUNT, 81 / AH_SYMBOL_COUNT + 1);
+}
+
+static void osdDrawHorizonSidebars(int elemPosX, int elemPosY, uint8_t decoration, uint8_t left, uint8_t right)
+{
+    // Draw AH sides
+    const int8_t hudwidth = AH_SIDEBAR_WIDTH_POS;
+    const int8_t hudheight = AH_SIDEBAR_HEIGHT_POS;
+    for (int y = -hudheight; y <= hudheight; y++) {
+        osdWriteElementChar(OSD_HORIZON_SIDEBARS, elemPosX - hudwidth, elemPosY + y, decoration);
+        osdWriteElementChar(OSD_HORIZON_SIDEBARS, elemPosX + hudwidth, elemPosY + y, decoration);
     }
-#endif
 
-#ifdef USE_BLACKBOX
-    if (IS_RC_MODE_ACTIVE(BOXBLACKBOX)) {
-        osdDrawSingleElement(OSD_LOG_STATUS);
+    // AH level indicators
+    osdWriteElementChar(OSD_HORIZON_SIDEBARS, elemPosX - hudwidth + 1, elemPosY, left);
+    osdWriteElementChar(OSD_HORIZON_SIDEBARS, elemPosX + hudwidth - 1, elemPosY, right);
+
+    osdSetElementArea(OSD_HORIZON_SIDEBARS, elemPosX - hudwidth, elemPosY - hudheight, 2 * hudwidth + 1, 2 * hudheight + 1);
+}
+
+static void osdEraseElement(uint8_t item)
+{
+    osdElementState_t *state = &osdElementState[item];
+
+    if (!state->drawn) {
+        return;
     }
-#endif
+
+    switch (item) {
+    case OSD_ARTIFICIAL_HORIZON:
+        for (int column = 0; column < AH_COLUMN_COUNT; column++) {
+            if (ahColumnSymbol[column]) {
+                osdWriteElementChar(item, state->x + column, ahColumnRow[column], ' ');
+                ahColumnSymbol[column] = 0;
+            }
+        }
+        break;
+
+    case OSD_HORIZON_SIDEBARS:
+        osdDrawHorizonSidebars(OSD_X(state->pos), OSD_Y(state->pos), ' ', ' ', ' ');
+        break;
+
+    default:
+        if (state->width) {
+            char buff[OSD_ELEMENT_BUFFER_LENGTH];
+            memset(buff, ' ', state->width);
+            buff[state->width] = '\0';
+            displayWrite(osdDisplayPort, state->x, state->y, buff);
+            osdElementsMarkDirty(item, state->x, state->y, state->width, true);
+        }
+        break;
+    }
+
+    state->drawn = false;
+}
+
+static void osdDrawTextElement(uint8_t item, int elemPosX, int elemPosY)
+{
+    osdElementState_t *state = &osdElementState[item];
+    const bool unchanged = state->drawn && !state->dirty;
+
+    uint32_t inputKey = 0;
+    const bool hasInputKey = osdElementInputKey(item, &inputKey);
+    if (unchanged && hasInputKey && inputKey == state->inputKey) {
+        return;
+    }
+
+    char buff[OSD_ELEMENT_BUFFER_LENGTH] = "";
+    if (!osdFormatElement(item, buff)) {
+        osdEraseElement(item);
+        return;
+    }
+    state->inputKey = inputKey;
+
+    const int length = strlen(buff);
+    const uint32_t textHash = fnv1a_string(buff);
+    if (unchanged && textHash == state->textHash && length == state->width) {
+        return;
+    }
+
+    // Blank whatever the previous text left behind
+    const int width = state->drawn ? MAX(length, state->width) : length;
+    memset(buff + length, ' ', width - length);
+    buff[width] = '\0';
+
+    if (width) {
+        displayWrite(osdDisplayPort, elemPosX, elemPosY, buff);
+        osdElementsMarkDirty(item, elemPosX, elemPosY, length, false);
+        if (width > length) {
+            osdElementsMarkDirty(item, elemPosX + length, elemPosY, width - length, true);
+        }
+    }
+
+    state->textHash = textHash;
+    osdSetElementArea(item, elemPosX, elemPosY, length, 1);
+}
+
+static void osdDrawElement(uint8_t item)
+{
+    osdElementState_t *state = &osdElementState[item];
+    const uint16_t pos = osdConfig()->item_pos[item];
+
+    if (!VISIBLE(pos) || BLINK(item) || !osdElementIsActive(item)) {
+        osdEraseElement(item);
+        return;
+    }
+
+    if (state->drawn && state->pos != pos) {
+        osdEraseElement(item);
+    }
+    state->pos = pos;
+
+    const int elemPosX = OSD_X(pos);
+    const int elemPosY = OSD_Y(pos);
+
+    switch (item) {
+    case OSD_ARTIFICIAL_HORIZON:
+        osdDrawArtificialHorizon(elemPosX, elemPosY);
+        break;
+
+    case OSD_HORIZON_SIDEBARS:
+        // Static, only drawn when something else has touched it
+        if (!state->drawn || state->dirty) {
+            osdDrawHorizonSidebars(elemPosX, elemPosY, SYM_AH_DECORATION, SYM_AH_LEFT, SYM_AH_RIGHT);
+        }
+        break;
+
+    default:
+        osdDrawTextElement(item, elemPosX, elemPosY);
+        break;
+    }
+}
+
+/*
+ * Called whenever something else cleared or wrote the screen, the next pass starts from a cleared screen.
+ */
+static void osdElementsInvalidate(void)
+{
+    osdElementsStale = true;
+    osdElementPassActive = false;
+}
+
+static void osdElementsStartPass(timeUs_t currentTimeUs)
+{
+    if (osdElementsStale) {
+        displayClearScreen(osdDisplayPort);
+        for (unsigned i = 0; i < sizeof(osdElementDisplayOrder); i++) {
+            osdElementState[osdElementDisplayOrder[i]].rank = i;
+            osdElementState[osdElementDisplayOrder[i]].drawn = false;
+        }
+        memset(ahColumnSymbol, 0, sizeof(ahColumnSymbol));
+        osdElementsStale = false;
+    }
+
+    if (osdElementsUnits != osdConfig()->units || cmpTimeUs(currentTimeUs, osdElementsRefreshAt) >= 0) {
+        for (unsigned i = 0; i < OSD_ITEM_COUNT; i++) {
+            osdElementState[i].dirty = true;
+        }
+        osdElementsUnits = osdConfig()->units;
+        osdElementsRefreshAt = currentTimeUs + OSD_ELEMENT_REFRESH_INTERVAL_US;
+    }
+
+    osdElementPassIndex = 0;
+    osdElementPassActive = true;
+}
+
+// Draws elements of the current pass until the time budget is used up, but always at least one
+static void osdElementsContinuePass(void)
+{
+    const timeUs_t startTimeUs = micros();
+
+    do {
+        osdDrawElement(osdElementDisplayOrder[osdElementPassIndex++]);
+        if (osdElementPassIndex >= sizeof(osdElementDisplayOrder)) {
+            osdElementPassActive = false;
+            break;
+        }
+    } while (cmpTimeUs(micros(), startTimeUs) < OSD_ELEMENT_DRAW_BUDGET_US);
+}
+
+static void osdDrawElements(timeUs_t currentTimeUs)
+{
+    // Hide OSD when OSDSW mode is active
+    if (IS_RC_MODE_ACTIVE(BOXOSD)) {
+        if (!osdElementsStale) {
+            displayClearScreen(osdDisplayPort);
+            osdElementsInvalidate();
+        }
+        return;
+    }
+
+    if (!osdElementPassActive) {
+        osdElementsStartPass(currentTimeUs);
+    }
+    osdElementsContinuePass();
 }
 
 void pgResetFn_osdConfig(osdConfig_t *osdConfig)
@@ -1162,6 +1541,7 @@ void osdInit(displayPort_t *osdDisplayPortToUse)
     memset(blinkBits, 0, sizeof(blinkBits));
 
     displayClearScreen(osdDisplayPort);
+    osdElementsInvalidate();
 
     osdDrawLogo(3, 1);
 
@@ -1418,6 +1798,7 @@ static void osdShowStats(uint16_t endBatteryVoltage)
     char buff[OSD_ELEMENT_BUFFER_LENGTH];
 
     displayClearScreen(osdDisplayPort);
+    osdElementsInvalidate();
     displayWrite(osdDisplayPort, 2, top++, "  --- STATS ---");
 
     if (osdStatGetState(OSD_STAT_RTC_DATE_TIME)) {
@@ -1513,6 +1894,7 @@ static void osdShowStats(uint16_t endBatteryVoltage)
 static void osdShowArmed(void)
 {
     displayClearScreen(osdDisplayPort);
+    osdElementsInvalidate();
     displayWrite(osdDisplayPort, 12, 7, "ARMED");
 }
 
@@ -1558,6 +1940,7 @@ STATIC_UNIT_TESTED void osdRefresh(timeUs_t currentTimeUs)
             if (IS_RC_MODE_ACTIVE(BOXOSD) && osdStatsVisible) {
                 osdStatsVisible = false;
                 displayClearScreen(osdDisplayPort);
+                osdElementsInvalidate();
             } else if (!IS_RC_MODE_ACTIVE(BOXOSD)) {
                 if (!osdStatsVisible) {
                     osdStatsVisible = true;
@@ -1582,6 +1965,7 @@ STATIC_UNIT_TESTED void osdRefresh(timeUs_t currentTimeUs)
             return;
         } else {
             displayClearScreen(osdDisplayPort);
+            osdElementsInvalidate();
             resumeRefreshAt = 0;
             osdStatsEnabled = false;
             stats.armed_time = 0;
@@ -1599,10 +1983,11 @@ STATIC_UNIT_TESTED void osdRefresh(timeUs_t currentTimeUs)
 #ifdef USE_CMS
     if (!displayIsGrabbed(osdDisplayPort)) {
         osdUpdateAlarms();
-        osdDrawElements();
+        osdDrawElements(currentTimeUs);
         displayHeartbeat(osdDisplayPort);
-#ifdef OSD_CALLS_CMS
     } else {
+        osdElementsInvalidate();
+#ifdef OSD_CALLS_CMS
         cmsUpdate(currentTimeUs);
 #endif
     }
@@ -1622,7 +2007,7 @@ void osdUpdate(timeUs_t currentTimeUs)
     }
 
 #ifdef MAX7456_DMA_CHANNEL_TX
-    // don't touch buffers if DMA transaction is in progress
+    // nothing to draw into while one frame is sent and the next waits for it
     if (displayIsTransferInProgress(osdDisplayPort)) {
         return;
     }
@@ -1649,6 +2034,10 @@ void osdUpdate(timeUs_t currentTimeUs)
         osdRefresh(currentTimeUs);
         showVisualBeeper = false;
     } else {
+        // finish a pass that did not fit in its time budget
+        if (osdElementPassActive && !displayIsGrabbed(osdDisplayPort)) {
+            osdElementsContinuePass();
+        }
         // rest of time redraw screen 10 chars per idle so it doesn't lock the main idle
         displayDrawScreen(osdDisplayPort);
     }
@@ -26,6 +26,7 @@
 
 #include "build/build_config.h"
 
+#include "common/maths.h"
 #include "common/utils.h"
 
 #include "pg/pg.h"
@@ -42,6 +43,7 @@
 #endif
 
 #if defined(SIMULATOR_BUILD)
+#include "drivers/serial_shm.h"
 #include "drivers/serial_tcp.h"
 #endif
 
@@ -377,7 +379,10 @@ serialPort_t *openSerialPort(
 #ifdef USE_UART8
         case SERIAL_PORT_USART8:
 #endif
-#if defined(SIMULATOR_BUILD)
+#if defined(SIMULATOR_SERIAL_SHM)
+            // emulate serial ports in shared memory
+            serialPort = serShmOpen(SERIAL_PORT_IDENTIFIER_TO_UARTDEV(identifier), rxCallback, rxCallbackData, baudRate, mode, options);
+#elif defined(SIMULATOR_BUILD)
             // emulate serial ports over TCP
             serialPort = serTcpOpen(SERIAL_PORT_IDENTIFIER_TO_UARTDEV(identifier), rxCallback, rxCallbackData, baudRate, mode, options);
 #else
@@ -512,6 +517,24 @@ static void nopConsumer(uint8_t data)
     UNUSED(data);
 }
 
+// Forward as much of the data received on one port as the other port has room for
+static void serialPassthroughForward(serialPort_t *from, serialPort_t *to, serialConsumer *consumer)
+{
+    const uint8_t *data;
+    const uint32_t count = MIN(serialRxSpan(from, &data), serialTxBytesFree(to));
+    if (count == 0) {
+        return;
+    }
+
+    LED0_ON;
+    serialWriteBuf(to, data, count);
+    for (uint32_t i = 0; i < count; i++) {
+        consumer(data[i]);
+    }
+    serialRxAdvance(from, count);
+    LED0_OFF;
+}
+
 /*
  A high-level serial passthrough implementation. Used by cli to start an
  arbitrary serial passthrough "proxy". Optional callbacks can be given to allow
@@ -531,31 +554,15 @@ void serialPassthrough(serialPort_t *left, serialPort_t *right, serialConsumer *
     LED1_OFF;
 
     // Either port might be open in a mode other than MODE_RXTX. We rely on
-    // serialRxBytesWaiting() to do the right thing for a TX only port. No
+    // serialRxSpan() to do the right thing for a TX only port. No
     // special handling is necessary OR performed.
     while (1) {
         // TODO: maintain a timestamp of last data received. Use this to
         // implement a guard interval and check for `+++` as an escape sequence
         // to return to CLI command mode.
         // https://en.wikipedia.org/wiki/Escape_sequence#Modem_control
-        if (serialRxBytesWaiting(left)) {
-            LED0_ON;
-            uint8_t c = serialRead(left);
-            // Make sure there is space in the tx buffer
-            while (!serialTxBytesFree(right));
-            serialWrite(right, c);
-            leftC(c);
-            LED0_OFF;
-         }
-         if (serialRxBytesWaiting(right)) {
-             LED0_ON;
-             uint8_t c = serialRead(right);
-             // Make sure there is space in the tx buffer
-             while (!serialTxBytesFree(left));
-             serialWrite(left, c);
-             rightC(c);
-             LED0_OFF;
-         }
+        serialPassthroughForward(left, right, leftC);
+        serialPassthroughForward(right, left, rightC);
      }
  }
  #endif
@@ -27,6 +27,7 @@
 
 #include "emfat.h"
 #include "emfat_file.h"
+#include "flash_readahead.h"
 
 #include "io/flashfs.h"
 
@@ -237,7 +238,7 @@ static void bblog_read_proc(uint8_t *dest, int size, uint32_t offset, emfat_entr
 {
     UNUSED(entry);
 
-    flashfsReadAbs(offset, dest, size);
+    flashReadAheadRead(offset, dest, size);
 }
 
 static const emfat_entry_t entriesPredefined[] =
@@ -282,7 +283,7 @@ static void emfat_add_log(emfat_entry_t *entry, int number, uint32_t offset, uin
 
 static void emfat_find_log(emfat_entry_t *entry, int maxCount)
 {
-    uint32_t limit  = flashfsIdentifyStartOfFreeSpace();
+    uint32_t limit  = flashfsGetOffset();
     uint32_t lastOffset = 0;
     uint32_t currOffset = 0;
     int fileNumber = 0;
@@ -290,7 +291,7 @@ static void emfat_find_log(emfat_entry_t *entry, int maxCount)
 
     for ( ; currOffset < limit ; currOffset += 2048) { // XXX 2048 = FREE_BLOCK_SIZE in io/flashfs.c
 
-        flashfsReadAbs(currOffset, buffer, 18);
+        flashfsReadLog(currOffset, buffer, 18);
 
         if (strncmp((char *)buffer, "H Product:Blackbox", 18)) {
             continue;
@@ -324,7 +325,7 @@ void emfat_init_files(void)
 
     // Singleton
     emfat_entry_t *entry = &entries[ENTRY_INDEX_BBL];
-    entry->curr_size = flashfsIdentifyStartOfFreeSpace();
+    entry->curr_size = flashfsGetOffset();
     entry->max_size = flashfsGetSize();
 
     // Detect and list individual power cycle sessions
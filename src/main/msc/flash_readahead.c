@@ -0,0 +1,145 @@
+/*
+ * This file is part of Cleanflight and Betaflight.
+ *
+ * Cleanflight and Betaflight are free software. You can redistribute
+ * this software and/or modify this software under the terms of the
+ * GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Cleanflight and Betaflight are distributed in the hope that they
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software.
+ *
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "platform.h"
+
+#include "build/atomic.h"
+
+#include "common/maths.h"
+
+#include "drivers/nvic.h"
+
+#include "io/flashfs.h"
+
+#include "flash_readahead.h"
+
+#define FLASH_READAHEAD_BUFFER_MASK (FLASH_READAHEAD_BUFFER_SIZE - 1)
+
+#if (FLASH_READAHEAD_BUFFER_SIZE & FLASH_READAHEAD_BUFFER_MASK) != 0
+#error "FLASH_READAHEAD_BUFFER_SIZE must be a power of two"
+#endif
+
+/*
+ * The buffer holds the flash range [start, end), each byte at its flash address modulo the buffer size, so the window
+ * slides forward without ever moving data.
+ */
+static struct {
+    uint8_t buffer[FLASH_READAHEAD_BUFFER_SIZE];
+    uint32_t start;
+    uint32_t end;
+    uint32_t nextReadAddress;
+    uint8_t sequentialReads;
+} readAhead;
+
+static flashReadAheadStats_t readAheadStats;
+
+void flashReadAheadInit(void)
+{
+    memset(&readAhead, 0, sizeof(readAhead));
+    memset(&readAheadStats, 0, sizeof(readAheadStats));
+}
+
+static void copyFromBuffer(uint32_t address, uint8_t *dest, unsigned int len)
+{
+    const unsigned int offset = address & FLASH_READAHEAD_BUFFER_MASK;
+    const unsigned int firstPart = MIN(len, FLASH_READAHEAD_BUFFER_SIZE - offset);
+
+    memcpy(dest, &readAhead.buffer[offset], firstPart);
+    memcpy(dest + firstPart, &readAhead.buffer[0], len - firstPart);
+}
+
+/*
+ * Read from flash, serving what we can from the read-ahead buffer. Called from the USB interrupt.
+ */
+int flashReadAheadRead(uint32_t address, uint8_t *buffer, unsigned int len)
+{
+    if (address == readAhead.nextReadAddress) {
+        if (readAhead.sequentialReads < FLASH_READAHEAD_SEQUENTIAL_THRESHOLD) {
+            readAhead.sequentialReads++;
+        }
+    } else {
+        readAhead.sequentialReads = 0;
+    }
+    readAhead.nextReadAddress = address + len;
+
+    unsigned int bytesFromBuffer = 0;
+
+    if (address >= readAhead.start && address < readAhead.end) {
+        bytesFromBuffer = MIN(len, readAhead.end - address);
+        copyFromBuffer(address, buffer, bytesFromBuffer);
+    }
+
+    int bytesRead = bytesFromBuffer;
+
+    if (bytesFromBuffer < len) {
+        bytesRead += flashfsReadLog(address + bytesFromBuffer, buffer + bytesFromBuffer, len - bytesFromBuffer);
+    }
+
+    readAheadStats.hitBytes += bytesFromBuffer;
+    readAheadStats.missBytes += len - bytesFromBuffer;
+
+    // The host doesn't read the same data twice, so whatever lies before the end of this read can be discarded
+    if (readAhead.nextReadAddress < readAhead.start || readAhead.nextReadAddress > readAhead.end) {
+        readAhead.end = readAhead.nextReadAddress;
+    }
+    readAhead.start = readAhead.nextReadAddress;
+
+    return bytesRead;
+}
+
+/*
+ * Fill the next chunk of the read-ahead buffer if the host is reading sequentially. Called from the idle loop while in
+ * MSC mode. Returns true if anything was read from flash.
+ *
+ * The USB interrupt is held off for the duration so that it can neither see a half-filled buffer nor start its own
+ * flash transaction in the middle of ours.
+ */
+bool flashReadAheadPrefetch(void)
+{
+    bool prefetched = false;
+
+    ATOMIC_BLOCK(NVIC_PRIO_USB) {
+        const uint32_t buffered = readAhead.end - readAhead.start;
+
+        if (readAhead.sequentialReads >= FLASH_READAHEAD_SEQUENTIAL_THRESHOLD && buffered < FLASH_READAHEAD_BUFFER_SIZE) {
+            const unsigned int offset = readAhead.end & FLASH_READAHEAD_BUFFER_MASK;
+            const unsigned int len = MIN(MIN(FLASH_READAHEAD_CHUNK_SIZE, FLASH_READAHEAD_BUFFER_SIZE - buffered), FLASH_READAHEAD_BUFFER_SIZE - offset);
+
+            const int bytesRead = flashfsReadLog(readAhead.end, &readAhead.buffer[offset], len);
+
+            if (bytesRead > 0) {
+                readAhead.end += bytesRead;
+                readAheadStats.prefetchedBytes += bytesRead;
+                prefetched = true;
+            }
+        }
+    }
+
+    return prefetched;
+}
+
+const flashReadAheadStats_t *flashReadAheadGetStats(void)
+{
+    return &readAheadStats;
+}
@@ -0,0 +1,55 @@
+/*
+ * This file is part of Cleanflight and Betaflight.
+ *
+ * Cleanflight and Betaflight are free software. You can redistribute
+ * this software and/or modify this software under the terms of the
+ * GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Cleanflight and Betaflight are distributed in the hope that they
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software.
+ *
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Read-ahead buffer for serving onboard flash contents over USB MSC.
+ *
+ * The host reads the log files with sequential SCSI READ commands, which the MSC stack services from the USB interrupt
+ * one packet at a time. Without read-ahead every packet waits for the SPI flash read before the USB transfer can
+ * start. Once sequential reads are detected, the idle loop prefetches the following flash pages into a ring buffer
+ * while the current packet is being sent, so the next READ is served from RAM.
+ */
+
+// Must be a power of two. Holds one F4 MSC media packet (8 sectors).
+#ifndef FLASH_READAHEAD_BUFFER_SIZE
+#define FLASH_READAHEAD_BUFFER_SIZE 4096
+#endif
+
+// Prefetch granularity, one flash page, which bounds how long a prefetch holds off the USB interrupt
+#define FLASH_READAHEAD_CHUNK_SIZE 256
+
+// Consecutive sequential reads before prefetching starts
+#define FLASH_READAHEAD_SEQUENTIAL_THRESHOLD 2
+
+typedef struct flashReadAheadStats_s {
+    uint32_t hitBytes;
+    uint32_t missBytes;
+    uint32_t prefetchedBytes;
+} flashReadAheadStats_t;
+
+void flashReadAheadInit(void);
+int flashReadAheadRead(uint32_t address, uint8_t *buffer, unsigned int len);
+bool flashReadAheadPrefetch(void);
+const flashReadAheadStats_t *flashReadAheadGetStats(void);
@@ -22,6 +22,8 @@
  * Author: jflyper (https://github.com/jflyper)
  */
 
+#include "platform.h"
+
 #ifdef USE_HAL_DRIVER
 #include "usbd_msc.h"
 #else
@@ -30,9 +32,20 @@
 #endif
 
 #include "usbd_storage.h"
+#include "flash_readahead.h"
 
 #ifdef USE_HAL_DRIVER
 USBD_StorageTypeDef *USBD_STORAGE_fops;
 #else
 USBD_STORAGE_cb_TypeDef *USBD_STORAGE_fops;
 #endif
+
+// Background work for the active storage backend, run from the MSC mode idle loop
+void mscStorageIdle(void)
+{
+#ifdef USE_FLASHFS
+    if (USBD_STORAGE_fops == &USBD_MSC_EMFAT_fops) {
+        flashReadAheadPrefetch();
+    }
+#endif
+}
@@ -44,3 +44,5 @@ extern USBD_STORAGE_cb_TypeDef USBD_MSC_MICRO_SDIO_fops;
 extern USBD_STORAGE_cb_TypeDef USBD_MSC_EMFAT_fops;
 #endif
 #endif
+
+void mscStorageIdle(void);
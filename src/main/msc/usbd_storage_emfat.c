@@ -30,6 +30,8 @@
 
 #include "platform.h"
 
+#include "blackbox/blackbox.h"
+
 #include "common/utils.h"
 
 #include "drivers/light_led.h"
@@ -43,6 +45,7 @@
 #include "usbd_storage.h"
 #include "usbd_storage_emfat.h"
 #include "emfat_file.h"
+#include "flash_readahead.h"
 
 
 #define STORAGE_LUN_NBR 1
@@ -71,9 +74,14 @@ static int8_t STORAGE_Init(uint8_t lun)
 #ifdef USE_FLASHFS 
 #ifdef USE_FLASH
     flashInit(flashConfig());
+#endif
+#ifdef USE_BLACKBOX
+    // A circular log is read back oldest first
+    flashfsSetEraseAhead(blackboxConfig()->flash_erase_ahead_kb * 1024, blackboxConfig()->flash_circular);
 #endif
     flashfsInit();
 #endif
+    flashReadAheadInit();
     emfat_init_files();
 
     delay(1000);
@@ -26,6 +26,7 @@
 
 #include "build/debug.h"
 
+#include "common/maths.h"
 #include "common/streambuf.h"
 #include "common/utils.h"
 #include "common/crc.h"
@@ -33,14 +34,29 @@
 #include "drivers/system.h"
 
 #include "interface/msp.h"
+#include "interface/msp_dispatch.h"
 #include "interface/cli.h"
 
 #include "io/serial.h"
 
 #include "msp/msp_serial.h"
 
+// Don't bother producing a stream frame unless the port can take at least this much of it
+#define MSP_STREAM_MIN_FRAME_SIZE 64
+#define MSP_MAX_CHECKSUM_SIZE 2
+
+// Commands queued on a port are answered back to back in one pass, up to this many, rather than one per pass
+#define MSP_MAX_COMMANDS_PER_PASS 8
+// Only go on to the next queued command while the port has at least this much room for its reply
+#define MSP_PIPELINE_MIN_TX_FREE 64
+
 static mspPort_t mspPorts[MAX_MSP_PORT_COUNT];
 
+static uint8_t mspSerialOutBuf[MSP_PORT_OUTBUF_SIZE];
+
+// The port whose command is being processed right now, if any
+static mspPort_t *mspProcessingPort;
+
 static void resetMspPort(mspPort_t *mspPortToReset, serialPort_t *serialPort, bool sharedWithTelemetry)
 {
     memset(mspPortToReset, 0, sizeof(mspPort_t));
@@ -277,12 +293,10 @@ static int mspSerialSendFrame(mspPort_t *msp, const uint8_t * hdr, int hdrLen, c
     if (!isSerialTransmitBufferEmpty(msp->port) && ((int)serialTxBytesFree(msp->port) < totalFrameLength))
         return 0;
 
-    // Transmit frame
-    serialBeginWrite(msp->port);
+    // Transmit frame, the caller brackets the frames it sends with serialBeginWrite() and serialEndWrite()
     serialWriteBuf(msp->port, hdr, hdrLen);
     serialWriteBuf(msp->port, data, dataLen);
     serialWriteBuf(msp->port, crc, crcLen);
-    serialEndWrite(msp->port);
 
     return totalFrameLength;
 }
@@ -380,12 +394,32 @@ static int mspSerialEncode(mspPort_t *msp, mspPacket_t *packet, mspVersion_e msp
     return mspSerialSendFrame(msp, hdrBuf, hdrLen, sbufPtr(&packet->buf), dataLen, crcBuf, crcLen);
 }
 
-static mspPostProcessFnPtr mspSerialProcessReceivedCommand(mspPort_t *msp, mspProcessCommandFnPtr mspProcessCommandFn)
+static bool mspSerialCanPipeline(mspPort_t *msp)
 {
-    static uint8_t outBuf[MSP_PORT_OUTBUF_SIZE];
+    return isSerialTransmitBufferEmpty(msp->port) || serialTxBytesFree(msp->port) >= MSP_PIPELINE_MIN_TX_FREE;
+}
+
+/*
+ * A pipelined command follows others answered in the same pass, so the replies before it may still be in the transmit
+ * buffer. Its reply is limited to the space left there. Returns false if the command is kept to be answered once the
+ * port has drained, rather than its reply being dropped.
+ *
+ * A query whose reply doesn't fit is run again then. A command which changes something is only run once there is
+ * room for the largest reply it could have, so it is never run twice.
+ */
+static bool mspSerialProcessReceivedCommand(mspPort_t *msp, mspProcessCommandFnPtr mspProcessCommandFn, bool pipelined, mspPostProcessFnPtr *mspPostProcessFnOut)
+{
+    uint8_t *outBufEnd = ARRAYEND(mspSerialOutBuf);
+    if (pipelined && !isSerialTransmitBufferEmpty(msp->port)) {
+        const int replySizeLimit = (int)serialTxBytesFree(msp->port) - MSP_MAX_HEADER_SIZE - MSP_MAX_CHECKSUM_SIZE;
+        if (replySizeLimit < (int)sizeof(mspSerialOutBuf) && !mspCommandIsQuery(msp->cmdMSP)) {
+            return false;
+        }
+        outBufEnd = mspSerialOutBuf + constrain(replySizeLimit, 0, (int)sizeof(mspSerialOutBuf));
+    }
 
     mspPacket_t reply = {
-        .buf = { .ptr = outBuf, .end = ARRAYEND(outBuf), },
+        .buf = { .ptr = mspSerialOutBuf, .end = outBufEnd, },
         .cmd = -1,
         .flags = 0,
         .result = 0,
@@ -402,14 +436,59 @@ static mspPostProcessFnPtr mspSerialProcessReceivedCommand(mspPort_t *msp, mspPr
     };
 
     mspPostProcessFnPtr mspPostProcessFn = NULL;
+
+    mspProcessingPort = msp;
     const mspResult_e status = mspProcessCommandFn(&command, &reply, &mspPostProcessFn);
+    mspProcessingPort = NULL;
 
     if (status != MSP_RESULT_NO_REPLY) {
         sbufSwitchToReader(&reply.buf, outBufHead); // change streambuf direction
-        mspSerialEncode(msp, &reply, msp->mspVersion);
+        if (!mspSerialEncode(msp, &reply, msp->mspVersion) && !isSerialTransmitBufferEmpty(msp->port)) {
+            // Only a query can get here, so running it again is harmless
+            return false;
+        }
     }
 
-    return mspPostProcessFn;
+    *mspPostProcessFnOut = mspPostProcessFn;
+    return true;
+}
+
+/*
+ * Push out as many frames of the port's stream as its transmit buffer has room for.
+ */
+static void mspSerialProcessStream(mspPort_t *msp)
+{
+    serialBeginWrite(msp->port);
+
+    while (msp->streamFn) {
+        const int frameSizeLimit = (int)serialTxBytesFree(msp->port) - MSP_MAX_HEADER_SIZE - MSP_MAX_CHECKSUM_SIZE;
+
+        if (frameSizeLimit < MSP_STREAM_MIN_FRAME_SIZE) {
+            // Wait for the port to drain
+            break;
+        }
+
+        mspPacket_t frame = {
+            .buf = { .ptr = mspSerialOutBuf, .end = mspSerialOutBuf + MIN(frameSizeLimit, (int)sizeof(mspSerialOutBuf)), },
+            .cmd = -1,
+            .flags = 0,
+            .result = 0,
+            .direction = MSP_DIRECTION_REPLY,
+        };
+
+        const mspResult_e status = msp->streamFn(&frame);
+
+        if (status == MSP_RESULT_ACK) {
+            sbufSwitchToReader(&frame.buf, mspSerialOutBuf);
+            mspSerialEncode(msp, &frame, msp->mspVersion);
+        } else if (status == MSP_RESULT_NO_REPLY) {
+            break;
+        } else {
+            msp->streamFn = NULL;
+        }
+    }
+
+    serialEndWrite(msp->port);
 }
 
 static void mspEvaluateNonMspData(mspPort_t * mspPort, uint8_t receivedChar)
@@ -466,6 +545,21 @@ static void mspSerialProcessReceivedReply(mspPort_t *msp, mspProcessReplyFnPtr m
     msp->c_state = MSP_IDLE;
 }
 
+// Returns false if the packet was kept for the next pass
+static bool mspSerialProcessReceivedPacket(mspPort_t *msp, mspProcessCommandFnPtr mspProcessCommandFn, mspProcessReplyFnPtr mspProcessReplyFn, bool pipelined, mspPostProcessFnPtr *mspPostProcessFn)
+{
+    if (msp->packetType == MSP_PACKET_COMMAND) {
+        if (!mspSerialProcessReceivedCommand(msp, mspProcessCommandFn, pipelined, mspPostProcessFn)) {
+            return false;
+        }
+    } else if (msp->packetType == MSP_PACKET_REPLY) {
+        mspSerialProcessReceivedReply(msp, mspProcessReplyFn);
+    }
+
+    msp->c_state = MSP_IDLE;
+    return true;
+}
+
 /*
  * Process MSP commands from serial ports configured as MSP ports.
  *
@@ -481,31 +575,58 @@ void mspSerialProcess(mspEvaluateNonMspData_e evaluateNonMspData, mspProcessComm
 
         mspPostProcessFnPtr mspPostProcessFn = NULL;
 
-        if (serialRxBytesWaiting(mspPort->port)) {
+        // A command kept from the last pass waits for the port to drain, the data received after it is left until then
+        const bool commandKept = mspPort->c_state == MSP_COMMAND_RECEIVED;
+        const bool receiving = commandKept ? isSerialTransmitBufferEmpty(mspPort->port) : serialRxBytesWaiting(mspPort->port);
+
+        if (receiving) {
             // There are bytes incoming - abort pending request
             mspPort->lastActivityMs = millis();
             mspPort->pendingRequest = MSP_PENDING_NONE;
 
-            while (serialRxBytesWaiting(mspPort->port)) {
-                const uint8_t c = serialRead(mspPort->port);
-                const bool consumed = mspSerialProcessReceivedData(mspPort, c);
+            int commandCount = 0;
+            bool passComplete = false;
 
-                if (!consumed && evaluateNonMspData == MSP_EVALUATE_NON_MSP_DATA) {
-                    mspEvaluateNonMspData(mspPort, c);
-                }
+            // The replies to all the commands answered in this pass go out back to back
+            serialBeginWrite(mspPort->port);
+
+            if (commandKept) {
+                mspSerialProcessReceivedPacket(mspPort, mspProcessCommandFn, mspProcessReplyFn, false, &mspPostProcessFn);
+                commandCount++;
+                passComplete = mspPostProcessFn || !mspSerialCanPipeline(mspPort);
+            }
+
+            // Parse the received data in place, a span at a time
+            const uint8_t *data;
+            uint32_t dataSize;
+            while (!passComplete && (dataSize = serialRxSpan(mspPort->port, &data))) {
+                uint32_t bytesParsed = 0;
+
+                while (bytesParsed < dataSize) {
+                    const uint8_t c = data[bytesParsed++];
+                    const bool consumed = mspSerialProcessReceivedData(mspPort, c);
 
-                if (mspPort->c_state == MSP_COMMAND_RECEIVED) {
-                    if (mspPort->packetType == MSP_PACKET_COMMAND) {
-                        mspPostProcessFn = mspSerialProcessReceivedCommand(mspPort, mspProcessCommandFn);
-                    } else if (mspPort->packetType == MSP_PACKET_REPLY) {
-                        mspSerialProcessReceivedReply(mspPort, mspProcessReplyFn);
+                    if (!consumed && evaluateNonMspData == MSP_EVALUATE_NON_MSP_DATA) {
+                        mspEvaluateNonMspData(mspPort, c);
                     }
 
-                    mspPort->c_state = MSP_IDLE;
-                    break; // process one command at a time so as not to block.
+                    if (mspPort->c_state == MSP_COMMAND_RECEIVED) {
+                        const bool processed = mspSerialProcessReceivedPacket(mspPort, mspProcessCommandFn, mspProcessReplyFn, commandCount > 0, &mspPostProcessFn);
+                        commandCount++;
+
+                        // Leave the rest for the next pass if the port is backing up, so as not to block
+                        if (!processed || mspPostProcessFn || commandCount >= MSP_MAX_COMMANDS_PER_PASS || !mspSerialCanPipeline(mspPort)) {
+                            passComplete = true;
+                            break;
+                        }
+                    }
                 }
+
+                serialRxAdvance(mspPort->port, bytesParsed);
             }
 
+            serialEndWrite(mspPort->port);
+
             if (mspPostProcessFn) {
                 waitForSerialPortToFinishTransmitting(mspPort->port);
                 mspPostProcessFn(mspPort->port);
@@ -514,6 +635,10 @@ void mspSerialProcess(mspEvaluateNonMspData_e evaluateNonMspData, mspProcessComm
         else {
             mspProcessPendingRequest(mspPort);
         }
+
+        if (mspPort->streamFn) {
+            mspSerialProcessStream(mspPort);
+        }
     }
 }
 
@@ -525,7 +650,7 @@ bool mspSerialWaiting(void)
             continue;
         }
 
-        if (serialRxBytesWaiting(mspPort->port)) {
+        if (serialRxBytesWaiting(mspPort->port) || mspPort->c_state == MSP_COMMAND_RECEIVED) {
             return true;
         }
     }
@@ -560,11 +685,42 @@ int mspSerialPush(uint8_t cmd, uint8_t *data, int datalen, mspDirection_e direct
             .direction = direction,
         };
 
+        serialBeginWrite(mspPort->port);
         ret = mspSerialEncode(mspPort, &push, MSP_V1);
+        serialEndWrite(mspPort->port);
     }
     return ret; // return the number of bytes written
 }
 
+/*
+ * Begin pushing frames produced by streamFn on the port that the command being processed arrived on. Stream functions
+ * keep their position in the stream to themselves, so this replaces any stream already running, on any port. Returns
+ * false if the command didn't arrive on an MSP serial port.
+ */
+bool mspSerialBeginStream(mspStreamFnPtr streamFn)
+{
+    if (!mspProcessingPort) {
+        return false;
+    }
+
+    for (int portIndex = 0; portIndex < MAX_MSP_PORT_COUNT; portIndex++) {
+        mspPorts[portIndex].streamFn = NULL;
+    }
+    mspProcessingPort->streamFn = streamFn;
+
+    return true;
+}
+
+bool mspSerialIsStreaming(void)
+{
+    for (int portIndex = 0; portIndex < MAX_MSP_PORT_COUNT; portIndex++) {
+        if (mspPorts[portIndex].port && mspPorts[portIndex].streamFn) {
+            return true;
+        }
+    }
+
+    return false;
+}
 
 uint32_t mspSerialTxBytesFree(void)
 {
@@ -589,3 +745,103 @@ uint32_t mspSerialTxBytesFree(void)
 
     return ret;
 }
+
+#ifdef USE_MSP_SUBSCRIPTIONS
+/*
+ * Replace the subscriptions of the port that the command being processed arrived on. Each subscription is first
+ * pushed on the next run of the subscription task. Returns false if the command didn't arrive on an MSP serial port.
+ */
+bool mspSerialSetSubscriptions(const mspSubscription_t *subscriptions, int count)
+{
+    if (!mspProcessingPort || count > MSP_MAX_SUBSCRIPTIONS) {
+        return false;
+    }
+
+    const timeMs_t now = millis();
+    for (int i = 0; i < count; i++) {
+        mspProcessingPort->subscriptions[i] = subscriptions[i];
+        mspProcessingPort->subscriptions[i].nextDueMs = now;
+    }
+    mspProcessingPort->subscriptionCount = count;
+
+    return true;
+}
+
+/*
+ * Generate the reply to a subscribed command and send it unless the port's transmit buffer is too full to take it
+ * without blocking. Returns false if the reply has to wait for the port to drain.
+ */
+static bool mspSerialPushSubscription(mspPort_t *msp, uint8_t cmd, mspProcessCommandFnPtr mspProcessCommandFn)
+{
+    mspPacket_t reply = {
+        .buf = { .ptr = mspSerialOutBuf, .end = ARRAYEND(mspSerialOutBuf), },
+        .cmd = -1,
+        .flags = 0,
+        .result = 0,
+        .direction = MSP_DIRECTION_REPLY,
+    };
+
+    mspPacket_t command = {
+        .buf = { .ptr = NULL, .end = NULL, },
+        .cmd = cmd,
+        .flags = 0,
+        .result = 0,
+        .direction = MSP_DIRECTION_REQUEST,
+    };
+
+    // Subscriptions are limited to plain out commands, none of which have anything to do afterwards
+    mspPostProcessFnPtr mspPostProcessFn = NULL;
+    if (mspProcessCommandFn(&command, &reply, &mspPostProcessFn) != MSP_RESULT_ACK) {
+        // Nothing to send, try again next interval
+        return true;
+    }
+
+    sbufSwitchToReader(&reply.buf, mspSerialOutBuf);
+
+    const int frameSize = MSP_MAX_HEADER_SIZE + sbufBytesRemaining(&reply.buf) + MSP_MAX_CHECKSUM_SIZE;
+    if ((int)serialTxBytesFree(msp->port) < frameSize) {
+        return false;
+    }
+
+    return mspSerialEncode(msp, &reply, msp->mspVersion) > 0;
+}
+
+/*
+ * Push the subscribed commands that are due on each port. A reply that doesn't fit into the transmit buffer stays due
+ * and is retried on the next run, a subscription that fell behind is resynchronised rather than sent in a burst.
+ *
+ * Called periodically by the scheduler.
+ */
+void mspSerialProcessSubscriptions(mspProcessCommandFnPtr mspProcessCommandFn)
+{
+    const timeMs_t now = millis();
+
+    for (int portIndex = 0; portIndex < MAX_MSP_PORT_COUNT; portIndex++) {
+        mspPort_t * const mspPort = &mspPorts[portIndex];
+        if (!mspPort->port || !mspPort->subscriptionCount) {
+            continue;
+        }
+
+        serialBeginWrite(mspPort->port);
+
+        for (int i = 0; i < mspPort->subscriptionCount; i++) {
+            mspSubscription_t *subscription = &mspPort->subscriptions[i];
+            if (cmp32(now, subscription->nextDueMs) < 0) {
+                continue;
+            }
+
+            if (!mspSerialPushSubscription(mspPort, subscription->cmd, mspProcessCommandFn)) {
+                // A smaller reply further on may still fit
+                continue;
+            }
+
+            subscription->nextDueMs += subscription->intervalMs;
+            if (cmp32(now, subscription->nextDueMs) >= 0) {
+                subscription->nextDueMs = now + subscription->intervalMs;
+            }
+        }
+
+        serialEndWrite(mspPort->port);
+    }
+}
+#endif
@@ -93,6 +93,18 @@ typedef struct __attribute__((packed)) {
 
 #define MSP_MAX_HEADER_SIZE     9
 
+#ifdef USE_MSP_SUBSCRIPTIONS
+#define MSP_MAX_SUBSCRIPTIONS 8
+// Subscriptions are pushed by a 100Hz task, so there is no point in asking for them any faster
+#define MSP_SUBSCRIPTION_MIN_INTERVAL_MS 10
+
+typedef struct mspSubscription_s {
+    uint8_t cmd;
+    uint16_t intervalMs;
+    timeMs_t nextDueMs;
+} mspSubscription_t;
+#endif
+
 struct serialPort_s;
 typedef struct mspPort_s {
     struct serialPort_s *port; // null when port unused.
@@ -109,6 +121,11 @@ typedef struct mspPort_s {
     uint8_t checksum1;
     uint8_t checksum2;
     bool sharedWithTelemetry;
+    mspStreamFnPtr streamFn;
+#ifdef USE_MSP_SUBSCRIPTIONS
+    mspSubscription_t subscriptions[MSP_MAX_SUBSCRIPTIONS];
+    uint8_t subscriptionCount;
+#endif
 } mspPort_t;
 
 void mspSerialInit(void);
@@ -118,4 +135,10 @@ void mspSerialAllocatePorts(void);
 void mspSerialReleasePortIfAllocated(struct serialPort_s *serialPort);
 void mspSerialReleaseSharedTelemetryPorts(void);
 int mspSerialPush(uint8_t cmd, uint8_t *data, int datalen, mspDirection_e direction);
+bool mspSerialBeginStream(mspStreamFnPtr streamFn);
+bool mspSerialIsStreaming(void);
 uint32_t mspSerialTxBytesFree(void);
+#ifdef USE_MSP_SUBSCRIPTIONS
+bool mspSerialSetSubscriptions(const mspSubscription_t *subscriptions, int count);
+void mspSerialProcessSubscriptions(mspProcessCommandFnPtr mspProcessCommandFn);
+#endif
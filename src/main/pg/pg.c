@@ -28,9 +28,56 @@
 
 #include "pg.h"
 
-const pgRegistry_t* pgFind(pgn_t pgn)
+// Open addressed PGN -> registry index hash table. The registry is fixed at link time, so it is built on first use.
+#define PG_INDEX_SIZE   256     // power of two, at least twice PG_REGISTRY_MAX_SIZE so that probes stay short
+#define PG_INDEX_MASK   (PG_INDEX_SIZE - 1)
+#define PG_INDEX_EMPTY  0xff
+
+static uint8_t pgIndexTable[PG_INDEX_SIZE];
+static bool pgIndexBuilt;
+
+// Groups that are known to match the stored config have their bit set, so everything starts out dirty
+static uint32_t pgCleanBits[(PG_REGISTRY_MAX_SIZE + 31) / 32];
+
+static unsigned pgIndexSlot(pgn_t pgn)
 {
+    return ((pgn * 2654435761u) >> 24) & PG_INDEX_MASK;
+}
+
+static void pgIndexBuild(void)
+{
+    memset(pgIndexTable, PG_INDEX_EMPTY, sizeof(pgIndexTable));
+
     PG_FOREACH(reg) {
+        if (pgIndex(reg) >= PG_REGISTRY_MAX_SIZE) {
+            break;
+        }
+
+        unsigned slot = pgIndexSlot(pgN(reg));
+        while (pgIndexTable[slot] != PG_INDEX_EMPTY) {
+            slot = (slot + 1) & PG_INDEX_MASK;
+        }
+        pgIndexTable[slot] = pgIndex(reg);
+    }
+
+    pgIndexBuilt = true;
+}
+
+const pgRegistry_t* pgFind(pgn_t pgn)
+{
+    if (!pgIndexBuilt) {
+        pgIndexBuild();
+    }
+
+    // Groups are inserted in registry order, so with duplicate PGNs the first one registered is found first
+    for (unsigned slot = pgIndexSlot(pgn); pgIndexTable[slot] != PG_INDEX_EMPTY; slot = (slot + 1) & PG_INDEX_MASK) {
+        const pgRegistry_t *reg = &__pg_registry_start[pgIndexTable[slot]];
+        if (pgN(reg) == pgn) {
+            return reg;
+        }
+    }
+
+    for (const pgRegistry_t *reg = __pg_registry_start + PG_REGISTRY_MAX_SIZE; reg < __pg_registry_end; reg++) {
         if (pgN(reg) == pgn) {
             return reg;
         }
@@ -38,6 +85,46 @@ const pgRegistry_t* pgFind(pgn_t pgn)
     return NULL;
 }
 
+void pgMarkDirty(const pgRegistry_t* reg)
+{
+    if (!reg) {
+        return;
+    }
+    const int index = pgIndex(reg);
+    if (index >= 0 && index < PG_REGISTRY_MAX_SIZE) {
+        pgCleanBits[index / 32] &= ~(1u << (index % 32));
+    }
+}
+
+void pgMarkClean(const pgRegistry_t* reg)
+{
+    if (!reg) {
+        return;
+    }
+    const int index = pgIndex(reg);
+    if (index >= 0 && index < PG_REGISTRY_MAX_SIZE) {
+        pgCleanBits[index / 32] |= 1u << (index % 32);
+    }
+}
+
+// Groups that are not tracked are always dirty, anything not in the registry never is
+bool pgIsDirty(const pgRegistry_t* reg)
+{
+    if (!reg) {
+        return false;
+    }
+    const int index = pgIndex(reg);
+    if (index < 0) {
+        return false;
+    }
+    return index >= PG_REGISTRY_MAX_SIZE || !(pgCleanBits[index / 32] & (1u << (index % 32)));
+}
+
+void pgMarkAllClean(void)
+{
+    memset(pgCleanBits, 0xff, sizeof(pgCleanBits));
+}
+
 static uint8_t *pgOffset(const pgRegistry_t* reg)
 {
     return reg->address;
@@ -60,6 +147,7 @@ void pgResetInstance(const pgRegistry_t *reg, uint8_t *base)
 void pgReset(const pgRegistry_t* reg)
 {
     pgResetInstance(reg, pgOffset(reg));
+    pgMarkDirty(reg);
 }
 
 bool pgResetCopy(void *copy, pgn_t pgn)
@@ -75,6 +163,7 @@ bool pgResetCopy(void *copy, pgn_t pgn)
 bool pgLoad(const pgRegistry_t* reg, const void *from, int size, int version)
 {
     pgResetInstance(reg, pgOffset(reg));
+    pgMarkDirty(reg);
     // restore only matching version, keep defaults otherwise
     if (version == pgVersion(reg)) {
         const int take = MIN(size, pgSize(reg));
@@ -81,6 +81,12 @@ extern const uint8_t __pg_resetdata_end[];
 
 #define PG_REGISTRY_SIZE (__pg_registry_end - __pg_registry_start)
 
+// Number of groups covered by the PGN index and the dirty tracking, groups beyond this are looked up by scanning
+#define PG_REGISTRY_MAX_SIZE 128
+
+// Position of the group in the registry, stable for the life of the firmware image
+static inline int pgIndex(const pgRegistry_t* reg) {return reg - __pg_registry_start;}
+
 // Helper to iterate over the PG register.  Cheaper than a visitor style callback.
 #define PG_FOREACH(_name) \
     for (const pgRegistry_t *(_name) = __pg_registry_start; (_name) < __pg_registry_end; _name++)
@@ -193,3 +199,10 @@ void pgResetAll(void);
 void pgResetInstance(const pgRegistry_t *reg, uint8_t *base);
 bool pgResetCopy(void *copy, pgn_t pgn);
 void pgReset(const pgRegistry_t* reg);
+
+// Groups that may differ from the stored config. Loads, resets and saves keep these up to date, other writers only mark
+// what the in-flight adjustment save should persist. Regular saves and the CLI diff compare the contents instead.
+void pgMarkDirty(const pgRegistry_t* reg);
+void pgMarkClean(const pgRegistry_t* reg);
+bool pgIsDirty(const pgRegistry_t* reg);
+void pgMarkAllClean(void);
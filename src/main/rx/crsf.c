@@ -50,6 +50,7 @@
 
 #define CRSF_TIME_NEEDED_PER_FRAME_US   1100 // 700 ms + 400 ms for potential ad-hoc request
 #define CRSF_TIME_BETWEEN_FRAMES_US     6667 // At fastest, frames are sent by the transmitter every 6.667 milliseconds, 150 Hz
+#define CRSF_TIME_BETWEEN_FRAMES_MAX_US 250000 // 4 Hz, the slowest RF mode, longer gaps are lost frames
 
 #define CRSF_DIGITAL_CHANNEL_MIN 172
 #define CRSF_DIGITAL_CHANNEL_MAX 1811
@@ -62,8 +63,10 @@ STATIC_UNIT_TESTED uint32_t crsfChannelData[CRSF_MAX_CHANNEL];
 
 static serialPort_t *serialPort;
 static uint32_t crsfFrameStartAtUs = 0;
-static uint8_t telemetryBuf[CRSF_FRAME_SIZE_MAX];
+static uint8_t telemetryBuf[CRSF_TELEMETRY_BATCH_SIZE];
 static uint8_t telemetryBufLen = 0;
+static uint32_t crsfRcFrameStartAtUs = 0;
+static volatile uint32_t crsfRcFrameIntervalUs = CRSF_TIME_BETWEEN_FRAMES_US;
 
 /*
  * CRSF protocol
@@ -124,6 +127,16 @@ STATIC_UNIT_TESTED uint8_t crsfFrameCRC(void)
     return crc;
 }
 
+// Follows the RF mode of the link, smoothed so the odd lost frame hardly changes it
+static void crsfUpdateFrameInterval(uint32_t frameStartAtUs)
+{
+    const uint32_t intervalUs = frameStartAtUs - crsfRcFrameStartAtUs;
+    crsfRcFrameStartAtUs = frameStartAtUs;
+    if (intervalUs < CRSF_TIME_BETWEEN_FRAMES_MAX_US) {
+        crsfRcFrameIntervalUs += ((int32_t)intervalUs - (int32_t)crsfRcFrameIntervalUs) / 8;
+    }
+}
+
 // Receive ISR callback, called back from serial port
 STATIC_UNIT_TESTED void crsfDataReceive(uint16_t c, void *data)
 {
@@ -154,7 +167,9 @@ STATIC_UNIT_TESTED void crsfDataReceive(uint16_t c, void *data)
         crsfFrameDone = crsfFramePosition < fullFrameLength ? false : true;
         if (crsfFrameDone) {
             crsfFramePosition = 0;
-            if (crsfFrame.frame.type != CRSF_FRAMETYPE_RC_CHANNELS_PACKED) {
+            if (crsfFrame.frame.type == CRSF_FRAMETYPE_RC_CHANNELS_PACKED) {
+                crsfUpdateFrameInterval(crsfFrameStartAtUs);
+            } else {
                 const uint8_t crc = crsfFrameCRC();
                 if (crc == crsfFrame.bytes[fullFrameLength - 1]) {
                     switch (crsfFrame.frame.type)
@@ -254,6 +269,11 @@ void crsfRxSendTelemetryData(void)
     }
 }
 
+uint32_t crsfRxFrameIntervalUs(void)
+{
+    return crsfRcFrameIntervalUs;
+}
+
 bool crsfRxInit(const rxConfig_t *rxConfig, rxRuntimeConfig_t *rxRuntimeConfig)
 {
     for (int ii = 0; ii < CRSF_MAX_CHANNEL; ++ii) {
@@ -28,6 +28,9 @@
 
 #define CRSF_MAX_CHANNEL        16
 
+// Telemetry frames written together in the gap between two RC frames
+#define CRSF_TELEMETRY_BATCH_SIZE   (2 * CRSF_FRAME_SIZE_MAX)
+
 typedef struct crsfFrameDef_s {
     uint8_t deviceAddress;
     uint8_t frameLength;
@@ -42,6 +45,7 @@ typedef union crsfFrame_u {
 
 void crsfRxWriteTelemetryData(const void *data, int len);
 void crsfRxSendTelemetryData(void);
+uint32_t crsfRxFrameIntervalUs(void);
 
 struct rxConfig_s;
 struct rxRuntimeConfig_s;
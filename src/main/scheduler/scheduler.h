@@ -132,6 +132,14 @@ typedef enum {
     TASK_PINIOBOX,
 #endif
 
+#ifdef USE_FLASHFS
+    TASK_FLASHFS_ERASE,
+#endif
+
+#ifdef USE_MSP_SUBSCRIPTIONS
+    TASK_MSP_SUBSCRIPTIONS,
+#endif
+
     /* Count of real tasks */
     TASK_COUNT,
 
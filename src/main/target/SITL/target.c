@@ -26,6 +26,7 @@
 
 #include <errno.h>
 #include <time.h>
+#include <unistd.h>
 
 #include "common/maths.h"
 
@@ -44,6 +45,9 @@ const timerHardware_t timerHardware[1]; // unused
 #include "drivers/accgyro/accgyro_fake.h"
 #include "flight/imu.h"
 
+#include "io/displayport_sim.h"
+
+#include "config/config_streamer.h"
 #include "config/feature.h"
 #include "fc/config.h"
 #include "scheduler/scheduler.h"
@@ -52,7 +56,6 @@ const timerHardware_t timerHardware[1]; // unused
 
 #include "rx/rx.h"
 
-#include "dyad.h"
 #include "target/SITL/udplink.h"
 
 uint32_t SystemCoreClock;
@@ -191,19 +194,49 @@ static void* udpThread(void* data) {
 static void* tcpThread(void* data) {
     UNUSED(data);
 
-    dyad_init();
-    dyad_setTickInterval(0.2f);
-    dyad_setUpdateTimeout(0.5f);
-
+    // Sleeps until there is something to do, the timeout is for noticing workerRunning
     while (workerRunning) {
-        dyad_update();
+        tcpServerUpdate(100);
     }
 
-    dyad_shutdown();
     printf("tcpThread end!!\n");
     return NULL;
 }
 
+#ifdef USE_SIM_DISPLAYPORT
+// Only shown if asked for, the file is opened once and rewritten in place
+static FILE *osdFrameFile = NULL;
+
+static void osdFrameWrite(const displayPort_t *displayPort) {
+    char frame[DISPLAY_DIRTY_ROWS_MAX * (DISPLAY_DIRTY_COLS_MAX + 1) + 1];
+    UNUSED(displayPort);
+
+    const size_t length = displayPortSimDumpFrame(frame, sizeof(frame));
+    rewind(osdFrameFile);
+    fwrite(frame, 1, length, osdFrameFile);
+    fflush(osdFrameFile);
+    if (ftruncate(fileno(osdFrameFile), length) != 0) {
+        printf("[osd]truncate error %d\n", errno);
+    }
+}
+
+static void osdFrameFileInit(void) {
+    const char *filename = getenv(OSD_FRAME_FILENAME_ENV);
+    if (filename == NULL) {
+        return;
+    }
+
+    osdFrameFile = fopen(filename, "w");
+    if (osdFrameFile == NULL) {
+        printf("[osd]can't open %s, error %d\n", filename, errno);
+        return;
+    }
+
+    printf("[osd]frames written to %s\n", filename);
+    displayPortSimSetFrameCallback(osdFrameWrite);
+}
+#endif
+
 // system
 void systemInit(void) {
     int ret;
@@ -224,6 +257,11 @@ void systemInit(void) {
         exit(1);
     }
 
+    if (!tcpServerInit()) {
+        printf("Create tcp server error!\n");
+        exit(1);
+    }
+
     ret = pthread_create(&tcpWorker, NULL, tcpThread, NULL);
     if (ret != 0) {
         printf("Create tcpWorker error!\n");
@@ -242,6 +280,10 @@ void systemInit(void) {
         exit(1);
     }
 
+#ifdef USE_SIM_DISPLAYPORT
+    osdFrameFileInit();
+#endif
+
     // serial can't been slow down
     rescheduleTask(TASK_SERIAL, 1);
 }
@@ -469,7 +511,7 @@ char _Min_Stack_Size;
 
 // fake EEPROM
 static FILE *eepromFd = NULL;
-uint8_t eepromData[EEPROM_SIZE];
+uint8_t eepromData[EEPROM_SIZE] __attribute__((aligned(FLASH_PAGE_SIZE)));
 
 void FLASH_Unlock(void) {
     if (eepromFd != NULL) {
@@ -518,7 +560,9 @@ void FLASH_Lock(void) {
 }
 
 FLASH_Status FLASH_ErasePage(uintptr_t Page_Address) {
-    UNUSED(Page_Address);
+    if ((Page_Address >= (uintptr_t)eepromData) && (Page_Address + FLASH_PAGE_SIZE <= (uintptr_t)ARRAYEND(eepromData))) {
+        memset((void *)Page_Address, 0xFF, FLASH_PAGE_SIZE);
+    }
 //    printf("[FLASH_ErasePage]%x\n", Page_Address);
     return FLASH_COMPLETE;
 }
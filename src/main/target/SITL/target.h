@@ -40,11 +40,17 @@
 //#define SIMULATOR_IMU_SYNC
 //#define SIMULATOR_GYROPID_SYNC
 
+// serial ports in shared memory instead of TCP, see drivers/serial_shm.h
+//#define SIMULATOR_SERIAL_SHM
+
 // file name to save config
 #define EEPROM_FILENAME "eeprom.bin"
 #define EEPROM_IN_RAM
 #define EEPROM_SIZE     32768
 
+// environment variable naming a text file to show the OSD in, rewritten with each frame sent
+#define OSD_FRAME_FILENAME_ENV "SITL_OSD_FILE"
+
 #define U_ID_0 0
 #define U_ID_1 1
 #define U_ID_2 2
@@ -69,6 +75,8 @@
 #define USE_BARO
 #define USE_FAKE_BARO
 
+#define USE_SIM_DISPLAYPORT
+
 #define USABLE_TIMER_CHANNEL_COUNT 0
 
 #define USE_UART1
@@ -86,7 +94,7 @@
 #define SERIAL_PORT_COUNT 8
 
 #define DEFAULT_RX_FEATURE      FEATURE_RX_MSP
-#define DEFAULT_FEATURES        (FEATURE_GPS | FEATURE_TELEMETRY)
+#define DEFAULT_FEATURES        (FEATURE_GPS | FEATURE_TELEMETRY | FEATURE_OSD)
 
 #define USE_PARAMETER_GROUPS
 
@@ -95,7 +103,6 @@
 #undef USE_TELEMETRY_LTM
 #undef USE_ADC
 #undef USE_VCP
-#undef USE_OSD
 #undef USE_PPM
 #undef USE_PWM
 #undef USE_SERIAL_RX
@@ -112,7 +119,6 @@
 #undef USE_TELEMETRY_SMARTPORT
 #undef USE_TELEMETRY_MAVLINK
 #undef USE_RESOURCE_MGMT
-#undef USE_CMS
 #undef USE_TELEMETRY_CRSF
 #undef USE_TELEMETRY_IBUS
 #undef USE_TELEMETRY_JETIEXBUS
@@ -142,6 +142,10 @@
 #undef USE_USB_CDC_HID
 #endif
 
+#if !defined(USE_FLASHFS)
+#undef USE_MSP_DATAFLASH_STREAM
+#endif
+
 #if defined(USE_USB_CDC_HID) || defined(USE_USB_MSC)
 #define USE_USB_ADVANCED_PROFILES
 #endif
@@ -151,6 +155,11 @@
 #define USE_32K_CAPABLE_GYRO
 #endif
 
+// F7 targets have the RAM to give the SD card filesystem a deeper cache to ride out card write latency
+#if defined(USE_SDCARD) && defined(STM32F7) && !defined(AFATFS_NUM_CACHE_SECTORS)
+#define AFATFS_NUM_CACHE_SECTORS 16
+#endif
+
 #if defined(USE_FLASH_W25M512)
 #define USE_FLASH_W25M
 #define USE_FLASH_M25P16
@@ -164,6 +164,10 @@
 #define USE_GYRO_OVERFLOW_CHECK
 #define USE_YAW_SPIN_RECOVERY
 #define USE_HUFFMAN
+#define USE_MSP_DATAFLASH_STREAM
+#define USE_CLI_SETTINGS_INDEX
+#define USE_MSP_SETTINGS
+#define USE_MSP_SUBSCRIPTIONS
 #define USE_MSP_DISPLAYPORT
 #define USE_MSP_OVER_TELEMETRY
 #define USE_PINIO
@@ -49,6 +49,7 @@
 #include "fc/runtime_config.h"
 
 #include "flight/imu.h"
+#include "flight/mixer.h"
 #include "flight/position.h"
 
 #include "interface/crsf_protocol.h"
@@ -59,14 +60,18 @@
 
 #include "rx/crsf.h"
 
+#include "sensors/barometer.h"
 #include "sensors/battery.h"
+#include "sensors/esc_sensor.h"
 #include "sensors/sensors.h"
 
 #include "telemetry/telemetry.h"
 #include "telemetry/crsf.h"
 #include "telemetry/msp_shared.h"
+#include "telemetry/telemetry_scheduler.h"
 
-#define CRSF_CYCLETIME_US                   100000 // 100ms, 10 Hz
+#define CRSF_TELEMETRY_BYTES_PER_RC_FRAME   8  // share of the link given to telemetry, follows the RF mode
+#define CRSF_BYTE_TIME_US                   24 // 420000 baud, 10 bits a byte
 #define CRSF_DEVICEINFO_VERSION             0x01
 #define CRSF_DEVICEINFO_PARAMETER_COUNT     0
 
@@ -75,7 +80,7 @@
 
 static bool crsfTelemetryEnabled;
 static bool deviceInfoReplyPending;
-static uint8_t crsfFrame[CRSF_FRAME_SIZE_MAX];
+static uint8_t crsfFrame[CRSF_TELEMETRY_BATCH_SIZE];
 
 #if defined(USE_MSP_OVER_TELEMETRY)
 typedef struct mspBuffer_s {
@@ -127,17 +132,30 @@ bool handleCrsfMspFrameBuffer(uint8_t payloadSize, mspResponseFnPtr responseFn)
 }
 #endif
 
+static uint8_t *crsfFrameStart;
+
+static void crsfStartFrame(sbuf_t *dst)
+{
+    crsfFrameStart = sbufPtr(dst);
+    sbufWriteU8(dst, CRSF_SYNC_BYTE);
+}
+
+static void crsfEndFrame(sbuf_t *dst)
+{
+    crc8_dvb_s2_sbuf_append(dst, crsfFrameStart + 2); // start at byte 2, since CRC does not include device address and frame length
+}
+
 static void crsfInitializeFrame(sbuf_t *dst)
 {
     dst->ptr = crsfFrame;
-    dst->end = ARRAYEND(crsfFrame);
+    dst->end = crsfFrame + CRSF_FRAME_SIZE_MAX;
 
-    sbufWriteU8(dst, CRSF_SYNC_BYTE);
+    crsfStartFrame(dst);
 }
 
 static void crsfFinalize(sbuf_t *dst)
 {
-    crc8_dvb_s2_sbuf_append(dst, &crsfFrame[2]); // start at byte 2, since CRC does not include device address and frame length
+    crsfEndFrame(dst);
     sbufSwitchToReader(dst, crsfFrame);
     // write the telemetry frame to the receiver.
     crsfRxWriteTelemetryData(sbufPtr(dst), sbufBytesRemaining(dst));
@@ -145,7 +163,7 @@ static void crsfFinalize(sbuf_t *dst)
 
 static int crsfFinalizeBuf(sbuf_t *dst, uint8_t *frame)
 {
-    crc8_dvb_s2_sbuf_append(dst, &crsfFrame[2]); // start at byte 2, since CRC does not include device address and frame length
+    crsfEndFrame(dst);
     sbufSwitchToReader(dst, crsfFrame);
     const int frameSize = sbufBytesRemaining(dst);
     for (int ii = 0; sbufBytesRemaining(dst); ++ii) {
@@ -214,6 +232,72 @@ void crsfFrameBatterySensor(sbuf_t *dst)
     sbufWriteU8(dst, batteryRemainingPercentage);
 }
 
+/*
+0x07 Vario sensor
+Payload:
+int16_t     Vertical speed ( cm/s )
+*/
+void crsfFrameVarioSensor(sbuf_t *dst)
+{
+    sbufWriteU8(dst, CRSF_FRAME_VARIO_SENSOR_PAYLOAD_SIZE + CRSF_FRAME_LENGTH_TYPE_CRC);
+    sbufWriteU8(dst, CRSF_FRAMETYPE_VARIO_SENSOR);
+    sbufWriteU16BigEndian(dst, getEstimatedVario());
+}
+
+#ifdef USE_ESC_SENSOR
+/*
+0x0C RPM
+Payload:
+uint8_t     RPM source id ( 0 for the ESCs )
+int24_t     RPM ( one for each motor )
+*/
+void crsfFrameRpm(sbuf_t *dst)
+{
+    uint8_t *lengthPtr = sbufPtr(dst);
+    sbufWriteU8(dst, 0);
+    sbufWriteU8(dst, CRSF_FRAMETYPE_RPM);
+    sbufWriteU8(dst, 0);
+    const int motorCount = MIN(getMotorCount(), CRSF_FRAME_RPM_VALUES_MAX);
+    for (int i = 0; i < motorCount; i++) {
+        const escSensorData_t *escData = getEscSensorData(i);
+        const int32_t rpm = (escData && escData->dataAge < ESC_DATA_INVALID) ? calcEscRpm(escData->rpm) : 0;
+        sbufWriteU8(dst, rpm >> 16);
+        sbufWriteU16BigEndian(dst, rpm);
+    }
+    *lengthPtr = sbufPtr(dst) - lengthPtr;
+}
+#endif
+
+/*
+0x0D Temperature
+Payload:
+uint8_t     Temperature source id ( 0 )
+int16_t     Temperature ( degree / 10 ), one for each ESC and then the barometer
+*/
+void crsfFrameTemperature(sbuf_t *dst)
+{
+    uint8_t *lengthPtr = sbufPtr(dst);
+    sbufWriteU8(dst, 0);
+    sbufWriteU8(dst, CRSF_FRAMETYPE_TEMP);
+    sbufWriteU8(dst, 0);
+#ifdef USE_ESC_SENSOR
+    if (featureIsEnabled(FEATURE_ESC_SENSOR)) {
+        const int motorCount = MIN(getMotorCount(), CRSF_FRAME_TEMP_VALUES_MAX - 1);
+        for (int i = 0; i < motorCount; i++) {
+            const escSensorData_t *escData = getEscSensorData(i);
+            const int16_t temperature = (escData && escData->dataAge < ESC_DATA_INVALID) ? escData->temperature * 10 : 0;
+            sbufWriteU16BigEndian(dst, temperature);
+        }
+    }
+#endif
+#ifdef USE_BARO
+    if (sensors(SENSOR_BARO)) {
+        sbufWriteU16BigEndian(dst, baro.baroTemperature / 10); // baroTemperature is in 0.01 degrees
+    }
+#endif
+    *lengthPtr = sbufPtr(dst) - lengthPtr;
+}
+
 typedef enum {
     CRSF_ACTIVE_ANTENNA1 = 0,
     CRSF_ACTIVE_ANTENNA2 = 1
@@ -346,20 +430,33 @@ static void crsfFrameDisplayPortClear(sbuf_t *dst)
 
 #endif
 
-#define BV(x)  (1 << (x)) // bit value
-
-// schedule array to decide how often each type of frame is sent
+// the rate and priority of each type of frame, budgeted in bytes of a share of the RC link
 typedef enum {
     CRSF_FRAME_START_INDEX = 0,
     CRSF_FRAME_ATTITUDE_INDEX = CRSF_FRAME_START_INDEX,
     CRSF_FRAME_BATTERY_SENSOR_INDEX,
     CRSF_FRAME_FLIGHT_MODE_INDEX,
     CRSF_FRAME_GPS_INDEX,
+    CRSF_FRAME_VARIO_SENSOR_INDEX,
+    CRSF_FRAME_RPM_INDEX,
+    CRSF_FRAME_TEMP_INDEX,
     CRSF_SCHEDULE_COUNT_MAX
 } crsfFrameTypeIndex_e;
 
-static uint8_t crsfScheduleCount;
-static uint8_t crsfSchedule[CRSF_SCHEDULE_COUNT_MAX];
+#define CRSF_FRAME_SIZE(payloadSize) ((payloadSize) + CRSF_FRAME_LENGTH_NON_PAYLOAD)
+
+// RPM and temperature frames are sized for the number of motors on init
+static telemetrySensor_t crsfSensors[CRSF_SCHEDULE_COUNT_MAX] = {
+    [CRSF_FRAME_ATTITUDE_INDEX]         = { 15, TELEMETRY_PRIORITY_HIGH,   CRSF_FRAME_SIZE(CRSF_FRAME_ATTITUDE_PAYLOAD_SIZE) },
+    [CRSF_FRAME_BATTERY_SENSOR_INDEX]   = { 10, TELEMETRY_PRIORITY_HIGH,   CRSF_FRAME_SIZE(CRSF_FRAME_BATTERY_SENSOR_PAYLOAD_SIZE) },
+    [CRSF_FRAME_FLIGHT_MODE_INDEX]      = { 5,  TELEMETRY_PRIORITY_NORMAL, CRSF_FRAME_SIZE(5) },
+    [CRSF_FRAME_GPS_INDEX]              = { 10, TELEMETRY_PRIORITY_NORMAL, CRSF_FRAME_SIZE(CRSF_FRAME_GPS_PAYLOAD_SIZE) },
+    [CRSF_FRAME_VARIO_SENSOR_INDEX]     = { 10, TELEMETRY_PRIORITY_NORMAL, CRSF_FRAME_SIZE(CRSF_FRAME_VARIO_SENSOR_PAYLOAD_SIZE) },
+    [CRSF_FRAME_RPM_INDEX]              = { 5,  TELEMETRY_PRIORITY_LOW,    0 },
+    [CRSF_FRAME_TEMP_INDEX]             = { 2,  TELEMETRY_PRIORITY_LOW,    0 },
+};
+
+static telemetrySchedule_t crsfSchedule;
 
 #if defined(USE_MSP_OVER_TELEMETRY)
 
@@ -385,39 +482,74 @@ void crsfSendMspResponse(uint8_t *payload)
 }
 #endif
 
-static void processCrsf(void)
+static void crsfFrameScheduled(sbuf_t *dst, crsfFrameTypeIndex_e index)
 {
-    static uint8_t crsfScheduleIndex = 0;
-
-    const uint8_t currentSchedule = crsfSchedule[crsfScheduleIndex];
-
-    sbuf_t crsfPayloadBuf;
-    sbuf_t *dst = &crsfPayloadBuf;
-
-    if (currentSchedule & BV(CRSF_FRAME_ATTITUDE_INDEX)) {
-        crsfInitializeFrame(dst);
+    switch (index) {
+    case CRSF_FRAME_ATTITUDE_INDEX:
         crsfFrameAttitude(dst);
-        crsfFinalize(dst);
-    }
-    if (currentSchedule & BV(CRSF_FRAME_BATTERY_SENSOR_INDEX)) {
-        crsfInitializeFrame(dst);
+        break;
+    case CRSF_FRAME_BATTERY_SENSOR_INDEX:
         crsfFrameBatterySensor(dst);
-        crsfFinalize(dst);
-    }
-
-    if (currentSchedule & BV(CRSF_FRAME_FLIGHT_MODE_INDEX)) {
-        crsfInitializeFrame(dst);
+        break;
+    case CRSF_FRAME_FLIGHT_MODE_INDEX:
         crsfFrameFlightMode(dst);
-        crsfFinalize(dst);
-    }
+        break;
 #ifdef USE_GPS
-    if (currentSchedule & BV(CRSF_FRAME_GPS_INDEX)) {
-        crsfInitializeFrame(dst);
+    case CRSF_FRAME_GPS_INDEX:
         crsfFrameGps(dst);
-        crsfFinalize(dst);
-    }
+        break;
+#endif
+    case CRSF_FRAME_VARIO_SENSOR_INDEX:
+        crsfFrameVarioSensor(dst);
+        break;
+#ifdef USE_ESC_SENSOR
+    case CRSF_FRAME_RPM_INDEX:
+        crsfFrameRpm(dst);
+        break;
 #endif
-    crsfScheduleIndex = (crsfScheduleIndex + 1) % crsfScheduleCount;
+    case CRSF_FRAME_TEMP_INDEX:
+        crsfFrameTemperature(dst);
+        break;
+    default:
+        // not enabled without the feature
+        break;
+    }
+}
+
+// Fills the batch with the frames that are due and fit, the CRC is still taken for each frame
+STATIC_UNIT_TESTED int crsfTelemetryBatch(uint8_t *batch, int size, timeUs_t currentTimeUs)
+{
+    sbuf_t crsfBatchBuf;
+    sbuf_t *dst = &crsfBatchBuf;
+    dst->ptr = batch;
+    dst->end = batch + size;
+
+    int index;
+    while ((index = telemetryScheduleNextWithin(&crsfSchedule, currentTimeUs, MIN(sbufBytesRemaining(dst), UINT8_MAX))) >= 0) {
+        crsfStartFrame(dst);
+        crsfFrameScheduled(dst, index);
+        crsfEndFrame(dst);
+    }
+    return dst->ptr - batch;
+}
+
+// Follows the RF mode: the budget is a share of the RC frame rate, and a batch has to fit in half the gap between
+// two RC frames to stay clear of the next one
+static void crsfUpdateLinkBudget(void)
+{
+    const uint32_t frameIntervalUs = MAX(crsfRxFrameIntervalUs(), 1);
+    const uint32_t budget = 1000000 * CRSF_TELEMETRY_BYTES_PER_RC_FRAME / frameIntervalUs;
+    telemetryScheduleSetBudget(&crsfSchedule, MAX(budget, 1), MIN(frameIntervalUs / 2 / CRSF_BYTE_TIME_US, CRSF_TELEMETRY_BATCH_SIZE));
+}
+
+static void processCrsf(timeUs_t currentTimeUs)
+{
+    crsfUpdateLinkBudget();
+
+    const int length = crsfTelemetryBatch(crsfFrame, crsfSchedule.burst, currentTimeUs);
+    if (length) {
+        crsfRxWriteTelemetryData(crsfFrame, length);
+    }
 }
 
 void crsfScheduleDeviceInfoResponse(void)
@@ -441,21 +573,29 @@ void initCrsfTelemetry(void)
     cmsDisplayPortRegister(displayPortCrsfInit());
 #endif
 
-    int index = 0;
-    if (sensors(SENSOR_ACC)) {
-        crsfSchedule[index++] = BV(CRSF_FRAME_ATTITUDE_INDEX);
-    }
-    if (isBatteryVoltageConfigured() || isAmperageConfigured()) {
-        crsfSchedule[index++] = BV(CRSF_FRAME_BATTERY_SENSOR_INDEX);
+    uint8_t motorCount = 0;
+#ifdef USE_ESC_SENSOR
+    if (featureIsEnabled(FEATURE_ESC_SENSOR)) {
+        motorCount = getMotorCount();
     }
-    crsfSchedule[index++] = BV(CRSF_FRAME_FLIGHT_MODE_INDEX);
+#endif
+    const uint8_t temperatureCount = motorCount + (sensors(SENSOR_BARO) ? 1 : 0);
+    crsfSensors[CRSF_FRAME_RPM_INDEX].size = CRSF_FRAME_SIZE(1 + 3 * MIN(motorCount, CRSF_FRAME_RPM_VALUES_MAX));
+    crsfSensors[CRSF_FRAME_TEMP_INDEX].size = CRSF_FRAME_SIZE(1 + 2 * MIN(temperatureCount, CRSF_FRAME_TEMP_VALUES_MAX));
+
+    telemetryScheduleInit(&crsfSchedule, crsfSensors, CRSF_SCHEDULE_COUNT_MAX, 0);
+    crsfUpdateLinkBudget();
+    telemetryScheduleEnable(&crsfSchedule, CRSF_FRAME_ATTITUDE_INDEX, sensors(SENSOR_ACC));
+    telemetryScheduleEnable(&crsfSchedule, CRSF_FRAME_BATTERY_SENSOR_INDEX, isBatteryVoltageConfigured() || isAmperageConfigured());
 #ifdef USE_GPS
-    if (featureIsEnabled(FEATURE_GPS)) {
-        crsfSchedule[index++] = BV(CRSF_FRAME_GPS_INDEX);
-    }
+    telemetryScheduleEnable(&crsfSchedule, CRSF_FRAME_GPS_INDEX, featureIsEnabled(FEATURE_GPS));
+#else
+    telemetryScheduleEnable(&crsfSchedule, CRSF_FRAME_GPS_INDEX, false);
 #endif
-    crsfScheduleCount = (uint8_t)index;
- }
+    telemetryScheduleEnable(&crsfSchedule, CRSF_FRAME_VARIO_SENSOR_INDEX, sensors(SENSOR_BARO));
+    telemetryScheduleEnable(&crsfSchedule, CRSF_FRAME_RPM_INDEX, motorCount > 0);
+    telemetryScheduleEnable(&crsfSchedule, CRSF_FRAME_TEMP_INDEX, temperatureCount > 0);
+}
 
 bool checkCrsfTelemetryState(void)
 {
@@ -492,8 +632,6 @@ void crsfProcessDisplayPortCmd(uint8_t *frameStart)
  */
 void handleCrsfTelemetry(timeUs_t currentTimeUs)
 {
-    static uint32_t crsfLastCycleTime;
-
     if (!crsfTelemetryEnabled) {
         return;
     }
@@ -506,7 +644,7 @@ void handleCrsfTelemetry(timeUs_t currentTimeUs)
 #if defined(USE_MSP_OVER_TELEMETRY)
     if (mspReplyPending) {
         mspReplyPending = handleCrsfMspFrameBuffer(CRSF_FRAME_TX_MSP_FRAME_SIZE, &crsfSendMspResponse);
-        crsfLastCycleTime = currentTimeUs; // reset telemetry timing due to ad-hoc request
+        telemetryScheduleLinkUsed(&crsfSchedule, currentTimeUs, CRSF_FRAME_SIZE_MAX); // ad-hoc responses take link time too
         return;
     }
 #endif
@@ -518,7 +656,7 @@ void handleCrsfTelemetry(timeUs_t currentTimeUs)
         crsfFrameDeviceInfo(dst);
         crsfFinalize(dst);
         deviceInfoReplyPending = false;
-        crsfLastCycleTime = currentTimeUs; // reset telemetry timing due to ad-hoc request
+        telemetryScheduleLinkUsed(&crsfSchedule, currentTimeUs, CRSF_FRAME_SIZE_MAX); // ad-hoc responses take link time too
         return;
     }
 
@@ -530,7 +668,7 @@ void handleCrsfTelemetry(timeUs_t currentTimeUs)
         crsfInitializeFrame(dst);
         crsfFrameDisplayPortClear(dst);
         crsfFinalize(dst);
-        crsfLastCycleTime = currentTimeUs;
+        telemetryScheduleLinkUsed(&crsfSchedule, currentTimeUs, CRSF_FRAME_SIZE_MAX);
         return;
     }
     const int nextRow = crsfDisplayPortNextRow();
@@ -540,18 +678,14 @@ void handleCrsfTelemetry(timeUs_t currentTimeUs)
         crsfInitializeFrame(dst);
         crsfFrameDisplayPortRow(dst, nextRow);
         crsfFinalize(dst);
-        crsfDisplayPortScreen()->pendingTransport[nextRow] = false;
-        crsfLastCycleTime = currentTimeUs;
+        telemetryScheduleLinkUsed(&crsfSchedule, currentTimeUs, CRSF_FRAME_SIZE_MAX);
         return;
     }
 #endif
 
-    // Actual telemetry data only needs to be sent at a low frequency, ie 10Hz
-    // Spread out scheduled frames evenly so each frame is sent at the same frequency.
-    if (currentTimeUs >= crsfLastCycleTime + (CRSF_CYCLETIME_US / crsfScheduleCount)) {
-        crsfLastCycleTime = currentTimeUs;
-        processCrsf();
-    }
+    // Actual telemetry data only needs to be sent at a low frequency, the schedule spreads the frames over the
+    // link by the rate each type of frame wants, and those due together go in one batch
+    processCrsf(currentTimeUs);
 }
 
 int getCrsfFrame(uint8_t *frame, crsfFrameType_e frameType)
@@ -576,6 +710,17 @@ int getCrsfFrame(uint8_t *frame, crsfFrameType_e frameType)
         crsfFrameGps(sbuf);
         break;
 #endif
+    case CRSF_FRAMETYPE_VARIO_SENSOR:
+        crsfFrameVarioSensor(sbuf);
+        break;
+#if defined(USE_ESC_SENSOR)
+    case CRSF_FRAMETYPE_RPM:
+        crsfFrameRpm(sbuf);
+        break;
+#endif
+    case CRSF_FRAMETYPE_TEMP:
+        crsfFrameTemperature(sbuf);
+        break;
     }
     const int frameSize = crsfFinalizeBuf(sbuf, frame);
     return frameSize;
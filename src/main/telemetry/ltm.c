@@ -78,10 +78,28 @@
 
 #include "telemetry/telemetry.h"
 #include "telemetry/ltm.h"
+#include "telemetry/telemetry_scheduler.h"
 
 
 #define TELEMETRY_LTM_INITIAL_PORT_MODE MODE_TX
-#define LTM_CYCLETIME   100
+
+typedef enum {
+    LTM_AFRAME_INDEX = 0,
+    LTM_SFRAME_INDEX,
+    LTM_GFRAME_INDEX,
+    LTM_OFRAME_INDEX,
+    LTM_FRAME_COUNT
+} ltmFrameIndex_e;
+
+// Rates at > 2400 baud, slower links send attitude and sensors first
+static const telemetrySensor_t ltmSensors[LTM_FRAME_COUNT] = {
+    [LTM_AFRAME_INDEX] = { .rateHz = 10, .priority = TELEMETRY_PRIORITY_HIGH,   .size = 10 },
+    [LTM_SFRAME_INDEX] = { .rateHz = 5,  .priority = TELEMETRY_PRIORITY_HIGH,   .size = 11 },
+    [LTM_GFRAME_INDEX] = { .rateHz = 5,  .priority = TELEMETRY_PRIORITY_NORMAL, .size = 18 },
+    [LTM_OFRAME_INDEX] = { .rateHz = 1,  .priority = TELEMETRY_PRIORITY_LOW,    .size = 18 },
+};
+
+static telemetrySchedule_t ltmSchedule;
 
 static serialPort_t *ltmPort;
 static serialPortConfig_t *portConfig;
@@ -236,33 +254,40 @@ static void ltm_oframe(void)
     ltm_finalise();
 }
 
-static void process_ltm(void)
+static void process_ltm(timeUs_t currentTimeUs)
 {
-    static uint8_t ltm_scheduler;
-    ltm_aframe();
-    if (ltm_scheduler & 1)
-        ltm_gframe();
-    else
-        ltm_sframe();
-    if (ltm_scheduler == 0)
-        ltm_oframe();
-    ltm_scheduler++;
-    ltm_scheduler %= 10;
+    int frame;
+    while ((frame = telemetryScheduleNext(&ltmSchedule, currentTimeUs)) >= 0) {
+        switch (frame) {
+        case LTM_AFRAME_INDEX:
+            ltm_aframe();
+            break;
+        case LTM_SFRAME_INDEX:
+            ltm_sframe();
+            break;
+        case LTM_GFRAME_INDEX:
+            ltm_gframe();
+            break;
+        case LTM_OFRAME_INDEX:
+            ltm_oframe();
+            break;
+        }
+    }
+}
+
+// 8N1, ten bits on the wire for each byte
+static void ltm_schedule_init(void)
+{
+    telemetryScheduleInit(&ltmSchedule, ltmSensors, LTM_FRAME_COUNT, ltmPort->baudRate / 10);
 }
 
 void handleLtmTelemetry(void)
 {
-    static uint32_t ltm_lastCycleTime;
-    uint32_t now;
     if (!ltmEnabled)
         return;
     if (!ltmPort)
         return;
-    now = millis();
-    if ((now - ltm_lastCycleTime) >= LTM_CYCLETIME) {
-        process_ltm();
-        ltm_lastCycleTime = now;
-    }
+    process_ltm(micros());
 }
 
 void freeLtmTelemetryPort(void)
@@ -290,6 +315,7 @@ void configureLtmTelemetryPort(void)
     ltmPort = openSerialPort(portConfig->identifier, FUNCTION_TELEMETRY_LTM, NULL, NULL, baudRates[baudRateIndex], TELEMETRY_LTM_INITIAL_PORT_MODE, telemetryConfig()->telemetry_inverted ? SERIAL_INVERTED : SERIAL_NOT_INVERTED);
     if (!ltmPort)
         return;
+    ltm_schedule_init();
     ltmEnabled = true;
 }
 
@@ -298,6 +324,7 @@ void checkLtmTelemetryState(void)
     if (portConfig && telemetryCheckRxPortShared(portConfig)) {
         if (!ltmEnabled && telemetrySharedPort != NULL) {
             ltmPort = telemetrySharedPort;
+            ltm_schedule_init();
             ltmEnabled = true;
         }
     } else {
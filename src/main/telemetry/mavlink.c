@@ -34,6 +34,7 @@
 #include "common/maths.h"
 #include "common/axis.h"
 #include "common/color.h"
+#include "common/utils.h"
 
 #include "config/feature.h"
 #include "pg/pg.h"
@@ -71,6 +72,7 @@
 
 #include "telemetry/telemetry.h"
 #include "telemetry/mavlink.h"
+#include "telemetry/telemetry_scheduler.h"
 
 // mavlink library uses unnames unions that's causes GCC to complain if -Wpedantic is used
 // until this is resolved in mavlink library - ignore -Wpedantic for mavlink code
@@ -79,9 +81,21 @@
 #include "common/mavlink.h"
 #pragma GCC diagnostic pop
 
-#define TELEMETRY_MAVLINK_INITIAL_PORT_MODE MODE_TX
-#define TELEMETRY_MAVLINK_MAXRATE 50
-#define TELEMETRY_MAVLINK_DELAY ((1000 * 1000) / TELEMETRY_MAVLINK_MAXRATE)
+#define TELEMETRY_MAVLINK_INITIAL_PORT_MODE MODE_RXTX
+
+// Who our messages come from, and the commands we take
+#define MAVLINK_SYSTEM_ID       0
+#define MAVLINK_COMPONENT_ID    200
+
+#define TELEMETRY_MAVLINK_RX_BYTES_MAX 64 // parsed each call, a REQUEST_DATA_STREAM is 14 bytes
+
+#ifndef MAV_CMD_SET_MESSAGE_INTERVAL
+// MAVLink 2 command, the library is MAVLink 1 but the command goes in a COMMAND_LONG all the same
+#define MAV_CMD_SET_MESSAGE_INTERVAL 511
+#endif
+
+// 6 byte header and 2 byte checksum
+#define MAVLINK_FRAME_SIZE(payload) ((payload) + 8)
 
 extern uint16_t rssi; // FIXME dependency on mw.c
 
@@ -91,49 +105,41 @@ static serialPortConfig_t *portConfig;
 static bool mavlinkTelemetryEnabled =  false;
 static portSharing_e mavlinkPortSharing;
 
-/* MAVLink datastream rates in Hz */
-static const uint8_t mavRates[] = {
-    [MAV_DATA_STREAM_EXTENDED_STATUS] = 2, //2Hz
-    [MAV_DATA_STREAM_RC_CHANNELS] = 5, //5Hz
-    [MAV_DATA_STREAM_POSITION] = 2, //2Hz
-    [MAV_DATA_STREAM_EXTRA1] = 10, //10Hz
-    [MAV_DATA_STREAM_EXTRA2] = 10 //2Hz
+/* MAVLink datastream default rates in Hz, and the bytes of the messages each stream sends */
+static const telemetrySensor_t mavStreamDefaults[] = {
+    [MAV_DATA_STREAM_EXTENDED_STATUS] = { .rateHz = 2,  .priority = TELEMETRY_PRIORITY_HIGH,
+        .size = MAVLINK_FRAME_SIZE(MAVLINK_MSG_ID_SYS_STATUS_LEN) },
+    [MAV_DATA_STREAM_RC_CHANNELS] =     { .rateHz = 5,  .priority = TELEMETRY_PRIORITY_HIGH,
+        .size = MAVLINK_FRAME_SIZE(MAVLINK_MSG_ID_RC_CHANNELS_RAW_LEN) },
+    [MAV_DATA_STREAM_POSITION] =        { .rateHz = 2,  .priority = TELEMETRY_PRIORITY_NORMAL,
+        .size = MAVLINK_FRAME_SIZE(MAVLINK_MSG_ID_GPS_RAW_INT_LEN) + MAVLINK_FRAME_SIZE(MAVLINK_MSG_ID_GLOBAL_POSITION_INT_LEN)
+            + MAVLINK_FRAME_SIZE(MAVLINK_MSG_ID_GPS_GLOBAL_ORIGIN_LEN) },
+    [MAV_DATA_STREAM_EXTRA1] =          { .rateHz = 10, .priority = TELEMETRY_PRIORITY_HIGH,
+        .size = MAVLINK_FRAME_SIZE(MAVLINK_MSG_ID_ATTITUDE_LEN) },
+    [MAV_DATA_STREAM_EXTRA2] =          { .rateHz = 10, .priority = TELEMETRY_PRIORITY_NORMAL,
+        .size = MAVLINK_FRAME_SIZE(MAVLINK_MSG_ID_VFR_HUD_LEN) + MAVLINK_FRAME_SIZE(MAVLINK_MSG_ID_HEARTBEAT_LEN) },
 };
 
-#define MAXSTREAMS (sizeof(mavRates) / sizeof(mavRates[0]))
-
-static uint8_t mavTicks[MAXSTREAMS];
-static mavlink_message_t mavMsg;
-static uint8_t mavBuffer[MAVLINK_MAX_PACKET_LEN];
-static uint32_t lastMavlinkMessage = 0;
-
-static int mavlinkStreamTrigger(enum MAV_DATA_STREAM streamNum)
-{
-    uint8_t rate = (uint8_t) mavRates[streamNum];
-    if (rate == 0) {
-        return 0;
-    }
-
-    if (mavTicks[streamNum] == 0) {
-        // we're triggering now, setup the next trigger point
-        if (rate > TELEMETRY_MAVLINK_MAXRATE) {
-            rate = TELEMETRY_MAVLINK_MAXRATE;
-        }
+#define MAXSTREAMS ARRAYLEN(mavStreamDefaults)
 
-        mavTicks[streamNum] = (TELEMETRY_MAVLINK_MAXRATE / rate);
-        return 1;
-    }
+// as the ground station asked for them
+static telemetrySensor_t mavStreams[MAXSTREAMS];
 
-    // count down at TASK_RATE_HZ
-    mavTicks[streamNum]--;
-    return 0;
-}
+static telemetrySchedule_t mavSchedule;
+static mavlink_message_t mavMsg;
+static mavlink_message_t mavRxMsg;
+static mavlink_status_t mavRxStatus;
 
+// The answer to the last command, held until the TX buffer has room for it
+static bool mavAckPending = false;
+static uint16_t mavAckCommand;
+static uint8_t mavAckResult;
 
-static void mavlinkSerialWrite(uint8_t * buf, uint16_t length)
+// mavlink_message_t is packed, so the header, payload and checksum are already laid out as they go on the wire and the
+// message goes from there straight to the TX buffer
+static void mavlinkSendMessage(void)
 {
-    for (int i = 0; i < length; i++)
-        serialWrite(mavlinkPort, buf[i]);
+    serialWriteBuf(mavlinkPort, &mavMsg.magic, mavMsg.len + MAVLINK_NUM_NON_PAYLOAD_BYTES);
 }
 
 static int16_t headingOrScaledMilliAmpereHoursDrawn(void)
@@ -147,6 +153,17 @@ static int16_t headingOrScaledMilliAmpereHoursDrawn(void)
 }
 
 
+// 8N1, ten bits on the wire for each byte
+static void mavlinkScheduleInit(void)
+{
+    memcpy(mavStreams, mavStreamDefaults, sizeof(mavStreams));
+    mavAckPending = false;
+    telemetryScheduleInit(&mavSchedule, mavStreams, MAXSTREAMS, mavlinkPort->baudRate / 10);
+#ifndef USE_GPS
+    telemetryScheduleEnable(&mavSchedule, MAV_DATA_STREAM_POSITION, false);
+#endif
+}
+
 void freeMAVLinkTelemetryPort(void)
 {
     closeSerialPort(mavlinkPort);
@@ -178,6 +195,7 @@ void configureMAVLinkTelemetryPort(void)
         return;
     }
 
+    mavlinkScheduleInit();
     mavlinkTelemetryEnabled = true;
 }
 
@@ -186,6 +204,7 @@ void checkMAVLinkTelemetryState(void)
     if (portConfig && telemetryCheckRxPortShared(portConfig)) {
         if (!mavlinkTelemetryEnabled && telemetrySharedPort != NULL) {
             mavlinkPort = telemetrySharedPort;
+            mavlinkScheduleInit();
             mavlinkTelemetryEnabled = true;
         }
     } else {
@@ -204,7 +223,6 @@ void checkMAVLinkTelemetryState(void)
 
 void mavlinkSendSystemStatus(void)
 {
-    uint16_t msgLength;
 
     uint32_t onboardControlAndSensors = 35843;
 
@@ -232,7 +250,7 @@ void mavlinkSendSystemStatus(void)
         batteryRemaining = isBatteryVoltageConfigured() ? calculateBatteryPercentageRemaining() : batteryRemaining;
     }
 
-    mavlink_msg_sys_status_pack(0, 200, &mavMsg,
+    mavlink_msg_sys_status_pack(MAVLINK_SYSTEM_ID, MAVLINK_COMPONENT_ID, &mavMsg,
         // onboard_control_sensors_present Bitmask showing which onboard controllers and sensors are present.
         //Value of 0: not present. Value of 1: present. Indices: 0: 3D gyro, 1: 3D acc, 2: 3D mag, 3: absolute pressure,
         // 4: differential pressure, 5: GPS, 6: optical flow, 7: computer vision position, 8: laser based position,
@@ -263,14 +281,12 @@ void mavlinkSendSystemStatus(void)
         0,
         // errors_count4 Autopilot-specific errors
         0);
-    msgLength = mavlink_msg_to_send_buffer(mavBuffer, &mavMsg);
-    mavlinkSerialWrite(mavBuffer, msgLength);
+    mavlinkSendMessage();
 }
 
 void mavlinkSendRCChannelsAndRSSI(void)
 {
-    uint16_t msgLength;
-    mavlink_msg_rc_channels_raw_pack(0, 200, &mavMsg,
+    mavlink_msg_rc_channels_raw_pack(MAVLINK_SYSTEM_ID, MAVLINK_COMPONENT_ID, &mavMsg,
         // time_boot_ms Timestamp (milliseconds since system boot)
         millis(),
         // port Servo output port (set of 8 outputs = 1 port). Most MAVs will just use one, but this allows to encode more than 8 servos.
@@ -293,14 +309,12 @@ void mavlinkSendRCChannelsAndRSSI(void)
         (rxRuntimeConfig.channelCount >= 8) ? rcData[7] : 0,
         // rssi Receive signal strength indicator, 0: 0%, 255: 100%
         constrain(scaleRange(getRssi(), 0, RSSI_MAX_VALUE, 0, 255), 0, 255));
-    msgLength = mavlink_msg_to_send_buffer(mavBuffer, &mavMsg);
-    mavlinkSerialWrite(mavBuffer, msgLength);
+    mavlinkSendMessage();
 }
 
 #if defined(USE_GPS)
 void mavlinkSendPosition(void)
 {
-    uint16_t msgLength;
     uint8_t gpsFixType = 0;
 
     if (!sensors(SENSOR_GPS))
@@ -318,7 +332,7 @@ void mavlinkSendPosition(void)
         }
     }
 
-    mavlink_msg_gps_raw_int_pack(0, 200, &mavMsg,
+    mavlink_msg_gps_raw_int_pack(MAVLINK_SYSTEM_ID, MAVLINK_COMPONENT_ID, &mavMsg,
         // time_usec Timestamp (microseconds since UNIX epoch or microseconds since system boot)
         micros(),
         // fix_type 0-1: no fix, 2: 2D fix, 3: 3D fix. Some applications will not use the value of this field unless it is at least two, so always correctly fill in the fix.
@@ -339,11 +353,10 @@ void mavlinkSendPosition(void)
         gpsSol.groundCourse * 10,
         // satellites_visible Number of satellites visible. If unknown, set to 255
         gpsSol.numSat);
-    msgLength = mavlink_msg_to_send_buffer(mavBuffer, &mavMsg);
-    mavlinkSerialWrite(mavBuffer, msgLength);
+    mavlinkSendMessage();
 
     // Global position
-    mavlink_msg_global_position_int_pack(0, 200, &mavMsg,
+    mavlink_msg_global_position_int_pack(MAVLINK_SYSTEM_ID, MAVLINK_COMPONENT_ID, &mavMsg,
         // time_usec Timestamp (microseconds since UNIX epoch or microseconds since system boot)
         micros(),
         // lat Latitude in 1E7 degrees
@@ -367,25 +380,22 @@ void mavlinkSendPosition(void)
         // heading Current heading in degrees, in compass units (0..360, 0=north)
         headingOrScaledMilliAmpereHoursDrawn()
     );
-    msgLength = mavlink_msg_to_send_buffer(mavBuffer, &mavMsg);
-    mavlinkSerialWrite(mavBuffer, msgLength);
+    mavlinkSendMessage();
 
-    mavlink_msg_gps_global_origin_pack(0, 200, &mavMsg,
+    mavlink_msg_gps_global_origin_pack(MAVLINK_SYSTEM_ID, MAVLINK_COMPONENT_ID, &mavMsg,
         // latitude Latitude (WGS84), expressed as * 1E7
         GPS_home[LAT],
         // longitude Longitude (WGS84), expressed as * 1E7
         GPS_home[LON],
         // altitude Altitude(WGS84), expressed as * 1000
         0);
-    msgLength = mavlink_msg_to_send_buffer(mavBuffer, &mavMsg);
-    mavlinkSerialWrite(mavBuffer, msgLength);
+    mavlinkSendMessage();
 }
 #endif
 
 void mavlinkSendAttitude(void)
 {
-    uint16_t msgLength;
-    mavlink_msg_attitude_pack(0, 200, &mavMsg,
+    mavlink_msg_attitude_pack(MAVLINK_SYSTEM_ID, MAVLINK_COMPONENT_ID, &mavMsg,
         // time_boot_ms Timestamp (milliseconds since system boot)
         millis(),
         // roll Roll angle (rad)
@@ -400,13 +410,11 @@ void mavlinkSendAttitude(void)
         0,
         // yawspeed Yaw angular speed (rad/s)
         0);
-    msgLength = mavlink_msg_to_send_buffer(mavBuffer, &mavMsg);
-    mavlinkSerialWrite(mavBuffer, msgLength);
+    mavlinkSendMessage();
 }
 
 void mavlinkSendHUDAndHeartbeat(void)
 {
-    uint16_t msgLength;
     float mavAltitude = 0;
     float mavGroundSpeed = 0;
     float mavAirSpeed = 0;
@@ -438,7 +446,7 @@ void mavlinkSendHUDAndHeartbeat(void)
     }
 #endif
 
-    mavlink_msg_vfr_hud_pack(0, 200, &mavMsg,
+    mavlink_msg_vfr_hud_pack(MAVLINK_SYSTEM_ID, MAVLINK_COMPONENT_ID, &mavMsg,
         // airspeed Current airspeed in m/s
         mavAirSpeed,
         // groundspeed Current ground speed in m/s
@@ -451,8 +459,7 @@ void mavlinkSendHUDAndHeartbeat(void)
         mavAltitude,
         // climb Current climb rate in meters/second
         mavClimbRate);
-    msgLength = mavlink_msg_to_send_buffer(mavBuffer, &mavMsg);
-    mavlinkSerialWrite(mavBuffer, msgLength);
+    mavlinkSendMessage();
 
 
     uint8_t mavModes = MAV_MODE_FLAG_MANUAL_INPUT_ENABLED;
@@ -525,7 +532,7 @@ void mavlinkSendHUDAndHeartbeat(void)
         mavSystemState = MAV_STATE_STANDBY;
     }
 
-    mavlink_msg_heartbeat_pack(0, 200, &mavMsg,
+    mavlink_msg_heartbeat_pack(MAVLINK_SYSTEM_ID, MAVLINK_COMPONENT_ID, &mavMsg,
         // type Type of the MAV (quadrotor, helicopter, etc., up to 15 types, defined in MAV_TYPE ENUM)
         mavSystemType,
         // autopilot Autopilot type / class. defined in MAV_AUTOPILOT ENUM
@@ -536,36 +543,166 @@ void mavlinkSendHUDAndHeartbeat(void)
         mavCustomMode,
         // system_status System status flag, see MAV_STATE ENUM
         mavSystemState);
-    msgLength = mavlink_msg_to_send_buffer(mavBuffer, &mavMsg);
-    mavlinkSerialWrite(mavBuffer, msgLength);
+    mavlinkSendMessage();
 }
 
-void processMAVLinkTelemetry(void)
+static void mavlinkSetStreamRate(uint8_t stream, uint16_t rateHz)
 {
-    // is executed @ TELEMETRY_MAVLINK_MAXRATE rate
-    if (mavlinkStreamTrigger(MAV_DATA_STREAM_EXTENDED_STATUS)) {
-        mavlinkSendSystemStatus();
+    mavStreams[stream].rateHz = MIN(rateHz, UINT8_MAX);
+}
+
+// Streams send several messages, the interval of any of them sets the rate of its stream
+static int mavlinkStreamOfMessage(uint16_t msgId)
+{
+    switch (msgId) {
+    case MAVLINK_MSG_ID_SYS_STATUS:
+        return MAV_DATA_STREAM_EXTENDED_STATUS;
+    case MAVLINK_MSG_ID_RC_CHANNELS_RAW:
+        return MAV_DATA_STREAM_RC_CHANNELS;
+    case MAVLINK_MSG_ID_GPS_RAW_INT:
+    case MAVLINK_MSG_ID_GLOBAL_POSITION_INT:
+    case MAVLINK_MSG_ID_GPS_GLOBAL_ORIGIN:
+        return MAV_DATA_STREAM_POSITION;
+    case MAVLINK_MSG_ID_ATTITUDE:
+        return MAV_DATA_STREAM_EXTRA1;
+    case MAVLINK_MSG_ID_VFR_HUD:
+    case MAVLINK_MSG_ID_HEARTBEAT:
+        return MAV_DATA_STREAM_EXTRA2;
+    default:
+        return -1;
     }
+}
+
+static bool mavlinkStreamIsSent(unsigned stream)
+{
+    return stream < MAXSTREAMS && mavStreamDefaults[stream].rateHz && telemetryScheduleIsEnabled(&mavSchedule, stream);
+}
+
+// Broadcasts, 0, are for us too
+static bool mavlinkIsForUs(uint8_t targetSystem, uint8_t targetComponent)
+{
+    return (targetSystem == 0 || targetSystem == MAVLINK_SYSTEM_ID) && (targetComponent == 0 || targetComponent == MAVLINK_COMPONENT_ID);
+}
 
-    if (mavlinkStreamTrigger(MAV_DATA_STREAM_RC_CHANNELS)) {
-        mavlinkSendRCChannelsAndRSSI();
+static void mavlinkHandleRequestDataStream(const mavlink_message_t *msg)
+{
+    mavlink_request_data_stream_t request;
+    mavlink_msg_request_data_stream_decode(msg, &request);
+
+    if (!mavlinkIsForUs(request.target_system, request.target_component)) {
+        return;
     }
 
-#ifdef USE_GPS
-    if (mavlinkStreamTrigger(MAV_DATA_STREAM_POSITION)) {
-        mavlinkSendPosition();
+    const uint16_t rateHz = request.start_stop ? request.req_message_rate : 0;
+    for (unsigned stream = 0; stream < MAXSTREAMS; stream++) {
+        if ((request.req_stream_id == MAV_DATA_STREAM_ALL || request.req_stream_id == stream) && mavlinkStreamIsSent(stream)) {
+            mavlinkSetStreamRate(stream, rateHz);
+        }
     }
-#endif
+}
 
-    if (mavlinkStreamTrigger(MAV_DATA_STREAM_EXTRA1)) {
-        mavlinkSendAttitude();
+static void mavlinkHandleCommand(const mavlink_message_t *msg)
+{
+    mavlink_command_long_t command;
+    mavlink_msg_command_long_decode(msg, &command);
+
+    if (!mavlinkIsForUs(command.target_system, command.target_component)) {
+        return;
     }
 
-    if (mavlinkStreamTrigger(MAV_DATA_STREAM_EXTRA2)) {
-        mavlinkSendHUDAndHeartbeat();
+    uint8_t result;
+    switch (command.command) {
+    case MAV_CMD_SET_MESSAGE_INTERVAL: {
+        const int stream = mavlinkStreamOfMessage(command.param1);
+        const float intervalUs = command.param2; // -1 to stop, 0 for the default rate
+        if (stream >= 0 && mavlinkStreamIsSent(stream)) {
+            if (intervalUs < 0) {
+                mavlinkSetStreamRate(stream, 0);
+            } else if (intervalUs == 0) {
+                mavlinkSetStreamRate(stream, mavStreamDefaults[stream].rateHz);
+            } else {
+                mavlinkSetStreamRate(stream, constrainf(1e6f / intervalUs, 1, UINT8_MAX));
+            }
+            result = MAV_RESULT_ACCEPTED;
+        } else {
+            result = MAV_RESULT_DENIED;
+        }
+        break;
+    }
+    default:
+        // the ground station gets an answer to all commands, even those we don't take
+        result = MAV_RESULT_UNSUPPORTED;
+        break;
+    }
+
+    mavAckCommand = command.command;
+    mavAckResult = result;
+    mavAckPending = true;
+}
+
+static void mavlinkSendPendingAck(void)
+{
+    if (mavAckPending && serialTxBytesFree(mavlinkPort) >= MAVLINK_FRAME_SIZE(MAVLINK_MSG_ID_COMMAND_ACK_LEN)) {
+        mavlink_msg_command_ack_pack(MAVLINK_SYSTEM_ID, MAVLINK_COMPONENT_ID, &mavMsg, mavAckCommand, mavAckResult);
+        mavlinkSendMessage();
+        mavAckPending = false;
     }
 }
 
+// The ground station sets the stream rates. Only on a port of our own, as a port shared with the RX has nothing for us.
+// A command isn't taken while the answer to the last one is still waiting to go out.
+static void mavlinkProcessReceived(void)
+{
+    for (int i = 0; i < TELEMETRY_MAVLINK_RX_BYTES_MAX && !mavAckPending && serialRxBytesWaiting(mavlinkPort); i++) {
+        if (!mavlink_parse_char(MAVLINK_COMM_0, serialRead(mavlinkPort), &mavRxMsg, &mavRxStatus)) {
+            continue;
+        }
+        switch (mavRxMsg.msgid) {
+        case MAVLINK_MSG_ID_REQUEST_DATA_STREAM:
+            mavlinkHandleRequestDataStream(&mavRxMsg);
+            break;
+        case MAVLINK_MSG_ID_COMMAND_LONG:
+            mavlinkHandleCommand(&mavRxMsg);
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+// Messages go out while the TX buffer has room for them, as many in a call as the schedule has due
+static void processMAVLinkTelemetry(timeUs_t currentTimeUs)
+{
+    int stream;
+
+    serialBeginWrite(mavlinkPort);
+    mavlinkSendPendingAck();
+    while ((stream = telemetryScheduleNextWithin(&mavSchedule, currentTimeUs, MIN(serialTxBytesFree(mavlinkPort), UINT8_MAX))) >= 0) {
+        switch (stream) {
+        case MAV_DATA_STREAM_EXTENDED_STATUS:
+            mavlinkSendSystemStatus();
+            break;
+        case MAV_DATA_STREAM_RC_CHANNELS:
+            mavlinkSendRCChannelsAndRSSI();
+            break;
+#ifdef USE_GPS
+        case MAV_DATA_STREAM_POSITION:
+            mavlinkSendPosition();
+            break;
+#endif
+        case MAV_DATA_STREAM_EXTRA1:
+            mavlinkSendAttitude();
+            break;
+        case MAV_DATA_STREAM_EXTRA2:
+            mavlinkSendHUDAndHeartbeat();
+            break;
+        default:
+            break;
+        }
+    }
+    serialEndWrite(mavlinkPort);
+}
+
 void handleMAVLinkTelemetry(void)
 {
     if (!mavlinkTelemetryEnabled) {
@@ -576,11 +713,11 @@ void handleMAVLinkTelemetry(void)
         return;
     }
 
-    uint32_t now = micros();
-    if ((now - lastMavlinkMessage) >= TELEMETRY_MAVLINK_DELAY) {
-        processMAVLinkTelemetry();
-        lastMavlinkMessage = now;
+    if (mavlinkPort != telemetrySharedPort) {
+        mavlinkProcessReceived();
     }
+
+    processMAVLinkTelemetry(micros());
 }
 
 #endif
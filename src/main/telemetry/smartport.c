@@ -78,6 +78,7 @@
 
 #include "telemetry/telemetry.h"
 #include "telemetry/smartport.h"
+#include "telemetry/telemetry_scheduler.h"
 #include "telemetry/msp_shared.h"
 
 #define SMARTPORT_MIN_TELEMETRY_RESPONSE_DELAY_US 500
@@ -145,33 +146,37 @@ enum
 };
 
 // if adding more sensors then increase this value
-#define MAX_DATAIDS 17
+#define MAX_DATAIDS 20
 
 static uint16_t frSkyDataIdTable[MAX_DATAIDS];
+static telemetrySensor_t frSkySensors[MAX_DATAIDS];
+static uint8_t frSkyDataIdCount;
 
-#ifdef USE_ESC_SENSOR
-// number of sensors to send between sending the ESC sensors
-#define ESC_SENSOR_PERIOD 7
+static telemetrySchedule_t smartPortSchedule;
+
+// values ready to send, by table index
+static uint32_t frSkySensorValues[MAX_DATAIDS];
+static uint16_t frSkySensorValueIds[MAX_DATAIDS];
+static uint32_t frSkySensorValuesReady;
+
+// for the sensors that send something different each time
+static uint8_t t1Cnt = 1;
+static uint8_t t2Cnt = 0;
+static bool sendLongitude = false;
 
-static uint16_t frSkyEscDataIdTable[] = {
+#ifdef USE_ESC_SENSOR
+static const uint16_t frSkyEscDataIdTable[] = {
     FSSP_DATAID_CURRENT   ,
     FSSP_DATAID_RPM       ,
     FSSP_DATAID_VFAS      ,
     FSSP_DATAID_TEMP
 };
-#endif
 
-typedef struct frSkyTableInfo_s {
-    uint16_t * table;
-    uint8_t size;
-    uint8_t index;
-} frSkyTableInfo_t;
+#define ESC_DATAID_COUNT ARRAYLEN(frSkyEscDataIdTable)
 
-static frSkyTableInfo_t frSkyDataIdTableInfo = { frSkyDataIdTable, 0, 0 };
-#ifdef USE_ESC_SENSOR
-#define ESC_DATAID_COUNT ( sizeof(frSkyEscDataIdTable) / sizeof(uint16_t) )
-
-static frSkyTableInfo_t frSkyEscDataIdTableInfo = {frSkyEscDataIdTable, ESC_DATAID_COUNT, 0};
+// ESC sensors are at the end of the table, each takes the motors in turn
+static uint8_t frSkyEscDataIdStart;
+static uint8_t frSkyEscIdOffset[ESC_DATAID_COUNT];
 #endif
 
 #define SMARTPORT_BAUD 57600
@@ -321,24 +326,34 @@ static bool reportExtendedEscSensors(void) {
     return featureIsEnabled(FEATURE_ESC_SENSOR) && telemetryConfig()->smartport_use_extra_sensors;
 }
 
-#define ADD_SENSOR(dataId) frSkyDataIdTableInfo.table[frSkyDataIdTableInfo.index++] = dataId
+static void addSensor(uint16_t dataId, smartportSensor_e sensor, telemetryPriority_e priority)
+{
+    frSkyDataIdTable[frSkyDataIdCount] = dataId;
+    frSkySensors[frSkyDataIdCount].rateHz = telemetryConfig()->smartport_sensor_rates[sensor];
+    frSkySensors[frSkyDataIdCount].priority = priority;
+    frSkySensors[frSkyDataIdCount].size = 1;
+    frSkyDataIdCount++;
+}
+
+// Rates are configured and relative, the receiver decides how often we get to send, every slot is used
+#define ADD_SENSOR(dataId, sensor, priority) addSensor(dataId, SMARTPORT_SENSOR_ ## sensor, TELEMETRY_PRIORITY_ ## priority)
 
 static void initSmartPortSensors(void)
 {
-    frSkyDataIdTableInfo.index = 0;
+    frSkyDataIdCount = 0;
 
-    ADD_SENSOR(FSSP_DATAID_T1);
-    ADD_SENSOR(FSSP_DATAID_T2);
+    ADD_SENSOR(FSSP_DATAID_T1, FLAGS, NORMAL);
+    ADD_SENSOR(FSSP_DATAID_T2, STATUS, LOW);
 
     if (isBatteryVoltageConfigured()) {
 #ifdef USE_ESC_SENSOR
         if (!reportExtendedEscSensors())
 #endif
         {
-            ADD_SENSOR(FSSP_DATAID_VFAS);
+            ADD_SENSOR(FSSP_DATAID_VFAS, VFAS, HIGH);
         }
 
-        ADD_SENSOR(FSSP_DATAID_A4);
+        ADD_SENSOR(FSSP_DATAID_A4, CELL_VOLTAGE, HIGH);
     }
 
     if (isAmperageConfigured()) {
@@ -346,44 +361,45 @@ static void initSmartPortSensors(void)
         if (!reportExtendedEscSensors())
 #endif
         {
-            ADD_SENSOR(FSSP_DATAID_CURRENT);
+            ADD_SENSOR(FSSP_DATAID_CURRENT, CURRENT, NORMAL);
         }
 
-        ADD_SENSOR(FSSP_DATAID_FUEL);
+        ADD_SENSOR(FSSP_DATAID_FUEL, FUEL, NORMAL);
     }
 
     if (sensors(SENSOR_ACC)) {
-        ADD_SENSOR(FSSP_DATAID_HEADING);
-        ADD_SENSOR(FSSP_DATAID_ACCX);
-        ADD_SENSOR(FSSP_DATAID_ACCY);
-        ADD_SENSOR(FSSP_DATAID_ACCZ);
+        ADD_SENSOR(FSSP_DATAID_HEADING, HEADING, NORMAL);
+        ADD_SENSOR(FSSP_DATAID_ACCX, ACC, LOW);
+        ADD_SENSOR(FSSP_DATAID_ACCY, ACC, LOW);
+        ADD_SENSOR(FSSP_DATAID_ACCZ, ACC, LOW);
     }
 
     if (sensors(SENSOR_BARO)) {
-        ADD_SENSOR(FSSP_DATAID_ALTITUDE);
-        ADD_SENSOR(FSSP_DATAID_VARIO);
+        ADD_SENSOR(FSSP_DATAID_ALTITUDE, ALTITUDE, NORMAL);
+        ADD_SENSOR(FSSP_DATAID_VARIO, VARIO, NORMAL);
     }
 
 #ifdef USE_GPS
     if (featureIsEnabled(FEATURE_GPS)) {
-        ADD_SENSOR(FSSP_DATAID_SPEED);
-        ADD_SENSOR(FSSP_DATAID_LATLONG);
-        ADD_SENSOR(FSSP_DATAID_LATLONG); // twice (one for lat, one for long)
-        ADD_SENSOR(FSSP_DATAID_HOME_DIST);
-        ADD_SENSOR(FSSP_DATAID_GPS_ALT);
+        ADD_SENSOR(FSSP_DATAID_SPEED, SPEED, NORMAL);
+        ADD_SENSOR(FSSP_DATAID_LATLONG, LATLONG, NORMAL); // latitude and longitude in turn
+        ADD_SENSOR(FSSP_DATAID_HOME_DIST, HOME_DIST, NORMAL);
+        ADD_SENSOR(FSSP_DATAID_GPS_ALT, GPS_ALT, NORMAL);
     }
 #endif
 
-    frSkyDataIdTableInfo.size = frSkyDataIdTableInfo.index;
-    frSkyDataIdTableInfo.index = 0;
-
 #ifdef USE_ESC_SENSOR
+    frSkyEscDataIdStart = frSkyDataIdCount;
     if (reportExtendedEscSensors()) {
-        frSkyEscDataIdTableInfo.size = ESC_DATAID_COUNT;
-    } else {
-        frSkyEscDataIdTableInfo.size = 0;
+        for (unsigned i = 0; i < ESC_DATAID_COUNT; i++) {
+            ADD_SENSOR(frSkyEscDataIdTable[i], ESC, LOW);
+            frSkyEscIdOffset[i] = 0;
+        }
     }
 #endif
+
+    telemetryScheduleInit(&smartPortSchedule, frSkySensors, frSkyDataIdCount, 0);
+    frSkySensorValuesReady = 0;
 }
 
 bool initSmartPortTelemetry(void)
@@ -459,15 +475,319 @@ static void smartPortSendMspResponse(uint8_t *data) {
 }
 #endif
 
-void processSmartPortTelemetry(smartPortPayload_t *payload, volatile bool *clearToSend, const uint32_t *requestTimeout)
+// Works out the value sent for a data ID, false if there is nothing to send
+static bool smartPortSensorValue(uint16_t id, uint32_t *value)
 {
-    static uint8_t smartPortIdCycleCnt = 0;
-    static uint8_t t1Cnt = 0;
-    static uint8_t t2Cnt = 0;
+    int32_t tmpi;
+    uint32_t tmp2 = 0;
+    uint16_t vfasVoltage;
+    uint8_t cellCount;
+
+#ifdef USE_ESC_SENSOR
+    escSensorData_t *escData;
+#endif
+
+    switch (id) {
+        case FSSP_DATAID_VFAS       :
+            vfasVoltage = getBatteryVoltage();
+            if (telemetryConfig()->report_cell_voltage) {
+                cellCount = getBatteryCellCount();
+                vfasVoltage = cellCount ? getBatteryVoltage() / cellCount : 0;
+            }
+            *value = vfasVoltage * 10; // given in 0.1V, convert to volts
+            return true;
+#ifdef USE_ESC_SENSOR
+        case FSSP_DATAID_VFAS1      :
+        case FSSP_DATAID_VFAS2      :
+        case FSSP_DATAID_VFAS3      :
+        case FSSP_DATAID_VFAS4      :
+        case FSSP_DATAID_VFAS5      :
+        case FSSP_DATAID_VFAS6      :
+        case FSSP_DATAID_VFAS7      :
+        case FSSP_DATAID_VFAS8      :
+            escData = getEscSensorData(id - FSSP_DATAID_VFAS1);
+            if (escData != NULL) {
+                *value = escData->voltage;
+                return true;
+            }
+            break;
+#endif
+        case FSSP_DATAID_CURRENT    :
+            *value = getAmperage() / 10; // given in 10mA steps, unknown requested unit
+            return true;
+#ifdef USE_ESC_SENSOR
+        case FSSP_DATAID_CURRENT1   :
+        case FSSP_DATAID_CURRENT2   :
+        case FSSP_DATAID_CURRENT3   :
+        case FSSP_DATAID_CURRENT4   :
+        case FSSP_DATAID_CURRENT5   :
+        case FSSP_DATAID_CURRENT6   :
+        case FSSP_DATAID_CURRENT7   :
+        case FSSP_DATAID_CURRENT8   :
+            escData = getEscSensorData(id - FSSP_DATAID_CURRENT1);
+            if (escData != NULL) {
+                *value = escData->current;
+                return true;
+            }
+            break;
+        case FSSP_DATAID_RPM        :
+            escData = getEscSensorData(ESC_SENSOR_COMBINED);
+            if (escData != NULL) {
+                *value = calcEscRpm(escData->rpm);
+                return true;
+            }
+            break;
+        case FSSP_DATAID_RPM1       :
+        case FSSP_DATAID_RPM2       :
+        case FSSP_DATAID_RPM3       :
+        case FSSP_DATAID_RPM4       :
+        case FSSP_DATAID_RPM5       :
+        case FSSP_DATAID_RPM6       :
+        case FSSP_DATAID_RPM7       :
+        case FSSP_DATAID_RPM8       :
+            escData = getEscSensorData(id - FSSP_DATAID_RPM1);
+            if (escData != NULL) {
+                *value = calcEscRpm(escData->rpm);
+                return true;
+            }
+            break;
+        case FSSP_DATAID_TEMP        :
+            escData = getEscSensorData(ESC_SENSOR_COMBINED);
+            if (escData != NULL) {
+                *value = escData->temperature;
+                return true;
+            }
+            break;
+        case FSSP_DATAID_TEMP1      :
+        case FSSP_DATAID_TEMP2      :
+        case FSSP_DATAID_TEMP3      :
+        case FSSP_DATAID_TEMP4      :
+        case FSSP_DATAID_TEMP5      :
+        case FSSP_DATAID_TEMP6      :
+        case FSSP_DATAID_TEMP7      :
+        case FSSP_DATAID_TEMP8      :
+            escData = getEscSensorData(id - FSSP_DATAID_TEMP1);
+            if (escData != NULL) {
+                *value = escData->temperature;
+                return true;
+            }
+            break;
+#endif
+        case FSSP_DATAID_ALTITUDE   :
+            *value = getEstimatedAltitudeCm(); // unknown given unit, requested 100 = 1 meter
+            return true;
+        case FSSP_DATAID_FUEL       :
+            *value = getMAhDrawn(); // given in mAh, unknown requested unit
+            return true;
+        case FSSP_DATAID_VARIO      :
+            *value = getEstimatedVario(); // unknown given unit but requested in 100 = 1m/s
+            return true;
+        case FSSP_DATAID_HEADING    :
+            *value = attitude.values.yaw * 10; // given in 10*deg, requested in 10000 = 100 deg
+            return true;
+        case FSSP_DATAID_ACCX       :
+            *value = lrintf(100 * acc.accADC[X] * acc.dev.acc_1G_rec); // Multiply by 100 to show as x.xx g on Taranis
+            return true;
+        case FSSP_DATAID_ACCY       :
+            *value = lrintf(100 * acc.accADC[Y] * acc.dev.acc_1G_rec);
+            return true;
+        case FSSP_DATAID_ACCZ       :
+            *value = lrintf(100 * acc.accADC[Z] * acc.dev.acc_1G_rec);
+            return true;
+        case FSSP_DATAID_T1         :
+            // we send all the flags as decimal digits for easy reading
+
+            // the t1Cnt simply allows the telemetry view to show at least some changes
+            tmpi = t1Cnt * 10000; // start off with at least one digit so the most significant 0 won't be cut off
+            // the Taranis seems to be able to fit 5 digits on the screen
+            // the Taranis seems to consider this number a signed 16 bit integer
+
+            if (!isArmingDisabled()) {
+                tmpi += 1;
+            } else {
+                tmpi += 2;
+            }
+            if (ARMING_FLAG(ARMED)) {
+                tmpi += 4;
+            }
+
+            if (FLIGHT_MODE(ANGLE_MODE)) {
+                tmpi += 10;
+            }
+            if (FLIGHT_MODE(HORIZON_MODE)) {
+                tmpi += 20;
+            }
+            if (FLIGHT_MODE(PASSTHRU_MODE)) {
+                tmpi += 40;
+            }
+
+            if (FLIGHT_MODE(MAG_MODE)) {
+                tmpi += 100;
+            }
+            if (FLIGHT_MODE(BARO_MODE)) {
+                tmpi += 200;
+            }
+
+            if (FLIGHT_MODE(GPS_HOLD_MODE)) {
+                tmpi += 1000;
+            }
+            if (FLIGHT_MODE(GPS_HOME_MODE)) {
+                tmpi += 2000;
+            }
+            if (FLIGHT_MODE(HEADFREE_MODE)) {
+                tmpi += 4000;
+            }
+
+            *value = (uint32_t)tmpi;
+            return true;
+        case FSSP_DATAID_T2         :
+#ifdef USE_GPS
+            if (sensors(SENSOR_GPS)) {
+                // provide GPS lock status
+                *value = (STATE(GPS_FIX) ? 1000 : 0) + (STATE(GPS_FIX_HOME) ? 2000 : 0) + gpsSol.numSat;
+                return true;
+            } else if (featureIsEnabled(FEATURE_GPS)) {
+                *value = 0;
+                return true;
+            } else
+#endif
+            if (telemetryConfig()->pidValuesAsTelemetry) {
+                switch (t2Cnt) {
+                    case 0:
+                        tmp2 = currentPidProfile->pid[PID_ROLL].P;
+                        tmp2 += (currentPidProfile->pid[PID_PITCH].P<<8);
+                        tmp2 += (currentPidProfile->pid[PID_YAW].P<<16);
+                    break;
+                    case 1:
+                        tmp2 = currentPidProfile->pid[PID_ROLL].I;
+                        tmp2 += (currentPidProfile->pid[PID_PITCH].I<<8);
+                        tmp2 += (currentPidProfile->pid[PID_YAW].I<<16);
+                    break;
+                    case 2:
+                        tmp2 = currentPidProfile->pid[PID_ROLL].D;
+                        tmp2 += (currentPidProfile->pid[PID_PITCH].D<<8);
+                        tmp2 += (currentPidProfile->pid[PID_YAW].D<<16);
+                    break;
+                    case 3:
+                        tmp2 = currentControlRateProfile->rates[FD_ROLL];
+                        tmp2 += (currentControlRateProfile->rates[FD_PITCH]<<8);
+                        tmp2 += (currentControlRateProfile->rates[FD_YAW]<<16);
+                    break;
+                }
+                tmp2 += t2Cnt<<24;
+                *value = tmp2;
+                return true;
+            }
+            break;
+#ifdef USE_GPS
+        case FSSP_DATAID_SPEED      :
+            if (STATE(GPS_FIX)) {
+                //convert to knots: 1cm/s = 0.0194384449 knots
+                //Speed should be sent in knots/1000 (GPS speed is in cm/s)
+                *value = gpsSol.groundSpeed * 1944 / 100;
+                return true;
+            }
+            break;
+        case FSSP_DATAID_LATLONG    :
+            if (STATE(GPS_FIX)) {
+                uint32_t tmpui = 0;
+                // the same ID is sent twice, one for longitude, one for latitude
+                // the MSB of the sent uint32_t helps FrSky keep track
+                if (sendLongitude) {
+                    tmpui = abs(gpsSol.llh.lon);  // now we have unsigned value and one bit to spare
+                    tmpui = (tmpui + tmpui / 2) / 25 | 0x80000000;  // 6/100 = 1.5/25, division by power of 2 is fast
+                    if (gpsSol.llh.lon < 0) tmpui |= 0x40000000;
+                }
+                else {
+                    tmpui = abs(gpsSol.llh.lat);  // now we have unsigned value and one bit to spare
+                    tmpui = (tmpui + tmpui / 2) / 25;  // 6/100 = 1.5/25, division by power of 2 is fast
+                    if (gpsSol.llh.lat < 0) tmpui |= 0x40000000;
+                }
+                *value = tmpui;
+                return true;
+            }
+            break;
+        case FSSP_DATAID_HOME_DIST  :
+            if (STATE(GPS_FIX)) {
+                *value = GPS_distanceToHome;
+                return true;
+            }
+            break;
+        case FSSP_DATAID_GPS_ALT    :
+            if (STATE(GPS_FIX)) {
+                *value = gpsSol.llh.altCm * 10; // given in 0.01m , requested in 10 = 1m (should be in mm, probably a bug in opentx, tested on 2.0.1.7)
+                return true;
+            }
+            break;
+#endif
+        case FSSP_DATAID_A4         :
+            cellCount = getBatteryCellCount();
+            vfasVoltage = cellCount ? (getBatteryVoltage() * 10 / cellCount) : 0; // given in 0.1V, convert to volts
+            *value = vfasVoltage;
+            return true;
+        default:
+            break;
+    }
+
+    return false;
+}
+
+// Moves on the sensors that send something different each time
+static void smartPortSensorSent(uint16_t id)
+{
+    switch (id) {
+        case FSSP_DATAID_T1         :
+            t1Cnt = t1Cnt % 3 + 1;
+            break;
+        case FSSP_DATAID_T2         :
+            t2Cnt = (t2Cnt + 1) % 4;
+            break;
+        case FSSP_DATAID_LATLONG    :
+            sendLongitude = !sendLongitude;
+            break;
+        default:
+            break;
+    }
+}
+
+#ifdef USE_ESC_SENSOR
+static void smartPortNextEscSensor(int index)
+{
+    uint8_t *offset = &frSkyEscIdOffset[index - frSkyEscDataIdStart];
+    *offset = (*offset + 1) % (getMotorCount() + 1); // each motor and ESC_SENSOR_COMBINED
+}
+#endif
+
+/*
+ * Works out the values from the telemetry task, so that answering a poll only takes copying one out. A value is taken
+ * out of the cache when it is sent, until the next refresh. An ESC sensor with no value for its motor moves on to the
+ * next one. Sensors with a rate of 0 are never sent, so are not worked out.
+ */
+static void smartPortRefreshSensorValues(void)
+{
+    for (int i = 0; i < frSkyDataIdCount; i++) {
+        uint16_t id = frSkyDataIdTable[i];
+#ifdef USE_ESC_SENSOR
+        if (i >= frSkyEscDataIdStart) {
+            id += frSkyEscIdOffset[i - frSkyEscDataIdStart];
+        }
+#endif
+        frSkySensorValueIds[i] = id;
+        if (frSkySensors[i].rateHz && telemetryScheduleIsEnabled(&smartPortSchedule, i) && smartPortSensorValue(id, &frSkySensorValues[i])) {
+            frSkySensorValuesReady |= BIT(i);
+        } else {
+            frSkySensorValuesReady &= ~BIT(i);
 #ifdef USE_ESC_SENSOR
-    static uint8_t smartPortIdOffset = 0;
+            if (i >= frSkyEscDataIdStart) {
+                smartPortNextEscSensor(i);
+            }
 #endif
+        }
+    }
+}
 
+void processSmartPortTelemetry(smartPortPayload_t *payload, volatile bool *clearToSend, const uint32_t *requestTimeout)
+{
 #if defined(USE_MSP_OVER_TELEMETRY)
     if (payload && smartPortPayloadContainsMSP(payload)) {
         // Do not check the physical ID here again
@@ -502,313 +822,23 @@ void processSmartPortTelemetry(smartPortPayload_t *payload, volatile bool *clear
         }
 #endif
 
-        // we can send back any data we want, our tables keep track of the order and frequency of each data type we send
-        frSkyTableInfo_t * tableInfo = &frSkyDataIdTableInfo;
-
-#ifdef USE_ESC_SENSOR
-        if (smartPortIdCycleCnt >= ESC_SENSOR_PERIOD) {
-            // send ESC sensors
-            tableInfo = &frSkyEscDataIdTableInfo;
-            if (tableInfo->index == tableInfo->size) { // end of ESC table, return to other sensors
-                tableInfo->index = 0;
-                smartPortIdCycleCnt = 0;
-                smartPortIdOffset++;
-                if (smartPortIdOffset == getMotorCount() + 1) { // each motor and ESC_SENSOR_COMBINED
-                    smartPortIdOffset = 0;
-                }
-            }
-        }
-        if (smartPortIdCycleCnt < ESC_SENSOR_PERIOD) {
-            // send other sensors
-            tableInfo = &frSkyDataIdTableInfo;
-#endif
-            if (tableInfo->index == tableInfo->size) { // end of table reached, loop back
-                tableInfo->index = 0;
-            }
-#ifdef USE_ESC_SENSOR
+        // we can send back any data we want, the schedule keeps track of the order and frequency of each data type we send,
+        // a sensor without a value keeps its place until it has one. The slot is left once every value has been sent
+        // since the last refresh.
+        const int index = telemetryScheduleNextReady(&smartPortSchedule, micros(), frSkySensorValuesReady);
+        if (index < 0) {
+            return;
         }
-#endif
-        uint16_t id = tableInfo->table[tableInfo->index];
+        const uint16_t id = frSkySensorValueIds[index];
+        smartPortSendPackage(id, frSkySensorValues[index]);
+        smartPortSensorSent(id);
+        *clearToSend = false;
+        frSkySensorValuesReady &= ~BIT(index);
 #ifdef USE_ESC_SENSOR
-        if (smartPortIdCycleCnt >= ESC_SENSOR_PERIOD) {
-            id += smartPortIdOffset;
+        if (index >= frSkyEscDataIdStart) {
+            smartPortNextEscSensor(index);
         }
 #endif
-        smartPortIdCycleCnt++;
-        tableInfo->index++;
-
-        int32_t tmpi;
-        uint32_t tmp2 = 0;
-        uint16_t vfasVoltage;
-        uint8_t cellCount;
-
-#ifdef USE_ESC_SENSOR
-        escSensorData_t *escData;
-#endif
-
-        switch (id) {
-            case FSSP_DATAID_VFAS       :
-                vfasVoltage = getBatteryVoltage();
-                if (telemetryConfig()->report_cell_voltage) {
-                    cellCount = getBatteryCellCount();
-                    vfasVoltage = cellCount ? getBatteryVoltage() / cellCount : 0;
-                }
-                smartPortSendPackage(id, vfasVoltage * 10); // given in 0.1V, convert to volts
-                *clearToSend = false;
-                break;
-#ifdef USE_ESC_SENSOR
-            case FSSP_DATAID_VFAS1      :
-            case FSSP_DATAID_VFAS2      :
-            case FSSP_DATAID_VFAS3      :
-            case FSSP_DATAID_VFAS4      :
-            case FSSP_DATAID_VFAS5      :
-            case FSSP_DATAID_VFAS6      :
-            case FSSP_DATAID_VFAS7      :
-            case FSSP_DATAID_VFAS8      :
-                escData = getEscSensorData(id - FSSP_DATAID_VFAS1);
-                if (escData != NULL) {
-                    smartPortSendPackage(id, escData->voltage);
-                    *clearToSend = false;
-                }
-                break;
-#endif
-            case FSSP_DATAID_CURRENT    :
-                smartPortSendPackage(id, getAmperage() / 10); // given in 10mA steps, unknown requested unit
-                *clearToSend = false;
-                break;
-#ifdef USE_ESC_SENSOR
-            case FSSP_DATAID_CURRENT1   :
-            case FSSP_DATAID_CURRENT2   :
-            case FSSP_DATAID_CURRENT3   :
-            case FSSP_DATAID_CURRENT4   :
-            case FSSP_DATAID_CURRENT5   :
-            case FSSP_DATAID_CURRENT6   :
-            case FSSP_DATAID_CURRENT7   :
-            case FSSP_DATAID_CURRENT8   :
-                escData = getEscSensorData(id - FSSP_DATAID_CURRENT1);
-                if (escData != NULL) {
-                    smartPortSendPackage(id, escData->current);
-                    *clearToSend = false;
-                }
-                break;
-            case FSSP_DATAID_RPM        :
-                escData = getEscSensorData(ESC_SENSOR_COMBINED);
-                if (escData != NULL) {
-                    smartPortSendPackage(id, calcEscRpm(escData->rpm));
-                    *clearToSend = false;
-                }
-                break;
-            case FSSP_DATAID_RPM1       :
-            case FSSP_DATAID_RPM2       :
-            case FSSP_DATAID_RPM3       :
-            case FSSP_DATAID_RPM4       :
-            case FSSP_DATAID_RPM5       :
-            case FSSP_DATAID_RPM6       :
-            case FSSP_DATAID_RPM7       :
-            case FSSP_DATAID_RPM8       :
-                escData = getEscSensorData(id - FSSP_DATAID_RPM1);
-                if (escData != NULL) {
-                    smartPortSendPackage(id, calcEscRpm(escData->rpm));
-                    *clearToSend = false;
-                }
-                break;
-            case FSSP_DATAID_TEMP        :
-                escData = getEscSensorData(ESC_SENSOR_COMBINED);
-                if (escData != NULL) {
-                    smartPortSendPackage(id, escData->temperature);
-                    *clearToSend = false;
-                }
-                break;
-            case FSSP_DATAID_TEMP1      :
-            case FSSP_DATAID_TEMP2      :
-            case FSSP_DATAID_TEMP3      :
-            case FSSP_DATAID_TEMP4      :
-            case FSSP_DATAID_TEMP5      :
-            case FSSP_DATAID_TEMP6      :
-            case FSSP_DATAID_TEMP7      :
-            case FSSP_DATAID_TEMP8      :
-                escData = getEscSensorData(id - FSSP_DATAID_TEMP1);
-                if (escData != NULL) {
-                    smartPortSendPackage(id, escData->temperature);
-                    *clearToSend = false;
-                }
-                break;
-#endif
-            case FSSP_DATAID_ALTITUDE   :
-                smartPortSendPackage(id, getEstimatedAltitudeCm()); // unknown given unit, requested 100 = 1 meter
-                *clearToSend = false;
-                break;
-            case FSSP_DATAID_FUEL       :
-                smartPortSendPackage(id, getMAhDrawn()); // given in mAh, unknown requested unit
-                *clearToSend = false;
-                break;
-            case FSSP_DATAID_VARIO      :
-                smartPortSendPackage(id, getEstimatedVario()); // unknown given unit but requested in 100 = 1m/s
-                *clearToSend = false;
-                break;
-            case FSSP_DATAID_HEADING    :
-                smartPortSendPackage(id, attitude.values.yaw * 10); // given in 10*deg, requested in 10000 = 100 deg
-                *clearToSend = false;
-                break;
-            case FSSP_DATAID_ACCX       :
-                smartPortSendPackage(id, lrintf(100 * acc.accADC[X] * acc.dev.acc_1G_rec)); // Multiply by 100 to show as x.xx g on Taranis
-                *clearToSend = false;
-                break;
-            case FSSP_DATAID_ACCY       :
-                smartPortSendPackage(id, lrintf(100 * acc.accADC[Y] * acc.dev.acc_1G_rec));
-                *clearToSend = false;
-                break;
-            case FSSP_DATAID_ACCZ       :
-                smartPortSendPackage(id, lrintf(100 * acc.accADC[Z] * acc.dev.acc_1G_rec));
-                *clearToSend = false;
-                break;
-            case FSSP_DATAID_T1         :
-                // we send all the flags as decimal digits for easy reading
-
-                // the t1Cnt simply allows the telemetry view to show at least some changes
-                t1Cnt++;
-                if (t1Cnt == 4) {
-                    t1Cnt = 1;
-                }
-                tmpi = t1Cnt * 10000; // start off with at least one digit so the most significant 0 won't be cut off
-                // the Taranis seems to be able to fit 5 digits on the screen
-                // the Taranis seems to consider this number a signed 16 bit integer
-
-                if (!isArmingDisabled()) {
-                    tmpi += 1;
-                } else {
-                    tmpi += 2;
-                }
-                if (ARMING_FLAG(ARMED)) {
-                    tmpi += 4;
-                }
-
-                if (FLIGHT_MODE(ANGLE_MODE)) {
-                    tmpi += 10;
-                }
-                if (FLIGHT_MODE(HORIZON_MODE)) {
-                    tmpi += 20;
-                }
-                if (FLIGHT_MODE(PASSTHRU_MODE)) {
-                    tmpi += 40;
-                }
-
-                if (FLIGHT_MODE(MAG_MODE)) {
-                    tmpi += 100;
-                }
-                if (FLIGHT_MODE(BARO_MODE)) {
-                    tmpi += 200;
-                }
-
-                if (FLIGHT_MODE(GPS_HOLD_MODE)) {
-                    tmpi += 1000;
-                }
-                if (FLIGHT_MODE(GPS_HOME_MODE)) {
-                    tmpi += 2000;
-                }
-                if (FLIGHT_MODE(HEADFREE_MODE)) {
-                    tmpi += 4000;
-                }
-
-                smartPortSendPackage(id, (uint32_t)tmpi);
-                *clearToSend = false;
-                break;
-            case FSSP_DATAID_T2         :
-#ifdef USE_GPS
-                if (sensors(SENSOR_GPS)) {
-                    // provide GPS lock status
-                    smartPortSendPackage(id, (STATE(GPS_FIX) ? 1000 : 0) + (STATE(GPS_FIX_HOME) ? 2000 : 0) + gpsSol.numSat);
-                    *clearToSend = false;
-                } else if (featureIsEnabled(FEATURE_GPS)) {
-                    smartPortSendPackage(id, 0);
-                    *clearToSend = false;
-                } else
-#endif
-                if (telemetryConfig()->pidValuesAsTelemetry) {
-                    switch (t2Cnt) {
-                        case 0:
-                            tmp2 = currentPidProfile->pid[PID_ROLL].P;
-                            tmp2 += (currentPidProfile->pid[PID_PITCH].P<<8);
-                            tmp2 += (currentPidProfile->pid[PID_YAW].P<<16);
-                        break;
-                        case 1:
-                            tmp2 = currentPidProfile->pid[PID_ROLL].I;
-                            tmp2 += (currentPidProfile->pid[PID_PITCH].I<<8);
-                            tmp2 += (currentPidProfile->pid[PID_YAW].I<<16);
-                        break;
-                        case 2:
-                            tmp2 = currentPidProfile->pid[PID_ROLL].D;
-                            tmp2 += (currentPidProfile->pid[PID_PITCH].D<<8);
-                            tmp2 += (currentPidProfile->pid[PID_YAW].D<<16);
-                        break;
-                        case 3:
-                            tmp2 = currentControlRateProfile->rates[FD_ROLL];
-                            tmp2 += (currentControlRateProfile->rates[FD_PITCH]<<8);
-                            tmp2 += (currentControlRateProfile->rates[FD_YAW]<<16);
-                        break;
-                    }
-                    tmp2 += t2Cnt<<24;
-                    t2Cnt++;
-                    if (t2Cnt == 4) {
-                        t2Cnt = 0;
-                    }
-                    smartPortSendPackage(id, tmp2);
-                    *clearToSend = false;
-                }
-                break;
-#ifdef USE_GPS
-            case FSSP_DATAID_SPEED      :
-                if (STATE(GPS_FIX)) {
-                    //convert to knots: 1cm/s = 0.0194384449 knots
-                    //Speed should be sent in knots/1000 (GPS speed is in cm/s)
-                    uint32_t tmpui = gpsSol.groundSpeed * 1944 / 100;
-                    smartPortSendPackage(id, tmpui);
-                    *clearToSend = false;
-                }
-                break;
-            case FSSP_DATAID_LATLONG    :
-                if (STATE(GPS_FIX)) {
-                    uint32_t tmpui = 0;
-                    // the same ID is sent twice, one for longitude, one for latitude
-                    // the MSB of the sent uint32_t helps FrSky keep track
-                    // the even/odd bit of our counter helps us keep track
-                    if (tableInfo->index & 1) {
-                        tmpui = abs(gpsSol.llh.lon);  // now we have unsigned value and one bit to spare
-                        tmpui = (tmpui + tmpui / 2) / 25 | 0x80000000;  // 6/100 = 1.5/25, division by power of 2 is fast
-                        if (gpsSol.llh.lon < 0) tmpui |= 0x40000000;
-                    }
-                    else {
-                        tmpui = abs(gpsSol.llh.lat);  // now we have unsigned value and one bit to spare
-                        tmpui = (tmpui + tmpui / 2) / 25;  // 6/100 = 1.5/25, division by power of 2 is fast
-                        if (gpsSol.llh.lat < 0) tmpui |= 0x40000000;
-                    }
-                    smartPortSendPackage(id, tmpui);
-                    *clearToSend = false;
-                }
-                break;
-            case FSSP_DATAID_HOME_DIST  :
-                if (STATE(GPS_FIX)) {
-                    smartPortSendPackage(id, GPS_distanceToHome);
-                     *clearToSend = false;
-                }
-                break;
-            case FSSP_DATAID_GPS_ALT    :
-                if (STATE(GPS_FIX)) {
-                    smartPortSendPackage(id, gpsSol.llh.altCm * 10); // given in 0.01m , requested in 10 = 1m (should be in mm, probably a bug in opentx, tested on 2.0.1.7)
-                    *clearToSend = false;
-                }
-                break;
-#endif
-            case FSSP_DATAID_A4         :
-                cellCount = getBatteryCellCount();
-                vfasVoltage = cellCount ? (getBatteryVoltage() * 10 / cellCount) : 0; // given in 0.1V, convert to volts
-                smartPortSendPackage(id, vfasVoltage);
-                *clearToSend = false;
-                break;
-            default:
-                break;
-                // if nothing is sent, hasRequest isn't cleared, we already incremented the counter, just loop back to the start
-        }
     }
 }
 
@@ -831,5 +861,9 @@ void handleSmartPortTelemetry(void)
 
             processSmartPortTelemetry(payload, &clearToSend, &requestTimeout);
     }
+
+    if (telemetryState == TELEMETRY_STATE_INITIALIZED_EXTERNAL || smartPortSerialPort) {
+        smartPortRefreshSensorValues();
+    }
 }
 #endif
@@ -54,6 +54,26 @@ enum
     // remaining 3 bits are crc (according to comments in openTx code)
 };
 
+// Sensors with a configurable rate, relative to each other
+typedef enum {
+    SMARTPORT_SENSOR_FLAGS = 0,     // T1, arming and flight modes
+    SMARTPORT_SENSOR_STATUS,        // T2, GPS status or PIDs
+    SMARTPORT_SENSOR_VFAS,
+    SMARTPORT_SENSOR_CELL_VOLTAGE,  // A4
+    SMARTPORT_SENSOR_CURRENT,
+    SMARTPORT_SENSOR_FUEL,
+    SMARTPORT_SENSOR_HEADING,
+    SMARTPORT_SENSOR_ACC,           // for each axis
+    SMARTPORT_SENSOR_ALTITUDE,
+    SMARTPORT_SENSOR_VARIO,
+    SMARTPORT_SENSOR_SPEED,
+    SMARTPORT_SENSOR_LATLONG,
+    SMARTPORT_SENSOR_HOME_DIST,
+    SMARTPORT_SENSOR_GPS_ALT,
+    SMARTPORT_SENSOR_ESC,           // for each ESC sensor value
+    SMARTPORT_SENSOR_COUNT
+} smartportSensor_e;
+
 typedef struct smartPortPayload_s {
     uint8_t  frameId;
     uint16_t valueId;
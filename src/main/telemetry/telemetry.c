@@ -78,6 +78,23 @@ PG_RESET_TEMPLATE(telemetryConfig_t, telemetryConfig,
     },
     .smartport_use_extra_sensors = false,
     .mavlink_mah_as_heading_divisor = 0,
+    .smartport_sensor_rates = {
+        [SMARTPORT_SENSOR_FLAGS] = 2,
+        [SMARTPORT_SENSOR_STATUS] = 1,
+        [SMARTPORT_SENSOR_VFAS] = 5,
+        [SMARTPORT_SENSOR_CELL_VOLTAGE] = 5,
+        [SMARTPORT_SENSOR_CURRENT] = 5,
+        [SMARTPORT_SENSOR_FUEL] = 2,
+        [SMARTPORT_SENSOR_HEADING] = 5,
+        [SMARTPORT_SENSOR_ACC] = 2,
+        [SMARTPORT_SENSOR_ALTITUDE] = 5,
+        [SMARTPORT_SENSOR_VARIO] = 10,
+        [SMARTPORT_SENSOR_SPEED] = 2,
+        [SMARTPORT_SENSOR_LATLONG] = 4,     // latitude and longitude in turn
+        [SMARTPORT_SENSOR_HOME_DIST] = 2,
+        [SMARTPORT_SENSOR_GPS_ALT] = 2,
+        [SMARTPORT_SENSOR_ESC] = 2,
+    },
 );
 
 void telemetryInit(void)
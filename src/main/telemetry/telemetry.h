@@ -30,6 +30,7 @@
 #include "pg/pg.h"
 #include "io/serial.h"
 #include "telemetry/ibus_shared.h"
+#include "telemetry/smartport.h"
 
 typedef enum {
     FRSKY_FORMAT_DMS = 0,
@@ -55,6 +56,7 @@ typedef struct telemetryConfig_s {
     uint8_t flysky_sensors[IBUS_SENSOR_COUNT];
     uint8_t smartport_use_extra_sensors;
     uint16_t mavlink_mah_as_heading_divisor;
+    uint8_t smartport_sensor_rates[SMARTPORT_SENSOR_COUNT];
 } telemetryConfig_t;
 
 PG_DECLARE(telemetryConfig_t, telemetryConfig);
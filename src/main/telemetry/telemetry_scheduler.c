@@ -0,0 +1,186 @@
+/*
+ * This file is part of Cleanflight and Betaflight.
+ *
+ * Cleanflight and Betaflight are free software. You can redistribute
+ * this software and/or modify this software under the terms of the
+ * GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Cleanflight and Betaflight are distributed in the hope that they
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software.
+ *
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "platform.h"
+
+#ifdef USE_TELEMETRY
+
+#include "common/maths.h"
+#include "common/utils.h"
+
+#include "telemetry/telemetry_scheduler.h"
+
+// Lateness is counted in 1/256 of a period, and no more than this many periods
+#define URGENCY_PERIOD          256
+#define URGENCY_PERIODS_MAX     8
+// Lateness worth a priority level
+#define URGENCY_PRIORITY        (2 * URGENCY_PERIOD)
+
+void telemetryScheduleInit(telemetrySchedule_t *schedule, const telemetrySensor_t *sensors, uint8_t count, uint32_t budget)
+{
+    memset(schedule, 0, sizeof(*schedule));
+    schedule->sensors = sensors;
+    schedule->count = MIN(count, TELEMETRY_SCHEDULE_SENSORS_MAX);
+    schedule->budget = budget;
+    for (int i = 0; i < schedule->count; i++) {
+        schedule->enabled |= BIT(i);
+    }
+}
+
+void telemetryScheduleEnable(telemetrySchedule_t *schedule, uint8_t index, bool enabled)
+{
+    if (index >= schedule->count) {
+        return;
+    }
+    if (enabled) {
+        schedule->enabled |= BIT(index);
+    } else {
+        schedule->enabled &= ~BIT(index);
+    }
+}
+
+bool telemetryScheduleIsEnabled(const telemetrySchedule_t *schedule, uint8_t index)
+{
+    return index < schedule->count && (schedule->enabled & BIT(index));
+}
+
+// For links whose rate changes, such as an RC link that switches RF mode
+void telemetryScheduleSetBudget(telemetrySchedule_t *schedule, uint32_t budget, uint8_t burst)
+{
+    schedule->budget = budget;
+    schedule->burst = burst;
+}
+
+static timeDelta_t sensorPeriodUs(const telemetrySensor_t *sensor)
+{
+    return 1000000 / sensor->rateHz;
+}
+
+// 0 if the sensor has to wait
+static uint32_t sensorUrgency(const telemetrySchedule_t *schedule, int index, timeUs_t currentTimeUs)
+{
+    const telemetrySensor_t *sensor = &schedule->sensors[index];
+    const timeDelta_t periodStep = MAX(sensorPeriodUs(sensor) / URGENCY_PERIOD, 1);
+    const timeDelta_t lateUs = cmpTimeUs(currentTimeUs, schedule->dueUs[index]);
+
+    if (lateUs >= 0) {
+        const uint32_t late = MIN(lateUs / periodStep, URGENCY_PERIODS_MAX * URGENCY_PERIOD);
+        return (sensor->priority + 1) * URGENCY_PRIORITY + late;
+    }
+    if (schedule->budget) {
+        return 0;
+    }
+    // Slots handed out by the receiver are not wasted, the sensor due next goes early
+    const uint32_t early = MIN(-lateUs / periodStep, URGENCY_PERIOD - 1);
+    return URGENCY_PERIOD - early;
+}
+
+static void sensorSent(telemetrySchedule_t *schedule, int index, timeUs_t currentTimeUs)
+{
+    const timeDelta_t periodUs = sensorPeriodUs(&schedule->sensors[index]);
+    timeUs_t *dueUs = &schedule->dueUs[index];
+
+    if (cmpTimeUs(*dueUs, currentTimeUs) > 0) {
+        // early
+        *dueUs = currentTimeUs + periodUs;
+    } else {
+        // keeps the rate if a little late, but doesn't make up for more than a period
+        *dueUs += periodUs;
+        if (cmpTimeUs(*dueUs, currentTimeUs) < 0) {
+            *dueUs = currentTimeUs;
+        }
+    }
+}
+
+// Marks link time taken by frames sent outside of the schedule, such as MSP replies
+void telemetryScheduleLinkUsed(telemetrySchedule_t *schedule, timeUs_t currentTimeUs, uint8_t size)
+{
+    if (!schedule->budget) {
+        return;
+    }
+    // time the link was idle is kept for up to a burst
+    const timeDelta_t burstUs = schedule->burst * 1000000 / schedule->budget;
+    if (cmpTimeUs(currentTimeUs, schedule->linkFreeUs) > burstUs) {
+        schedule->linkFreeUs = currentTimeUs - burstUs;
+    }
+    schedule->linkFreeUs += size * 1000000 / schedule->budget;
+}
+
+static int scheduleNext(telemetrySchedule_t *schedule, timeUs_t currentTimeUs, uint8_t maxSize, uint32_t candidates)
+{
+    if (!schedule->started) {
+        for (int i = 0; i < schedule->count; i++) {
+            schedule->dueUs[i] = currentTimeUs;
+        }
+        // the link starts idle, with a burst to use
+        schedule->linkFreeUs = currentTimeUs;
+        if (schedule->budget) {
+            schedule->linkFreeUs -= schedule->burst * 1000000 / schedule->budget;
+        }
+        schedule->started = true;
+    }
+
+    if (schedule->budget && cmpTimeUs(currentTimeUs, schedule->linkFreeUs) < 0) {
+        return -1;
+    }
+
+    int next = -1;
+    uint32_t nextUrgency = 0;
+    for (int i = 0; i < schedule->count; i++) {
+        if (!(schedule->enabled & candidates & BIT(i)) || !schedule->sensors[i].rateHz || schedule->sensors[i].size > maxSize) {
+            continue;
+        }
+        const uint32_t urgency = sensorUrgency(schedule, i, currentTimeUs);
+        if (urgency > nextUrgency) {
+            next = i;
+            nextUrgency = urgency;
+        }
+    }
+
+    if (next >= 0) {
+        sensorSent(schedule, next, currentTimeUs);
+        telemetryScheduleLinkUsed(schedule, currentTimeUs, schedule->sensors[next].size);
+    }
+    return next;
+}
+
+// Returns the sensor to send now, and counts it as sent, or -1 if there is none or the link is busy
+int telemetryScheduleNext(telemetrySchedule_t *schedule, timeUs_t currentTimeUs)
+{
+    return scheduleNext(schedule, currentTimeUs, UINT8_MAX, UINT32_MAX);
+}
+
+// As telemetryScheduleNext, for sensors no bigger than maxSize, for filling what is left of a buffer
+int telemetryScheduleNextWithin(telemetrySchedule_t *schedule, timeUs_t currentTimeUs, uint8_t maxSize)
+{
+    return scheduleNext(schedule, currentTimeUs, maxSize, UINT32_MAX);
+}
+
+// As telemetryScheduleNext, only from the sensors in ready, the others stay due until they have a value to send
+int telemetryScheduleNextReady(telemetrySchedule_t *schedule, timeUs_t currentTimeUs, uint32_t ready)
+{
+    return scheduleNext(schedule, currentTimeUs, UINT8_MAX, ready);
+}
+
+#endif
@@ -0,0 +1,69 @@
+/*
+ * This file is part of Cleanflight and Betaflight.
+ *
+ * Cleanflight and Betaflight are free software. You can redistribute
+ * this software and/or modify this software under the terms of the
+ * GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Cleanflight and Betaflight are distributed in the hope that they
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software.
+ *
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "common/time.h"
+
+/*
+ * Shared sensor scheduling for the telemetry protocols.
+ *
+ * A protocol declares a sensor for each frame or value it sends, with the rate it wants it at and a priority, and
+ * the budget of its link. Asking the schedule for the next sensor gives the most overdue one the link has room for,
+ * higher priorities first. A sensor late by two whole periods counts as a priority higher, so busier sensors can't
+ * hold it back for ever.
+ */
+
+#define TELEMETRY_SCHEDULE_SENSORS_MAX 32
+
+typedef enum {
+    TELEMETRY_PRIORITY_LOW = 0,
+    TELEMETRY_PRIORITY_NORMAL,
+    TELEMETRY_PRIORITY_HIGH,    // voltage, RSSI and attitude
+} telemetryPriority_e;
+
+typedef struct telemetrySensor_s {
+    uint8_t rateHz;             // 0 to never send
+    uint8_t priority;           // telemetryPriority_e
+    uint8_t size;               // bytes on the link, 1 for links budgeted in frames
+} telemetrySensor_t;
+
+typedef struct telemetrySchedule_s {
+    const telemetrySensor_t *sensors;
+    uint8_t count;
+    bool started;
+    uint32_t budget;            // bytes or frames per second, 0 if the receiver hands out the slots
+    uint8_t burst;              // bytes or frames that can go together after the link was idle
+    uint32_t enabled;           // bit per sensor
+    timeUs_t linkFreeUs;        // when the link has room for the next frame
+    timeUs_t dueUs[TELEMETRY_SCHEDULE_SENSORS_MAX];
+} telemetrySchedule_t;
+
+void telemetryScheduleInit(telemetrySchedule_t *schedule, const telemetrySensor_t *sensors, uint8_t count, uint32_t budget);
+void telemetryScheduleEnable(telemetrySchedule_t *schedule, uint8_t index, bool enabled);
+bool telemetryScheduleIsEnabled(const telemetrySchedule_t *schedule, uint8_t index);
+void telemetryScheduleSetBudget(telemetrySchedule_t *schedule, uint32_t budget, uint8_t burst);
+int telemetryScheduleNext(telemetrySchedule_t *schedule, timeUs_t currentTimeUs);
+int telemetryScheduleNextWithin(telemetrySchedule_t *schedule, timeUs_t currentTimeUs, uint8_t maxSize);
+int telemetryScheduleNextReady(telemetrySchedule_t *schedule, timeUs_t currentTimeUs, uint32_t ready);
+void telemetryScheduleLinkUsed(telemetrySchedule_t *schedule, timeUs_t currentTimeUs, uint8_t size);
@@ -53,6 +53,7 @@ __IO uint32_t packetSent;                                     // HJI
 extern __IO uint32_t receiveLength;                          // HJI
 
 uint8_t receiveBuffer[64];                                   // HJI
+static uint8_t receiveOffset = 0;
 uint32_t sendLength;                                          // HJI
 static void IntToUnicode(uint32_t value, uint8_t *pbuf, uint8_t len);
 static void (*ctrlLineStateCb)(void *context, uint16_t ctrlLineState);
@@ -331,7 +332,6 @@ uint32_t CDC_Send_FreeBytes(void)
  *******************************************************************************/
 uint32_t CDC_Receive_DATA(uint8_t* recvBuf, uint32_t len)
 {
-    static uint8_t offset = 0;
     uint8_t i;
 
     if (len > receiveLength) {
@@ -339,20 +339,39 @@ uint32_t CDC_Receive_DATA(uint8_t* recvBuf, uint32_t len)
     }
 
     for (i = 0; i < len; i++) {
-        recvBuf[i] = (uint8_t)(receiveBuffer[i + offset]);
+        recvBuf[i] = (uint8_t)(receiveBuffer[i + receiveOffset]);
     }
 
+    CDC_Receive_Skip(len);
+
+    return len;
+}
+
+/*******************************************************************************
+ * Function Name  : Receive span.
+ * Description    : the received data not yet read, without consuming it
+ * Input          : None.
+ * Output         : pointer to the data.
+ * Return         : number of bytes at the pointer.
+ *******************************************************************************/
+uint32_t CDC_Receive_Span(const uint8_t **data)
+{
+    *data = &receiveBuffer[receiveOffset];
+
+    return receiveLength;
+}
+
+void CDC_Receive_Skip(uint32_t len)
+{
     receiveLength -= len;
-    offset += len;
+    receiveOffset += len;
 
     /* re-enable the rx endpoint which we had set to receive 0 bytes */
     if (receiveLength == 0) {
         SetEPRxCount(ENDP3, 64);
         SetEPRxStatus(ENDP3, EP_RX_VALID);
-        offset = 0;
+        receiveOffset = 0;
     }
-
-    return len;
 }
 
 uint32_t CDC_Receive_BytesAvailable(void)
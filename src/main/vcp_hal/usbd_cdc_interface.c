@@ -352,6 +352,24 @@ uint32_t CDC_Receive_DATA(uint8_t* recvBuf, uint32_t len)
     return count;
 }
 
+/*
+ * The received data not yet read, without consuming it
+ */
+uint32_t CDC_Receive_Span(const uint8_t **data)
+{
+    *data = rxBuffPtr;
+
+    return rxBuffPtr != NULL ? rxAvailable : 0;
+}
+
+void CDC_Receive_Skip(uint32_t len)
+{
+    rxBuffPtr += len;
+    rxAvailable -= len;
+    if (len && rxAvailable < 1)
+        USBD_CDC_ReceivePacket(&USBD_Device);
+}
+
 uint32_t CDC_Receive_BytesAvailable(void)
 {
     return rxAvailable;
@@ -241,6 +241,23 @@ uint32_t CDC_Receive_DATA(uint8_t* recvBuf, uint32_t len)
     return count;
 }
 
+/*
+ * The received data not yet read that is contiguous in the circular buffer, without consuming it
+ */
+uint32_t CDC_Receive_Span(const uint8_t **data)
+{
+    const uint32_t in = APP_Tx_ptr_in;
+
+    *data = &APP_Tx_Buffer[APP_Tx_ptr_out];
+
+    return APP_Tx_ptr_out > in ? APP_TX_DATA_SIZE - APP_Tx_ptr_out : in - APP_Tx_ptr_out;
+}
+
+void CDC_Receive_Skip(uint32_t len)
+{
+    APP_Tx_ptr_out = (APP_Tx_ptr_out + len) % APP_TX_DATA_SIZE;
+}
+
 uint32_t CDC_Receive_BytesAvailable(void)
 {
     /* return the bytes available in the receive circular buffer */
@@ -0,0 +1,791 @@
+/*
+ * This file is part of Cleanflight and Betaflight.
+ *
+ * Cleanflight and Betaflight are free software. You can redistribute
+ * this software and/or modify this software under the terms of the
+ * GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Cleanflight and Betaflight are distributed in the hope that they
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software.
+ *
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+extern "C" {
+    #include "platform.h"
+
+    #include "common/maths.h"
+    #include "common/utils.h"
+
+    #include "drivers/sdcard.h"
+
+    #include "io/asyncfatfs/asyncfatfs.h"
+    #include "io/asyncfatfs/fat_standard.h"
+}
+
+#include "unittest_macros.h"
+#include "gtest/gtest.h"
+
+/*
+ * Simulated SD card.
+ *
+ * A RAM disk behind the same non-blocking API and multi-block write state machine as drivers/sdcard.c, with a simple
+ * latency model so that the write throughput and worst-case stall of the filesystem can be measured on the host.
+ */
+
+#define SIM_SDCARD_BLOCK_SIZE          512
+#define SIM_SDCARD_NUM_BLOCKS          65536 // 32MB
+
+#define SIM_PARTITION_START_SECTOR     64
+#define SIM_SECTORS_PER_CLUSTER        8
+#define SIM_RESERVED_SECTORS           1
+#define SIM_FAT_SECTORS                32
+#define SIM_ROOT_ENTRIES               512
+
+// Latency model, all times in microseconds
+#define SIM_LATENCY_TRANSFER_US        100   // Clocking one block over the bus
+#define SIM_LATENCY_READ_US            300   // Card access time for a single block read
+#define SIM_LATENCY_SINGLE_WRITE_US    1500  // Programming a lone block (read-modify-write of an erase block)
+#define SIM_LATENCY_MULTI_WRITE_US     200   // Programming each block of a multiple block write
+#define SIM_LATENCY_STOP_US            500   // Stop transmission at the end of a multiple block write
+#define SIM_LATENCY_HOUSEKEEPING_US    25000 // Occasional internal garbage collection by the card
+#define SIM_HOUSEKEEPING_INTERVAL      128   // Blocks programmed between housekeeping stalls
+
+typedef enum {
+    SIM_SDCARD_STATE_READY,
+    SIM_SDCARD_STATE_READING,
+    SIM_SDCARD_STATE_SENDING_WRITE,
+    SIM_SDCARD_STATE_WAITING_FOR_WRITE,
+    SIM_SDCARD_STATE_WRITING_MULTIPLE_BLOCKS,
+    SIM_SDCARD_STATE_STOPPING_MULTIPLE_BLOCK_WRITE
+} simSdcardState_e;
+
+typedef struct simSdcardStats_s {
+    uint32_t blocksRead;
+    uint32_t singleBlockWrites;
+    uint32_t multiBlockWrites; // Multiple block write commands issued
+    uint32_t multiBlockBlocks; // Blocks written as part of a multiple block write
+} simSdcardStats_t;
+
+static struct {
+    simSdcardState_e state;
+    uint32_t busyUntil;
+    bool multiBlock;
+    uint32_t multiWriteNextBlock;
+    uint32_t multiWriteBlocksRemain;
+    uint32_t blocksProgrammed;
+
+    uint32_t blockIndex;
+    uint8_t *buffer;
+    sdcard_operationCompleteCallback_c callback;
+    uint32_t callbackData;
+
+    simSdcardStats_t stats;
+} simSdcard;
+
+static uint8_t simDisk[SIM_SDCARD_NUM_BLOCKS][SIM_SDCARD_BLOCK_SIZE];
+static uint32_t simTimeUs;
+
+static void simSdcardBusyFor(simSdcardState_e state, uint32_t durationUs)
+{
+    simSdcard.state = state;
+    simSdcard.busyUntil = simTimeUs + durationUs;
+}
+
+static void simSdcardEndWriteBlocks(void)
+{
+    simSdcard.multiWriteBlocksRemain = 0;
+    simSdcardBusyFor(SIM_SDCARD_STATE_STOPPING_MULTIPLE_BLOCK_WRITE, SIM_LATENCY_STOP_US);
+}
+
+static void simSdcardReset(void)
+{
+    memset(&simSdcard, 0, sizeof(simSdcard));
+    memset(simDisk, 0, sizeof(simDisk));
+    simTimeUs = 0;
+}
+
+static void simSdcardWriteLE16(uint8_t *dest, uint16_t value)
+{
+    dest[0] = value & 0xFF;
+    dest[1] = value >> 8;
+}
+
+static void simSdcardWriteLE32(uint8_t *dest, uint32_t value)
+{
+    simSdcardWriteLE16(dest, value & 0xFFFF);
+    simSdcardWriteLE16(dest + 2, value >> 16);
+}
+
+/*
+ * Lay down a freshly formatted FAT16 filesystem in a single MBR partition.
+ */
+static void simSdcardFormat(void)
+{
+    const uint32_t partitionSectors = SIM_SDCARD_NUM_BLOCKS - SIM_PARTITION_START_SECTOR;
+
+    uint8_t *mbr = simDisk[0];
+    uint8_t *partition = mbr + 446;
+
+    partition[4] = MBR_PARTITION_TYPE_FAT16;
+    simSdcardWriteLE32(partition + 8, SIM_PARTITION_START_SECTOR);
+    simSdcardWriteLE32(partition + 12, partitionSectors);
+    mbr[510] = 0x55;
+    mbr[511] = 0xAA;
+
+    uint8_t *volumeID = simDisk[SIM_PARTITION_START_SECTOR];
+
+    memcpy(volumeID + 3, "BFSIMFAT", 8);
+    simSdcardWriteLE16(volumeID + 11, SIM_SDCARD_BLOCK_SIZE);
+    volumeID[13] = SIM_SECTORS_PER_CLUSTER;
+    simSdcardWriteLE16(volumeID + 14, SIM_RESERVED_SECTORS);
+    volumeID[16] = 2; // Number of FATs
+    simSdcardWriteLE16(volumeID + 17, SIM_ROOT_ENTRIES);
+    volumeID[21] = 0xF8; // Fixed disk
+    simSdcardWriteLE16(volumeID + 22, SIM_FAT_SECTORS);
+    simSdcardWriteLE32(volumeID + 32, partitionSectors);
+    volumeID[510] = FAT_VOLUME_ID_SIGNATURE_1;
+    volumeID[511] = FAT_VOLUME_ID_SIGNATURE_2;
+
+    for (int fat = 0; fat < 2; fat++) {
+        uint8_t *fatSector = simDisk[SIM_PARTITION_START_SECTOR + SIM_RESERVED_SECTORS + fat * SIM_FAT_SECTORS];
+
+        simSdcardWriteLE16(fatSector, 0xFFF8);
+        simSdcardWriteLE16(fatSector + 2, 0xFFFF);
+    }
+}
+
+/*
+ * Advance the simulated clock, completing any card operations which fall due.
+ */
+static void simSdcardAdvance(uint32_t durationUs)
+{
+    simTimeUs += durationUs;
+    sdcard_poll();
+}
+
+extern "C" {
+
+bool sdcard_poll(void)
+{
+    while (simSdcard.state != SIM_SDCARD_STATE_READY && simSdcard.state != SIM_SDCARD_STATE_WRITING_MULTIPLE_BLOCKS
+        && (int32_t) (simTimeUs - simSdcard.busyUntil) >= 0) {
+        switch (simSdcard.state) {
+            case SIM_SDCARD_STATE_READING:
+                memcpy(simSdcard.buffer, simDisk[simSdcard.blockIndex], SIM_SDCARD_BLOCK_SIZE);
+                simSdcard.state = SIM_SDCARD_STATE_READY;
+                simSdcard.stats.blocksRead++;
+
+                simSdcard.callback(SDCARD_BLOCK_OPERATION_READ, simSdcard.blockIndex, simSdcard.buffer, simSdcard.callbackData);
+            break;
+            case SIM_SDCARD_STATE_SENDING_WRITE: {
+                memcpy(simDisk[simSdcard.blockIndex], simSdcard.buffer, SIM_SDCARD_BLOCK_SIZE);
+
+                uint32_t programTime = simSdcard.multiBlock ? SIM_LATENCY_MULTI_WRITE_US : SIM_LATENCY_SINGLE_WRITE_US;
+
+                if (++simSdcard.blocksProgrammed % SIM_HOUSEKEEPING_INTERVAL == 0) {
+                    programTime += SIM_LATENCY_HOUSEKEEPING_US;
+                }
+
+                simSdcardBusyFor(SIM_SDCARD_STATE_WAITING_FOR_WRITE, programTime);
+
+                // Like the real driver, the caller gets their buffer back as soon as it has been transmitted
+                if (simSdcard.callback) {
+                    simSdcard.callback(SDCARD_BLOCK_OPERATION_WRITE, simSdcard.blockIndex, simSdcard.buffer, simSdcard.callbackData);
+                }
+            }
+            break;
+            case SIM_SDCARD_STATE_WAITING_FOR_WRITE:
+                if (simSdcard.multiWriteBlocksRemain > 1) {
+                    simSdcard.multiWriteBlocksRemain--;
+                    simSdcard.multiWriteNextBlock++;
+                    simSdcard.state = SIM_SDCARD_STATE_WRITING_MULTIPLE_BLOCKS;
+                } else if (simSdcard.multiWriteBlocksRemain == 1) {
+                    simSdcardEndWriteBlocks();
+                } else {
+                    simSdcard.state = SIM_SDCARD_STATE_READY;
+                }
+            break;
+            case SIM_SDCARD_STATE_STOPPING_MULTIPLE_BLOCK_WRITE:
+                simSdcard.state = SIM_SDCARD_STATE_READY;
+            break;
+            default:
+                ;
+        }
+    }
+
+    return simSdcard.state == SIM_SDCARD_STATE_READY || simSdcard.state == SIM_SDCARD_STATE_WRITING_MULTIPLE_BLOCKS;
+}
+
+bool sdcard_readBlock(uint32_t blockIndex, uint8_t *buffer, sdcard_operationCompleteCallback_c callback, uint32_t callbackData)
+{
+    if (simSdcard.state == SIM_SDCARD_STATE_WRITING_MULTIPLE_BLOCKS) {
+        simSdcardEndWriteBlocks();
+    }
+
+    if (simSdcard.state != SIM_SDCARD_STATE_READY || blockIndex >= SIM_SDCARD_NUM_BLOCKS) {
+        return false;
+    }
+
+    simSdcard.blockIndex = blockIndex;
+    simSdcard.buffer = buffer;
+    simSdcard.callback = callback;
+    simSdcard.callbackData = callbackData;
+
+    simSdcardBusyFor(SIM_SDCARD_STATE_READING, SIM_LATENCY_READ_US + SIM_LATENCY_TRANSFER_US);
+
+    return true;
+}
+
+sdcardOperationStatus_e sdcard_beginWriteBlocks(uint32_t blockIndex, uint32_t blockCount)
+{
+    if (simSdcard.state == SIM_SDCARD_STATE_WRITING_MULTIPLE_BLOCKS) {
+        if (blockIndex == simSdcard.multiWriteNextBlock) {
+            return SDCARD_OPERATION_SUCCESS;
+        }
+
+        simSdcardEndWriteBlocks();
+    }
+
+    if (simSdcard.state != SIM_SDCARD_STATE_READY) {
+        return SDCARD_OPERATION_BUSY;
+    }
+
+    simSdcard.state = SIM_SDCARD_STATE_WRITING_MULTIPLE_BLOCKS;
+    simSdcard.multiWriteNextBlock = blockIndex;
+    simSdcard.multiWriteBlocksRemain = blockCount;
+    simSdcard.stats.multiBlockWrites++;
+
+    return SDCARD_OPERATION_SUCCESS;
+}
+
+sdcardOperationStatus_e sdcard_writeBlock(uint32_t blockIndex, uint8_t *buffer, sdcard_operationCompleteCallback_c callback, uint32_t callbackData)
+{
+    if (blockIndex >= SIM_SDCARD_NUM_BLOCKS) {
+        return SDCARD_OPERATION_FAILURE;
+    }
+
+    switch (simSdcard.state) {
+        case SIM_SDCARD_STATE_WRITING_MULTIPLE_BLOCKS:
+            if (blockIndex != simSdcard.multiWriteNextBlock) {
+                simSdcardEndWriteBlocks();
+
+                return SDCARD_OPERATION_BUSY;
+            }
+            simSdcard.multiBlock = true;
+            simSdcard.stats.multiBlockBlocks++;
+        break;
+        case SIM_SDCARD_STATE_READY:
+            simSdcard.multiBlock = false;
+            simSdcard.stats.singleBlockWrites++;
+        break;
+        default:
+            return SDCARD_OPERATION_BUSY;
+    }
+
+    simSdcard.blockIndex = blockIndex;
+    simSdcard.buffer = buffer;
+    simSdcard.callback = callback;
+    simSdcard.callbackData = callbackData;
+
+    simSdcardBusyFor(SIM_SDCARD_STATE_SENDING_WRITE, SIM_LATENCY_TRANSFER_US);
+
+    return SDCARD_OPERATION_IN_PROGRESS;
+}
+
+void sdcard_setProfilerCallback(sdcard_profilerCallback_c callback)
+{
+    UNUSED(callback);
+}
+
+}
+
+#define SIM_TICK_US 125 // 8kHz, like the main loop which feeds the logger
+
+static afatfsFilePtr_t openedFile;
+static bool fileClosed;
+
+static void fileOpened(afatfsFilePtr_t file)
+{
+    openedFile = file;
+}
+
+static void fileClosedCallback(void)
+{
+    fileClosed = true;
+}
+
+static void simTick(void)
+{
+    simSdcardAdvance(SIM_TICK_US);
+    afatfs_poll();
+}
+
+static bool simRunUntil(bool (*condition)(void), uint32_t timeoutUs)
+{
+    const uint32_t startTime = simTimeUs;
+
+    while (!condition()) {
+        if (simTimeUs - startTime > timeoutUs) {
+            return false;
+        }
+        simTick();
+    }
+
+    return true;
+}
+
+static bool filesystemReady(void)
+{
+    return afatfs_getFilesystemState() == AFATFS_FILESYSTEM_STATE_READY;
+}
+
+static bool fileIsOpen(void)
+{
+    return openedFile != NULL;
+}
+
+static bool fileIsClosed(void)
+{
+    return fileClosed;
+}
+
+static bool filesystemDestroyed(void)
+{
+    return afatfs_destroy(false);
+}
+
+static void startFilesystem(void)
+{
+    afatfs_init();
+
+    ASSERT_TRUE(simRunUntil(filesystemReady, 60 * 1000000));
+}
+
+static void mountFilesystem(void)
+{
+    simSdcardReset();
+    simSdcardFormat();
+
+    startFilesystem();
+}
+
+static bool fileOpenAttempted;
+
+static void fileOpenAttemptComplete(afatfsFilePtr_t file)
+{
+    openedFile = file;
+    fileOpenAttempted = true;
+}
+
+static bool fileOpenComplete(void)
+{
+    return fileOpenAttempted;
+}
+
+/*
+ * Open the file and wait for the result, which is left in openedFile (NULL on failure).
+ */
+static void tryOpenFile(const char *filename, const char *mode)
+{
+    openedFile = NULL;
+    fileOpenAttempted = false;
+
+    ASSERT_TRUE(afatfs_fopen(filename, mode, fileOpenAttemptComplete));
+    ASSERT_TRUE(simRunUntil(fileOpenComplete, 10 * 1000000));
+}
+
+static void openFile(const char *filename, const char *mode)
+{
+    openedFile = NULL;
+
+    ASSERT_TRUE(afatfs_fopen(filename, mode, fileOpened));
+    ASSERT_TRUE(simRunUntil(fileIsOpen, 10 * 1000000));
+}
+
+static bool fileCloseStarted(void)
+{
+    return afatfs_fclose(openedFile, fileClosedCallback);
+}
+
+static void closeFile(void)
+{
+    fileClosed = false;
+
+    // The file can be busy with an operation of its own for a while after the last write
+    ASSERT_TRUE(simRunUntil(fileCloseStarted, 10 * 1000000));
+    ASSERT_TRUE(simRunUntil(fileIsClosed, 10 * 1000000));
+}
+
+static uint8_t logPattern(uint32_t offset)
+{
+    return (offset * 7 + (offset >> 9)) & 0xFF;
+}
+
+typedef struct logResult_s {
+    uint32_t bytesWritten;
+    uint32_t bytesDropped;
+    uint32_t worstStallUs;
+    uint32_t durationUs;
+} logResult_t;
+
+/*
+ * Feed the open file at a steady rate like the blackbox does, dropping whatever doesn't fit into the cache (the
+ * logger can't wait for the card).
+ */
+static logResult_t simLogAtRate(uint32_t bytesPerSecond, uint32_t totalBytes)
+{
+    logResult_t result;
+    memset(&result, 0, sizeof(result));
+
+    const uint32_t startTime = simTimeUs;
+    uint32_t stallStart = 0;
+    bool stalled = false;
+    uint32_t offset = 0;
+    uint8_t chunk[256];
+
+    // Give up if the filesystem stops accepting data entirely
+    const uint32_t timeoutUs = (uint32_t) ((uint64_t) totalBytes * 1000000 / bytesPerSecond) * 2;
+
+    while (offset < totalBytes && simTimeUs - startTime < timeoutUs) {
+        const uint32_t elapsedUs = simTimeUs - startTime;
+        const uint32_t due = (uint32_t) ((uint64_t) elapsedUs * bytesPerSecond / 1000000);
+        uint32_t pending = due - (offset + result.bytesDropped);
+
+        while (pending > 0 && offset < totalBytes) {
+            uint32_t chunkLen = MIN(MIN(pending, sizeof(chunk)), totalBytes - offset);
+            const uint32_t freeSpace = afatfs_getFreeBufferSpace();
+
+            if (freeSpace < chunkLen) {
+                if (!stalled) {
+                    stalled = true;
+                    stallStart = simTimeUs;
+                }
+                result.bytesDropped += pending;
+                break;
+            }
+
+            if (stalled) {
+                stalled = false;
+                result.worstStallUs = MAX(result.worstStallUs, simTimeUs - stallStart);
+            }
+
+            for (uint32_t i = 0; i < chunkLen; i++) {
+                chunk[i] = logPattern(offset + i);
+            }
+
+            chunkLen = afatfs_fwrite(openedFile, chunk, chunkLen);
+            offset += chunkLen;
+            pending -= chunkLen;
+
+            if (chunkLen == 0) {
+                break;
+            }
+        }
+
+        simTick();
+    }
+
+    if (stalled) {
+        result.worstStallUs = MAX(result.worstStallUs, simTimeUs - stallStart);
+    }
+
+    result.bytesWritten = offset;
+    result.durationUs = simTimeUs - startTime;
+
+    return result;
+}
+
+TEST(AsyncFatFSTest, TestMount)
+{
+    mountFilesystem();
+
+    EXPECT_EQ(AFATFS_FILESYSTEM_STATE_READY, afatfs_getFilesystemState());
+    EXPECT_GT(afatfs_getContiguousFreeSpace(), 16u * 1024 * 1024);
+
+    ASSERT_TRUE(simRunUntil(filesystemDestroyed, 10 * 1000000));
+}
+
+TEST(AsyncFatFSTest, TestSequentialLogWriteUsesMultipleBlockWrites)
+{
+    const uint32_t logSize = 512 * 1024;
+
+    mountFilesystem();
+    openFile("LOG00001.BFL", "as");
+
+    memset(&simSdcard.stats, 0, sizeof(simSdcard.stats));
+
+    logResult_t result = simLogAtRate(150 * 1024, logSize);
+
+    EXPECT_EQ(logSize, result.bytesWritten);
+    EXPECT_EQ(0u, result.bytesDropped);
+
+    closeFile();
+
+    // Nearly all of the log data should have gone out as part of long multiple block writes
+    EXPECT_GT(simSdcard.stats.multiBlockBlocks, logSize / SIM_SDCARD_BLOCK_SIZE * 9 / 10);
+    EXPECT_LT(simSdcard.stats.multiBlockWrites, simSdcard.stats.multiBlockBlocks / 4);
+
+    // Read it all back
+    openFile("LOG00001.BFL", "r");
+
+    uint8_t readBuffer[512];
+    uint32_t readOffset = 0;
+    uint32_t mismatches = 0;
+
+    while (readOffset < logSize && simTimeUs < 600 * 1000000u) {
+        uint32_t readLen = afatfs_fread(openedFile, readBuffer, sizeof(readBuffer));
+
+        for (uint32_t i = 0; i < readLen; i++) {
+            if (readBuffer[i] != logPattern(readOffset + i)) {
+                mismatches++;
+            }
+        }
+        readOffset += readLen;
+
+        if (afatfs_feof(openedFile)) {
+            break;
+        }
+
+        simTick();
+    }
+
+    EXPECT_EQ(logSize, readOffset);
+    EXPECT_EQ(0u, mismatches);
+
+    closeFile();
+
+    ASSERT_TRUE(simRunUntil(filesystemDestroyed, 10 * 1000000));
+}
+
+/*
+ * Find the highest steady logging rate the filesystem sustains against the simulated card without dropping data.
+ */
+static uint32_t sustainedLogThroughput(const char *mode)
+{
+    const uint32_t logSize = 2 * 1024 * 1024;
+    const uint32_t rates[] = { 64, 128, 256, 384, 512, 768 };
+    uint32_t bestSustainedRate = 0;
+
+    for (unsigned i = 0; i < ARRAYLEN(rates); i++) {
+        mountFilesystem();
+        openFile("LOG00001.BFL", mode);
+
+        memset(&simSdcard.stats, 0, sizeof(simSdcard.stats));
+
+        logResult_t result = simLogAtRate(rates[i] * 1024, logSize);
+
+        closeFile();
+
+        if (result.bytesDropped == 0) {
+            bestSustainedRate = rates[i];
+        }
+
+        EXPECT_TRUE(simRunUntil(filesystemDestroyed, 10 * 1000000));
+    }
+
+    return bestSustainedRate;
+}
+
+TEST(AsyncFatFSTest, TestContiguousLogThroughput)
+{
+    // A 16kB blackbox log at 2kHz needs around 100KB/s
+    EXPECT_GE(sustainedLogThroughput("as"), 128u);
+}
+
+TEST(AsyncFatFSTest, TestRegularFileThroughput)
+{
+    // Files which grow a cluster at a time don't get the erase hint, so they rely on the cache combining writes
+    EXPECT_GE(sustainedLogThroughput("w"), 64u);
+    EXPECT_GT(simSdcard.stats.multiBlockBlocks, 0u);
+}
+
+static afatfsFilePtr_t logDirectory;
+
+static void logDirectoryOpened(afatfsFilePtr_t directory)
+{
+    logDirectory = directory;
+}
+
+static bool logDirectoryIsOpen(void)
+{
+    return logDirectory != NULL;
+}
+
+static bool changedIntoLogDirectory(void)
+{
+    return afatfs_chdir(logDirectory);
+}
+
+/*
+ * Do what the blackbox does to get into the log directory.
+ */
+static void changeIntoLogDirectory(void)
+{
+    logDirectory = NULL;
+
+    ASSERT_TRUE(afatfs_mkdir("logs", logDirectoryOpened));
+    ASSERT_TRUE(simRunUntil(logDirectoryIsOpen, 10 * 1000000));
+    ASSERT_TRUE(simRunUntil(changedIntoLogDirectory, 10 * 1000000));
+
+    afatfs_fclose(logDirectory, NULL);
+}
+
+static void logFilename(char *filename, uint32_t logNumber)
+{
+    sprintf(filename, "LOG%05u.BFL", logNumber);
+}
+
+static void createEmptyLogs(uint32_t count)
+{
+    char filename[13];
+
+    for (uint32_t i = 1; i <= count; i++) {
+        logFilename(filename, i);
+
+        openFile(filename, "w");
+        closeFile();
+    }
+}
+
+static uint32_t largestLogNumber;
+
+static bool largestLogNumberFound(void)
+{
+    return afatfs_findLargestFileNumber("LOG", "BFL", &largestLogNumber) != AFATFS_OPERATION_IN_PROGRESS;
+}
+
+static afatfsOperationStatus_e findLargestLogNumber(void)
+{
+    EXPECT_TRUE(simRunUntil(largestLogNumberFound, 10 * 1000000));
+
+    return afatfs_findLargestFileNumber("LOG", "BFL", &largestLogNumber);
+}
+
+static bool fileUnlinked;
+
+static void fileUnlinkedCallback(void)
+{
+    fileUnlinked = true;
+}
+
+static bool fileIsUnlinked(void)
+{
+    return fileUnlinked;
+}
+
+TEST(AsyncFatFSTest, TestDirectoryCacheTracksLogFiles)
+{
+    mountFilesystem();
+    changeIntoLogDirectory();
+
+    // Nothing logged yet
+    EXPECT_EQ(AFATFS_OPERATION_SUCCESS, findLargestLogNumber());
+    EXPECT_EQ(0u, largestLogNumber);
+
+    createEmptyLogs(30);
+
+    EXPECT_EQ(AFATFS_OPERATION_SUCCESS, findLargestLogNumber());
+    EXPECT_EQ(30u, largestLogNumber);
+
+    // Existing files are found through the cache, and missing ones aren't
+    tryOpenFile("LOG00017.BFL", "r");
+    EXPECT_TRUE(openedFile != NULL);
+    closeFile();
+
+    tryOpenFile("LOG00099.BFL", "r");
+    EXPECT_TRUE(openedFile == NULL);
+
+    // Deleting the most recent log means its number will be reused
+    openFile("LOG00030.BFL", "r");
+    fileUnlinked = false;
+    ASSERT_TRUE(afatfs_funlink(openedFile, fileUnlinkedCallback));
+    ASSERT_TRUE(simRunUntil(fileIsUnlinked, 10 * 1000000));
+
+    EXPECT_EQ(AFATFS_OPERATION_SUCCESS, findLargestLogNumber());
+    EXPECT_EQ(29u, largestLogNumber);
+
+    // The next log should take the free directory entry left behind
+    openFile("LOG00030.BFL", "w");
+    closeFile();
+    openFile("LOG00031.BFL", "w");
+    closeFile();
+
+    EXPECT_EQ(AFATFS_OPERATION_SUCCESS, findLargestLogNumber());
+    EXPECT_EQ(31u, largestLogNumber);
+
+    // What's on the disk should agree with the cache after a remount
+    ASSERT_TRUE(simRunUntil(filesystemDestroyed, 10 * 1000000));
+    startFilesystem();
+    changeIntoLogDirectory();
+
+    EXPECT_EQ(AFATFS_OPERATION_SUCCESS, findLargestLogNumber());
+    EXPECT_EQ(31u, largestLogNumber);
+
+    for (uint32_t i = 1; i <= 31; i++) {
+        char filename[13];
+
+        logFilename(filename, i);
+        tryOpenFile(filename, "r");
+        EXPECT_TRUE(openedFile != NULL) << filename;
+        if (openedFile) {
+            closeFile();
+        }
+    }
+
+    ASSERT_TRUE(simRunUntil(filesystemDestroyed, 10 * 1000000));
+}
+
+/*
+ * Starting a new log shouldn't take longer as logs accumulate in the directory.
+ */
+TEST(AsyncFatFSTest, TestLogCreationTimeIndependentOfLogCount)
+{
+    // Well past what would fit in the sector cache, and hundreds of directory entries
+    const uint32_t logCounts[] = { 4, 400 };
+    uint32_t openTimeUs[ARRAYLEN(logCounts)];
+    uint32_t blocksRead[ARRAYLEN(logCounts)];
+
+    for (unsigned i = 0; i < ARRAYLEN(logCounts); i++) {
+        char filename[13];
+
+        mountFilesystem();
+        changeIntoLogDirectory();
+        createEmptyLogs(logCounts[i]);
+
+        ASSERT_EQ(AFATFS_OPERATION_SUCCESS, findLargestLogNumber());
+        ASSERT_EQ(logCounts[i], largestLogNumber);
+
+        // Flying a log pushes the directory sectors out of the sector cache before the next arm
+        logFilename(filename, ++largestLogNumber);
+        openFile(filename, "as");
+        simLogAtRate(64 * 1024, 64 * 1024);
+        closeFile();
+
+        const uint32_t startTime = simTimeUs;
+        const uint32_t startBlocksRead = simSdcard.stats.blocksRead;
+
+        logFilename(filename, largestLogNumber + 1);
+        openFile(filename, "as");
+
+        openTimeUs[i] = simTimeUs - startTime;
+        blocksRead[i] = simSdcard.stats.blocksRead - startBlocksRead;
+
+        closeFile();
+        ASSERT_TRUE(simRunUntil(filesystemDestroyed, 10 * 1000000));
+    }
+
+    EXPECT_LE(blocksRead[1], blocksRead[0] + 1);
+    EXPECT_LE(openTimeUs[1], openTimeUs[0] * 3 / 2 + SIM_TICK_US);
+}
@@ -23,6 +23,8 @@
 
 #include <math.h>
 
+#include <chrono>
+
 extern "C" {
     #include "platform.h"
     #include "target.h"
@@ -55,11 +57,35 @@ extern "C" {
 
     void cliSet(char *cmdline);
     void cliGet(char *cmdline);
+    const clivalue_t *cliFindValue(const char *name, unsigned length);
+    void dumpAllValues(uint16_t valueSection, uint8_t dumpMask);
+    void dumpPgValue(const clivalue_t *value, uint8_t dumpMask);
+
+    // About as many settings as a full build has, in a PG of their own
+    #define BENCH_VALUE_COUNT 400
+
+    typedef struct benchConfig_s {
+        uint8_t values[BENCH_VALUE_COUNT];
+    } benchConfig_t;
+
+    enum { BENCH_COUNTER_BASE = __COUNTER__ + 1 };
+
+    #define BENCH_VALUE(n) { "bench_value_" #n, VAR_UINT8 | MASTER_VALUE, { .minmax = { 0, 255 } }, PG_RESERVED_FOR_TESTING_2, __COUNTER__ - BENCH_COUNTER_BASE },
+    #define BENCH_VALUES_10(n) BENCH_VALUE(n##0) BENCH_VALUE(n##1) BENCH_VALUE(n##2) BENCH_VALUE(n##3) BENCH_VALUE(n##4) \
+        BENCH_VALUE(n##5) BENCH_VALUE(n##6) BENCH_VALUE(n##7) BENCH_VALUE(n##8) BENCH_VALUE(n##9)
+    #define BENCH_VALUES_100(n) BENCH_VALUES_10(n##0) BENCH_VALUES_10(n##1) BENCH_VALUES_10(n##2) BENCH_VALUES_10(n##3) \
+        BENCH_VALUES_10(n##4) BENCH_VALUES_10(n##5) BENCH_VALUES_10(n##6) BENCH_VALUES_10(n##7) BENCH_VALUES_10(n##8) \
+        BENCH_VALUES_10(n##9)
 
     const clivalue_t valueTable[] = {
-        { "array_unit_test",             VAR_INT8  | MODE_ARRAY | MASTER_VALUE, .config.array.length = 3, PG_RESERVED_FOR_TESTING_1, 0 }
+        BENCH_VALUES_100(1)
+        BENCH_VALUES_100(2)
+        { "array_unit_test",             VAR_INT8  | MODE_ARRAY | MASTER_VALUE, .config.array.length = 3, PG_RESERVED_FOR_TESTING_1, 0 },
+        BENCH_VALUES_100(3)
+        BENCH_VALUES_100(4)
     };
     const uint16_t valueTableEntryCount = ARRAYLEN(valueTable);
+    uint16_t valueTableNameIndex[ARRAYLEN(valueTable)];
     const lookupTableEntry_t lookupTables[] = {};
 
 
@@ -81,9 +107,12 @@ extern "C" {
     PG_REGISTER_ARRAY(rxFailsafeChannelConfig_t, MAX_SUPPORTED_RC_CHANNEL_COUNT, rxFailsafeChannelConfigs, PG_RX_FAILSAFE_CHANNEL_CONFIG, 0);
     PG_REGISTER(pidConfig_t, pidConfig, PG_PID_CONFIG, 0);
 
-    PG_REGISTER_WITH_RESET_FN(int8_t, unitTestData, PG_RESERVED_FOR_TESTING_1, 0);
+    PG_REGISTER_ARRAY_WITH_RESET_FN(int8_t, 3, unitTestData, PG_RESERVED_FOR_TESTING_1, 0);
+    PG_REGISTER(benchConfig_t, benchConfig, PG_RESERVED_FOR_TESTING_2, 0);
 }
 
+#define DO_DIFF (1 << 4) // see dumpFlags_e in cli.c
+
 #include "unittest_macros.h"
 #include "gtest/gtest.h"
 TEST(CLIUnittest, TestCliSet)
@@ -115,6 +144,151 @@ TEST(CLIUnittest, TestCliSet)
     //EXPECT_EQ(false, false);
 }
 
+TEST(CLIUnittest, TestCliFindValue)
+{
+    for (unsigned i = 0; i < valueTableEntryCount; i++) {
+        EXPECT_EQ(&valueTable[i], cliFindValue(valueTable[i].name, strlen(valueTable[i].name)));
+    }
+
+    // Case insensitive, and the name doesn't need to be terminated
+    EXPECT_EQ(&valueTable[200], cliFindValue("ARRAY_Unit_Test = 1", strlen("array_unit_test")));
+
+    // Prefixes and extensions of names don't match
+    EXPECT_EQ(NULL, cliFindValue("array_unit", strlen("array_unit")));
+    EXPECT_EQ(NULL, cliFindValue("array_unit_tests", strlen("array_unit_tests")));
+    EXPECT_EQ(NULL, cliFindValue("bench_value_1000", strlen("bench_value_1000")));
+    EXPECT_EQ(NULL, cliFindValue("", 0));
+}
+
+TEST(CLIUnittest, TestDiffOnlyPrintsChangedValues)
+{
+    const pgRegistry_t *pg = pgFind(PG_RESERVED_FOR_TESTING_2);
+
+    // Defaults in the PG, the config being diffed in its copy
+    memset(pg->address, 0, pgSize(pg));
+    memset(pg->copy, 0, pgSize(pg));
+    pg->copy[42] = 7;
+
+    testing::internal::CaptureStdout();
+    dumpAllValues(MASTER_VALUE, DO_DIFF);
+    const std::string output = testing::internal::GetCapturedStdout();
+
+    EXPECT_NE(std::string::npos, output.find("set bench_value_142 = 7"));
+    EXPECT_EQ(std::string::npos, output.find("bench_value_100"));
+    EXPECT_EQ(std::string::npos, output.find("bench_value_143"));
+}
+
+static const clivalue_t *findValueByScanning(const char *name, unsigned length)
+{
+    for (unsigned i = 0; i < valueTableEntryCount; i++) {
+        if (strncasecmp(name, valueTable[i].name, length) == 0 && strlen(valueTable[i].name) == length) {
+            return &valueTable[i];
+        }
+    }
+
+    return NULL;
+}
+
+TEST(CLIUnittest, TestCliFindValueMatchesScan)
+{
+    for (unsigned i = 0; i < valueTableEntryCount; i++) {
+        const char *name = valueTable[i].name;
+        const unsigned length = strlen(name);
+
+        EXPECT_EQ(findValueByScanning(name, length), cliFindValue(name, length));
+        EXPECT_EQ(findValueByScanning(name, length - 1), cliFindValue(name, length - 1));
+    }
+
+    EXPECT_EQ(findValueByScanning("bench_value_1000", 16), cliFindValue("bench_value_1000", 16));
+    EXPECT_EQ(findValueByScanning("zzz", 3), cliFindValue("zzz", 3));
+}
+
+TEST(CLIUnittest, TestCliFindValueIsFasterThanScan)
+{
+    // Both look up every name, the index is built before timing
+    cliFindValue("", 0);
+    const int rounds = 100;
+    const clivalue_t *found = NULL;
+
+    const std::chrono::steady_clock::time_point scanStart = std::chrono::steady_clock::now();
+    for (int round = 0; round < rounds; round++) {
+        for (unsigned i = 0; i < valueTableEntryCount; i++) {
+            found = findValueByScanning(valueTable[i].name, strlen(valueTable[i].name));
+            ASSERT_NE((const clivalue_t *)NULL, found);
+        }
+    }
+    const std::chrono::steady_clock::duration scan = std::chrono::steady_clock::now() - scanStart;
+
+    const std::chrono::steady_clock::time_point indexStart = std::chrono::steady_clock::now();
+    for (int round = 0; round < rounds; round++) {
+        for (unsigned i = 0; i < valueTableEntryCount; i++) {
+            found = cliFindValue(valueTable[i].name, strlen(valueTable[i].name));
+            ASSERT_NE((const clivalue_t *)NULL, found);
+        }
+    }
+    const std::chrono::steady_clock::duration indexed = std::chrono::steady_clock::now() - indexStart;
+
+    // About 9 comparisons against 200 on average, so well clear of any noise
+    EXPECT_LT(indexed * 4, scan);
+}
+
+TEST(CLIUnittest, TestCliGet)
+{
+    // A whole name only shows that setting
+    testing::internal::CaptureStdout();
+    cliGet((char *)"BENCH_value_142");
+    std::string output = testing::internal::GetCapturedStdout();
+
+    EXPECT_EQ(0u, output.find("bench_value_142 = 0"));
+    EXPECT_EQ(output.find(" = "), output.rfind(" = "));
+
+    // Part of a name shows every setting containing it
+    testing::internal::CaptureStdout();
+    cliGet((char *)"value_14");
+    output = testing::internal::GetCapturedStdout();
+
+    EXPECT_NE(std::string::npos, output.find("bench_value_140 = "));
+    EXPECT_NE(std::string::npos, output.find("bench_value_149 = "));
+    EXPECT_EQ(std::string::npos, output.find("bench_value_150"));
+    EXPECT_EQ(std::string::npos, output.find("Invalid name"));
+
+    testing::internal::CaptureStdout();
+    cliGet((char *)"no_such_value");
+    output = testing::internal::GetCapturedStdout();
+
+    EXPECT_NE(std::string::npos, output.find("Invalid name"));
+}
+
+TEST(CLIUnittest, TestDiffMatchesPerValueDiff)
+{
+    const pgRegistry_t *pg = pgFind(PG_RESERVED_FOR_TESTING_2);
+    const pgRegistry_t *unitTestPg = pgFind(PG_RESERVED_FOR_TESTING_1);
+
+    memset(pg->address, 0, pgSize(pg));
+    memset(pg->copy, 0, pgSize(pg));
+    memcpy(unitTestPg->copy, unitTestPg->address, pgSize(unitTestPg));
+
+    for (int changed = 0; changed < 2; changed++) {
+        // Comparing every value, as a diff did before
+        testing::internal::CaptureStdout();
+        for (unsigned i = 0; i < valueTableEntryCount; i++) {
+            if ((valueTable[i].type & VALUE_SECTION_MASK) == MASTER_VALUE) {
+                dumpPgValue(&valueTable[i], DO_DIFF);
+            }
+        }
+        const std::string perValue = testing::internal::GetCapturedStdout();
+
+        testing::internal::CaptureStdout();
+        dumpAllValues(MASTER_VALUE, DO_DIFF);
+        const std::string diff = testing::internal::GetCapturedStdout();
+
+        EXPECT_EQ(perValue, diff);
+
+        pg->copy[0] = 1;
+        pg->copy[BENCH_VALUE_COUNT - 1] = 255;
+    }
+}
+
 // STUBS
 extern "C" {
 
@@ -31,10 +31,12 @@ extern "C" {
     #include "cms/cms.h"
     #include "cms/cms_types.h"
     #include "fc/runtime_config.h"
+    #include "io/displayport_sim.h"
     void cmsMenuOpen(void);
     long cmsMenuBack(displayPort_t *pDisplay);
     uint16_t cmsHandleKey(displayPort_t *pDisplay, uint8_t key);
     extern CMS_Menu *currentMenu;    // Points to top entry of the current page
+    extern int16_t rcData[18];
 }
 
 #include "unittest_macros.h"
@@ -114,6 +116,178 @@ TEST(CMSUnittest, TestCmsMenuKey)
     uint16_t result = cmsHandleKey(displayPort, KEY_ESC);
     EXPECT_EQ(BUTTON_PAUSE, result);
 }
+
+static uint8_t testValue;
+static uint8_t testPolledValue;
+static OSD_UINT8_t entryTestValue = { &testValue, 0, 200, 1 };
+static OSD_UINT8_t entryTestPolledValue = { &testPolledValue, 0, 200, 1 };
+
+static OSD_Entry menuTestSubEntries[] =
+{
+    {"-- SUB --", OME_Label, NULL, NULL, 0},
+    {"VALUE", OME_UINT8, NULL, &entryTestValue, 0},
+    {"OTHER", OME_UINT8, NULL, &entryTestValue, 0},
+    {"EXTRA", OME_UINT8, NULL, &entryTestValue, 0},
+    {"BACK", OME_Back, NULL, NULL, 0},
+    {NULL, OME_END, NULL, NULL, 0}
+};
+
+static CMS_Menu menuTestSub = {
+#ifdef CMS_MENU_DEBUG
+    "MENUTESTSUB",
+    OME_MENU,
+#endif
+    NULL,
+    NULL,
+    menuTestSubEntries,
+};
+
+static OSD_Entry menuTestEntries[] =
+{
+    {"-- TEST --", OME_Label, NULL, NULL, 0},
+    {"VALUE", OME_UINT8, NULL, &entryTestValue, 0},
+    {"POLLED", OME_UINT8, NULL, &entryTestPolledValue, DYNAMIC_EVERY(500)},
+    {"SUB", OME_Submenu, cmsMenuChange, &menuTestSub, 0},
+    {"BACK", OME_Back, NULL, NULL, 0},
+    {NULL, OME_END, NULL, NULL, 0}
+};
+
+static CMS_Menu menuTest = {
+#ifdef CMS_MENU_DEBUG
+    "MENUTEST",
+    OME_MENU,
+#endif
+    NULL,
+    NULL,
+    menuTestEntries,
+};
+
+static timeUs_t testTimeUs;
+
+static void cmsTestUpdate(timeUs_t deltaUs)
+{
+    testTimeUs += deltaUs;
+    cmsUpdate(testTimeUs);
+}
+
+// Opens the test menu on a virtual display, sticks centred
+static displayPort_t *cmsTestOpen(displayPortSimTransport_e transport = DISPLAYPORT_SIM_TRANSPORT_MSP)
+{
+    for (int i = 0; i < 18; i++) {
+        rcData[i] = 1500;
+    }
+    testValue = 0;
+    testPolledValue = 0;
+
+    cmsInit();
+    cmsInMenu = false;
+    displayPort_t *displayPort = displayPortSimInit(transport, 16, 30);
+    cmsDisplayPortRegister(displayPort);
+    cmsMenuOpen();
+    cmsMenuChange(displayPort, &menuTest);
+    cmsTestUpdate(50000);
+    displayPortSimResetStats();
+    return displayPort;
+}
+
+TEST(CMSUnittest, TestCmsCursorRedrawsTwoLines)
+{
+    // given
+    // five entries centred from line 6, the cursor on the first value
+    displayPort_t *displayPort = cmsTestOpen();
+    EXPECT_EQ('>', displayPortSimGetChar(2, 7));
+
+    // when
+    cmsHandleKey(displayPort, CMS_KEY_DOWN);
+    cmsTestUpdate(50000);
+
+    // then
+    EXPECT_EQ(2u, displayPortSimGetStats()->writes);
+    EXPECT_EQ(' ', displayPortSimGetChar(2, 7));
+    EXPECT_EQ('>', displayPortSimGetChar(2, 8));
+}
+
+TEST(CMSUnittest, TestCmsMenuChangeSendsDifferences)
+{
+    // given
+    displayPort_t *displayPort = cmsTestOpen();
+    cmsHandleKey(displayPort, CMS_KEY_DOWN);
+    cmsHandleKey(displayPort, CMS_KEY_DOWN);
+    cmsTestUpdate(50000);
+    displayPortSimResetStats();
+
+    // when
+    cmsHandleKey(displayPort, CMS_KEY_RIGHT);
+    cmsTestUpdate(50000);
+
+    // then
+    // the screen is not cleared, the lines with "VALUE" and "BACK" stay apart from the cursor
+    char frame[16 * 31 + 1];
+    displayPortSimDumpFrame(frame, sizeof(frame));
+    EXPECT_EQ(0u, displayPortSimGetStats()->clears);
+    EXPECT_EQ(4u, displayPortSimGetStats()->writes);
+    EXPECT_NE(nullptr, strstr(frame, "-- SUB --"));
+    EXPECT_EQ(nullptr, strstr(frame, "POLLED"));
+
+    // when
+    cmsHandleKey(displayPort, CMS_KEY_ESC);
+    cmsTestUpdate(50000);
+
+    // then
+    displayPortSimDumpFrame(frame, sizeof(frame));
+    EXPECT_NE(nullptr, strstr(frame, "-- TEST --"));
+    EXPECT_NE(nullptr, strstr(frame, "POLLED"));
+}
+
+TEST(CMSUnittest, TestCmsDynamicPollInterval)
+{
+    // given
+    cmsTestOpen();
+    testValue = 7;
+
+    // when
+    // ten polls, the value changing for every one
+    for (int i = 0; i < 10; i++) {
+        testPolledValue++;
+        cmsTestUpdate(110000);
+    }
+
+    // then
+    // shown every fifth poll, values that are not dynamic are left alone
+    EXPECT_EQ(2u, displayPortSimGetStats()->writes);
+    EXPECT_EQ('0', displayPortSimGetChar(27, 7));
+}
+
+TEST(CMSUnittest, TestSimDisplayPortUpdates)
+{
+    const int rounds = 100;
+
+    for (int transport = 0; transport < DISPLAYPORT_SIM_TRANSPORT_COUNT; transport++) {
+        // the menu drawn on a cleared screen
+        cmsTestOpen((displayPortSimTransport_e)transport);
+        displayClearScreen(pCurrentDisplay);
+        cmsTestUpdate(50000);
+        while (!displayIsSynced(pCurrentDisplay)) {
+            displayDrawScreen(pCurrentDisplay);
+        }
+        const uint32_t menuBytes = displayPortSimGetStats()->bytesSent;
+        displayPortSimResetStats();
+
+        // moving the cursor, into the sub menu and back, with a polled value changing
+        static const cms_key_e keys[] = { CMS_KEY_DOWN, CMS_KEY_DOWN, CMS_KEY_RIGHT, CMS_KEY_ESC, CMS_KEY_UP, CMS_KEY_UP };
+        for (int round = 0; round < rounds; round++) {
+            testPolledValue++;
+            cmsHandleKey(pCurrentDisplay, keys[round % (sizeof(keys) / sizeof(keys[0]))]);
+            cmsTestUpdate(110000);
+        }
+
+        const displayPortSimStats_t *stats = displayPortSimGetStats();
+
+        EXPECT_EQ(0u, stats->clears);
+        EXPECT_LT(stats->bytesSent / rounds, menuBytes);
+    }
+}
+
 // STUBS
 
 extern "C" {
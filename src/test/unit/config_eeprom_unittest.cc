@@ -0,0 +1,493 @@
+/*
+ * This file is part of Cleanflight.
+ *
+ * Cleanflight is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Cleanflight is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cleanflight.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+extern "C" {
+    #include "platform.h"
+
+    #include "common/crc.h"
+    #include "common/utils.h"
+
+    #include "config/config_eeprom.h"
+    #include "config/config_streamer.h"
+
+    #include "drivers/system.h"
+
+    #include "pg/pg.h"
+    #include "pg/pg_ids.h"
+
+    typedef struct smallConfig_s {
+        uint8_t mode;
+        uint16_t rate;
+        uint32_t flags;
+    } smallConfig_t;
+
+    typedef struct largeConfig_s {
+        uint8_t data[200];
+    } largeConfig_t;
+
+    typedef struct versionedConfig_s {
+        uint32_t value;
+    } versionedConfig_t;
+
+    PG_DECLARE(smallConfig_t, smallConfig);
+    PG_DECLARE(largeConfig_t, largeConfig);
+    PG_DECLARE(versionedConfig_t, versionedConfig);
+
+    PG_REGISTER(smallConfig_t, smallConfig, PG_RESERVED_FOR_TESTING_1, 0);
+    PG_REGISTER(largeConfig_t, largeConfig, PG_RESERVED_FOR_TESTING_2, 0);
+    PG_REGISTER(versionedConfig_t, versionedConfig, PG_RESERVED_FOR_TESTING_3, 1);
+
+    extern const pgRegistry_t smallConfig_Registry;
+    extern const pgRegistry_t largeConfig_Registry;
+    extern const pgRegistry_t versionedConfig_Registry;
+
+    uint8_t eepromData[EEPROM_SIZE] __attribute__((aligned(FLASH_PAGE_SIZE)));
+}
+
+#include "unittest_macros.h"
+#include "gtest/gtest.h"
+
+#define CONFIG_BANK_SIZE (EEPROM_SIZE / 2)
+#define HEADER_GENERATION_OFFSET 4
+
+// Record header, word aligned record sizes and the commit record that ends each save
+#define RECORD_HEADER_SIZE 12
+#define SMALL_RECORD_SIZE ((RECORD_HEADER_SIZE + sizeof(smallConfig_t) + 3) & ~3)
+#define LARGE_RECORD_SIZE ((RECORD_HEADER_SIZE + sizeof(largeConfig_t) + 3) & ~3)
+#define COMMIT_RECORD_SIZE RECORD_HEADER_SIZE
+
+#define LEGACY_RECORD_HEADER_SIZE 6
+
+static int flashPagesErased;
+static int flashWordsProgrammed;
+static int flashProgramBudget;      // words that can be programmed before the simulated power cut, -1 for no limit
+static bool flashFailure;
+
+static void eraseEEPROM(void)
+{
+    memset(eepromData, 0xFF, sizeof(eepromData));
+}
+
+static void resetFlashCounters(void)
+{
+    flashPagesErased = 0;
+    flashWordsProgrammed = 0;
+    flashProgramBudget = -1;
+    flashFailure = false;
+}
+
+static void setConfig(uint8_t mode, uint8_t fill)
+{
+    smallConfigMutable()->mode = mode;
+    smallConfigMutable()->rate = 1000 + mode;
+    smallConfigMutable()->flags = 0xA5A5A5A5;
+    memset(largeConfigMutable()->data, fill, sizeof(largeConfig()->data));
+    versionedConfigMutable()->value = 42;
+
+    // as an in-flight adjustment does
+    pgMarkDirty(&smallConfig_Registry);
+    pgMarkDirty(&largeConfig_Registry);
+    pgMarkDirty(&versionedConfig_Registry);
+}
+
+static void expectConfig(uint8_t mode, uint8_t fill)
+{
+    EXPECT_EQ(mode, smallConfig()->mode);
+    EXPECT_EQ(1000 + mode, smallConfig()->rate);
+    EXPECT_EQ(0xA5A5A5A5, smallConfig()->flags);
+    for (unsigned i = 0; i < sizeof(largeConfig()->data); i++) {
+        EXPECT_EQ(fill, largeConfig()->data[i]);
+    }
+    EXPECT_EQ(42, versionedConfig()->value);
+}
+
+// Reload the config as after a reboot, starting from cleared PGs
+static bool reloadConfig(void)
+{
+    setConfig(0, 0);
+    versionedConfigMutable()->value = 0;
+
+    return isEEPROMVersionValid() && loadEEPROM();
+}
+
+static void startWithSavedConfig(uint8_t mode, uint8_t fill)
+{
+    eraseEEPROM();
+    setConfig(mode, fill);
+    writeConfigToEEPROM();
+    resetFlashCounters();
+}
+
+// Saves the config as it was before the log, a snapshot of records checked by one CRC
+static void writeLegacyConfig(void)
+{
+    eraseEEPROM();
+
+    uint8_t *p = eepromData;
+    *p++ = EEPROM_CONF_VERSION;
+    *p++ = 0xBE;
+    PG_FOREACH(reg) {
+        const uint16_t size = LEGACY_RECORD_HEADER_SIZE + pgSize(reg);
+        const pgn_t pgn = pgN(reg);
+        memcpy(p, &size, sizeof(size));
+        memcpy(p + 2, &pgn, sizeof(pgn));
+        p[4] = pgVersion(reg);
+        p[5] = 0;
+        memcpy(p + LEGACY_RECORD_HEADER_SIZE, reg->address, pgSize(reg));
+        p += size;
+    }
+    // terminator
+    *p++ = 0;
+    *p++ = 0;
+
+    const uint16_t crc = crc16_ccitt_update(0xFFFF, eepromData, p - eepromData);
+    const uint16_t invertedBigEndianCrc = ~(((crc & 0xFF) << 8) | (crc >> 8));
+    memcpy(p, &invertedBigEndianCrc, sizeof(invertedBigEndianCrc));
+}
+
+TEST(ConfigEepromTest, TestErasedEepromIsInvalid)
+{
+    eraseEEPROM();
+
+    EXPECT_FALSE(isEEPROMVersionValid());
+    EXPECT_FALSE(isEEPROMStructureValid());
+}
+
+TEST(ConfigEepromTest, TestSaveAndLoad)
+{
+    eraseEEPROM();
+    resetFlashCounters();
+
+    setConfig(3, 0x55);
+    writeConfigToEEPROM();
+
+    EXPECT_FALSE(flashFailure);
+    EXPECT_TRUE(isEEPROMStructureValid());
+    EXPECT_EQ(1, flashPagesErased);
+
+    EXPECT_TRUE(reloadConfig());
+    expectConfig(3, 0x55);
+}
+
+TEST(ConfigEepromTest, TestUnchangedSaveWritesNothing)
+{
+    startWithSavedConfig(3, 0x55);
+
+    writeConfigToEEPROM();
+
+    EXPECT_EQ(0, flashPagesErased);
+    EXPECT_EQ(0, flashWordsProgrammed);
+}
+
+TEST(ConfigEepromTest, TestSaveAppendsOnlyChangedRecords)
+{
+    startWithSavedConfig(3, 0x55);
+    const uint16_t configSize = getEEPROMConfigSize();
+
+    smallConfigMutable()->mode = 4;
+    smallConfigMutable()->rate = 1004;
+    writeConfigToEEPROM();
+
+    EXPECT_EQ(0, flashPagesErased);
+    EXPECT_EQ((SMALL_RECORD_SIZE + COMMIT_RECORD_SIZE) / sizeof(uint32_t), (unsigned)flashWordsProgrammed);
+    EXPECT_EQ(configSize + SMALL_RECORD_SIZE + COMMIT_RECORD_SIZE, getEEPROMConfigSize());
+
+    EXPECT_TRUE(reloadConfig());
+    expectConfig(4, 0x55);
+}
+
+// Save changes to the large config until the log is compacted, returns the value of the last save
+static uint8_t saveUntilCompacted(uint8_t fill)
+{
+    uint16_t configSize = getEEPROMConfigSize();
+
+    while (true) {
+        fill++;
+        setConfig(3, fill);
+        writeConfigToEEPROM();
+
+        if (flashFailure || getEEPROMConfigSize() < configSize) {
+            return fill;
+        }
+        configSize = getEEPROMConfigSize();
+    }
+}
+
+TEST(ConfigEepromTest, TestFullLogIsCompactedIntoOtherBank)
+{
+    startWithSavedConfig(3, 0);
+
+    uint8_t fill = saveUntilCompacted(0);
+
+    EXPECT_FALSE(flashFailure);
+    EXPECT_GT(fill, 2);
+
+    // The second bank holds a fresh snapshot with the next generation, the previous one is still intact
+    EXPECT_EQ(0xBE, eepromData[1]);
+    EXPECT_EQ(1, eepromData[HEADER_GENERATION_OFFSET]);
+    EXPECT_EQ(0xBE, eepromData[CONFIG_BANK_SIZE + 1]);
+    EXPECT_EQ(2, eepromData[CONFIG_BANK_SIZE + HEADER_GENERATION_OFFSET]);
+
+    EXPECT_TRUE(reloadConfig());
+    expectConfig(3, fill);
+
+    // And the one after that goes back to the first bank
+    fill = saveUntilCompacted(fill);
+
+    EXPECT_FALSE(flashFailure);
+    EXPECT_EQ(3, eepromData[HEADER_GENERATION_OFFSET]);
+    EXPECT_EQ(2, eepromData[CONFIG_BANK_SIZE + HEADER_GENERATION_OFFSET]);
+
+    EXPECT_TRUE(reloadConfig());
+    expectConfig(3, fill);
+}
+
+TEST(ConfigEepromTest, TestTornSaveIsIgnored)
+{
+    startWithSavedConfig(3, 0x55);
+
+    // Power is lost part way through appending both records
+    setConfig(4, 0x66);
+    flashProgramBudget = (SMALL_RECORD_SIZE + LARGE_RECORD_SIZE) / sizeof(uint32_t) - 1;
+    writeConfigToEEPROM();
+    EXPECT_TRUE(flashFailure);
+
+    // Neither change is applied
+    resetFlashCounters();
+    EXPECT_TRUE(reloadConfig());
+    expectConfig(3, 0x55);
+
+    // The next save can't append after the torn records, it compacts instead
+    setConfig(5, 0x77);
+    writeConfigToEEPROM();
+    EXPECT_FALSE(flashFailure);
+    EXPECT_GT(flashPagesErased, 0);
+
+    EXPECT_TRUE(reloadConfig());
+    expectConfig(5, 0x77);
+}
+
+TEST(ConfigEepromTest, TestTornCompactionKeepsPreviousConfig)
+{
+    startWithSavedConfig(3, 0);
+    const uint8_t compactingFill = saveUntilCompacted(0);
+
+    startWithSavedConfig(3, 0);
+    for (uint8_t fill = 1; fill < compactingFill; fill++) {
+        setConfig(3, fill);
+        writeConfigToEEPROM();
+    }
+
+    // Power is lost while the snapshot is written into the other bank
+    resetFlashCounters();
+    setConfig(3, compactingFill);
+    flashProgramBudget = 20;
+    writeConfigToEEPROM();
+    EXPECT_TRUE(flashFailure);
+    EXPECT_GT(flashPagesErased, 0);
+
+    resetFlashCounters();
+    EXPECT_TRUE(reloadConfig());
+    expectConfig(3, compactingFill - 1);
+}
+
+TEST(ConfigEepromTest, TestChangesWithoutErase)
+{
+    startWithSavedConfig(3, 0x55);
+
+    // Small changes fit in the erased remainder of the current page
+    setConfig(4, 0x55);
+    EXPECT_TRUE(writeConfigChangesToEEPROM());
+    EXPECT_EQ(0, flashPagesErased);
+
+    EXPECT_TRUE(reloadConfig());
+    expectConfig(4, 0x55);
+
+    // Until a change would need the next page to be erased
+    int saves = 0;
+    bool saved;
+    do {
+        setConfig(4, 0x56 + saves);
+        flashWordsProgrammed = 0;
+        saved = writeConfigChangesToEEPROM();
+        saves++;
+    } while (saved);
+
+    EXPECT_GT(saves, 1);
+    EXPECT_EQ(0, flashPagesErased);
+    EXPECT_EQ(0, flashWordsProgrammed);
+
+    // A normal save still goes through
+    writeConfigToEEPROM();
+    EXPECT_FALSE(flashFailure);
+
+    EXPECT_TRUE(reloadConfig());
+    expectConfig(4, 0x56 + saves - 1);
+}
+
+TEST(ConfigEepromTest, TestLoadAndSaveClearDirtyFlags)
+{
+    startWithSavedConfig(3, 0x55);
+
+    EXPECT_TRUE(reloadConfig());
+    PG_FOREACH(reg) {
+        EXPECT_FALSE(pgIsDirty(reg));
+    }
+
+    setConfig(4, 0x55);
+    EXPECT_TRUE(pgIsDirty(&smallConfig_Registry));
+
+    writeConfigToEEPROM();
+    PG_FOREACH(reg) {
+        EXPECT_FALSE(pgIsDirty(reg));
+    }
+
+    // A PG without a stored record keeps its defaults, which are not what is stored
+    eraseEEPROM();
+    EXPECT_FALSE(reloadConfig());
+    EXPECT_TRUE(pgIsDirty(&largeConfig_Registry));
+}
+
+TEST(ConfigEepromTest, TestChangesOnlyWriteDirtyGroups)
+{
+    startWithSavedConfig(3, 0x55);
+    EXPECT_TRUE(reloadConfig());
+
+    // Changed but not marked, so the in-flight save doesn't even look at it
+    memset(largeConfigMutable()->data, 0x66, sizeof(largeConfig()->data));
+    smallConfigMutable()->mode = 4;
+    smallConfigMutable()->rate = 1004;
+    pgMarkDirty(&smallConfig_Registry);
+
+    const uint16_t configSize = getEEPROMConfigSize();
+    EXPECT_TRUE(writeConfigChangesToEEPROM());
+    EXPECT_EQ(configSize + SMALL_RECORD_SIZE + COMMIT_RECORD_SIZE, getEEPROMConfigSize());
+    EXPECT_FALSE(pgIsDirty(&smallConfig_Registry));
+
+    // A regular save compares every group
+    writeConfigToEEPROM();
+    EXPECT_TRUE(reloadConfig());
+    expectConfig(4, 0x66);
+}
+
+TEST(ConfigEepromTest, TestCorruptRecordEndsLog)
+{
+    startWithSavedConfig(3, 0x55);
+
+    setConfig(4, 0x55);
+    writeConfigToEEPROM();
+    const uint16_t configSize = getEEPROMConfigSize();
+
+    setConfig(5, 0x55);
+    writeConfigToEEPROM();
+
+    // Corrupt the payload of the last save, the CRC check drops it
+    eepromData[configSize + RECORD_HEADER_SIZE] ^= 0x01;
+
+    EXPECT_TRUE(reloadConfig());
+    expectConfig(4, 0x55);
+    EXPECT_EQ(configSize, getEEPROMConfigSize());
+}
+
+TEST(ConfigEepromTest, TestLegacyConfigIsLoaded)
+{
+    setConfig(3, 0x55);
+    writeLegacyConfig();
+    resetFlashCounters();
+
+    EXPECT_TRUE(isEEPROMStructureValid());
+    EXPECT_TRUE(reloadConfig());
+    expectConfig(3, 0x55);
+
+    // the next save replaces it with a log in the other bank, the old copy is left until that is committed
+    setConfig(4, 0x55);
+    writeConfigToEEPROM();
+    EXPECT_FALSE(flashFailure);
+    EXPECT_EQ(1, flashPagesErased);
+    EXPECT_EQ(0xBE, eepromData[CONFIG_BANK_SIZE + 1]);
+    EXPECT_EQ(1, eepromData[CONFIG_BANK_SIZE + HEADER_GENERATION_OFFSET]);
+
+    EXPECT_TRUE(reloadConfig());
+    expectConfig(4, 0x55);
+}
+
+TEST(ConfigEepromTest, TestCorruptLegacyConfigIsInvalid)
+{
+    setConfig(3, 0x55);
+    writeLegacyConfig();
+    eepromData[10] ^= 0x01;
+
+    EXPECT_FALSE(isEEPROMStructureValid());
+    EXPECT_FALSE(reloadConfig());
+}
+
+// STUBS
+
+extern "C" {
+
+void FLASH_Unlock(void)
+{
+}
+
+void FLASH_Lock(void)
+{
+}
+
+FLASH_Status FLASH_ErasePage(uintptr_t Page_Address)
+{
+    EXPECT_EQ(0, (Page_Address - (uintptr_t)eepromData) % FLASH_PAGE_SIZE);
+
+    if (flashProgramBudget == 0) {
+        return FLASH_COMPLETE;
+    }
+
+    memset((void *)Page_Address, 0xFF, FLASH_PAGE_SIZE);
+    flashPagesErased++;
+
+    return FLASH_COMPLETE;
+}
+
+FLASH_Status FLASH_ProgramWord(uintptr_t addr, uint32_t Data)
+{
+    EXPECT_GE(addr, (uintptr_t)eepromData);
+    EXPECT_LT(addr, (uintptr_t)ARRAYEND(eepromData));
+
+    if (flashProgramBudget == 0) {
+        return FLASH_COMPLETE;
+    }
+    if (flashProgramBudget > 0) {
+        flashProgramBudget--;
+    }
+
+    // Flash can only be programmed once between erases
+    EXPECT_EQ(0xFFFFFFFF, *(uint32_t *)addr);
+    *(uint32_t *)addr = Data;
+    flashWordsProgrammed++;
+
+    return FLASH_COMPLETE;
+}
+
+void failureMode(failureMode_e)
+{
+    flashFailure = true;
+}
+
+}
@@ -0,0 +1,111 @@
+/*
+ * This file is part of Cleanflight and Betaflight.
+ *
+ * Cleanflight and Betaflight are free software. You can redistribute
+ * this software and/or modify this software under the terms of the
+ * GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Cleanflight and Betaflight are distributed in the hope that they
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software.
+ *
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+extern "C" {
+    #include "platform.h"
+
+    #include "drivers/display.h"
+}
+
+#include "unittest_macros.h"
+#include "gtest/gtest.h"
+
+#define TEST_ROWS 4
+#define TEST_COLS 30
+
+static void expectSpan(displayDirty_t *dirty, uint8_t mergeGap, uint8_t x, uint8_t y, uint8_t length)
+{
+    displaySpan_t span;
+    ASSERT_TRUE(displayDirtyNextSpan(dirty, mergeGap, &span));
+    EXPECT_EQ(x, span.x);
+    EXPECT_EQ(y, span.y);
+    EXPECT_EQ(length, span.length);
+}
+
+TEST(DisplayUnittest, TestDirtySpansInScreenOrder)
+{
+    displayDirty_t dirty;
+    displayDirtyClear(&dirty);
+    EXPECT_TRUE(displayDirtyIsClear(&dirty));
+
+    displayDirtyMark(&dirty, 20, 3, 4);
+    displayDirtyMark(&dirty, 5, 1, 3);
+    displayDirtyMark(&dirty, 0, 1, 2);
+    displayDirtyMark(&dirty, 28, 0, 10);
+
+    expectSpan(&dirty, 0, 28, 0, 4);
+    expectSpan(&dirty, 0, 0, 1, 2);
+    expectSpan(&dirty, 0, 5, 1, 3);
+    expectSpan(&dirty, 0, 20, 3, 4);
+
+    displaySpan_t span;
+    EXPECT_FALSE(displayDirtyNextSpan(&dirty, 0, &span));
+    EXPECT_TRUE(displayDirtyIsClear(&dirty));
+}
+
+TEST(DisplayUnittest, TestDirtySpansMergeSmallGaps)
+{
+    displayDirty_t dirty;
+    displayDirtyClear(&dirty);
+
+    displayDirtyMark(&dirty, 2, 0, 2);
+    displayDirtyMark(&dirty, 7, 0, 1);
+    displayDirtyMark(&dirty, 12, 0, 1);
+
+    // gaps of 3 and 4 columns
+    expectSpan(&dirty, 3, 2, 0, 6);
+    expectSpan(&dirty, 3, 12, 0, 1);
+
+    displayDirtyMarkAll(&dirty, TEST_ROWS, TEST_COLS);
+    displayDirtyMark(&dirty, 0, 3, 1);
+    expectSpan(&dirty, DISPLAY_DIRTY_COLS_MAX, 0, 0, TEST_COLS);
+}
+
+TEST(DisplayUnittest, TestBufferWriteMarksChanges)
+{
+    char buffer[TEST_ROWS * TEST_COLS];
+    memset(buffer, ' ', sizeof(buffer));
+    displayDirty_t dirty;
+    displayDirtyClear(&dirty);
+
+    displayBufferWrite(&dirty, buffer, TEST_ROWS, TEST_COLS, 3, 2, "ABC");
+    EXPECT_EQ(0, memcmp(&buffer[2 * TEST_COLS + 3], "ABC", 3));
+    expectSpan(&dirty, 0, 3, 2, 3);
+
+    // Rewriting the same text changes nothing
+    displayBufferWrite(&dirty, buffer, TEST_ROWS, TEST_COLS, 3, 2, "ABC");
+    EXPECT_TRUE(displayDirtyIsClear(&dirty));
+
+    displayBufferWrite(&dirty, buffer, TEST_ROWS, TEST_COLS, 3, 2, "AXC");
+    expectSpan(&dirty, 0, 4, 2, 1);
+
+    // Clipped at the screen edges
+    displayBufferWrite(&dirty, buffer, TEST_ROWS, TEST_COLS, TEST_COLS - 2, 0, "WXYZ");
+    EXPECT_EQ(0, memcmp(&buffer[TEST_COLS - 2], "WX", 2));
+    EXPECT_EQ(' ', buffer[TEST_COLS]);
+    expectSpan(&dirty, 0, TEST_COLS - 2, 0, 2);
+
+    displayBufferWrite(&dirty, buffer, TEST_ROWS, TEST_COLS, 0, TEST_ROWS, "A");
+    EXPECT_TRUE(displayDirtyIsClear(&dirty));
+}
@@ -0,0 +1,232 @@
+/*
+ * This file is part of Cleanflight.
+ *
+ * Cleanflight is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Cleanflight is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cleanflight.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+extern "C" {
+    #include "common/maths.h"
+
+    #include "msc/flash_readahead.h"
+}
+
+#include "unittest_macros.h"
+#include "gtest/gtest.h"
+
+#define SIM_FLASH_SIZE (256 * 1024)
+
+// Simulated SPI flash timing, in nanoseconds. About 21MHz SPI plus the command, address and chip select overhead.
+#define SIM_FLASH_TRANSACTION_NS 4000
+#define SIM_FLASH_BYTE_NS 400
+
+// Full speed USB bulk transfers manage about 1MB/s
+#define SIM_USB_BYTE_NS 1000
+
+#define MSC_SECTOR_SIZE 512
+#define MSC_MEDIA_PACKET 4096
+
+static uint8_t simFlash[SIM_FLASH_SIZE];
+static uint32_t simFlashReads;
+static uint64_t simTimeNs;
+
+static void simFlashInit(void)
+{
+    for (int i = 0; i < SIM_FLASH_SIZE; i++) {
+        simFlash[i] = (uint8_t)((i * 7) ^ (i >> 8));
+    }
+    simFlashReads = 0;
+    simTimeNs = 0;
+
+    flashReadAheadInit();
+}
+
+static void expectFlashContents(uint32_t address, const uint8_t *data, int len)
+{
+    for (int i = 0; i < len; i++) {
+        if (simFlash[address + i] != data[i]) {
+            FAIL() << "mismatch at flash address " << address + i;
+        }
+    }
+}
+
+/*
+ * One MSC media packet: the USB interrupt reads the sectors through the read-ahead layer, then the packet is sent to
+ * the host while the idle loop prefetches.
+ */
+static void transferPacket(uint32_t address, bool prefetch)
+{
+    uint8_t packet[MSC_MEDIA_PACKET];
+
+    for (int sector = 0; sector < MSC_MEDIA_PACKET / MSC_SECTOR_SIZE; sector++) {
+        const uint32_t sectorAddress = address + sector * MSC_SECTOR_SIZE;
+
+        EXPECT_EQ(MSC_SECTOR_SIZE, flashReadAheadRead(sectorAddress, &packet[sector * MSC_SECTOR_SIZE], MSC_SECTOR_SIZE));
+    }
+    expectFlashContents(address, packet, MSC_MEDIA_PACKET);
+
+    const uint64_t transferDoneNs = simTimeNs + MSC_MEDIA_PACKET * SIM_USB_BYTE_NS;
+
+    // A prefetch that is still running when the transfer completes holds off the next read
+    while (simTimeNs < transferDoneNs) {
+        if (!prefetch || !flashReadAheadPrefetch()) {
+            simTimeNs = transferDoneNs;
+        }
+    }
+}
+
+TEST(FlashReadAheadTest, TestRandomReadsReturnFlashContents)
+{
+    simFlashInit();
+
+    uint8_t buffer[1024];
+
+    srand(1);
+    for (int i = 0; i < 500; i++) {
+        const uint32_t address = rand() % (SIM_FLASH_SIZE - sizeof(buffer));
+        const unsigned int len = 1 + rand() % sizeof(buffer);
+
+        EXPECT_EQ((int)len, flashReadAheadRead(address, buffer, len));
+        expectFlashContents(address, buffer, len);
+
+        flashReadAheadPrefetch();
+    }
+
+    // Random access never looks sequential so nothing is worth prefetching
+    EXPECT_EQ(0, flashReadAheadGetStats()->prefetchedBytes);
+    EXPECT_EQ(0, flashReadAheadGetStats()->hitBytes);
+}
+
+TEST(FlashReadAheadTest, TestSequentialReadsAcrossBufferWrap)
+{
+    simFlashInit();
+
+    uint8_t buffer[1024];
+    uint32_t address = 123;
+
+    // Odd sizes so that reads and prefetches straddle the end of the ring buffer in every possible way
+    srand(2);
+    while (address < SIM_FLASH_SIZE - sizeof(buffer)) {
+        const unsigned int len = 1 + rand() % sizeof(buffer);
+
+        EXPECT_EQ((int)len, flashReadAheadRead(address, buffer, len));
+        expectFlashContents(address, buffer, len);
+        address += len;
+
+        const int prefetches = rand() % 24;
+        for (int i = 0; i < prefetches; i++) {
+            flashReadAheadPrefetch();
+        }
+    }
+
+    EXPECT_GT(flashReadAheadGetStats()->hitBytes, flashReadAheadGetStats()->missBytes);
+}
+
+TEST(FlashReadAheadTest, TestSeekDiscardsBuffer)
+{
+    simFlashInit();
+
+    uint8_t buffer[MSC_SECTOR_SIZE];
+
+    for (uint32_t address = 0; address < 4 * MSC_SECTOR_SIZE; address += MSC_SECTOR_SIZE) {
+        flashReadAheadRead(address, buffer, MSC_SECTOR_SIZE);
+    }
+    while (flashReadAheadPrefetch());
+    EXPECT_EQ(FLASH_READAHEAD_BUFFER_SIZE, flashReadAheadGetStats()->prefetchedBytes);
+
+    // Backwards seek into data that was already handed out
+    const uint32_t readsBefore = simFlashReads;
+    EXPECT_EQ(MSC_SECTOR_SIZE, flashReadAheadRead(MSC_SECTOR_SIZE, buffer, MSC_SECTOR_SIZE));
+    expectFlashContents(MSC_SECTOR_SIZE, buffer, MSC_SECTOR_SIZE);
+    EXPECT_EQ(readsBefore + 1, simFlashReads);
+
+    // Until the host settles into sequential reads again
+    EXPECT_FALSE(flashReadAheadPrefetch());
+}
+
+TEST(FlashReadAheadTest, TestPrefetchStopsAtEndOfFlash)
+{
+    simFlashInit();
+
+    uint8_t buffer[MSC_SECTOR_SIZE];
+    uint32_t address = SIM_FLASH_SIZE - 4 * MSC_SECTOR_SIZE;
+
+    for (int i = 0; i < 3; i++) {
+        flashReadAheadRead(address, buffer, MSC_SECTOR_SIZE);
+        address += MSC_SECTOR_SIZE;
+    }
+    while (flashReadAheadPrefetch());
+    EXPECT_EQ(MSC_SECTOR_SIZE, flashReadAheadGetStats()->prefetchedBytes);
+
+    EXPECT_EQ(MSC_SECTOR_SIZE, flashReadAheadRead(address, buffer, MSC_SECTOR_SIZE));
+    expectFlashContents(address, buffer, MSC_SECTOR_SIZE);
+    address += MSC_SECTOR_SIZE;
+
+    EXPECT_EQ(0, flashReadAheadRead(address, buffer, MSC_SECTOR_SIZE));
+    EXPECT_FALSE(flashReadAheadPrefetch());
+}
+
+TEST(FlashReadAheadTest, TestSequentialTransferOverlapsFlashAndUsb)
+{
+    const int packets = SIM_FLASH_SIZE / MSC_MEDIA_PACKET;
+
+    // Without prefetching every packet waits for the flash before it can be sent
+    simFlashInit();
+    for (int i = 0; i < packets; i++) {
+        transferPacket(i * MSC_MEDIA_PACKET, false);
+    }
+    const uint64_t onDemandNs = simTimeNs;
+
+    simFlashInit();
+    for (int i = 0; i < packets; i++) {
+        transferPacket(i * MSC_MEDIA_PACKET, true);
+    }
+    const uint64_t readAheadNs = simTimeNs;
+
+    const uint64_t usbNs = (uint64_t)SIM_FLASH_SIZE * SIM_USB_BYTE_NS;
+    const uint64_t flashNs = (uint64_t)SIM_FLASH_SIZE * SIM_FLASH_BYTE_NS;
+
+    // Serialised, the transfer takes as long as the USB and flash times combined
+    EXPECT_GE(onDemandNs, usbNs + flashNs);
+
+    // Overlapped, it is limited by the slower of the two, plus the first packets before the stream is detected
+    EXPECT_LT(readAheadNs, MAX(usbNs, flashNs) * 105 / 100);
+
+    // Only the packets before sequential access was detected went to the flash on demand
+    EXPECT_LE(flashReadAheadGetStats()->missBytes, 2 * MSC_MEDIA_PACKET);
+}
+
+// STUBS
+
+extern "C" {
+
+int flashfsReadLog(uint32_t address, uint8_t *buffer, unsigned int len)
+{
+    if (address >= SIM_FLASH_SIZE) {
+        return 0;
+    }
+    len = MIN(len, SIM_FLASH_SIZE - address);
+
+    memcpy(buffer, &simFlash[address], len);
+
+    simFlashReads++;
+    simTimeNs += SIM_FLASH_TRANSACTION_NS + len * SIM_FLASH_BYTE_NS;
+
+    return len;
+}
+
+}
@@ -0,0 +1,223 @@
+/*
+ * This file is part of Cleanflight and Betaflight.
+ *
+ * Cleanflight and Betaflight are free software. You can redistribute
+ * this software and/or modify this software under the terms of the
+ * GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Cleanflight and Betaflight are distributed in the hope that they
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software.
+ *
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+extern "C" {
+    #include "platform.h"
+
+    #include "common/maths.h"
+
+    #include "drivers/flash.h"
+
+    #include "io/flashfs.h"
+}
+
+#include "unittest_macros.h"
+#include "gtest/gtest.h"
+
+#define SIM_FLASH_SECTORS 16
+#define SIM_FLASH_SECTOR_SIZE 4096
+#define SIM_FLASH_PAGE_SIZE 256
+#define SIM_FLASH_SIZE (SIM_FLASH_SECTORS * SIM_FLASH_SECTOR_SIZE)
+
+// flashfs finds the end of the data to the nearest block of this size
+#define TEST_FREE_BLOCK_SIZE 2048
+
+#define TEST_ERASE_AHEAD (2 * SIM_FLASH_SECTOR_SIZE)
+
+static uint8_t simFlash[SIM_FLASH_SIZE];
+static uint32_t simProgramAddress;
+
+static const flashGeometry_t simGeometry = {
+    .sectors = SIM_FLASH_SECTORS,
+    .pageSize = SIM_FLASH_PAGE_SIZE,
+    .sectorSize = SIM_FLASH_SECTOR_SIZE,
+    .totalSize = SIM_FLASH_SIZE,
+    .pagesPerSector = SIM_FLASH_SECTOR_SIZE / SIM_FLASH_PAGE_SIZE,
+    .flashType = FLASH_TYPE_NOR,
+};
+
+// The log written by the tests, every block starts with a run of 0xFF longer than the old 16 byte erased check
+static uint8_t logByte(uint32_t position)
+{
+    if (position % TEST_FREE_BLOCK_SIZE < 100) {
+        return 0xFF;
+    }
+    return position % 251;
+}
+
+static void writeLog(uint32_t start, uint32_t len)
+{
+    uint8_t page[SIM_FLASH_PAGE_SIZE];
+
+    for (uint32_t position = start; position < start + len; position += sizeof(page)) {
+        // Like the blackbox, let the background eraser run until there is room to log
+        for (int i = 0; i < 1000 && flashfsIsEOF(); i++) {
+            flashfsEraseAheadUpdate();
+        }
+        ASSERT_FALSE(flashfsIsEOF());
+
+        for (unsigned i = 0; i < sizeof(page); i++) {
+            page[i] = logByte(position + i);
+        }
+        flashfsWrite(page, sizeof(page), true);
+        flashfsFlushSync();
+    }
+}
+
+// Checks that the whole log reads back oldest first, and that it holds the last `stored` bytes written
+static void expectLog(uint32_t written, uint32_t stored)
+{
+    static uint8_t buffer[SIM_FLASH_SIZE];
+
+    EXPECT_EQ(stored, flashfsGetOffset());
+
+    memset(buffer, 0, sizeof(buffer));
+    // read in awkward sized pieces so that some straddle the end of the device
+    uint32_t offset = 0;
+    while (offset < stored) {
+        const int bytesRead = flashfsReadLog(offset, buffer + offset, MIN(1000U, stored - offset));
+        ASSERT_LT(0, bytesRead);
+        offset += bytesRead;
+    }
+
+    for (uint32_t i = 0; i < stored; i++) {
+        ASSERT_EQ(logByte(written - stored + i), buffer[i]) << "at offset " << i;
+    }
+}
+
+static void initFlash(uint32_t eraseAhead, bool circular)
+{
+    memset(simFlash, 0xFF, sizeof(simFlash));
+    flashfsSetEraseAhead(eraseAhead, circular);
+    flashfsEraseCompletely();
+    flashfsInit();
+}
+
+TEST(FlashfsTest, TestFindsEndOfLogPastRunsOfErasedBytes)
+{
+    initFlash(0, false);
+
+    writeLog(0, 5 * TEST_FREE_BLOCK_SIZE);
+    expectLog(5 * TEST_FREE_BLOCK_SIZE, 5 * TEST_FREE_BLOCK_SIZE);
+
+    // each block starts with 100 bytes of 0xFF, only a whole erased page marks the free space
+    flashfsInit();
+    expectLog(5 * TEST_FREE_BLOCK_SIZE, 5 * TEST_FREE_BLOCK_SIZE);
+}
+
+TEST(FlashfsTest, TestLogBeforeWrapReadsFromStart)
+{
+    initFlash(TEST_ERASE_AHEAD, true);
+
+    writeLog(0, SIM_FLASH_SIZE / 2);
+    expectLog(SIM_FLASH_SIZE / 2, SIM_FLASH_SIZE / 2);
+
+    flashfsInit();
+    expectLog(SIM_FLASH_SIZE / 2, SIM_FLASH_SIZE / 2);
+}
+
+TEST(FlashfsTest, TestWrappedLogReadsOldestFirst)
+{
+    initFlash(TEST_ERASE_AHEAD, true);
+
+    // goes round the device more than twice, finishing part way through a sector
+    const uint32_t written = 2 * SIM_FLASH_SIZE + 5 * SIM_FLASH_SECTOR_SIZE + TEST_FREE_BLOCK_SIZE;
+    writeLog(0, written);
+
+    // the tail is half way through sector 5, sector 6 was erased ahead of it, the oldest data starts at sector 7
+    const uint32_t stored = SIM_FLASH_SIZE - 2 * SIM_FLASH_SECTOR_SIZE + TEST_FREE_BLOCK_SIZE;
+    expectLog(written, stored);
+
+    // and the same is found again after a restart
+    flashfsInit();
+    expectLog(written, stored);
+
+    // logging carries on from where it was, reclaiming the oldest sector once the tail reaches the next one
+    writeLog(written, SIM_FLASH_SECTOR_SIZE);
+    expectLog(written + SIM_FLASH_SECTOR_SIZE, stored);
+}
+
+TEST(FlashfsTest, TestReadLogPastEnd)
+{
+    initFlash(0, false);
+
+    writeLog(0, TEST_FREE_BLOCK_SIZE);
+
+    uint8_t buffer[16];
+    EXPECT_EQ(0, flashfsReadLog(SIM_FLASH_SIZE, buffer, sizeof(buffer)));
+    EXPECT_EQ(8, flashfsReadLog(SIM_FLASH_SIZE - 8, buffer, sizeof(buffer)));
+}
+
+// STUBS
+
+extern "C" {
+
+bool flashIsReady(void) { return true; }
+bool flashWaitForReady(uint32_t) { return true; }
+
+void flashEraseSector(uint32_t address)
+{
+    address -= address % SIM_FLASH_SECTOR_SIZE;
+    memset(simFlash + address, 0xFF, SIM_FLASH_SECTOR_SIZE);
+}
+
+void flashEraseCompletely(void)
+{
+    memset(simFlash, 0xFF, sizeof(simFlash));
+}
+
+void flashPageProgramBegin(uint32_t address)
+{
+    simProgramAddress = address;
+}
+
+void flashPageProgramContinue(const uint8_t *data, int length)
+{
+    EXPECT_GE(SIM_FLASH_SIZE, simProgramAddress + length);
+    for (int i = 0; i < length; i++) {
+        // programming can only clear bits
+        simFlash[simProgramAddress++] &= data[i];
+    }
+}
+
+void flashPageProgramFinish(void) {}
+
+void flashPageProgram(uint32_t address, const uint8_t *data, int length)
+{
+    flashPageProgramBegin(address);
+    flashPageProgramContinue(data, length);
+    flashPageProgramFinish();
+}
+
+int flashReadBytes(uint32_t address, uint8_t *buffer, int length)
+{
+    memcpy(buffer, simFlash + address, length);
+    return length;
+}
+
+void flashFlush(void) {}
+
+const flashGeometry_t *flashGetGeometry(void) { return &simGeometry; }
+
+}
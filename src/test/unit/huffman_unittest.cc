@@ -417,6 +417,27 @@ TEST(HuffmanUnittest, TestHuffmanEncode)
     EXPECT_EQ(0xd8, (int)outBuf[4]);
 }
 
+TEST(HuffmanUnittest, TestHuffmanEncodedLength)
+{
+    const uint8_t inBuf1[] = {0,1,1};
+    EXPECT_EQ(1, huffmanEncodedLength(inBuf1, sizeof(inBuf1), huffmanTable));
+
+    const uint8_t inBuf2[] = {0,1,2,3};
+    EXPECT_EQ(2, huffmanEncodedLength(inBuf2, sizeof(inBuf2), huffmanTable));
+
+    const uint8_t inBuf3[] = {0,1,2,3,4,5,6,7};
+    EXPECT_EQ(5, huffmanEncodedLength(inBuf3, sizeof(inBuf3), huffmanTable));
+
+    // The estimate should always agree with the encoder
+    uint8_t inBuf4[OUTBUF_LEN / 2];
+    for (unsigned i = 0; i < sizeof(inBuf4); i++) {
+        inBuf4[i] = i * 37;
+    }
+    const int len = huffmanEncodeBuf(outBuf, OUTBUF_LEN, inBuf4, sizeof(inBuf4), huffmanTable);
+    EXPECT_LT(0, len);
+    EXPECT_EQ(len, huffmanEncodedLength(inBuf4, sizeof(inBuf4), huffmanTable));
+}
+
 TEST(HuffmanUnittest, TestHuffmanEncodeStreaming)
 {
     #define INBUF_LEN1  3
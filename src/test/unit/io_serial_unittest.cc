@@ -19,6 +19,9 @@
 #include <stdbool.h>
 
 #include <limits.h>
+#include <string.h>
+
+#include <vector>
 
 extern "C" {
     #include "platform.h"
@@ -47,21 +50,252 @@ TEST(IoSerialTest, TestFindPortConfig)
     EXPECT_EQ(NULL, portConfig);
 }
 
+#define TEST_RX_BUFFER_SIZE 16
+
+static uint8_t testRxBuffer[TEST_RX_BUFFER_SIZE];
+
+static uint32_t testRxBytesWaiting(const serialPort_t *instance)
+{
+    return (instance->rxBufferHead - instance->rxBufferTail) & (instance->rxBufferSize - 1);
+}
+
+static const struct serialPortVTable testVTable = {
+    .serialWrite = NULL,
+    .serialTotalRxWaiting = testRxBytesWaiting,
+    .serialTotalTxFree = NULL,
+    .serialRead = NULL,
+    .serialSetBaudRate = NULL,
+    .isSerialTransmitBufferEmpty = NULL,
+    .setMode = NULL,
+    .setCtrlLineStateCb = NULL,
+    .setBaudRateCb = NULL,
+    .writeBuf = NULL,
+    .beginWrite = NULL,
+    .endWrite = NULL,
+    .rxSpan = serialRingRxSpan,
+    .rxAdvance = serialRingRxAdvance
+};
+
+// A port whose receive ring starts at the given position, as if the bytes before it had been received and read
+static void initTestPort(serialPort_t *port, uint32_t position)
+{
+    memset(port, 0, sizeof(*port));
+    memset(testRxBuffer, 0, sizeof(testRxBuffer));
+    port->vTable = &testVTable;
+    port->rxBuffer = testRxBuffer;
+    port->rxBufferSize = TEST_RX_BUFFER_SIZE;
+    port->rxBufferHead = position;
+    port->rxBufferTail = position;
+}
+
+static void receive(serialPort_t *port, const std::vector<uint8_t> &data)
+{
+    for (uint8_t c : data) {
+        port->rxBuffer[port->rxBufferHead] = c;
+        port->rxBufferHead = (port->rxBufferHead + 1) % port->rxBufferSize;
+    }
+}
+
+TEST(IoSerialTest, TestRxSpanIsContiguous)
+{
+    serialPort_t port;
+    initTestPort(&port, 0);
+
+    const uint8_t *data;
+    EXPECT_EQ(0U, serialRxSpan(&port, &data));
+
+    receive(&port, { 1, 2, 3, 4, 5 });
+
+    // Peeking leaves the data in place
+    EXPECT_EQ(5U, serialRxSpan(&port, &data));
+    EXPECT_EQ(std::vector<uint8_t>({ 1, 2, 3, 4, 5 }), std::vector<uint8_t>(data, data + 5));
+    EXPECT_EQ(5U, serialRxSpan(&port, &data));
+    EXPECT_EQ(1, data[0]);
+
+    serialRxAdvance(&port, 2);
+    EXPECT_EQ(3U, serialRxBytesWaiting(&port));
+    EXPECT_EQ(3U, serialRxSpan(&port, &data));
+    EXPECT_EQ(3, data[0]);
+
+    serialRxAdvance(&port, 3);
+    EXPECT_EQ(0U, serialRxSpan(&port, &data));
+}
+
+TEST(IoSerialTest, TestRxSpanWrapsAround)
+{
+    serialPort_t port;
+    initTestPort(&port, TEST_RX_BUFFER_SIZE - 3);
+
+    receive(&port, { 1, 2, 3, 4, 5, 6, 7 });
+    EXPECT_EQ(7U, serialRxBytesWaiting(&port));
+
+    // The span ends at the end of the buffer, the rest follows from its start
+    const uint8_t *data;
+    EXPECT_EQ(3U, serialRxSpan(&port, &data));
+    EXPECT_EQ(std::vector<uint8_t>({ 1, 2, 3 }), std::vector<uint8_t>(data, data + 3));
+
+    serialRxAdvance(&port, 3);
+    EXPECT_EQ(0U, port.rxBufferTail);
+    EXPECT_EQ(4U, serialRxSpan(&port, &data));
+    EXPECT_EQ(std::vector<uint8_t>({ 4, 5, 6, 7 }), std::vector<uint8_t>(data, data + 4));
+}
+
+TEST(IoSerialTest, TestReadBufAcrossWraparound)
+{
+    serialPort_t port;
+    initTestPort(&port, TEST_RX_BUFFER_SIZE - 5);
+
+    const std::vector<uint8_t> received = { 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20, 21 };
+    receive(&port, received);
+
+    uint8_t buf[32];
+
+    // Limited to the requested count
+    EXPECT_EQ(2U, serialReadBuf(&port, buf, 2));
+    EXPECT_EQ(std::vector<uint8_t>({ 10, 11 }), std::vector<uint8_t>(buf, buf + 2));
+
+    // Continues past the end of the buffer
+    EXPECT_EQ(10U, serialReadBuf(&port, buf, sizeof(buf)));
+    EXPECT_EQ(std::vector<uint8_t>(received.begin() + 2, received.end()), std::vector<uint8_t>(buf, buf + 10));
+    EXPECT_EQ(0U, serialRxBytesWaiting(&port));
+    EXPECT_EQ(0U, serialReadBuf(&port, buf, sizeof(buf)));
+}
+
+TEST(IoSerialTest, TestRxAdvanceToEndOfBuffer)
+{
+    serialPort_t port;
+    initTestPort(&port, TEST_RX_BUFFER_SIZE - 4);
+
+    receive(&port, { 1, 2, 3, 4 });
+
+    const uint8_t *data;
+    EXPECT_EQ(4U, serialRxSpan(&port, &data));
+    serialRxAdvance(&port, 4);
+
+    EXPECT_EQ(0U, port.rxBufferTail);
+    EXPECT_EQ(0U, serialRxSpan(&port, &data));
+
+    receive(&port, { 5 });
+    EXPECT_EQ(1U, serialRxSpan(&port, &data));
+    EXPECT_EQ(5, data[0]);
+}
+
+// Circular DMA into the receive ring, its data counter counts down from the buffer size and reloads after reaching zero
+static uint32_t dmaDataCounter;
+
+static void initTestDmaPort(serialPort_t *port, uint32_t position)
+{
+    initTestPort(port, position);
+    dmaDataCounter = TEST_RX_BUFFER_SIZE - position;
+}
+
+static void dmaReceive(serialPort_t *port, const std::vector<uint8_t> &data)
+{
+    for (uint8_t c : data) {
+        if (dmaDataCounter == 0) {
+            dmaDataCounter = TEST_RX_BUFFER_SIZE;
+        }
+        port->rxBuffer[TEST_RX_BUFFER_SIZE - dmaDataCounter] = c;
+        dmaDataCounter--;
+    }
+}
+
+static std::vector<uint8_t> callbackData;
+
+static void testRxCallback(uint16_t c, void *data)
+{
+    UNUSED(data);
+    callbackData.push_back(c);
+}
+
+TEST(IoSerialTest, TestRxDmaSyncWrapsAround)
+{
+    serialPort_t port;
+    initTestDmaPort(&port, TEST_RX_BUFFER_SIZE - 2);
+
+    serialRxDmaSync(&port, dmaDataCounter);
+    EXPECT_EQ(0U, serialRxBytesWaiting(&port));
+
+    dmaReceive(&port, { 1, 2, 3, 4, 5 });
+    serialRxDmaSync(&port, dmaDataCounter);
+    EXPECT_EQ(5U, serialRxBytesWaiting(&port));
+    EXPECT_EQ(3U, port.rxBufferHead);
+
+    uint8_t buf[TEST_RX_BUFFER_SIZE];
+    EXPECT_EQ(5U, serialReadBuf(&port, buf, sizeof(buf)));
+    EXPECT_EQ(std::vector<uint8_t>({ 1, 2, 3, 4, 5 }), std::vector<uint8_t>(buf, buf + 5));
+
+    // Reading in between leaves the head where the DMA is
+    dmaReceive(&port, { 6, 7 });
+    serialRxDmaSync(&port, dmaDataCounter);
+    EXPECT_EQ(1U, serialReadBuf(&port, buf, 1));
+    dmaReceive(&port, { 8 });
+    serialRxDmaSync(&port, dmaDataCounter);
+    EXPECT_EQ(2U, serialReadBuf(&port, buf, sizeof(buf)));
+    EXPECT_EQ(std::vector<uint8_t>({ 7, 8 }), std::vector<uint8_t>(buf, buf + 2));
+}
+
+TEST(IoSerialTest, TestRxDmaSyncCounterAtZero)
+{
+    serialPort_t port;
+    initTestDmaPort(&port, TEST_RX_BUFFER_SIZE - 3);
+
+    // The last byte of the buffer written, the counter has not been reloaded yet
+    dmaReceive(&port, { 1, 2, 3 });
+    EXPECT_EQ(0U, dmaDataCounter);
+    serialRxDmaSync(&port, dmaDataCounter);
+    EXPECT_EQ(0U, port.rxBufferHead);
+    EXPECT_EQ(3U, serialRxBytesWaiting(&port));
+
+    // The same position once reloaded
+    serialRxDmaSync(&port, TEST_RX_BUFFER_SIZE);
+    EXPECT_EQ(0U, port.rxBufferHead);
+
+    const uint8_t *data;
+    EXPECT_EQ(3U, serialRxSpan(&port, &data));
+    EXPECT_EQ(std::vector<uint8_t>({ 1, 2, 3 }), std::vector<uint8_t>(data, data + 3));
+}
+
+TEST(IoSerialTest, TestRxDmaDeliver)
+{
+    serialPort_t port;
+    initTestDmaPort(&port, TEST_RX_BUFFER_SIZE - 4);
+    port.rxCallback = testRxCallback;
+    callbackData.clear();
+
+    // Nothing received, nothing passed on
+    serialRxDmaDeliver(&port, dmaDataCounter);
+    EXPECT_TRUE(callbackData.empty());
+
+    // A burst across the end of the buffer arrives in order
+    const std::vector<uint8_t> burst = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10 };
+    dmaReceive(&port, burst);
+    serialRxDmaDeliver(&port, dmaDataCounter);
+    EXPECT_EQ(burst, callbackData);
+    EXPECT_EQ(port.rxBufferHead, port.rxBufferTail);
+
+    // Each byte once, however often the interrupts fire
+    serialRxDmaDeliver(&port, dmaDataCounter);
+    EXPECT_EQ(burst.size(), callbackData.size());
+
+    // Up to the last byte of the buffer
+    callbackData.clear();
+    const std::vector<uint8_t> rest = { 11, 12, 13, 14, 15, 16, 17, 18, 19, 20 };
+    dmaReceive(&port, rest);
+    serialRxDmaDeliver(&port, dmaDataCounter);
+    EXPECT_EQ(rest, callbackData);
+    EXPECT_EQ(0U, port.rxBufferTail);
+}
+
 
 // STUBS
 extern "C" {
     void delay(uint32_t) {}
 
-    bool isSerialTransmitBufferEmpty(const serialPort_t *) { return true; }
-
     void systemResetToBootloader(void) {}
 
     bool telemetryCheckRxPortShared(const serialPortConfig_t *) { return false; }
 
-    uint32_t serialRxBytesWaiting(const serialPort_t *) { return 0; }
-    uint8_t serialRead(serialPort_t *) { return 0; }
-    void serialWrite(serialPort_t *, uint8_t) {}
-
     serialPort_t *usbVcpOpen(void) { return NULL; }
 
     serialPort_t *uartOpen(UARTDevice_e, serialReceiveCallbackPtr, void *, uint32_t, portMode_e, portOptions_e) {
@@ -72,11 +306,7 @@ extern "C" {
       return NULL;
     }
 
-    void serialSetCtrlLineStateCb(serialPort_t *, void (*)(void *, uint16_t ), void *) {}
     void serialSetCtrlLineState(serialPort_t *, uint16_t ) {}
-    uint32_t serialTxBytesFree(const serialPort_t *) {return 1;}
-
-    void serialSetBaudRateCb(serialPort_t *, void (*)(serialPort_t *context, uint32_t baud), serialPort_t *) {}
 
     void pinioSet(int, bool) {}
 }
@@ -0,0 +1,295 @@
+/*
+ * This file is part of Cleanflight and Betaflight.
+ *
+ * Cleanflight and Betaflight are free software. You can redistribute
+ * this software and/or modify this software under the terms of the
+ * GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Cleanflight and Betaflight are distributed in the hope that they
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software.
+ *
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+extern "C" {
+    #include "platform.h"
+
+    #include "drivers/display.h"
+    #include "drivers/max7456.h"
+    #include "drivers/max7456_stream.h"
+}
+
+#include "unittest_macros.h"
+#include "gtest/gtest.h"
+
+#define TEST_COLS 30
+
+/*
+ * Display memory as the chip sees the SPI writes of a stream, two bytes per register write. Following the datasheet, the
+ * address is only set outside of auto-increment mode.
+ */
+typedef struct chipModel_s {
+    uint8_t memory[VIDEO_BUFFER_CHARS_PAL];
+    uint8_t dmm;
+    uint16_t address;
+    bool autoIncrement;
+    uint16_t registerWrites;
+} chipModel_t;
+
+static void chipReset(chipModel_t *chip)
+{
+    memset(chip, 0, sizeof(*chip));
+    memset(chip->memory, ' ', sizeof(chip->memory));
+}
+
+static void chipTransfer(chipModel_t *chip, const uint8_t *buf, uint16_t length)
+{
+    ASSERT_EQ(0, length % 2);
+
+    for (int i = 0; i < length; i += 2) {
+        const uint8_t add = buf[i];
+        const uint8_t data = buf[i + 1];
+        chip->registerWrites++;
+
+        switch (add) {
+        case MAX7456ADD_DMM:
+            chip->dmm = data;
+            chip->autoIncrement = data & AUTO_INCREMENT;
+            break;
+        case MAX7456ADD_DMAH:
+            EXPECT_FALSE(chip->autoIncrement) << "addressed in auto-increment mode";
+            chip->address = ((data & 0x01) << 8) | (chip->address & 0xff);
+            break;
+        case MAX7456ADD_DMAL:
+            EXPECT_FALSE(chip->autoIncrement) << "addressed in auto-increment mode";
+            chip->address = (chip->address & 0x100) | data;
+            break;
+        case MAX7456ADD_DMDI:
+            if (chip->autoIncrement && data == END_STRING) {
+                // ends auto-increment mode, nothing written
+                chip->autoIncrement = false;
+                chip->dmm &= ~AUTO_INCREMENT;
+                break;
+            }
+            ASSERT_LT(chip->address, VIDEO_BUFFER_CHARS_PAL);
+            chip->memory[chip->address] = data;
+            if (chip->autoIncrement) {
+                chip->address++;
+            }
+            break;
+        default:
+            FAIL() << "unexpected register " << (int)add;
+        }
+    }
+}
+
+static uint8_t screenBuffer[VIDEO_BUFFER_CHARS_PAL + 40];
+static uint8_t shadowBuffer[VIDEO_BUFFER_CHARS_PAL];
+static displayDirty_t screenDirty;
+static uint8_t stream[MAX7456_STREAM_SIZE];
+static chipModel_t chip;
+
+static max7456Screen_t testScreen(uint16_t size)
+{
+    const max7456Screen_t screen = {
+        .buffer = screenBuffer,
+        .shadow = shadowBuffer,
+        .dirty = &screenDirty,
+        .size = size,
+        .cols = TEST_COLS,
+        .dmm = INVERT_PIXEL_COLOR,
+    };
+    return screen;
+}
+
+// Chip and buffers showing a blank screen, DMM as set up by the driver
+static void testInit(void)
+{
+    chipReset(&chip);
+    chip.dmm = INVERT_PIXEL_COLOR;
+    memset(screenBuffer, ' ', sizeof(screenBuffer));
+    memset(shadowBuffer, ' ', sizeof(shadowBuffer));
+    displayDirtyClear(&screenDirty);
+}
+
+static void testWrite(uint8_t x, uint8_t y, const char *text)
+{
+    displayBufferWrite(&screenDirty, (char *)screenBuffer, VIDEO_LINES_PAL, TEST_COLS, x, y, text);
+}
+
+static uint16_t testDraw(uint16_t bufSize, bool refresh)
+{
+    const max7456Screen_t screen = testScreen(VIDEO_BUFFER_CHARS_PAL);
+    const uint16_t length = max7456StreamBuild(&screen, stream, bufSize, refresh);
+    EXPECT_LE(length, bufSize);
+    chipTransfer(&chip, stream, length);
+    return length;
+}
+
+static void expectChipShowsScreen(uint16_t size)
+{
+    for (int i = 0; i < size; i++) {
+        EXPECT_EQ(screenBuffer[i], chip.memory[i]) << "at " << i;
+        EXPECT_EQ(screenBuffer[i], shadowBuffer[i]) << "at " << i;
+    }
+    // every stream leaves auto-increment mode
+    EXPECT_FALSE(chip.autoIncrement);
+    EXPECT_EQ(INVERT_PIXEL_COLOR, chip.dmm);
+}
+
+TEST(Max7456StreamTest, TestNothingToSend)
+{
+    testInit();
+
+    EXPECT_EQ(0, testDraw(sizeof(stream), false));
+
+    // written but unchanged
+    testWrite(3, 3, "   ");
+    EXPECT_EQ(0, testDraw(sizeof(stream), false));
+    EXPECT_TRUE(displayDirtyIsClear(&screenDirty));
+}
+
+TEST(Max7456StreamTest, TestRunIsAddressedOnce)
+{
+    testInit();
+    testWrite(2, 1, "BATTERY");
+
+    // address high and low, DMM, seven characters, end of auto-increment and DMM
+    EXPECT_EQ(4 + 2 + 7 * 2 + 4, testDraw(sizeof(stream), false));
+    expectChipShowsScreen(VIDEO_BUFFER_CHARS_PAL);
+    EXPECT_TRUE(displayDirtyIsClear(&screenDirty));
+}
+
+TEST(Max7456StreamTest, TestRunsAreJoined)
+{
+    testInit();
+    testWrite(2, 1, "AB");
+    testWrite(6, 1, "CD");      // two unchanged between, sent again
+    testWrite(20, 1, "EF");     // ended and addressed
+    testWrite(29, 1, "G");
+    testWrite(0, 2, "H");       // carries on to the next row
+
+    EXPECT_EQ(4 + 2 + 6 * 2 + 4 + 4 + 2 + 2 * 2 + 4 + 4 + 2 + 2 * 2 + 4, testDraw(sizeof(stream), false));
+    expectChipShowsScreen(VIDEO_BUFFER_CHARS_PAL);
+}
+
+TEST(Max7456StreamTest, TestChangesOnlyAreSent)
+{
+    testInit();
+    testWrite(0, 0, "ALT 10M");
+    testDraw(sizeof(stream), false);
+
+    testWrite(0, 0, "ALT 12M");
+    // on its own, addressed without auto-increment mode
+    EXPECT_EQ(4 + 2, testDraw(sizeof(stream), false));
+    expectChipShowsScreen(VIDEO_BUFFER_CHARS_PAL);
+}
+
+TEST(Max7456StreamTest, TestEndStringWrittenDirectly)
+{
+    testInit();
+    const char text[] = { 'A', (char)END_STRING, 'B', (char)END_STRING, 0 };
+    testWrite(10, 5, text);
+
+    testDraw(sizeof(stream), false);
+    expectChipShowsScreen(VIDEO_BUFFER_CHARS_PAL);
+    EXPECT_EQ(END_STRING, chip.memory[5 * TEST_COLS + 11]);
+    EXPECT_EQ(END_STRING, chip.memory[5 * TEST_COLS + 13]);
+}
+
+TEST(Max7456StreamTest, TestRefreshSendsWholeScreen)
+{
+    testInit();
+    for (int i = 0; i < VIDEO_BUFFER_CHARS_PAL; i++) {
+        screenBuffer[i] = (i * 7) % END_STRING;
+        shadowBuffer[i] = screenBuffer[i];
+    }
+    displayDirtyMarkAll(&screenDirty, VIDEO_LINES_PAL, TEST_COLS);
+
+    // a single run, fits a buffer
+    EXPECT_EQ(4 + 2 + VIDEO_BUFFER_CHARS_PAL * 2 + 4, testDraw(sizeof(stream), true));
+    expectChipShowsScreen(VIDEO_BUFFER_CHARS_PAL);
+    EXPECT_TRUE(displayDirtyIsClear(&screenDirty));
+}
+
+TEST(Max7456StreamTest, TestSmallBufferTakesSeveralFrames)
+{
+    testInit();
+    for (int i = 0; i < VIDEO_BUFFER_CHARS_PAL; i++) {
+        screenBuffer[i] = (i % 3) ? 'A' + i % 26 : END_STRING;
+    }
+    displayDirtyMarkAll(&screenDirty, VIDEO_LINES_PAL, TEST_COLS);
+
+    int frames = 0;
+    while (!displayDirtyIsClear(&screenDirty)) {
+        ASSERT_LT(frames, 1000);
+        EXPECT_GT(testDraw(64, false), 0);
+        frames++;
+    }
+    EXPECT_GT(frames, 1);
+    expectChipShowsScreen(VIDEO_BUFFER_CHARS_PAL);
+}
+
+TEST(Max7456StreamTest, TestNtscRowsNotSent)
+{
+    testInit();
+    testWrite(0, VIDEO_LINES_NTSC - 1, "NTSC");
+    testWrite(0, VIDEO_LINES_NTSC, "PAL");
+
+    const max7456Screen_t screen = testScreen(VIDEO_BUFFER_CHARS_NTSC);
+    chipTransfer(&chip, stream, max7456StreamBuild(&screen, stream, sizeof(stream), false));
+
+    expectChipShowsScreen(VIDEO_BUFFER_CHARS_NTSC);
+    EXPECT_EQ(' ', chip.memory[VIDEO_BUFFER_CHARS_NTSC]);
+    EXPECT_TRUE(displayDirtyIsClear(&screenDirty));
+}
+
+/*
+ * Compares the stream with addressing each changed character on its own, six bytes each.
+ */
+TEST(Max7456StreamTest, TestStreamBytes)
+{
+    static const struct {
+        const char *name;
+        uint8_t stride;     // every stride-th character changes
+        uint8_t length;     // for a run of that many
+    } patterns[] = {
+        { "scattered", 40, 1 },
+        { "elements", 12, 5 },
+        { "rows", 30, 30 },
+    };
+
+    for (unsigned p = 0; p < sizeof(patterns) / sizeof(patterns[0]); p++) {
+        testInit();
+        int changed = 0;
+        for (int pos = 0; pos + patterns[p].length <= VIDEO_BUFFER_CHARS_PAL; pos += patterns[p].stride) {
+            for (int i = 0; i < patterns[p].length; i++) {
+                char c[2] = { (char)('0' + (pos + i) % 10), 0 };
+                testWrite((pos + i) % TEST_COLS, (pos + i) / TEST_COLS, c);
+                changed++;
+            }
+        }
+
+        const uint16_t bytes = testDraw(sizeof(stream), false);
+
+        expectChipShowsScreen(VIDEO_BUFFER_CHARS_PAL);
+        // no worse for scattered characters
+        EXPECT_LE(bytes, changed * 6);
+        if (patterns[p].length > 1) {
+            EXPECT_LE(bytes, changed * 4);
+        }
+        EXPECT_TRUE(displayDirtyIsClear(&screenDirty));
+    }
+}
@@ -0,0 +1,354 @@
+/*
+ * This file is part of Cleanflight and Betaflight.
+ *
+ * Cleanflight and Betaflight are free software. You can redistribute
+ * this software and/or modify this software under the terms of the
+ * GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Cleanflight and Betaflight are distributed in the hope that they
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software.
+ *
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+extern "C" {
+    #include "platform.h"
+
+    #include "common/maths.h"
+    #include "common/streambuf.h"
+    #include "common/utils.h"
+
+    #include "fc/runtime_config.h"
+
+    #include "interface/msp.h"
+    #include "interface/msp_dataflash.h"
+    #include "interface/msp_protocol.h"
+}
+
+#include "unittest_macros.h"
+#include "gtest/gtest.h"
+
+#define TEST_FLASH_SIZE (64 * 1024)
+#define TEST_CHUNK_SIZE 1024
+#define TEST_FRAME_HEADER_SIZE 9
+
+enum {
+    TEST_STREAM_START,
+    TEST_STREAM_ACK,
+    TEST_STREAM_STOP
+};
+
+static mspStreamFnPtr testStreamFn;
+static int testStreamsBegun;
+static bool testFlashErased;
+
+typedef struct testFrame_s {
+    mspResult_e result;
+    uint16_t sequence;
+    uint32_t address;
+    uint16_t length;
+    uint8_t compression;
+    int size;                   // bytes of content after the header
+    uint8_t content[TEST_CHUNK_SIZE + 16];
+} testFrame_t;
+
+static uint8_t testFlashByte(uint32_t address)
+{
+    return testFlashErased ? 0xFF : address % 251;
+}
+
+static mspResult_e sendCommand(const uint8_t *request, int requestLen, uint8_t *reply, int replySize)
+{
+    uint8_t requestBuf[16];
+    memcpy(requestBuf, request, requestLen);
+    sbuf_t src = { requestBuf, requestBuf + requestLen };
+    sbuf_t dst = { reply, reply + replySize };
+
+    return mspDataflashReadStreamCommand(&dst, &src);
+}
+
+static mspResult_e startStream(uint32_t address, uint32_t length, uint8_t window, uint8_t compressionMethods, uint8_t *reply)
+{
+    uint8_t request[11];
+    request[0] = TEST_STREAM_START;
+    memcpy(&request[1], &address, sizeof(address));
+    memcpy(&request[5], &length, sizeof(length));
+    request[9] = window;
+    request[10] = compressionMethods;
+
+    uint8_t replyBuf[4];
+    return sendCommand(request, sizeof(request), reply ? reply : replyBuf, sizeof(replyBuf));
+}
+
+static void ack(uint16_t nextSequence)
+{
+    const uint8_t request[] = { TEST_STREAM_ACK, (uint8_t)(nextSequence & 0xFF), (uint8_t)(nextSequence >> 8) };
+    uint8_t reply[4];
+
+    EXPECT_EQ(MSP_RESULT_NO_REPLY, sendCommand(request, sizeof(request), reply, sizeof(reply)));
+}
+
+// Asks the stream for its next frame, as the serial port does when its transmit buffer has room
+static testFrame_t nextFrame(void)
+{
+    static uint8_t buf[TEST_CHUNK_SIZE + 64];
+    mspPacket_t packet;
+    memset(&packet, 0, sizeof(packet));
+    packet.buf.ptr = buf;
+    packet.buf.end = buf + sizeof(buf);
+
+    testFrame_t frame;
+    memset(&frame, 0, sizeof(frame));
+    EXPECT_NE(nullptr, testStreamFn);
+    frame.result = testStreamFn(&packet);
+    if (frame.result != MSP_RESULT_ACK) {
+        return frame;
+    }
+
+    EXPECT_EQ(MSP_DATAFLASH_READ_STREAM, packet.cmd);
+    memcpy(&frame.sequence, &buf[0], sizeof(frame.sequence));
+    memcpy(&frame.address, &buf[2], sizeof(frame.address));
+    memcpy(&frame.length, &buf[6], sizeof(frame.length));
+    frame.compression = buf[8];
+    frame.size = packet.buf.ptr - buf - TEST_FRAME_HEADER_SIZE;
+    EXPECT_GE((int)sizeof(frame.content), frame.size);
+    memcpy(frame.content, &buf[TEST_FRAME_HEADER_SIZE], MIN(frame.size, (int)sizeof(frame.content)));
+
+    return frame;
+}
+
+// Takes frames until the window is full, returns how many were sent
+static int framesUntilWindowFull(void)
+{
+    int frames = 0;
+    while (nextFrame().result == MSP_RESULT_ACK) {
+        frames++;
+        if (frames > 100) {
+            break;
+        }
+    }
+    return frames;
+}
+
+static void resetTest(void)
+{
+    testStreamFn = NULL;
+    testStreamsBegun = 0;
+    testFlashErased = false;
+    armingFlags = 0;
+}
+
+TEST(MspDataflashTest, TestStartReply)
+{
+    resetTest();
+    uint8_t reply[4];
+
+    EXPECT_EQ(MSP_RESULT_ACK, startStream(0, TEST_FLASH_SIZE, 4, BIT(NO_COMPRESSION), reply));
+    EXPECT_EQ(1, testStreamsBegun);
+    EXPECT_EQ(TEST_CHUNK_SIZE, reply[0] | reply[1] << 8);
+    EXPECT_EQ(4, reply[2]);
+    EXPECT_EQ(BIT(NO_COMPRESSION) | BIT(RUN_LENGTH), reply[3]);
+
+    // the window is kept to what the FC allows
+    EXPECT_EQ(MSP_RESULT_ACK, startStream(0, TEST_FLASH_SIZE, 0, BIT(NO_COMPRESSION), reply));
+    EXPECT_EQ(1, reply[2]);
+    EXPECT_EQ(MSP_RESULT_ACK, startStream(0, TEST_FLASH_SIZE, 100, BIT(NO_COMPRESSION), reply));
+    EXPECT_EQ(16, reply[2]);
+
+    // past the end of the flash
+    EXPECT_EQ(MSP_RESULT_ERROR, startStream(TEST_FLASH_SIZE + 1, 1, 4, BIT(NO_COMPRESSION), reply));
+}
+
+TEST(MspDataflashTest, TestWindowExhaustion)
+{
+    resetTest();
+    startStream(0, TEST_FLASH_SIZE, 3, BIT(NO_COMPRESSION), NULL);
+
+    for (int i = 0; i < 3; i++) {
+        const testFrame_t frame = nextFrame();
+        EXPECT_EQ(MSP_RESULT_ACK, frame.result);
+        EXPECT_EQ(i, frame.sequence);
+        EXPECT_EQ((uint32_t)i * TEST_CHUNK_SIZE, frame.address);
+        EXPECT_EQ(TEST_CHUNK_SIZE, frame.length);
+        EXPECT_EQ(NO_COMPRESSION, frame.compression);
+        EXPECT_EQ(TEST_CHUNK_SIZE, frame.size);
+        for (int j = 0; j < frame.size; j++) {
+            ASSERT_EQ(testFlashByte(frame.address + j), frame.content[j]);
+        }
+    }
+
+    // nothing more until the client acknowledges, however often the port asks
+    EXPECT_EQ(MSP_RESULT_NO_REPLY, nextFrame().result);
+    EXPECT_EQ(MSP_RESULT_NO_REPLY, nextFrame().result);
+}
+
+TEST(MspDataflashTest, TestAckAdvancesWindow)
+{
+    resetTest();
+    startStream(0, TEST_FLASH_SIZE, 2, BIT(NO_COMPRESSION), NULL);
+    EXPECT_EQ(2, framesUntilWindowFull());
+
+    // the first frame arrived, one more can go
+    ack(1);
+    const testFrame_t frame = nextFrame();
+    EXPECT_EQ(MSP_RESULT_ACK, frame.result);
+    EXPECT_EQ(2, frame.sequence);
+    EXPECT_EQ(2u * TEST_CHUNK_SIZE, frame.address);
+    EXPECT_EQ(MSP_RESULT_NO_REPLY, nextFrame().result);
+
+    // all of them arrived
+    ack(3);
+    EXPECT_EQ(2, framesUntilWindowFull());
+}
+
+TEST(MspDataflashTest, TestOutOfOrderAndDuplicateAcksAreIgnored)
+{
+    resetTest();
+    startStream(0, TEST_FLASH_SIZE, 4, BIT(NO_COMPRESSION), NULL);
+    EXPECT_EQ(4, framesUntilWindowFull());
+
+    // an older acknowledgement arriving after a newer one doesn't take the window back
+    ack(3);
+    ack(1);
+    EXPECT_EQ(3, framesUntilWindowFull());
+
+    // and a repeated one doesn't open it further
+    ack(5);
+    ack(5);
+    EXPECT_EQ(2, framesUntilWindowFull());
+}
+
+TEST(MspDataflashTest, TestAckForFramesNotSentIsIgnored)
+{
+    resetTest();
+    startStream(0, TEST_FLASH_SIZE, 2, BIT(NO_COMPRESSION), NULL);
+    EXPECT_EQ(2, framesUntilWindowFull());
+
+    ack(10);
+    EXPECT_EQ(MSP_RESULT_NO_REPLY, nextFrame().result);
+
+    ack(2);
+    EXPECT_EQ(2, framesUntilWindowFull());
+}
+
+TEST(MspDataflashTest, TestStreamEndsWithEmptyFrame)
+{
+    resetTest();
+    startStream(1000, TEST_CHUNK_SIZE + 500, 16, BIT(NO_COMPRESSION), NULL);
+
+    testFrame_t frame = nextFrame();
+    EXPECT_EQ(1000u, frame.address);
+    EXPECT_EQ(TEST_CHUNK_SIZE, frame.length);
+
+    frame = nextFrame();
+    EXPECT_EQ(1000u + TEST_CHUNK_SIZE, frame.address);
+    EXPECT_EQ(500, frame.length);
+
+    frame = nextFrame();
+    EXPECT_EQ(MSP_RESULT_ACK, frame.result);
+    EXPECT_EQ(2, frame.sequence);
+    EXPECT_EQ(0, frame.length);
+
+    // and the stream is over
+    EXPECT_EQ(MSP_RESULT_ERROR, nextFrame().result);
+}
+
+TEST(MspDataflashTest, TestStreamReplacedByAnotherPort)
+{
+    resetTest();
+    startStream(0, TEST_FLASH_SIZE, 2, BIT(NO_COMPRESSION), NULL);
+    EXPECT_EQ(2, framesUntilWindowFull());
+
+    // a client on another port starts its own, the serial layer moves the stream over to that port
+    startStream(8192, TEST_FLASH_SIZE - 8192, 2, BIT(NO_COMPRESSION), NULL);
+    EXPECT_EQ(2, testStreamsBegun);
+
+    testFrame_t frame = nextFrame();
+    EXPECT_EQ(0, frame.sequence);
+    EXPECT_EQ(8192u, frame.address);
+
+    // a late acknowledgement from the first client is for frames this stream hasn't sent
+    ack(2);
+    frame = nextFrame();
+    EXPECT_EQ(MSP_RESULT_ACK, frame.result);
+    EXPECT_EQ(1, frame.sequence);
+    EXPECT_EQ(MSP_RESULT_NO_REPLY, nextFrame().result);
+}
+
+TEST(MspDataflashTest, TestStopEndsStream)
+{
+    resetTest();
+    startStream(0, TEST_FLASH_SIZE, 2, BIT(NO_COMPRESSION), NULL);
+
+    const uint8_t request[] = { TEST_STREAM_STOP };
+    uint8_t reply[4];
+    EXPECT_EQ(MSP_RESULT_ACK, sendCommand(request, sizeof(request), reply, sizeof(reply)));
+    EXPECT_EQ(MSP_RESULT_ERROR, nextFrame().result);
+}
+
+TEST(MspDataflashTest, TestArmingEndsStream)
+{
+    resetTest();
+    startStream(0, TEST_FLASH_SIZE, 2, BIT(NO_COMPRESSION), NULL);
+
+    ENABLE_ARMING_FLAG(ARMED);
+    EXPECT_EQ(MSP_RESULT_ERROR, nextFrame().result);
+    EXPECT_EQ(MSP_RESULT_ERROR, startStream(0, TEST_FLASH_SIZE, 2, BIT(NO_COMPRESSION), NULL));
+
+    // disarming doesn't bring it back
+    DISABLE_ARMING_FLAG(ARMED);
+    EXPECT_EQ(MSP_RESULT_ERROR, nextFrame().result);
+}
+
+TEST(MspDataflashTest, TestErasedFlashIsRunLengthCoded)
+{
+    resetTest();
+    testFlashErased = true;
+    startStream(0, TEST_FLASH_SIZE, 2, BIT(NO_COMPRESSION) | BIT(RUN_LENGTH), NULL);
+
+    const testFrame_t frame = nextFrame();
+    EXPECT_EQ(TEST_CHUNK_SIZE, frame.length);
+    EXPECT_EQ(RUN_LENGTH, frame.compression);
+    EXPECT_GT(32, frame.size);
+
+    // a client that can't decode it gets it raw
+    startStream(0, TEST_FLASH_SIZE, 2, BIT(NO_COMPRESSION), NULL);
+    EXPECT_EQ(NO_COMPRESSION, nextFrame().compression);
+}
+
+// STUBS
+
+extern "C" {
+
+uint8_t armingFlags;
+
+bool mspSerialBeginStream(mspStreamFnPtr streamFn)
+{
+    testStreamFn = streamFn;
+    testStreamsBegun++;
+    return true;
+}
+
+bool flashfsIsReady(void) { return true; }
+uint32_t flashfsGetSize(void) { return TEST_FLASH_SIZE; }
+
+int flashfsReadLog(uint32_t offset, uint8_t *data, unsigned int len)
+{
+    for (unsigned i = 0; i < len; i++) {
+        data[i] = testFlashByte(offset + i);
+    }
+    return len;
+}
+
+}
@@ -0,0 +1,108 @@
+/*
+ * This file is part of Cleanflight.
+ *
+ * Cleanflight is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Cleanflight is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cleanflight.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+extern "C" {
+    #include "platform.h"
+
+    #include "flight/pid.h"
+
+    #include "interface/msp_dispatch.h"
+    #include "interface/msp_protocol.h"
+
+    extern const mspCommand_t mspCommandTable[];
+    extern const unsigned mspCommandCount;
+}
+
+#include "unittest_macros.h"
+#include "gtest/gtest.h"
+
+TEST(MspDispatchTest, TestTableIsSorted)
+{
+    ASSERT_GT(mspCommandCount, 0U);
+
+    for (unsigned i = 1; i < mspCommandCount; i++) {
+        EXPECT_LT(mspCommandTable[i - 1].cmd, mspCommandTable[i].cmd) << "at index " << i;
+    }
+    for (unsigned i = 0; i < mspCommandCount; i++) {
+        EXPECT_LT(mspCommandTable[i].handler, MSP_HANDLER_COUNT) << "command " << (int)mspCommandTable[i].cmd;
+    }
+}
+
+TEST(MspDispatchTest, TestFindEveryCommand)
+{
+    unsigned found = 0;
+
+    for (int cmd = 0; cmd < 256; cmd++) {
+        const mspCommand_t *command = mspFindCommand(cmd);
+        if (command) {
+            EXPECT_EQ(cmd, command->cmd);
+            EXPECT_EQ(&mspCommandTable[found], command);
+            found++;
+        }
+    }
+
+    EXPECT_EQ(mspCommandCount, found);
+}
+
+TEST(MspDispatchTest, TestUnknownCommands)
+{
+    EXPECT_EQ(NULL, mspFindCommand(0));
+    EXPECT_EQ(NULL, mspFindCommand(MSP_API_VERSION - 1));
+    EXPECT_EQ(NULL, mspFindCommand(255));
+}
+
+TEST(MspDispatchTest, TestCommandAttributes)
+{
+    const mspCommand_t *command = mspFindCommand(MSP_STATUS);
+    ASSERT_TRUE(command != NULL);
+    EXPECT_EQ(MSP_HANDLER_OUT, command->handler);
+    EXPECT_EQ(0, command->minPayloadSize);
+    EXPECT_EQ(0, command->flags);
+
+    command = mspFindCommand(MSP_SET_PID);
+    ASSERT_TRUE(command != NULL);
+    EXPECT_EQ(MSP_HANDLER_IN, command->handler);
+    EXPECT_EQ(PID_ITEM_COUNT * 3, command->minPayloadSize);
+
+    command = mspFindCommand(MSP_DATAFLASH_READ);
+    ASSERT_TRUE(command != NULL);
+    EXPECT_EQ(MSP_HANDLER_DATAFLASH_READ, command->handler);
+    EXPECT_EQ(4, command->minPayloadSize);
+
+    const uint8_t disarmedOnly[] = { MSP_EEPROM_WRITE, MSP_RESET_CONF, MSP_ACC_CALIBRATION, MSP_MAG_CALIBRATION, MSP_REBOOT, MSP_SET_4WAY_IF, MSP_DATAFLASH_ERASE };
+    for (unsigned i = 0; i < sizeof(disarmedOnly); i++) {
+        command = mspFindCommand(disarmedOnly[i]);
+        ASSERT_TRUE(command != NULL);
+        EXPECT_TRUE(command->flags & MSP_COMMAND_DISARMED_ONLY) << "command " << (int)disarmedOnly[i];
+    }
+}
+
+TEST(MspDispatchTest, TestQueries)
+{
+    const uint8_t queries[] = { MSP_STATUS, MSP_DATAFLASH_READ, MSP_SETTINGS_READ, MSP_API_VERSION, 0 };
+    for (unsigned i = 0; i < sizeof(queries); i++) {
+        EXPECT_TRUE(mspCommandIsQuery(queries[i])) << "command " << (int)queries[i];
+    }
+
+    const uint8_t changes[] = { MSP_DATAFLASH_ERASE, MSP_DATAFLASH_READ_STREAM, MSP_ACC_CALIBRATION, MSP_SET_PID, MSP_SET_BATTERY_CONFIG, MSP_EEPROM_WRITE, MSP_SET_4WAY_IF };
+    for (unsigned i = 0; i < sizeof(changes); i++) {
+        EXPECT_FALSE(mspCommandIsQuery(changes[i])) << "command " << (int)changes[i];
+    }
+}
@@ -0,0 +1,698 @@
+/*
+ * This file is part of Cleanflight.
+ *
+ * Cleanflight is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Cleanflight is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cleanflight.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include <limits.h>
+
+#include <algorithm>
+#include <vector>
+
+extern "C" {
+    #include "platform.h"
+
+    #include "common/streambuf.h"
+
+    #include "drivers/serial.h"
+
+    #include "io/serial.h"
+
+    #include "msp/msp_serial.h"
+
+    #include "pg/pg.h"
+    #include "pg/pg_ids.h"
+
+    PG_REGISTER(serialConfig_t, serialConfig, PG_SERIAL_CONFIG, 0);
+}
+
+#include "unittest_macros.h"
+#include "gtest/gtest.h"
+
+#define TEST_CMD_POST_PROCESS 200
+#define TEST_CMD_SUBSCRIBE 201
+#define TEST_CMD_STREAM 202
+#define TEST_CMD_ERASE 203
+
+typedef std::vector<uint8_t> bytes_t;
+
+static serialPort_t testPort;
+static serialPortConfig_t testPortConfig;
+
+static bytes_t rxData;
+static unsigned rxPos;
+static unsigned rxSpanLimit;
+
+static bytes_t txData;
+static unsigned txBuffered;
+static unsigned txCapacity;
+static unsigned txOverflows;
+static int writeDepth;
+static int writeBrackets;
+static int drainWaits;
+
+static int replySize[256];
+static std::vector<int> processedCommands;
+static int postProcessCalls;
+
+// A second MSP port, with room for anything written to it
+static serialPort_t otherPort;
+static serialPortConfig_t otherPortConfig;
+static bool otherPortEnabled;
+static bool otherPortConfigFound;
+static bytes_t otherRxData;
+static unsigned otherRxPos;
+static bytes_t otherTxData;
+
+static int streamFramesLeft;
+
+static std::vector<mspSubscription_t> testSubscriptions;
+static bool subscribed;
+static timeMs_t currentTimeMs;
+
+static void testPostProcessFn(serialPort_t *port)
+{
+    UNUSED(port);
+
+    // The replies have been sent by now
+    EXPECT_EQ(0, writeDepth);
+    postProcessCalls++;
+}
+
+static mspResult_e testStreamFn(mspPacket_t *frame)
+{
+    if (streamFramesLeft == 0) {
+        return MSP_RESULT_NO_REPLY;
+    }
+    streamFramesLeft--;
+
+    frame->cmd = TEST_CMD_STREAM;
+    sbufWriteU8(&frame->buf, TEST_CMD_STREAM);
+
+    return MSP_RESULT_ACK;
+}
+
+static mspResult_e testProcessCommand(mspPacket_t *cmd, mspPacket_t *reply, mspPostProcessFnPtr *mspPostProcessFn)
+{
+    processedCommands.push_back(cmd->cmd);
+
+    reply->cmd = cmd->cmd;
+    for (int i = 0; i < replySize[cmd->cmd]; i++) {
+        sbufWriteU8(&reply->buf, cmd->cmd);
+    }
+
+    if (cmd->cmd == TEST_CMD_POST_PROCESS) {
+        *mspPostProcessFn = testPostProcessFn;
+    } else if (cmd->cmd == TEST_CMD_SUBSCRIBE) {
+        subscribed = mspSerialSetSubscriptions(testSubscriptions.data(), testSubscriptions.size());
+    } else if (cmd->cmd == TEST_CMD_STREAM) {
+        EXPECT_TRUE(mspSerialBeginStream(testStreamFn));
+    }
+
+    return MSP_RESULT_ACK;
+}
+
+static void testProcessReply(mspPacket_t *reply)
+{
+    UNUSED(reply);
+}
+
+static void queueRequestOn(bytes_t *data, uint8_t cmd)
+{
+    const uint8_t request[] = { '$', 'M', '<', 0, cmd, cmd };
+    data->insert(data->end(), request, request + sizeof(request));
+}
+
+static void queueRequest(uint8_t cmd)
+{
+    queueRequestOn(&rxData, cmd);
+}
+
+// The commands of the v1 reply frames sent so far, checking that they are complete and back to back
+static std::vector<int> sentReplies(void)
+{
+    std::vector<int> commands;
+
+    unsigned i = 0;
+    while (i < txData.size()) {
+        EXPECT_EQ('$', txData[i]);
+        EXPECT_EQ('M', txData[i + 1]);
+        EXPECT_EQ('>', txData[i + 2]);
+        const uint8_t size = txData[i + 3];
+        const uint8_t cmd = txData[i + 4];
+        uint8_t checksum = size ^ cmd;
+        for (int j = 0; j < size; j++) {
+            EXPECT_EQ(cmd, txData[i + 5 + j]);
+            checksum ^= txData[i + 5 + j];
+        }
+        EXPECT_EQ(checksum, txData[i + 5 + size]);
+
+        commands.push_back(cmd);
+        i += 6 + size;
+    }
+
+    return commands;
+}
+
+static void resetTest(unsigned capacity)
+{
+    rxData.clear();
+    rxPos = 0;
+    rxSpanLimit = UINT_MAX;
+    txData.clear();
+    txBuffered = 0;
+    txCapacity = capacity;
+    txOverflows = 0;
+    writeDepth = 0;
+    writeBrackets = 0;
+    drainWaits = 0;
+    processedCommands.clear();
+    postProcessCalls = 0;
+    otherPortEnabled = false;
+    otherRxData.clear();
+    otherRxPos = 0;
+    otherTxData.clear();
+    streamFramesLeft = 0;
+    testSubscriptions.clear();
+    subscribed = false;
+    currentTimeMs = 0;
+    for (int i = 0; i < 256; i++) {
+        replySize[i] = 4;
+    }
+
+    testPortConfig.identifier = SERIAL_PORT_USART1;
+    otherPortConfig.identifier = SERIAL_PORT_USART2;
+    otherPortConfigFound = false;
+    mspSerialInit();
+}
+
+static void resetTestWithOtherPort(unsigned capacity)
+{
+    resetTest(capacity);
+
+    otherPortEnabled = true;
+    otherPortConfigFound = false;
+    mspSerialInit();
+}
+
+TEST(MspSerialTest, TestOneCommandIsAnswered)
+{
+    resetTest(256);
+
+    queueRequest(101);
+    mspSerialProcess(MSP_SKIP_NON_MSP_DATA, testProcessCommand, testProcessReply);
+
+    EXPECT_EQ(std::vector<int>({ 101 }), sentReplies());
+    EXPECT_EQ(1, writeBrackets);
+}
+
+TEST(MspSerialTest, TestQueuedCommandsAreAnsweredInOnePass)
+{
+    resetTest(256);
+
+    const std::vector<int> commands = { 101, 102, 105, 108, 110 };
+    for (int cmd : commands) {
+        queueRequest(cmd);
+    }
+
+    mspSerialProcess(MSP_SKIP_NON_MSP_DATA, testProcessCommand, testProcessReply);
+
+    EXPECT_EQ(commands, processedCommands);
+    EXPECT_EQ(commands, sentReplies());
+
+    // All of the replies went out in one write
+    EXPECT_EQ(1, writeBrackets);
+    EXPECT_EQ(0U, txOverflows);
+}
+
+TEST(MspSerialTest, TestCommandsPerPassAreLimited)
+{
+    resetTest(4096);
+
+    for (int cmd = 1; cmd <= 20; cmd++) {
+        queueRequest(cmd);
+    }
+
+    int passes = 0;
+    while (rxPos < rxData.size()) {
+        mspSerialProcess(MSP_SKIP_NON_MSP_DATA, testProcessCommand, testProcessReply);
+        passes++;
+    }
+
+    EXPECT_EQ(3, passes);
+    EXPECT_EQ(20U, sentReplies().size());
+}
+
+TEST(MspSerialTest, TestPipeliningStopsWhenTransmitBufferFills)
+{
+    // Room for about three replies
+    resetTest(100);
+
+    std::vector<int> commands;
+    for (int cmd = 1; cmd <= 12; cmd++) {
+        replySize[cmd] = 20;
+        queueRequest(cmd);
+        commands.push_back(cmd);
+    }
+
+    int passes = 0;
+    while (rxPos < rxData.size()) {
+        mspSerialProcess(MSP_SKIP_NON_MSP_DATA, testProcessCommand, testProcessReply);
+        passes++;
+
+        EXPECT_LE(txBuffered, txCapacity);
+
+        // The port drains between passes
+        txBuffered = 0;
+    }
+
+    EXPECT_GT(passes, 1);
+    EXPECT_LT(passes, 12);
+
+    // Nothing was dropped
+    EXPECT_EQ(commands, sentReplies());
+    EXPECT_EQ(0U, txOverflows);
+    EXPECT_EQ(0, drainWaits);
+}
+
+TEST(MspSerialTest, TestLargeReplyWaitsRatherThanBeingDropped)
+{
+    resetTest(100);
+
+    replySize[1] = 30;
+    replySize[2] = 80;
+    queueRequest(1);
+    queueRequest(2);
+    queueRequest(3);
+
+    // The reply to 2 doesn't fit behind the one to 1, 2 is kept and what follows it left unread
+    mspSerialProcess(MSP_SKIP_NON_MSP_DATA, testProcessCommand, testProcessReply);
+
+    EXPECT_EQ(std::vector<int>({ 1 }), sentReplies());
+    EXPECT_EQ(12U, rxPos);
+
+    // Nothing more while the port is still busy, without waiting for it
+    mspSerialProcess(MSP_SKIP_NON_MSP_DATA, testProcessCommand, testProcessReply);
+
+    EXPECT_EQ(std::vector<int>({ 1 }), sentReplies());
+    EXPECT_EQ(12U, rxPos);
+
+    // Then answered once the port has drained, filling it again
+    txBuffered = 0;
+    mspSerialProcess(MSP_SKIP_NON_MSP_DATA, testProcessCommand, testProcessReply);
+
+    EXPECT_EQ(std::vector<int>({ 1, 2 }), sentReplies());
+
+    txBuffered = 0;
+    mspSerialProcess(MSP_SKIP_NON_MSP_DATA, testProcessCommand, testProcessReply);
+
+    EXPECT_EQ(std::vector<int>({ 1, 2, 3 }), sentReplies());
+    EXPECT_EQ(0, drainWaits);
+    EXPECT_EQ(0U, txOverflows);
+}
+
+TEST(MspSerialTest, TestCommandThatChangesSomethingRunsOnce)
+{
+    resetTest(100);
+
+    replySize[1] = 30;
+    replySize[TEST_CMD_ERASE] = 80;
+    queueRequest(1);
+    queueRequest(TEST_CMD_ERASE);
+    queueRequest(3);
+
+    // There might not be room for its reply behind the one to 1, so it isn't run until the port has drained
+    mspSerialProcess(MSP_SKIP_NON_MSP_DATA, testProcessCommand, testProcessReply);
+
+    EXPECT_EQ(std::vector<int>({ 1 }), processedCommands);
+    EXPECT_EQ(std::vector<int>({ 1 }), sentReplies());
+
+    mspSerialProcess(MSP_SKIP_NON_MSP_DATA, testProcessCommand, testProcessReply);
+
+    EXPECT_EQ(std::vector<int>({ 1 }), processedCommands);
+
+    txBuffered = 0;
+    mspSerialProcess(MSP_SKIP_NON_MSP_DATA, testProcessCommand, testProcessReply);
+
+    txBuffered = 0;
+    mspSerialProcess(MSP_SKIP_NON_MSP_DATA, testProcessCommand, testProcessReply);
+
+    EXPECT_EQ(std::vector<int>({ 1, TEST_CMD_ERASE, 3 }), processedCommands);
+    EXPECT_EQ(std::vector<int>({ 1, TEST_CMD_ERASE, 3 }), sentReplies());
+    EXPECT_EQ(0, drainWaits);
+    EXPECT_EQ(0U, txOverflows);
+}
+
+TEST(MspSerialTest, TestCommandThatChangesSomethingIsPipelinedWhenItFits)
+{
+    // Room for the largest reply behind the first one
+    resetTest(2 * MSP_PORT_OUTBUF_SIZE);
+
+    queueRequest(1);
+    queueRequest(TEST_CMD_ERASE);
+    queueRequest(3);
+
+    mspSerialProcess(MSP_SKIP_NON_MSP_DATA, testProcessCommand, testProcessReply);
+
+    EXPECT_EQ(std::vector<int>({ 1, TEST_CMD_ERASE, 3 }), processedCommands);
+    EXPECT_EQ(std::vector<int>({ 1, TEST_CMD_ERASE, 3 }), sentReplies());
+    EXPECT_EQ(1, writeBrackets);
+}
+
+TEST(MspSerialTest, TestRequestsSplitAcrossSpans)
+{
+    resetTest(256);
+
+    // As if the requests wrapped around the end of the receive buffer, a few bytes at a time
+    rxSpanLimit = 4;
+    const std::vector<int> commands = { 101, 102, 105 };
+    for (int cmd : commands) {
+        queueRequest(cmd);
+    }
+
+    mspSerialProcess(MSP_SKIP_NON_MSP_DATA, testProcessCommand, testProcessReply);
+
+    EXPECT_EQ(commands, sentReplies());
+    EXPECT_EQ(rxData.size(), rxPos);
+}
+
+TEST(MspSerialTest, TestPostProcessEndsPass)
+{
+    resetTest(256);
+
+    queueRequest(101);
+    queueRequest(TEST_CMD_POST_PROCESS);
+    queueRequest(102);
+
+    mspSerialProcess(MSP_SKIP_NON_MSP_DATA, testProcessCommand, testProcessReply);
+
+    EXPECT_EQ(std::vector<int>({ 101, TEST_CMD_POST_PROCESS }), sentReplies());
+    EXPECT_EQ(1, postProcessCalls);
+
+    mspSerialProcess(MSP_SKIP_NON_MSP_DATA, testProcessCommand, testProcessReply);
+    EXPECT_EQ(std::vector<int>({ 101, TEST_CMD_POST_PROCESS, 102 }), sentReplies());
+}
+
+static void subscribe(const std::vector<mspSubscription_t> &subscriptions)
+{
+    testSubscriptions = subscriptions;
+    queueRequest(TEST_CMD_SUBSCRIBE);
+    mspSerialProcess(MSP_SKIP_NON_MSP_DATA, testProcessCommand, testProcessReply);
+    EXPECT_TRUE(subscribed);
+
+    // Only count the pushed frames
+    txData.clear();
+    txBuffered = 0;
+    processedCommands.clear();
+}
+
+// Run the subscription task every 10ms up to the given time, the port drains in between
+static void runSubscriptionsUntil(timeMs_t endTimeMs)
+{
+    while (currentTimeMs <= endTimeMs) {
+        mspSerialProcessSubscriptions(testProcessCommand);
+        txBuffered = 0;
+        currentTimeMs += 10;
+    }
+}
+
+TEST(MspSerialTest, TestSubscriptionsArePushedAtTheirInterval)
+{
+    resetTest(256);
+
+    subscribe({ { 108, 20, 0 }, { 110, 100, 0 } });
+    runSubscriptionsUntil(990);
+
+    const std::vector<int> sent = sentReplies();
+    EXPECT_EQ(50, std::count(sent.begin(), sent.end(), 108));
+    EXPECT_EQ(10, std::count(sent.begin(), sent.end(), 110));
+    EXPECT_EQ(0U, txOverflows);
+
+    // Both are pushed straight away
+    EXPECT_EQ(std::vector<int>({ 108, 110 }), std::vector<int>(sent.begin(), sent.begin() + 2));
+}
+
+TEST(MspSerialTest, TestSubscriptionsAreReplaced)
+{
+    resetTest(256);
+
+    subscribe({ { 108, 20, 0 } });
+    runSubscriptionsUntil(100);
+    EXPECT_FALSE(sentReplies().empty());
+
+    subscribe({ { 105, 50, 0 } });
+    runSubscriptionsUntil(300);
+    EXPECT_EQ(std::vector<int>({ 105, 105, 105, 105 }), sentReplies());
+
+    // No subscriptions stops the pushes
+    subscribe({});
+    runSubscriptionsUntil(600);
+    EXPECT_TRUE(sentReplies().empty());
+    EXPECT_TRUE(processedCommands.empty());
+}
+
+TEST(MspSerialTest, TestSubscriptionWaitsForTransmitBuffer)
+{
+    resetTest(64);
+
+    replySize[108] = 40;
+    replySize[110] = 4;
+    subscribe({ { 108, 10, 0 }, { 110, 10, 0 } });
+
+    // The port is busy, the larger reply has to wait but the smaller one still fits
+    txBuffered = 30;
+    mspSerialProcessSubscriptions(testProcessCommand);
+    EXPECT_EQ(std::vector<int>({ 110 }), sentReplies());
+    EXPECT_EQ(0U, txOverflows);
+    EXPECT_EQ(0, drainWaits);
+
+    // Once drained the waiting reply goes out without waiting for its next interval
+    txBuffered = 0;
+    mspSerialProcessSubscriptions(testProcessCommand);
+    EXPECT_EQ(std::vector<int>({ 110, 108 }), sentReplies());
+}
+
+TEST(MspSerialTest, TestLateSubscriptionIsNotSentInABurst)
+{
+    resetTest(256);
+
+    subscribe({ { 108, 10, 0 } });
+    mspSerialProcessSubscriptions(testProcessCommand);
+    EXPECT_EQ(1U, sentReplies().size());
+
+    // The task didn't run for a while
+    currentTimeMs = 1000;
+    mspSerialProcessSubscriptions(testProcessCommand);
+    mspSerialProcessSubscriptions(testProcessCommand);
+    EXPECT_EQ(2U, sentReplies().size());
+
+    currentTimeMs = 1010;
+    mspSerialProcessSubscriptions(testProcessCommand);
+    EXPECT_EQ(3U, sentReplies().size());
+}
+
+TEST(MspSerialTest, TestNewStreamStopsTheOneOnAnotherPort)
+{
+    resetTestWithOtherPort(256);
+
+    queueRequest(TEST_CMD_STREAM);
+    streamFramesLeft = 1;
+    mspSerialProcess(MSP_SKIP_NON_MSP_DATA, testProcessCommand, testProcessReply);
+
+    EXPECT_EQ(std::vector<int>({ TEST_CMD_STREAM, TEST_CMD_STREAM }), sentReplies());
+    EXPECT_TRUE(otherTxData.empty());
+
+    // The stream moves to the other port, rather than the two sharing its position
+    queueRequestOn(&otherRxData, TEST_CMD_STREAM);
+    mspSerialProcess(MSP_SKIP_NON_MSP_DATA, testProcessCommand, testProcessReply);
+    txData.clear();
+    otherTxData.clear();
+
+    streamFramesLeft = 2;
+    mspSerialProcess(MSP_SKIP_NON_MSP_DATA, testProcessCommand, testProcessReply);
+
+    EXPECT_TRUE(txData.empty());
+    EXPECT_EQ(2 * 7U, otherTxData.size());
+    EXPECT_TRUE(mspSerialIsStreaming());
+}
+
+// STUBS
+
+extern "C" {
+
+bool mspCommandIsQuery(uint8_t cmd)
+{
+    return cmd != TEST_CMD_ERASE;
+}
+
+const uint32_t baudRates[] = { 0, 9600, 19200, 38400, 57600, 115200 };
+
+serialPortConfig_t *findSerialPortConfig(serialPortFunction_e function)
+{
+    UNUSED(function);
+
+    return &testPortConfig;
+}
+
+serialPortConfig_t *findNextSerialPortConfig(serialPortFunction_e function)
+{
+    UNUSED(function);
+
+    if (otherPortEnabled && !otherPortConfigFound) {
+        otherPortConfigFound = true;
+        return &otherPortConfig;
+    }
+
+    return NULL;
+}
+
+serialPort_t *openSerialPort(serialPortIdentifier_e identifier, serialPortFunction_e function, serialReceiveCallbackPtr rxCallback,
+    void *rxCallbackData, uint32_t baudrate, portMode_e mode, portOptions_e options)
+{
+    UNUSED(function);
+    UNUSED(rxCallback);
+    UNUSED(rxCallbackData);
+    UNUSED(baudrate);
+    UNUSED(mode);
+    UNUSED(options);
+
+    if (identifier == SERIAL_PORT_USART2) {
+        otherPort.identifier = SERIAL_PORT_USART2;
+        return &otherPort;
+    }
+
+    testPort.identifier = SERIAL_PORT_USART1;
+
+    return &testPort;
+}
+
+void closeSerialPort(serialPort_t *serialPort)
+{
+    UNUSED(serialPort);
+}
+
+bool isSerialPortShared(const serialPortConfig_t *portConfig, uint16_t functionMask, serialPortFunction_e sharedWithFunction)
+{
+    UNUSED(portConfig);
+    UNUSED(functionMask);
+    UNUSED(sharedWithFunction);
+
+    return false;
+}
+
+uint32_t serialRxBytesWaiting(const serialPort_t *instance)
+{
+    if (instance == &otherPort) {
+        return otherRxData.size() - otherRxPos;
+    }
+
+    return rxData.size() - rxPos;
+}
+
+uint32_t serialRxSpan(const serialPort_t *instance, const uint8_t **data)
+{
+    if (instance == &otherPort) {
+        *data = otherRxData.data() + otherRxPos;
+        return otherRxData.size() - otherRxPos;
+    }
+
+    *data = rxData.data() + rxPos;
+
+    return std::min<unsigned>(rxData.size() - rxPos, rxSpanLimit);
+}
+
+void serialRxAdvance(serialPort_t *instance, uint32_t count)
+{
+    if (instance == &otherPort) {
+        otherRxPos += count;
+        return;
+    }
+
+    rxPos += count;
+}
+
+uint32_t serialTxBytesFree(const serialPort_t *instance)
+{
+    if (instance == &otherPort) {
+        return UINT16_MAX;
+    }
+
+    return txCapacity - txBuffered;
+}
+
+bool isSerialTransmitBufferEmpty(const serialPort_t *instance)
+{
+    if (instance == &otherPort) {
+        return true;
+    }
+
+    return txBuffered == 0;
+}
+
+void serialWriteBuf(serialPort_t *instance, const uint8_t *data, int count)
+{
+    if (instance == &otherPort) {
+        otherTxData.insert(otherTxData.end(), data, data + count);
+        return;
+    }
+
+    txData.insert(txData.end(), data, data + count);
+    txBuffered += count;
+    if (txBuffered > txCapacity) {
+        txOverflows++;
+    }
+}
+
+void serialBeginWrite(serialPort_t *instance)
+{
+    UNUSED(instance);
+
+    EXPECT_EQ(0, writeDepth);
+    writeDepth++;
+}
+
+void serialEndWrite(serialPort_t *instance)
+{
+    UNUSED(instance);
+
+    EXPECT_EQ(1, writeDepth);
+    writeDepth--;
+    writeBrackets++;
+}
+
+void waitForSerialPortToFinishTransmitting(serialPort_t *serialPort)
+{
+    UNUSED(serialPort);
+
+    txBuffered = 0;
+    drainWaits++;
+}
+
+timeMs_t millis(void)
+{
+    return currentTimeMs;
+}
+
+void systemResetToBootloader(void) {}
+
+void cliEnter(serialPort_t *serialPort)
+{
+    UNUSED(serialPort);
+}
+
+}
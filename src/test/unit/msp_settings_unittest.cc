@@ -0,0 +1,385 @@
+/*
+ * This file is part of Cleanflight.
+ *
+ * Cleanflight is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Cleanflight is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cleanflight.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+
+#include <vector>
+
+extern "C" {
+    #include "platform.h"
+
+    #include "common/axis.h"
+    #include "common/hash.h"
+    #include "common/streambuf.h"
+    #include "common/utils.h"
+
+    #include "fc/controlrate_profile.h"
+
+    #include "flight/pid.h"
+
+    #include "interface/msp_settings.h"
+    #include "interface/settings.h"
+
+    #include "pg/pg.h"
+    #include "pg/pg_ids.h"
+
+    typedef struct testSettings_s {
+        uint8_t direct;
+        int16_t signedValue;
+        uint8_t lookup;
+        uint16_t bits;
+        int8_t array[3];
+        uint32_t wide;
+    } testSettings_t;
+
+    PG_DECLARE(testSettings_t, testSettings);
+
+    PG_REGISTER(testSettings_t, testSettings, PG_RESERVED_FOR_TESTING_1, 0);
+    PG_REGISTER_ARRAY(pidProfile_t, MAX_PROFILE_COUNT, pidProfiles, PG_PID_PROFILE, 0);
+    PG_REGISTER_ARRAY(controlRateConfig_t, CONTROL_RATE_PROFILE_COUNT, controlRateProfiles, PG_CONTROL_RATE_PROFILES, 0);
+
+    static const char * const lookupTableOffOn[] = { "OFF", "ON" };
+
+    const lookupTableEntry_t lookupTables[] = {
+        { lookupTableOffOn, ARRAYLEN(lookupTableOffOn) },
+    };
+
+    const clivalue_t valueTable[] = {
+        { "test_direct", VAR_UINT8 | MASTER_VALUE, { .minmax = { 10, 200 } }, PG_RESERVED_FOR_TESTING_1, offsetof(testSettings_t, direct) },
+        { "test_signed", VAR_INT16 | MASTER_VALUE, { .minmax = { -500, 500 } }, PG_RESERVED_FOR_TESTING_1, offsetof(testSettings_t, signedValue) },
+        { "test_lookup", VAR_UINT8 | MASTER_VALUE | MODE_LOOKUP, { .lookup = { TABLE_OFF_ON } }, PG_RESERVED_FOR_TESTING_1, offsetof(testSettings_t, lookup) },
+        { "test_bit", VAR_UINT16 | MASTER_VALUE | MODE_BITSET, { .bitpos = 3 }, PG_RESERVED_FOR_TESTING_1, offsetof(testSettings_t, bits) },
+        { "test_array", VAR_INT8 | MASTER_VALUE | MODE_ARRAY, { .array = { 3 } }, PG_RESERVED_FOR_TESTING_1, offsetof(testSettings_t, array) },
+        { "test_wide", VAR_UINT32 | MASTER_VALUE, { .minmax = { 0, 5000 } }, PG_RESERVED_FOR_TESTING_1, offsetof(testSettings_t, wide) },
+        { "p_pitch", VAR_UINT8 | PROFILE_VALUE, { .minmax = { 0, 200 } }, PG_PID_PROFILE, offsetof(pidProfile_t, pid[PID_PITCH].P) },
+        { "roll_rc_rate", VAR_UINT8 | PROFILE_RATE_VALUE, { .minmax = { 1, 255 } }, PG_CONTROL_RATE_PROFILES, offsetof(controlRateConfig_t, rcRates[FD_ROLL]) },
+    };
+    const uint16_t valueTableEntryCount = ARRAYLEN(valueTable);
+
+    extern const pgRegistry_t testSettings_Registry;
+}
+
+#include "unittest_macros.h"
+#include "gtest/gtest.h"
+
+#define TEST_DIRECT     0
+#define TEST_SIGNED     1
+#define TEST_LOOKUP     2
+#define TEST_BIT        3
+#define TEST_ARRAY      4
+#define TEST_WIDE       5
+#define TEST_P_PITCH    6
+#define TEST_RC_RATE    7
+
+#define CURRENT MSP_SETTINGS_CURRENT_PROFILE
+
+static uint8_t currentPidProfileIndex;
+static uint8_t currentRateProfileIndex;
+
+typedef std::vector<uint8_t> bytes_t;
+
+static void resetSettings(void)
+{
+    memset(testSettingsMutable(), 0, sizeof(testSettings_t));
+    memset(pidProfiles_array(), 0, sizeof(*pidProfiles_array()));
+    memset(controlRateProfiles_array(), 0, sizeof(*controlRateProfiles_array()));
+    currentPidProfileIndex = 0;
+    currentRateProfileIndex = 0;
+}
+
+static void appendU16(bytes_t *request, uint16_t value)
+{
+    request->push_back(value & 0xff);
+    request->push_back(value >> 8);
+}
+
+static mspResult_e read(bytes_t request, bytes_t *reply, int replySize = 256)
+{
+    uint8_t replyBuffer[256];
+    sbuf_t src;
+    sbuf_t dst;
+    sbufInit(&src, request.data(), request.data() + request.size());
+    sbufInit(&dst, replyBuffer, replyBuffer + replySize);
+
+    const mspResult_e result = mspSettingsRead(&dst, &src);
+    reply->assign(replyBuffer, sbufPtr(&dst));
+
+    return result;
+}
+
+static mspResult_e write(bytes_t request)
+{
+    sbuf_t src;
+    sbufInit(&src, request.data(), request.data() + request.size());
+
+    return mspSettingsWrite(&src);
+}
+
+TEST(MspSettingsTest, TestReadValues)
+{
+    resetSettings();
+    testSettingsMutable()->direct = 123;
+    testSettingsMutable()->signedValue = -300;
+    testSettingsMutable()->lookup = 1;
+    testSettingsMutable()->bits = 0x0008;
+    testSettingsMutable()->array[0] = -1;
+    testSettingsMutable()->array[1] = 2;
+    testSettingsMutable()->array[2] = 3;
+    testSettingsMutable()->wide = 0x12345678;
+
+    bytes_t request = { CURRENT, CURRENT };
+    for (int id = TEST_DIRECT; id <= TEST_WIDE; id++) {
+        appendU16(&request, id);
+    }
+
+    bytes_t reply;
+    EXPECT_EQ(MSP_RESULT_ACK, read(request, &reply));
+
+    const bytes_t expected = { 6, 0, 123, 0xd4, 0xfe, 1, 1, 0xff, 2, 3, 0x78, 0x56, 0x34, 0x12 };
+    EXPECT_EQ(expected, reply);
+}
+
+TEST(MspSettingsTest, TestReadSelectsProfiles)
+{
+    resetSettings();
+    pidProfilesMutable(0)->pid[PID_PITCH].P = 40;
+    pidProfilesMutable(2)->pid[PID_PITCH].P = 60;
+    controlRateProfilesMutable(1)->rcRates[FD_ROLL] = 90;
+    controlRateProfilesMutable(5)->rcRates[FD_ROLL] = 110;
+    currentRateProfileIndex = 5;
+
+    bytes_t request = { 2, 1 };
+    appendU16(&request, TEST_P_PITCH);
+    appendU16(&request, TEST_RC_RATE);
+
+    bytes_t reply;
+    EXPECT_EQ(MSP_RESULT_ACK, read(request, &reply));
+    EXPECT_EQ(bytes_t({ 2, 0, 60, 90 }), reply);
+
+    request = { CURRENT, CURRENT };
+    appendU16(&request, TEST_P_PITCH);
+    appendU16(&request, TEST_RC_RATE);
+
+    EXPECT_EQ(MSP_RESULT_ACK, read(request, &reply));
+    EXPECT_EQ(bytes_t({ 2, 0, 40, 110 }), reply);
+
+    request = { MAX_PROFILE_COUNT, CURRENT };
+    EXPECT_EQ(MSP_RESULT_ERROR, read(request, &reply));
+}
+
+TEST(MspSettingsTest, TestReadStopsWhenReplyIsFull)
+{
+    resetSettings();
+
+    bytes_t request = { CURRENT, CURRENT };
+    appendU16(&request, TEST_DIRECT);
+    appendU16(&request, TEST_WIDE);
+    appendU16(&request, TEST_LOOKUP);
+
+    // Room for the count, the first value and half of the second
+    bytes_t reply;
+    EXPECT_EQ(MSP_RESULT_ACK, read(request, &reply, 5));
+    EXPECT_EQ(bytes_t({ 1, 0, 0 }), reply);
+
+    request = { CURRENT, CURRENT };
+    appendU16(&request, valueTableEntryCount);
+    EXPECT_EQ(MSP_RESULT_ERROR, read(request, &reply));
+}
+
+TEST(MspSettingsTest, TestWriteValues)
+{
+    resetSettings();
+    testSettingsMutable()->bits = 0x0001;
+    pgMarkAllClean();
+
+    bytes_t request = { CURRENT, 3 };
+    appendU16(&request, TEST_DIRECT);
+    request.push_back(150);
+    appendU16(&request, TEST_SIGNED);
+    appendU16(&request, (uint16_t)-500);
+    appendU16(&request, TEST_BIT);
+    request.push_back(1);
+    appendU16(&request, TEST_ARRAY);
+    request.insert(request.end(), { 0x80, 0x7f, 0x00 });
+    appendU16(&request, TEST_WIDE);
+    request.insert(request.end(), { 0x88, 0x13, 0x00, 0x00 });
+    appendU16(&request, TEST_RC_RATE);
+    request.push_back(77);
+
+    EXPECT_EQ(MSP_RESULT_ACK, write(request));
+
+    EXPECT_EQ(150, testSettings()->direct);
+    EXPECT_EQ(-500, testSettings()->signedValue);
+    EXPECT_EQ(0x0009, testSettings()->bits);
+    EXPECT_EQ(-128, testSettings()->array[0]);
+    EXPECT_EQ(127, testSettings()->array[1]);
+    EXPECT_EQ(0, testSettings()->array[2]);
+    EXPECT_EQ(5000, testSettings()->wide);
+    EXPECT_EQ(77, controlRateProfiles(3)->rcRates[FD_ROLL]);
+    EXPECT_EQ(0, controlRateProfiles(0)->rcRates[FD_ROLL]);
+
+    EXPECT_TRUE(pgIsDirty(&testSettings_Registry));
+    EXPECT_TRUE(pgIsDirty(pgFind(PG_CONTROL_RATE_PROFILES)));
+    EXPECT_FALSE(pgIsDirty(pgFind(PG_PID_PROFILE)));
+
+    // Clearing a bit leaves the others alone
+    request = { CURRENT, CURRENT };
+    appendU16(&request, TEST_BIT);
+    request.push_back(0);
+    EXPECT_EQ(MSP_RESULT_ACK, write(request));
+    EXPECT_EQ(0x0001, testSettings()->bits);
+}
+
+TEST(MspSettingsTest, TestInvalidWriteChangesNothing)
+{
+    const bytes_t rejected[] = {
+        // out of range after a valid value
+        { CURRENT, CURRENT, TEST_DIRECT, 0, 100, TEST_DIRECT, 0, 201 },
+        { CURRENT, CURRENT, TEST_DIRECT, 0, 100, TEST_SIGNED, 0, 0xf5, 0x01 },
+        { CURRENT, CURRENT, TEST_DIRECT, 0, 100, TEST_LOOKUP, 0, 2 },
+        { CURRENT, CURRENT, TEST_DIRECT, 0, 100, TEST_BIT, 0, 2 },
+        // truncated value or id
+        { CURRENT, CURRENT, TEST_DIRECT, 0, 100, TEST_WIDE, 0, 0x88, 0x13 },
+        { CURRENT, CURRENT, TEST_DIRECT, 0, 100, TEST_DIRECT },
+        // unknown setting or profile
+        { CURRENT, CURRENT, TEST_DIRECT, 0, 100, (uint8_t)valueTableEntryCount, 0, 1 },
+        { CURRENT, CONTROL_RATE_PROFILE_COUNT, TEST_DIRECT, 0, 100 },
+        { CURRENT },
+    };
+
+    for (const bytes_t &request : rejected) {
+        resetSettings();
+        testSettingsMutable()->direct = 50;
+
+        EXPECT_EQ(MSP_RESULT_ERROR, write(request));
+        EXPECT_EQ(50, testSettings()->direct);
+    }
+}
+
+TEST(MspSettingsTest, TestReadWriteRoundTrip)
+{
+    resetSettings();
+    testSettingsMutable()->direct = 33;
+    testSettingsMutable()->signedValue = -1;
+    testSettingsMutable()->array[2] = -7;
+    testSettingsMutable()->wide = 4999;
+    pidProfilesMutable(0)->pid[PID_PITCH].P = 55;
+    controlRateProfilesMutable(0)->rcRates[FD_ROLL] = 20;
+
+    bytes_t request = { CURRENT, CURRENT };
+    for (int id = 0; id < valueTableEntryCount; id++) {
+        appendU16(&request, id);
+    }
+    bytes_t values;
+    EXPECT_EQ(MSP_RESULT_ACK, read(request, &values));
+    const testSettings_t saved = *testSettings();
+
+    // Write back what was read, in the write format
+    resetSettings();
+    bytes_t writeRequest = { CURRENT, CURRENT };
+    const int sizes[] = { 1, 2, 1, 1, 3, 4, 1, 1 };
+    unsigned offset = 2;
+    for (int id = 0; id < valueTableEntryCount; id++) {
+        appendU16(&writeRequest, id);
+        writeRequest.insert(writeRequest.end(), values.begin() + offset, values.begin() + offset + sizes[id]);
+        offset += sizes[id];
+    }
+    EXPECT_EQ(values.size(), offset);
+
+    EXPECT_EQ(MSP_RESULT_ACK, write(writeRequest));
+    EXPECT_EQ(0, memcmp(&saved, testSettings(), sizeof(saved)));
+    EXPECT_EQ(55, pidProfiles(0)->pid[PID_PITCH].P);
+    EXPECT_EQ(20, controlRateProfiles(0)->rcRates[FD_ROLL]);
+}
+
+TEST(MspSettingsTest, TestSchemaPagesMatchHash)
+{
+    uint8_t info[6];
+    sbuf_t dst;
+    sbufInit(&dst, info, info + sizeof(info));
+    mspSettingsSerializeInfo(&dst);
+
+    EXPECT_EQ(valueTableEntryCount, info[0] | info[1] << 8);
+    const uint32_t hash = info[2] | info[3] << 8 | info[4] << 16 | (uint32_t)info[5] << 24;
+    EXPECT_EQ(mspSettingsSchemaHash(), hash);
+
+    // A client with a small buffer reads the schema a page at a time and hashes the entries
+    uint32_t clientHash = FNV1A_OFFSET_BASIS;
+    uint16_t nextId = 0;
+    int pages = 0;
+    bool sawLookupNames = false;
+    while (nextId < valueTableEntryCount) {
+        uint8_t request[2] = { (uint8_t)(nextId & 0xff), (uint8_t)(nextId >> 8) };
+        uint8_t reply[40];
+        sbuf_t src;
+        sbufInit(&src, request, request + sizeof(request));
+        sbufInit(&dst, reply, reply + sizeof(reply));
+
+        EXPECT_EQ(MSP_RESULT_ACK, mspSettingsSerializeSchema(&dst, &src));
+        EXPECT_EQ(nextId, reply[0] | reply[1] << 8);
+        const uint8_t entries = reply[2];
+        ASSERT_GT(entries, 0);
+
+        clientHash = fnv1a_update(clientHash, &reply[3], sbufPtr(&dst) - &reply[3]);
+        sawLookupNames |= memmem(reply, sbufPtr(&dst) - reply, "\x03OFF\x02ON", 7) != NULL;
+
+        nextId += entries;
+        pages++;
+    }
+
+    EXPECT_GT(pages, 1);
+    EXPECT_EQ(hash, clientHash);
+    EXPECT_TRUE(sawLookupNames);
+}
+
+TEST(MspSettingsTest, TestSchemaEntry)
+{
+    const uint8_t request[2] = { TEST_SIGNED, 0 };
+    uint8_t reply[64];
+    sbuf_t src;
+    sbuf_t dst;
+    sbufInit(&src, (uint8_t *)request, (uint8_t *)request + sizeof(request));
+    sbufInit(&dst, reply, reply + 3 + 12 + sizeof("test_signed") - 1 + 1);
+
+    EXPECT_EQ(MSP_RESULT_ACK, mspSettingsSerializeSchema(&dst, &src));
+
+    const bytes_t expected = {
+        TEST_SIGNED, 0, 1,
+        VAR_INT16 | MASTER_VALUE, 1, 0x0c, 0xfe, 0xff, 0xff, 0xf4, 0x01, 0x00, 0x00,
+        11, 't', 'e', 's', 't', '_', 's', 'i', 'g', 'n', 'e', 'd', 0,
+    };
+    EXPECT_EQ(expected, bytes_t(reply, sbufPtr(&dst)));
+}
+
+// STUBS
+
+extern "C" {
+
+uint8_t getCurrentPidProfileIndex(void)
+{
+    return currentPidProfileIndex;
+}
+
+uint8_t getCurrentControlRateProfileIndex(void)
+{
+    return currentRateProfileIndex;
+}
+
+}
@@ -34,6 +34,7 @@ extern "C" {
 
     #include "common/time.h"
 
+    #include "drivers/max7456_stream.h"
     #include "drivers/max7456_symbols.h"
     #include "drivers/serial.h"
 
@@ -47,6 +48,7 @@ extern "C" {
     #include "flight/imu.h"
 
     #include "io/beeper.h"
+    #include "io/displayport_sim.h"
     #include "io/gps.h"
     #include "io/osd.h"
 
@@ -883,6 +885,261 @@ TEST(OsdTest, TestElementWarningsBattery)
     // TODO
 }
 
+/*
+ * Tests that only elements whose text changed are written again.
+ */
+TEST(OsdTest, TestIncrementalRedraw)
+{
+    // given
+    osdConfigMutable()->item_pos[OSD_RSSI_VALUE] = OSD_POS(8, 14) | VISIBLE_FLAG;
+    osdConfigMutable()->rssi_alarm = 0;
+    rssi = 1024;
+    osdRefresh(simulationTime);
+
+    // when
+    testDisplayPortCharsWritten = 0;
+    osdRefresh(simulationTime);
+
+    // then
+    EXPECT_EQ(0, testDisplayPortCharsWritten);
+    displayPortTestBufferSubstring(8, 14, "%c99", SYM_RSSI);
+
+    // when
+    rssi = 512;
+    testDisplayPortCharsWritten = 0;
+    osdRefresh(simulationTime);
+
+    // then
+    EXPECT_EQ(3, testDisplayPortCharsWritten);
+    displayPortTestBufferSubstring(8, 14, "%c50", SYM_RSSI);
+
+    // when
+    osdConfigMutable()->item_pos[OSD_RSSI_VALUE] = OSD_POS(20, 14) | VISIBLE_FLAG;
+    osdRefresh(simulationTime);
+
+    // then
+    displayPortTestBufferSubstring(8, 14, "   ");
+    displayPortTestBufferSubstring(20, 14, "%c50", SYM_RSSI);
+
+    // when
+    osdConfigMutable()->item_pos[OSD_RSSI_VALUE] = OSD_POS(20, 14);
+    osdRefresh(simulationTime);
+
+    // then
+    displayPortTestBufferSubstring(20, 14, "   ");
+}
+
+/*
+ * Characters written per refresh with every element visible, when everything is rewritten and when one value changes.
+ *
+ * Both are checked against the characters they take now, so the benchmark needs no output to show a change to either.
+ */
+TEST(OsdTest, BenchmarkRefresh)
+{
+    const int rounds = 200;
+
+    static pidProfile_t pidProfile;
+    currentPidProfile = &pidProfile;
+
+    for (int i = 0; i < OSD_ITEM_COUNT; i++) {
+        osdConfigMutable()->item_pos[i] = OSD_POS((i % 3) * 10, i / 3) | VISIBLE_FLAG;
+    }
+    // Too wide for the grid
+    osdConfigMutable()->item_pos[OSD_DEBUG] = 0;
+    osdConfigMutable()->item_pos[OSD_ARTIFICIAL_HORIZON] = 0;
+    osdConfigMutable()->item_pos[OSD_HORIZON_SIDEBARS] = 0;
+    // Settle the screen on the new layout
+    rssi = 512;
+    osdRefresh(simulationTime);
+    osdRefresh(simulationTime);
+
+    // Every element rewritten, as each refresh did before
+    for (int round = 0; round < rounds; round++) {
+        simulationTime += 2e6;
+        testDisplayPortCharsWritten = 0;
+        osdRefresh(simulationTime);
+
+        EXPECT_EQ(204, testDisplayPortCharsWritten);
+    }
+
+    // One value changing per refresh, only its characters are written
+    for (int round = 0; round < rounds; round++) {
+        rssi = round % 2 ? 512 : 256;
+        testDisplayPortCharsWritten = 0;
+        osdRefresh(simulationTime);
+
+        EXPECT_EQ(3, testDisplayPortCharsWritten);
+    }
+}
+
+static void simDisplayPortDrawAll(displayPort_t *displayPort)
+{
+    while (!displayIsSynced(displayPort)) {
+        displayDrawScreen(displayPort);
+    }
+}
+
+/*
+ * Tests that the OSD reaches the virtual display, and that only changes are sent.
+ */
+TEST(OsdTest, TestSimDisplayPort)
+{
+    // given
+    displayPort_t *displayPort = displayPortSimInit(DISPLAYPORT_SIM_TRANSPORT_MAX7456, 16, 30);
+
+    // when
+    osdInit(displayPort);
+
+    // then
+    // the splash screen fits a transfer
+    EXPECT_FALSE(displayIsSynced(displayPort));
+    simDisplayPortDrawAll(displayPort);
+    EXPECT_LE(displayPortSimGetStats()->maxFrameBytes, (uint32_t)MAX7456_STREAM_SIZE);
+
+    char frame[16 * 31 + 1];
+    EXPECT_EQ(16u * 31, displayPortSimDumpFrame(frame, sizeof(frame)));
+    EXPECT_NE(nullptr, strstr(frame, "MENU:THR MID"));
+
+    // given
+    for (int i = 0; i < OSD_ITEM_COUNT; i++) {
+        osdConfigMutable()->item_pos[i] = 0;
+    }
+    osdConfigMutable()->item_pos[OSD_RSSI_VALUE] = OSD_POS(8, 14) | VISIBLE_FLAG;
+    rssi = 1024;
+
+    // when
+    // splash screen timeout has elapsed
+    simulationTime += 4e6;
+    osdRefresh(simulationTime);
+    simDisplayPortDrawAll(displayPort);
+
+    // then
+    EXPECT_EQ(' ', displayPortSimGetChar(7, 8));
+    EXPECT_EQ(SYM_RSSI, displayPortSimGetChar(8, 14));
+    EXPECT_EQ('9', displayPortSimGetChar(9, 14));
+    EXPECT_EQ('9', displayPortSimGetChar(10, 14));
+
+    // when
+    displayPortSimResetStats();
+    // Settle the screen on the new layout
+    rssi = 512;
+    osdRefresh(simulationTime);
+    osdRefresh(simulationTime);
+    displayDrawScreen(displayPort);
+
+    // then
+    // the two digits as one run, entering and leaving auto-increment mode, the address and a data write each
+    EXPECT_EQ(2u, displayPortSimGetStats()->charsSent);
+    EXPECT_EQ(14u, displayPortSimGetStats()->bytesSent);
+    EXPECT_EQ('5', displayPortSimGetChar(9, 14));
+    EXPECT_EQ('0', displayPortSimGetChar(10, 14));
+}
+
+typedef struct simLayout_s {
+    const char *name;
+    bool horizon;
+    bool grid;
+} simLayout_t;
+
+static void simLayoutApply(const simLayout_t *layout)
+{
+    for (int i = 0; i < OSD_ITEM_COUNT; i++) {
+        osdConfigMutable()->item_pos[i] = layout->grid ? OSD_POS((i % 3) * 10, i / 3) | VISIBLE_FLAG : 0;
+    }
+    if (layout->grid) {
+        osdConfigMutable()->item_pos[OSD_DEBUG] = 0;
+        osdConfigMutable()->item_pos[OSD_ARTIFICIAL_HORIZON] = 0;
+        osdConfigMutable()->item_pos[OSD_HORIZON_SIDEBARS] = 0;
+        return;
+    }
+
+    osdConfigMutable()->item_pos[OSD_RSSI_VALUE] = OSD_POS(8, 1) | VISIBLE_FLAG;
+    osdConfigMutable()->item_pos[OSD_MAIN_BATT_VOLTAGE] = OSD_POS(12, 1) | VISIBLE_FLAG;
+    osdConfigMutable()->item_pos[OSD_ITEM_TIMER_2] = OSD_POS(1, 1) | VISIBLE_FLAG;
+    osdConfigMutable()->item_pos[OSD_FLYMODE] = OSD_POS(13, 10) | VISIBLE_FLAG;
+    osdConfigMutable()->item_pos[OSD_WARNINGS] = OSD_POS(9, 10) | VISIBLE_FLAG;
+    osdConfigMutable()->item_pos[OSD_CROSSHAIRS] = OSD_POS(13, 6) | VISIBLE_FLAG;
+    if (layout->horizon) {
+        osdConfigMutable()->item_pos[OSD_ARTIFICIAL_HORIZON] = OSD_POS(14, 2) | VISIBLE_FLAG;
+        osdConfigMutable()->item_pos[OSD_HORIZON_SIDEBARS] = OSD_POS(14, 6) | VISIBLE_FLAG;
+    }
+}
+
+/*
+ * Bytes on the wire per refresh for each transport and element layout, with the RSSI changing and the craft rolling.
+ *
+ * Each is checked against a budget about 10% over what it takes now, so the benchmark needs no output to show a
+ * change to the incremental drawing sending more than it used to.
+ */
+TEST(OsdTest, BenchmarkSimTransports)
+{
+    const int rounds = 100;
+    // a refresh every 10 calls of osdUpdate at 60Hz
+    const int ticksPerRefresh = 10;
+    const timeUs_t tickUs = 16667;
+    static const simLayout_t layouts[] = {
+        { "minimal", false, false },
+        { "horizon", true, false },
+        { "grid", false, true },
+    };
+    static const uint32_t byteBudgets[DISPLAYPORT_SIM_TRANSPORT_COUNT][ARRAYLEN(layouts)] = {
+        { 32, 64, 84 },     // MAX7456
+        { 37, 64, 80 },     // MSP
+        { 46, 128, 176 },   // CRSF
+    };
+
+    static pidProfile_t pidProfile;
+    currentPidProfile = &pidProfile;
+    sensorsSet(SENSOR_ACC);
+    osdConfigMutable()->ahMaxPitch = 20;
+    osdConfigMutable()->ahMaxRoll = 40;
+
+    uint32_t bytes[DISPLAYPORT_SIM_TRANSPORT_COUNT][ARRAYLEN(layouts)];
+
+    for (int transport = 0; transport < DISPLAYPORT_SIM_TRANSPORT_COUNT; transport++) {
+        for (unsigned l = 0; l < ARRAYLEN(layouts); l++) {
+            displayPort_t *displayPort = displayPortSimInit((displayPortSimTransport_e)transport, 16, 30);
+            osdInit(displayPort);
+            simLayoutApply(&layouts[l]);
+            simulationTime += 4e6;
+            osdRefresh(simulationTime);
+            simDisplayPortDrawAll(displayPort);
+            displayPortSimResetStats();
+
+            for (int round = 0; round < rounds * ticksPerRefresh; round++) {
+                if (round % ticksPerRefresh == 0) {
+                    rssi = round % (2 * ticksPerRefresh) ? 512 : 256;
+                    attitude.values.roll = (round / ticksPerRefresh % 30) * 10;
+                }
+                simulationTime += tickUs;
+                osdUpdate(simulationTime);
+            }
+            simDisplayPortDrawAll(displayPort);
+
+            const displayPortSimStats_t *stats = displayPortSimGetStats();
+            bytes[transport][l] = stats->bytesSent / rounds;
+
+            EXPECT_GT(bytes[transport][l], 0u);
+            EXPECT_LE(bytes[transport][l], byteBudgets[transport][l]) << displayPortSimTransportName((displayPortSimTransport_e)transport) << " " << layouts[l].name;
+            // a refresh for each frame, and only what changed is sent, except by CRSF which sends whole rows
+            EXPECT_EQ((uint32_t)rounds, stats->frames);
+            if (transport != DISPLAYPORT_SIM_TRANSPORT_CRSF) {
+                EXPECT_LT(stats->charsSent, stats->charsWritten);
+            }
+            if (transport == DISPLAYPORT_SIM_TRANSPORT_MAX7456) {
+                EXPECT_LE(stats->maxFrameBytes, (uint32_t)MAX7456_STREAM_SIZE);
+            }
+        }
+
+        // the horizon moves with every refresh
+        EXPECT_GT(bytes[transport][1], bytes[transport][0]);
+    }
+
+    attitude.values.roll = 0;
+    sensorsClear(SENSOR_ACC);
+    osdInit(displayPortTestInit());
+}
+
 /*
  * Tests the time string formatting function with a series of precision settings and time values.
  */
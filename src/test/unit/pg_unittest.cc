@@ -39,6 +39,15 @@ PG_RESET_TEMPLATE(motorConfig_t, motorConfig,
     .mincommand = 1000,
     .dev = {.motorPwmRate = 400}
 );
+
+typedef struct testConfig_s {
+    uint32_t value;
+} testConfig_t;
+
+// PGNs that are a multiple of 256 apart, to check that they don't end up in the same hash slot
+PG_REGISTER(testConfig_t, testConfig1, PG_RESERVED_FOR_TESTING_1, 0);
+PG_REGISTER(testConfig_t, testConfig2, PG_RESERVED_FOR_TESTING_1 - 256, 0);
+PG_REGISTER(testConfig_t, testConfig3, PG_RESERVED_FOR_TESTING_1 - 512, 0);
 }
 
 
@@ -83,6 +92,64 @@ TEST(ParameterGroupsfTest, Test_pgFind)
     EXPECT_EQ(400, motorConfig3.dev.motorPwmRate);
 }
 
+TEST(ParameterGroupsfTest, Test_pgFindEveryGroup)
+{
+    EXPECT_EQ(4, PG_REGISTRY_SIZE);
+
+    PG_FOREACH(reg) {
+        EXPECT_EQ(reg, pgFind(pgN(reg)));
+        EXPECT_EQ(reg, &__pg_registry_start[pgIndex(reg)]);
+    }
+
+    EXPECT_EQ(NULL, pgFind(PG_RESERVED_FOR_TESTING_2));
+    EXPECT_EQ(NULL, pgFind(PG_RESERVED_FOR_TESTING_1 - 768));
+}
+
+TEST(ParameterGroupsfTest, Test_pgDirty)
+{
+    const pgRegistry_t *motorRegistry = pgFind(PG_MOTOR_CONFIG);
+    const pgRegistry_t *testRegistry = pgFind(PG_RESERVED_FOR_TESTING_1);
+
+    pgMarkAllClean();
+    PG_FOREACH(reg) {
+        EXPECT_FALSE(pgIsDirty(reg));
+    }
+
+    pgMarkDirty(motorRegistry);
+    EXPECT_TRUE(pgIsDirty(motorRegistry));
+    EXPECT_FALSE(pgIsDirty(testRegistry));
+
+    pgMarkClean(motorRegistry);
+    EXPECT_FALSE(pgIsDirty(motorRegistry));
+
+    // Resetting or loading a group changes it
+    pgReset(testRegistry);
+    EXPECT_TRUE(pgIsDirty(testRegistry));
+
+    pgMarkAllClean();
+    const testConfig_t stored = { 1234 };
+    EXPECT_TRUE(pgLoad(testRegistry, &stored, sizeof(stored), 0));
+    EXPECT_TRUE(pgIsDirty(testRegistry));
+}
+
+TEST(ParameterGroupsfTest, Test_pgDirtyOutsideRegistry)
+{
+    pgMarkAllClean();
+
+    // nothing is written outside of the dirty bits
+    pgMarkDirty(NULL);
+    pgMarkClean(NULL);
+    EXPECT_FALSE(pgIsDirty(NULL));
+
+    const pgRegistry_t *beforeRegistry = __pg_registry_start - 1;
+    pgMarkDirty(beforeRegistry);
+    EXPECT_FALSE(pgIsDirty(beforeRegistry));
+
+    PG_FOREACH(reg) {
+        EXPECT_FALSE(pgIsDirty(reg));
+    }
+}
+
 // STUBS
 
 extern "C" {
@@ -191,9 +191,10 @@ TEST_F(RcControlsModesTest, updateActivatedModesUsingValidAuxConfigurationAndRXV
 
 enum {
     COUNTER_QUEUE_CONFIRMATION_BEEP,
-    COUNTER_CHANGE_CONTROL_RATE_PROFILE
+    COUNTER_CHANGE_CONTROL_RATE_PROFILE,
+    COUNTER_WRITE_CONFIG_CHANGES
 };
-#define CALL_COUNT_ITEM_COUNT 2
+#define CALL_COUNT_ITEM_COUNT 3
 
 static int callCounts[CALL_COUNT_ITEM_COUNT];
 
@@ -516,6 +517,44 @@ TEST_F(RcControlsAdjustmentsTest, processRcRateProfileAdjustments)
     EXPECT_EQ(adjustmentStateMask, expectedAdjustmentStateMask);
 }
 
+TEST_F(RcControlsAdjustmentsTest, processRcAdjustmentsSavedOnlyWhenDisarmed)
+{
+    // given
+    systemConfigMutable()->inflightAdjustmentSave = true;
+    configureAdjustment(0, AUX3 - NON_AUX_CHANNEL_COUNT, &rateAdjustmentConfig);
+
+    // and
+    for (int index = AUX1; index < MAX_SUPPORTED_RC_CHANNEL_COUNT; index++) {
+        rcData[index] = PWM_RANGE_MIDDLE;
+    }
+
+    // and
+    resetCallCounters();
+    resetMillis();
+    ENABLE_ARMING_FLAG(ARMED);
+
+    // when
+    rcData[AUX3] = PWM_RANGE_MAX;
+    processRcAdjustments(&controlRateConfig);
+    rcData[AUX3] = PWM_RANGE_MIDDLE;
+    fixedMillis = 10000;
+    processRcAdjustments(&controlRateConfig);
+
+    // then
+    EXPECT_EQ(controlRateConfig.rcRates[FD_ROLL], 91);
+    EXPECT_EQ(CALL_COUNTER(COUNTER_WRITE_CONFIG_CHANGES), 0);
+
+    // when
+    DISABLE_ARMING_FLAG(ARMED);
+    processRcAdjustments(&controlRateConfig);
+    processRcAdjustments(&controlRateConfig);
+
+    // then
+    EXPECT_EQ(CALL_COUNTER(COUNTER_WRITE_CONFIG_CHANGES), 1);
+
+    systemConfigMutable()->inflightAdjustmentSave = false;
+}
+
 static const adjustmentConfig_t pidPitchAndRollPAdjustmentConfig = {
     .adjustmentFunction = ADJUSTMENT_PITCH_ROLL_P,
     .mode = ADJUSTMENT_MODE_STEP,
@@ -699,6 +738,11 @@ TEST_F(RcControlsAdjustmentsTest, processPIDIncreasePidController2)
 
 extern "C" {
 void saveConfigAndNotify(void) {}
+bool writeConfigChangesToEEPROM(void)
+{
+    callCounts[COUNTER_WRITE_CONFIG_CHANGES]++;
+    return true;
+}
 void initRcProcessing(void) {}
 void changePidProfile(uint8_t) {}
 void pidInitConfig(const pidProfile_t *) {}
@@ -0,0 +1,147 @@
+/*
+ * This file is part of Cleanflight.
+ *
+ * Cleanflight is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Cleanflight is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cleanflight.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+extern "C" {
+    #include "common/rle.h"
+}
+
+#include "unittest_macros.h"
+#include "gtest/gtest.h"
+
+#define BUF_LEN 1024
+
+static uint8_t inBuf[BUF_LEN];
+static uint8_t encodedBuf[BUF_LEN * 2];
+static uint8_t decodedBuf[BUF_LEN];
+
+/*
+ * PackBits decoder, as the client would implement it.
+ */
+static int rleDecodeBuf(uint8_t *outBuf, int outBufLen, const uint8_t *inBuf, int inLen)
+{
+    int outLen = 0;
+    int pos = 0;
+
+    while (pos < inLen) {
+        const uint8_t control = inBuf[pos++];
+
+        if (control < 128) {
+            const int literalLen = control + 1;
+            if (pos + literalLen > inLen || outLen + literalLen > outBufLen) {
+                return -1;
+            }
+            memcpy(outBuf + outLen, inBuf + pos, literalLen);
+            pos += literalLen;
+            outLen += literalLen;
+        } else if (control > 128) {
+            const int repeatLen = 257 - control;
+            if (pos >= inLen || outLen + repeatLen > outBufLen) {
+                return -1;
+            }
+            memset(outBuf + outLen, inBuf[pos++], repeatLen);
+            outLen += repeatLen;
+        }
+    }
+
+    return outLen;
+}
+
+static int encodeAndCheckRoundTrip(int len)
+{
+    const int encodedLen = rleEncodeBuf(encodedBuf, sizeof(encodedBuf), inBuf, len);
+
+    EXPECT_EQ(encodedLen, rleEncodeBuf(NULL, 0, inBuf, len));
+
+    EXPECT_EQ(len, rleDecodeBuf(decodedBuf, sizeof(decodedBuf), encodedBuf, encodedLen));
+    EXPECT_EQ(0, memcmp(inBuf, decodedBuf, len));
+
+    return encodedLen;
+}
+
+TEST(RleUnittest, TestEmpty)
+{
+    EXPECT_EQ(0, rleEncodeBuf(encodedBuf, sizeof(encodedBuf), inBuf, 0));
+}
+
+TEST(RleUnittest, TestLiterals)
+{
+    const uint8_t data[] = {1, 2, 3, 3, 4};
+    memcpy(inBuf, data, sizeof(data));
+
+    // Pairs aren't worth a repeat packet
+    EXPECT_EQ(6, encodeAndCheckRoundTrip(sizeof(data)));
+    EXPECT_EQ(4, encodedBuf[0]);
+    EXPECT_EQ(0, memcmp(encodedBuf + 1, data, sizeof(data)));
+}
+
+TEST(RleUnittest, TestRepeats)
+{
+    const uint8_t data[] = {7, 0xFF, 0xFF, 0xFF, 0xFF, 8};
+    memcpy(inBuf, data, sizeof(data));
+
+    EXPECT_EQ(6, encodeAndCheckRoundTrip(sizeof(data)));
+    EXPECT_EQ(0, encodedBuf[0]);
+    EXPECT_EQ(7, encodedBuf[1]);
+    EXPECT_EQ(257 - 4, encodedBuf[2]);
+    EXPECT_EQ(0xFF, encodedBuf[3]);
+    EXPECT_EQ(0, encodedBuf[4]);
+    EXPECT_EQ(8, encodedBuf[5]);
+}
+
+TEST(RleUnittest, TestLongRunsAreSplit)
+{
+    // Erased flash
+    memset(inBuf, 0xFF, BUF_LEN);
+    EXPECT_EQ(BUF_LEN / RLE_MAX_PACKET_LENGTH * 2, encodeAndCheckRoundTrip(BUF_LEN));
+
+    // A run one longer than a packet leaves a single literal
+    memset(inBuf, 0, RLE_MAX_PACKET_LENGTH + 1);
+    EXPECT_EQ(4, encodeAndCheckRoundTrip(RLE_MAX_PACKET_LENGTH + 1));
+
+    // Literals that don't fit in one packet
+    for (int i = 0; i < BUF_LEN; i++) {
+        inBuf[i] = i;
+    }
+    EXPECT_EQ(BUF_LEN + BUF_LEN / RLE_MAX_PACKET_LENGTH, encodeAndCheckRoundTrip(BUF_LEN));
+}
+
+TEST(RleUnittest, TestMixedContent)
+{
+    // Something like a log which stops partway through the flash page
+    for (int i = 0; i < BUF_LEN; i++) {
+        inBuf[i] = i < 700 ? (i * 7) % 5 : 0xFF;
+    }
+
+    const int encodedLen = encodeAndCheckRoundTrip(BUF_LEN);
+    EXPECT_LT(encodedLen, BUF_LEN);
+}
+
+TEST(RleUnittest, TestOverflow)
+{
+    for (int i = 0; i < 64; i++) {
+        inBuf[i] = i;
+    }
+
+    EXPECT_EQ(65, rleEncodeBuf(encodedBuf, 65, inBuf, 64));
+    EXPECT_EQ(-1, rleEncodeBuf(encodedBuf, 64, inBuf, 64));
+
+    memset(inBuf, 0xAA, 64);
+    EXPECT_EQ(-1, rleEncodeBuf(encodedBuf, 1, inBuf, 64));
+}
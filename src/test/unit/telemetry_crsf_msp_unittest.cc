@@ -55,6 +55,7 @@ extern "C" {
     #include "rx/rx.h"
     #include "rx/crsf.h"
 
+    #include "sensors/barometer.h"
     #include "sensors/battery.h"
     #include "sensors/sensors.h"
 
@@ -252,6 +253,7 @@ extern "C" {
 
     gpsSolutionData_t gpsSol;
     attitudeEulerAngles_t attitude = { { 0, 0, 0 } };
+    baro_t baro;
 
     uint32_t micros(void) {return dummyTimeUs;}
     serialPort_t *openSerialPort(serialPortIdentifier_e, serialPortFunction_e, serialReceiveCallbackPtr, void *, uint32_t, portMode_e, portOptions_e) {return NULL;}
@@ -263,6 +265,7 @@ extern "C" {
     uint16_t getBatteryAverageCellVoltage(void) {
         return 0;
     }
+    int16_t getEstimatedVario(void) { return 0; }
     bool isAmperageConfigured(void) { return true; }
     int32_t getAmperage(void) {
         return testAmperage;
@@ -53,6 +53,7 @@ extern "C" {
     #include "rx/rx.h"
     #include "rx/crsf.h"
 
+    #include "sensors/barometer.h"
     #include "sensors/battery.h"
     #include "sensors/sensors.h"
     #include "sensors/acceleration.h"
@@ -66,6 +67,9 @@ extern "C" {
     uint16_t testBatteryVoltage = 0;
     int32_t testAmperage = 0;
     int32_t testmAhDrawn = 0;
+    int16_t testVario = 0;
+
+    int crsfTelemetryBatch(uint8_t *batch, int size, timeUs_t currentTimeUs);
 
     serialPort_t *telemetrySharedPort;
     PG_REGISTER(batteryConfig_t, batteryConfig, PG_BATTERY_CONFIG, 0);
@@ -273,6 +277,116 @@ TEST(TelemetryCrsfTest, TestFlightMode)
     EXPECT_EQ(crfsCrc(frame, frameLen), frame[7]);
 }
 
+TEST(TelemetryCrsfTest, TestVario)
+{
+    uint8_t frame[CRSF_FRAME_SIZE_MAX];
+
+    testVario = -125; // cm/s
+    int frameLen = getCrsfFrame(frame, CRSF_FRAMETYPE_VARIO_SENSOR);
+    EXPECT_EQ(CRSF_FRAME_VARIO_SENSOR_PAYLOAD_SIZE + FRAME_HEADER_FOOTER_LEN, frameLen);
+    EXPECT_EQ(CRSF_SYNC_BYTE, frame[0]); // address
+    EXPECT_EQ(4, frame[1]); // length
+    EXPECT_EQ(0x07, frame[2]); // type
+    int16_t vario = frame[3] << 8 | frame[4];
+    EXPECT_EQ(-125, vario);
+    EXPECT_EQ(crfsCrc(frame, frameLen), frame[5]);
+}
+
+TEST(TelemetryCrsfTest, TestTemperature)
+{
+    uint8_t frame[CRSF_FRAME_SIZE_MAX];
+
+    sensorsSet(SENSOR_BARO);
+    baro.baroTemperature = 2345; // 23.45 degrees
+    int frameLen = getCrsfFrame(frame, CRSF_FRAMETYPE_TEMP);
+    EXPECT_EQ(3 + FRAME_HEADER_FOOTER_LEN, frameLen);
+    EXPECT_EQ(CRSF_SYNC_BYTE, frame[0]); // address
+    EXPECT_EQ(5, frame[1]); // length
+    EXPECT_EQ(0x0D, frame[2]); // type
+    EXPECT_EQ(0, frame[3]); // source id
+    int16_t temperature = frame[4] << 8 | frame[5];
+    EXPECT_EQ(234, temperature);
+    EXPECT_EQ(crfsCrc(frame, frameLen), frame[6]);
+
+    sensorsClear(SENSOR_BARO);
+}
+
+// Checks each frame of a batch and returns how many there are
+static int checkBatch(uint8_t *batch, int length, uint8_t *types)
+{
+    int frames = 0;
+    int pos = 0;
+    while (pos < length) {
+        EXPECT_EQ(CRSF_SYNC_BYTE, batch[pos]);
+        const int frameLen = batch[pos + 1] + 2;
+        EXPECT_LE(pos + frameLen, length);
+        EXPECT_EQ(crfsCrc(&batch[pos], frameLen), batch[pos + frameLen - 1]);
+        if (types) {
+            types[frames] = batch[pos + 2];
+        }
+        frames++;
+        pos += frameLen;
+    }
+    EXPECT_EQ(length, pos);
+    return frames;
+}
+
+TEST(TelemetryCrsfTest, TestBatchedFrames)
+{
+    uint8_t batch[CRSF_TELEMETRY_BATCH_SIZE];
+    uint8_t types[CRSF_TELEMETRY_BATCH_SIZE];
+
+    sensorsSet(SENSOR_ACC | SENSOR_BARO);
+    initCrsfTelemetry();
+
+    // all due at once go together: attitude, battery, flight mode, GPS, vario and temperature
+    int length = crsfTelemetryBatch(batch, sizeof(batch), 0);
+    EXPECT_EQ(6, checkBatch(batch, length, types));
+    EXPECT_EQ(CRSF_FRAMETYPE_ATTITUDE, types[0]);
+    EXPECT_EQ(CRSF_FRAMETYPE_BATTERY_SENSOR, types[1]);
+
+    // nothing more is due
+    EXPECT_EQ(0, crsfTelemetryBatch(batch, sizeof(batch), 0));
+
+    // a small window only takes what fits
+    initCrsfTelemetry();
+    length = crsfTelemetryBatch(batch, 20, 0);
+    EXPECT_LE(length, 20);
+    EXPECT_EQ(2, checkBatch(batch, length, types));
+    EXPECT_EQ(CRSF_FRAMETYPE_ATTITUDE, types[0]);
+    EXPECT_EQ(CRSF_FRAMETYPE_FLIGHT_MODE, types[1]);
+
+    sensorsClear(SENSOR_ACC | SENSOR_BARO);
+}
+
+TEST(TelemetryCrsfTest, TestBatchesKeepLinkBudget)
+{
+    uint8_t batch[CRSF_TELEMETRY_BATCH_SIZE];
+
+    sensorsSet(SENSOR_ACC | SENSOR_BARO);
+    initCrsfTelemetry();
+
+    // at the 150Hz RF mode, a telemetry task at 250Hz
+    int frames = 0;
+    int bytes = 0;
+    int batches = 0;
+    for (timeUs_t t = 0; t < 1000000; t += 4000) {
+        const int length = crsfTelemetryBatch(batch, sizeof(batch), t);
+        frames += checkBatch(batch, length, NULL);
+        bytes += length;
+        batches += length ? 1 : 0;
+    }
+
+    // every frame at its rate, 15 + 10 + 5 + 10 + 10 + 2
+    EXPECT_GE(frames, 52 - 6);
+    EXPECT_LE(frames, 52 + 6);
+    // within the share of the link, and its first burst
+    EXPECT_LE(bytes, 1000000 * 8 / 6667 + CRSF_TELEMETRY_BATCH_SIZE);
+    EXPECT_LT(batches, frames);
+
+    sensorsClear(SENSOR_ACC | SENSOR_BARO);
+}
+
 // STUBS
 
 extern "C" {
@@ -288,6 +402,7 @@ attitudeEulerAngles_t attitude = { { 0, 0, 0 } };     // absolute angle inclinat
 
 uint16_t GPS_distanceToHome;        // distance to home point in meters
 gpsSolutionData_t gpsSol;
+baro_t baro;
 
 void beeperConfirmationBeeps(uint8_t beepCount) {UNUSED(beepCount);}
 
@@ -342,6 +457,10 @@ int32_t getMAhDrawn(void){
   return testmAhDrawn;
 }
 
+int16_t getEstimatedVario(void) {
+    return testVario;
+}
+
 bool sendMspReply(uint8_t, mspResponseFnPtr) { return false; }
 bool handleMspFrame(uint8_t *, int)  { return false; }
 void crsfScheduleMspResponse(void) {};
@@ -0,0 +1,386 @@
+/*
+ * This file is part of Cleanflight and Betaflight.
+ *
+ * Cleanflight and Betaflight are free software. You can redistribute
+ * this software and/or modify this software under the terms of the
+ * GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Cleanflight and Betaflight are distributed in the hope that they
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software.
+ *
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <vector>
+
+extern "C" {
+    #include "platform.h"
+
+    #include "common/axis.h"
+    #include "common/time.h"
+
+    #include "pg/pg.h"
+    #include "pg/pg_ids.h"
+
+    #include "drivers/serial.h"
+
+    #include "fc/runtime_config.h"
+
+    #include "flight/failsafe.h"
+    #include "flight/imu.h"
+    #include "flight/mixer.h"
+
+    #include "io/gps.h"
+    #include "io/serial.h"
+
+    #include "rx/rx.h"
+
+    #include "sensors/battery.h"
+    #include "sensors/sensors.h"
+
+    #include "telemetry/mavlink.h"
+    #include "telemetry/telemetry.h"
+
+    #include "common/mavlink.h"
+
+    PG_REGISTER(telemetryConfig_t, telemetryConfig, PG_TELEMETRY_CONFIG, 0);
+    PG_REGISTER(mixerConfig_t, mixerConfig, PG_MIXER_CONFIG, 0);
+
+    timeUs_t testTimeUs = 0;
+}
+
+#include "unittest_macros.h"
+#include "gtest/gtest.h"
+
+// Who the ground station is, and who it talks to
+#define TEST_GCS_SYSTEM_ID 255
+#define TEST_GCS_COMPONENT_ID 190
+#define TEST_FC_COMPONENT_ID 200
+
+#define TEST_CALL_INTERVAL_US 10000 // the telemetry task runs at 100Hz
+#define TEST_SECONDS 10
+
+#ifndef MAV_CMD_SET_MESSAGE_INTERVAL
+#define MAV_CMD_SET_MESSAGE_INTERVAL 511
+#endif
+
+static serialPort_t testPort;
+static serialPortConfig_t testPortConfig;
+
+static std::vector<uint8_t> rxData;
+static unsigned rxPos;
+
+static std::vector<uint8_t> txData;
+static unsigned txBuffered;
+static unsigned txCapacity;
+
+// What the ground station has received so far
+static unsigned txParsed;
+static int messagesReceived[256];
+static std::vector<mavlink_command_ack_t> acks;
+
+static void resetMavlink(void)
+{
+    rxData.clear();
+    rxPos = 0;
+    txData.clear();
+    txBuffered = 0;
+    txCapacity = 256;
+    txParsed = 0;
+    memset(messagesReceived, 0, sizeof(messagesReceived));
+    acks.clear();
+
+    testPortConfig.identifier = SERIAL_PORT_USART1;
+    testPortConfig.telemetry_baudrateIndex = BAUD_115200;
+
+    // reopening the port sets all the streams back to their default rates
+    initMAVLinkTelemetry();
+    freeMAVLinkTelemetryPort();
+    configureMAVLinkTelemetryPort();
+}
+
+static void sendToFc(const mavlink_message_t *msg)
+{
+    uint8_t buffer[MAVLINK_MAX_PACKET_LEN];
+    const uint16_t len = mavlink_msg_to_send_buffer(buffer, msg);
+    rxData.insert(rxData.end(), buffer, buffer + len);
+}
+
+static void requestDataStream(uint8_t targetSystem, uint8_t stream, uint16_t rateHz, bool start)
+{
+    mavlink_message_t msg;
+    mavlink_msg_request_data_stream_pack(TEST_GCS_SYSTEM_ID, TEST_GCS_COMPONENT_ID, &msg, targetSystem, TEST_FC_COMPONENT_ID, stream, rateHz, start);
+    sendToFc(&msg);
+}
+
+static void sendCommand(uint8_t targetSystem, uint16_t command, float param1, float param2)
+{
+    mavlink_message_t msg;
+    mavlink_msg_command_long_pack(TEST_GCS_SYSTEM_ID, TEST_GCS_COMPONENT_ID, &msg, targetSystem, TEST_FC_COMPONENT_ID, command, 0, param1, param2, 0, 0, 0, 0, 0);
+    sendToFc(&msg);
+}
+
+// Parses what the FC sent as the ground station would, every byte must belong to a frame with a good checksum
+static void receiveFromFc(void)
+{
+    mavlink_message_t msg;
+    mavlink_status_t status;
+    unsigned frameStart = txParsed;
+
+    for (; txParsed < txData.size(); txParsed++) {
+        if (!mavlink_parse_char(MAVLINK_COMM_1, txData[txParsed], &msg, &status)) {
+            continue;
+        }
+
+        EXPECT_EQ(frameStart + msg.len + MAVLINK_NUM_NON_PAYLOAD_BYTES - 1, txParsed);
+        frameStart = txParsed + 1;
+
+        EXPECT_EQ(0, msg.sysid);
+        EXPECT_EQ(TEST_FC_COMPONENT_ID, msg.compid);
+        messagesReceived[msg.msgid]++;
+
+        if (msg.msgid == MAVLINK_MSG_ID_COMMAND_ACK) {
+            mavlink_command_ack_t ack;
+            mavlink_msg_command_ack_decode(&msg, &ack);
+            acks.push_back(ack);
+        }
+    }
+
+    EXPECT_EQ(frameStart, txParsed);
+    EXPECT_EQ(0, status.packet_rx_drop_count);
+}
+
+// Runs the telemetry task for a while, the port drains between calls, and counts the messages sent
+static void runFor(int seconds)
+{
+    memset(messagesReceived, 0, sizeof(messagesReceived));
+
+    for (int i = 0; i < seconds * 1000000 / TEST_CALL_INTERVAL_US; i++) {
+        testTimeUs += TEST_CALL_INTERVAL_US;
+        handleMAVLinkTelemetry();
+        EXPECT_LE(txBuffered, txCapacity);
+        txBuffered = 0;
+    }
+
+    receiveFromFc();
+}
+
+static void expectRate(int rateHz, int msgId)
+{
+    EXPECT_NEAR(rateHz * TEST_SECONDS, messagesReceived[msgId], rateHz * TEST_SECONDS / 10 + 1) << "message " << msgId;
+}
+
+TEST(TelemetryMavlinkTest, TestDefaultRates)
+{
+    resetMavlink();
+
+    runFor(TEST_SECONDS);
+
+    expectRate(2, MAVLINK_MSG_ID_SYS_STATUS);
+    expectRate(5, MAVLINK_MSG_ID_RC_CHANNELS_RAW);
+    expectRate(10, MAVLINK_MSG_ID_ATTITUDE);
+    expectRate(10, MAVLINK_MSG_ID_VFR_HUD);
+    expectRate(10, MAVLINK_MSG_ID_HEARTBEAT);
+}
+
+TEST(TelemetryMavlinkTest, TestRequestDataStream)
+{
+    resetMavlink();
+
+    // attitude at 50Hz
+    requestDataStream(0, MAV_DATA_STREAM_EXTRA1, 50, true);
+    runFor(TEST_SECONDS);
+
+    EXPECT_EQ(rxData.size(), rxPos);
+    expectRate(50, MAVLINK_MSG_ID_ATTITUDE);
+    expectRate(10, MAVLINK_MSG_ID_VFR_HUD);
+
+    // stopping it
+    requestDataStream(0, MAV_DATA_STREAM_EXTRA1, 50, false);
+    runFor(TEST_SECONDS);
+
+    EXPECT_EQ(0, messagesReceived[MAVLINK_MSG_ID_ATTITUDE]);
+    expectRate(10, MAVLINK_MSG_ID_VFR_HUD);
+
+    // and all of them
+    requestDataStream(0, MAV_DATA_STREAM_ALL, 1, true);
+    runFor(TEST_SECONDS);
+
+    expectRate(1, MAVLINK_MSG_ID_SYS_STATUS);
+    expectRate(1, MAVLINK_MSG_ID_ATTITUDE);
+    expectRate(1, MAVLINK_MSG_ID_HEARTBEAT);
+
+    // streams have no answer
+    EXPECT_TRUE(acks.empty());
+}
+
+TEST(TelemetryMavlinkTest, TestSetMessageInterval)
+{
+    resetMavlink();
+
+    // attitude every 20ms, 50Hz
+    sendCommand(0, MAV_CMD_SET_MESSAGE_INTERVAL, MAVLINK_MSG_ID_ATTITUDE, 20000);
+    runFor(TEST_SECONDS);
+
+    expectRate(50, MAVLINK_MSG_ID_ATTITUDE);
+    ASSERT_EQ(1U, acks.size());
+    EXPECT_EQ(MAV_CMD_SET_MESSAGE_INTERVAL, acks[0].command);
+    EXPECT_EQ(MAV_RESULT_ACCEPTED, acks[0].result);
+
+    // -1 stops it
+    sendCommand(0, MAV_CMD_SET_MESSAGE_INTERVAL, MAVLINK_MSG_ID_ATTITUDE, -1);
+    runFor(TEST_SECONDS);
+
+    EXPECT_EQ(0, messagesReceived[MAVLINK_MSG_ID_ATTITUDE]);
+    expectRate(10, MAVLINK_MSG_ID_VFR_HUD);
+
+    // 0 is the default rate
+    sendCommand(0, MAV_CMD_SET_MESSAGE_INTERVAL, MAVLINK_MSG_ID_ATTITUDE, 0);
+    runFor(TEST_SECONDS);
+
+    expectRate(10, MAVLINK_MSG_ID_ATTITUDE);
+
+    // the heartbeat's interval sets the rate of the stream it goes in
+    sendCommand(0, MAV_CMD_SET_MESSAGE_INTERVAL, MAVLINK_MSG_ID_HEARTBEAT, 1000000);
+    runFor(TEST_SECONDS);
+
+    expectRate(1, MAVLINK_MSG_ID_HEARTBEAT);
+    expectRate(1, MAVLINK_MSG_ID_VFR_HUD);
+
+    // a message we don't send is denied
+    sendCommand(0, MAV_CMD_SET_MESSAGE_INTERVAL, MAVLINK_MSG_ID_SCALED_PRESSURE, 20000);
+    runFor(1);
+
+    ASSERT_EQ(5U, acks.size());
+    EXPECT_EQ(MAV_RESULT_ACCEPTED, acks[3].result);
+    EXPECT_EQ(MAV_RESULT_DENIED, acks[4].result);
+}
+
+TEST(TelemetryMavlinkTest, TestUnknownCommandIsUnsupported)
+{
+    resetMavlink();
+
+    sendCommand(0, MAV_CMD_COMPONENT_ARM_DISARM, 1, 0);
+    runFor(1);
+
+    ASSERT_EQ(1U, acks.size());
+    EXPECT_EQ(MAV_CMD_COMPONENT_ARM_DISARM, acks[0].command);
+    EXPECT_EQ(MAV_RESULT_UNSUPPORTED, acks[0].result);
+}
+
+TEST(TelemetryMavlinkTest, TestRequestsForAnotherSystemAreIgnored)
+{
+    resetMavlink();
+
+    requestDataStream(1, MAV_DATA_STREAM_EXTRA1, 50, true);
+    sendCommand(1, MAV_CMD_SET_MESSAGE_INTERVAL, MAVLINK_MSG_ID_HEARTBEAT, -1);
+    runFor(TEST_SECONDS);
+
+    EXPECT_EQ(rxData.size(), rxPos);
+    expectRate(10, MAVLINK_MSG_ID_ATTITUDE);
+    expectRate(10, MAVLINK_MSG_ID_HEARTBEAT);
+    EXPECT_TRUE(acks.empty());
+}
+
+TEST(TelemetryMavlinkTest, TestAckWaitsForRoomToSendIt)
+{
+    resetMavlink();
+
+    // the port is full
+    txBuffered = txCapacity;
+    sendCommand(0, MAV_CMD_SET_MESSAGE_INTERVAL, MAVLINK_MSG_ID_ATTITUDE, 20000);
+    sendCommand(0, MAV_CMD_SET_MESSAGE_INTERVAL, MAVLINK_MSG_ID_HEARTBEAT, 1000000);
+
+    testTimeUs += TEST_CALL_INTERVAL_US;
+    handleMAVLinkTelemetry();
+    receiveFromFc();
+
+    EXPECT_TRUE(acks.empty());
+    // the second command waits until the first has been answered
+    EXPECT_GT(rxData.size(), rxPos);
+
+    txBuffered = 0;
+    runFor(TEST_SECONDS);
+
+    ASSERT_EQ(2U, acks.size());
+    EXPECT_EQ(MAV_RESULT_ACCEPTED, acks[0].result);
+    EXPECT_EQ(MAV_RESULT_ACCEPTED, acks[1].result);
+    expectRate(1, MAVLINK_MSG_ID_HEARTBEAT);
+}
+
+// STUBS
+
+extern "C" {
+
+attitudeEulerAngles_t attitude = { { 0, 0, 0 } };
+gpsSolutionData_t gpsSol;
+int32_t GPS_home[2];
+uint16_t GPS_distanceToHome;
+int16_t GPS_directionToHome;
+int16_t rcData[MAX_SUPPORTED_RC_CHANNEL_COUNT];
+rxRuntimeConfig_t rxRuntimeConfig;
+serialPort_t *telemetrySharedPort = NULL;
+uint8_t armingFlags;
+uint16_t flightModeFlags;
+uint8_t stateFlags;
+
+const uint32_t baudRates[] = { 0, 9600, 19200, 38400, 57600, 115200, 230400, 250000, 400000, 460800, 500000, 921600, 1000000, 1500000, 2000000, 2470000 };
+
+uint32_t micros(void) { return testTimeUs; }
+uint32_t millis(void) { return testTimeUs / 1000; }
+
+bool sensors(uint32_t mask) { return mask == SENSOR_ACC; }
+bool featureIsEnabled(uint32_t) { return false; }
+
+bool isBatteryVoltageConfigured(void) { return true; }
+bool isAmperageConfigured(void) { return true; }
+uint16_t getBatteryVoltage(void) { return 168; }
+int32_t getAmperage(void) { return 1250; }
+int32_t getMAhDrawn(void) { return 0; }
+batteryState_e getBatteryState(void) { return BATTERY_OK; }
+uint8_t calculateBatteryPercentageRemaining(void) { return 100; }
+
+uint16_t getRssi(void) { return 0; }
+int32_t getEstimatedAltitudeCm(void) { return 0; }
+bool failsafeIsActive(void) { return false; }
+
+serialPortConfig_t *findSerialPortConfig(serialPortFunction_e) { return &testPortConfig; }
+portSharing_e determinePortSharing(const serialPortConfig_t *, serialPortFunction_e) { return PORTSHARING_NOT_SHARED; }
+bool telemetryDetermineEnabledState(portSharing_e) { return true; }
+bool telemetryCheckRxPortShared(const serialPortConfig_t *) { return false; }
+
+serialPort_t *openSerialPort(serialPortIdentifier_e, serialPortFunction_e, serialReceiveCallbackPtr, void *, uint32_t baudRate, portMode_e, portOptions_e)
+{
+    testPort.baudRate = baudRate;
+    return &testPort;
+}
+
+void closeSerialPort(serialPort_t *) {}
+
+uint32_t serialRxBytesWaiting(const serialPort_t *) { return rxData.size() - rxPos; }
+uint8_t serialRead(serialPort_t *) { return rxData[rxPos++]; }
+
+uint32_t serialTxBytesFree(const serialPort_t *) { return txCapacity - txBuffered; }
+
+void serialWriteBuf(serialPort_t *, const uint8_t *data, int count)
+{
+    EXPECT_LE(txBuffered + count, txCapacity);
+    txData.insert(txData.end(), data, data + count);
+    txBuffered += count;
+}
+
+void serialBeginWrite(serialPort_t *) {}
+void serialEndWrite(serialPort_t *) {}
+
+}
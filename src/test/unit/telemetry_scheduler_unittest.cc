@@ -0,0 +1,232 @@
+/*
+ * This file is part of Cleanflight and Betaflight.
+ *
+ * Cleanflight and Betaflight are free software. You can redistribute
+ * this software and/or modify this software under the terms of the
+ * GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Cleanflight and Betaflight are distributed in the hope that they
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software.
+ *
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+extern "C" {
+    #include "platform.h"
+
+    #include "common/utils.h"
+
+    #include "telemetry/telemetry_scheduler.h"
+}
+
+#include "unittest_macros.h"
+#include "gtest/gtest.h"
+
+#define TEST_SECONDS 10
+#define TEST_STEP_US 1000
+
+static telemetrySchedule_t schedule;
+static int sent[TELEMETRY_SCHEDULE_SENSORS_MAX];
+
+// Runs the schedule for the test time, asking every step, with the time a frame first waited for in worstWaitUs
+static void runSchedule(timeUs_t startUs, timeUs_t *worstWaitUs)
+{
+    timeUs_t lastSentUs[TELEMETRY_SCHEDULE_SENSORS_MAX];
+    memset(sent, 0, sizeof(sent));
+    for (int i = 0; i < TELEMETRY_SCHEDULE_SENSORS_MAX; i++) {
+        lastSentUs[i] = startUs;
+        if (worstWaitUs) {
+            worstWaitUs[i] = 0;
+        }
+    }
+
+    for (int step = 0; step < TEST_SECONDS * 1000000 / TEST_STEP_US; step++) {
+        const timeUs_t t = startUs + step * TEST_STEP_US;
+        const int index = telemetryScheduleNext(&schedule, t);
+        if (index >= 0) {
+            sent[index]++;
+            if (worstWaitUs && t - lastSentUs[index] > worstWaitUs[index]) {
+                worstWaitUs[index] = t - lastSentUs[index];
+            }
+            lastSentUs[index] = t;
+        }
+    }
+}
+
+TEST(TelemetrySchedulerTest, TestRatesMet)
+{
+    static const telemetrySensor_t sensors[] = {
+        { 50, TELEMETRY_PRIORITY_HIGH, 10 },
+        { 10, TELEMETRY_PRIORITY_NORMAL, 20 },
+        { 1, TELEMETRY_PRIORITY_LOW, 20 },
+    };
+    // plenty of room
+    telemetryScheduleInit(&schedule, sensors, 3, 11520);
+
+    runSchedule(0, NULL);
+
+    EXPECT_NEAR(50 * TEST_SECONDS, sent[0], 2);
+    EXPECT_NEAR(10 * TEST_SECONDS, sent[1], 1);
+    EXPECT_NEAR(1 * TEST_SECONDS, sent[2], 1);
+}
+
+TEST(TelemetrySchedulerTest, TestLinkBudgetKept)
+{
+    static const telemetrySensor_t sensors[] = {
+        { 50, TELEMETRY_PRIORITY_HIGH, 20 },
+        { 50, TELEMETRY_PRIORITY_NORMAL, 20 },
+        { 50, TELEMETRY_PRIORITY_LOW, 20 },
+    };
+    // 50 frames a second, a third of what is asked for
+    telemetryScheduleInit(&schedule, sensors, 3, 1000);
+
+    timeUs_t worstWaitUs[TELEMETRY_SCHEDULE_SENSORS_MAX];
+    runSchedule(0, worstWaitUs);
+
+    const int total = sent[0] + sent[1] + sent[2];
+    EXPECT_LE(total, 50 * TEST_SECONDS + 1);
+    EXPECT_GE(total, 50 * TEST_SECONDS - 1);
+
+    // higher priorities first, but nothing starves
+    EXPECT_GT(sent[0], sent[1]);
+    EXPECT_GT(sent[1], sent[2]);
+    EXPECT_GT(sent[2], 0);
+    for (int i = 0; i < 3; i++) {
+        EXPECT_LT(worstWaitUs[i], 1000000u) << "sensor " << i;
+    }
+}
+
+TEST(TelemetrySchedulerTest, TestSlotsFilledWithoutBudget)
+{
+    static const telemetrySensor_t sensors[] = {
+        { 5, TELEMETRY_PRIORITY_HIGH, 1 },
+        { 1, TELEMETRY_PRIORITY_LOW, 1 },
+    };
+    // the receiver hands out a slot every step, each gets one
+    telemetryScheduleInit(&schedule, sensors, 2, 0);
+
+    runSchedule(0, NULL);
+
+    EXPECT_EQ(TEST_SECONDS * 1000000 / TEST_STEP_US, sent[0] + sent[1]);
+    // still in proportion
+    EXPECT_GT(sent[0], sent[1] * 3);
+    EXPECT_GT(sent[1], 0);
+}
+
+TEST(TelemetrySchedulerTest, TestDisabledSensorsNotSent)
+{
+    static const telemetrySensor_t sensors[] = {
+        { 10, TELEMETRY_PRIORITY_NORMAL, 1 },
+        { 10, TELEMETRY_PRIORITY_HIGH, 1 },
+        { 0, TELEMETRY_PRIORITY_HIGH, 1 },
+    };
+    telemetryScheduleInit(&schedule, sensors, 3, 0);
+    telemetryScheduleEnable(&schedule, 1, false);
+
+    EXPECT_TRUE(telemetryScheduleIsEnabled(&schedule, 0));
+    EXPECT_FALSE(telemetryScheduleIsEnabled(&schedule, 1));
+    EXPECT_FALSE(telemetryScheduleIsEnabled(&schedule, 3));
+
+    runSchedule(0, NULL);
+    EXPECT_GT(sent[0], 0);
+    EXPECT_EQ(0, sent[1]);
+    EXPECT_EQ(0, sent[2]);
+
+    telemetryScheduleEnable(&schedule, 0, false);
+    EXPECT_EQ(-1, telemetryScheduleNext(&schedule, TEST_SECONDS * 1000000));
+}
+
+TEST(TelemetrySchedulerTest, TestLinkUsedDelaysSchedule)
+{
+    static const telemetrySensor_t sensors[] = {
+        { 10, TELEMETRY_PRIORITY_HIGH, 10 },
+    };
+    // 100 bytes a second
+    telemetryScheduleInit(&schedule, sensors, 1, 100);
+
+    EXPECT_EQ(0, telemetryScheduleNext(&schedule, 0));
+
+    // an MSP reply of 50 bytes keeps the link for another half second past the frame
+    telemetryScheduleLinkUsed(&schedule, 0, 50);
+    EXPECT_EQ(-1, telemetryScheduleNext(&schedule, 500000));
+    EXPECT_EQ(0, telemetryScheduleNext(&schedule, 600000));
+}
+
+TEST(TelemetrySchedulerTest, TestTimerWraps)
+{
+    static const telemetrySensor_t sensors[] = {
+        { 20, TELEMETRY_PRIORITY_HIGH, 1 },
+        { 5, TELEMETRY_PRIORITY_LOW, 1 },
+    };
+    telemetryScheduleInit(&schedule, sensors, 2, 1000);
+
+    runSchedule((timeUs_t)0 - TEST_SECONDS * 1000000 / 2, NULL);
+
+    EXPECT_NEAR(20 * TEST_SECONDS, sent[0], 1);
+    EXPECT_NEAR(5 * TEST_SECONDS, sent[1], 1);
+}
+
+TEST(TelemetrySchedulerTest, TestBurstAfterIdle)
+{
+    static const telemetrySensor_t sensors[] = {
+        { 10, TELEMETRY_PRIORITY_HIGH, 10 },
+        { 10, TELEMETRY_PRIORITY_NORMAL, 10 },
+        { 10, TELEMETRY_PRIORITY_NORMAL, 10 },
+        { 10, TELEMETRY_PRIORITY_LOW, 10 },
+    };
+    // 100 bytes a second, two frames can follow the one the link is free for
+    telemetryScheduleInit(&schedule, sensors, 4, 0);
+    telemetryScheduleSetBudget(&schedule, 100, 20);
+
+    // none small enough
+    EXPECT_EQ(-1, telemetryScheduleNextWithin(&schedule, 0, 5));
+
+    EXPECT_EQ(0, telemetryScheduleNextWithin(&schedule, 0, 10));
+    EXPECT_EQ(1, telemetryScheduleNext(&schedule, 0));
+    EXPECT_EQ(2, telemetryScheduleNext(&schedule, 0));
+    EXPECT_EQ(-1, telemetryScheduleNext(&schedule, 0));
+
+    // the link catches up, then a burst builds up again while it is idle
+    EXPECT_GE(telemetryScheduleNext(&schedule, 100000), 0);
+    EXPECT_EQ(-1, telemetryScheduleNext(&schedule, 150000));
+    int sent = 0;
+    while (telemetryScheduleNext(&schedule, 2000000) >= 0) {
+        sent++;
+    }
+    EXPECT_EQ(3, sent);
+}
+
+TEST(TelemetrySchedulerTest, TestSensorWithoutValueKeepsItsPlace)
+{
+    static const telemetrySensor_t sensors[] = {
+        { 10, TELEMETRY_PRIORITY_HIGH, 1 },
+        { 10, TELEMETRY_PRIORITY_LOW, 1 },
+    };
+    // slots handed out by the receiver
+    telemetryScheduleInit(&schedule, sensors, 2, 0);
+
+    // the high priority sensor has no value for a second, only the other one is sent
+    for (timeUs_t t = 0; t < 1000000; t += 50000) {
+        EXPECT_EQ(1, telemetryScheduleNextReady(&schedule, t, BIT(1)));
+    }
+
+    // it is still due, so goes as soon as it has one, and makes up for one period it missed
+    EXPECT_EQ(0, telemetryScheduleNextReady(&schedule, 1000000, BIT(0) | BIT(1)));
+    EXPECT_EQ(0, telemetryScheduleNextReady(&schedule, 1000000, BIT(0) | BIT(1)));
+    EXPECT_EQ(1, telemetryScheduleNextReady(&schedule, 1000000, BIT(0) | BIT(1)));
+
+    // nothing to send
+    EXPECT_EQ(-1, telemetryScheduleNextReady(&schedule, 1050000, 0));
+}
@@ -0,0 +1,251 @@
+/*
+ * This file is part of Cleanflight and Betaflight.
+ *
+ * Cleanflight and Betaflight are free software. You can redistribute
+ * this software and/or modify this software under the terms of the
+ * GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Cleanflight and Betaflight are distributed in the hope that they
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software.
+ *
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+extern "C" {
+    #include "platform.h"
+
+    #include "common/axis.h"
+    #include "common/time.h"
+
+    #include "pg/pg.h"
+    #include "pg/pg_ids.h"
+
+    #include "drivers/serial.h"
+
+    #include "fc/controlrate_profile.h"
+    #include "fc/runtime_config.h"
+
+    #include "flight/imu.h"
+    #include "flight/pid.h"
+
+    #include "io/gps.h"
+    #include "io/serial.h"
+
+    #include "sensors/acceleration.h"
+    #include "sensors/battery.h"
+    #include "sensors/sensors.h"
+
+    #include "telemetry/smartport.h"
+    #include "telemetry/telemetry.h"
+
+    PG_REGISTER(telemetryConfig_t, telemetryConfig, PG_TELEMETRY_CONFIG, 0);
+
+    uint16_t testBatteryVoltage = 0;
+    int32_t testAmperage = 0;
+    timeUs_t testTimeUs = 0;
+    uint32_t testMillis = 0;
+}
+
+#include "unittest_macros.h"
+#include "gtest/gtest.h"
+
+#define FSSP_DATAID_VFAS    0x0210
+#define FSSP_DATAID_CURRENT 0x0200
+#define FSSP_DATAID_FUEL    0x0600
+#define FSSP_DATAID_HEADING 0x0840
+#define FSSP_DATAID_ACCX    0x0700
+#define FSSP_DATAID_T1      0x0400
+#define FSSP_DATAID_T2      0x0410
+#define FSSP_DATAID_A4      0x0910
+
+#define TEST_POLL_INTERVAL_US 24000   // the slot for our physical ID comes round this often
+#define TEST_SECONDS 10
+
+#define TEST_DATAID_MAX 0x1000
+
+static int framesWritten;
+static int framesSent[TEST_DATAID_MAX];
+static uint32_t dataSent[TEST_DATAID_MAX];
+
+static void testWriteFrame(const smartPortPayload_t *payload)
+{
+    EXPECT_EQ(FSSP_DATA_FRAME, payload->frameId);
+    EXPECT_GT(TEST_DATAID_MAX, payload->valueId);
+    framesWritten++;
+    framesSent[payload->valueId]++;
+    dataSent[payload->valueId] = payload->data;
+}
+
+static void initSmartPort(void)
+{
+    static bool initialised = false;
+    if (initialised) {
+        return;
+    }
+    initialised = true;
+
+    telemetryConfig_t *config = telemetryConfigMutable();
+    memset(config, 0, sizeof(*config));
+    config->smartport_sensor_rates[SMARTPORT_SENSOR_FLAGS] = 2;
+    config->smartport_sensor_rates[SMARTPORT_SENSOR_STATUS] = 1;
+    config->smartport_sensor_rates[SMARTPORT_SENSOR_VFAS] = 10;
+    config->smartport_sensor_rates[SMARTPORT_SENSOR_CELL_VOLTAGE] = 5;
+    config->smartport_sensor_rates[SMARTPORT_SENSOR_CURRENT] = 5;
+    config->smartport_sensor_rates[SMARTPORT_SENSOR_FUEL] = 2;
+    // heading and acc are not sent
+    config->smartport_sensor_rates[SMARTPORT_SENSOR_HEADING] = 0;
+    config->smartport_sensor_rates[SMARTPORT_SENSOR_ACC] = 0;
+
+    sensorsSet(SENSOR_ACC);
+
+    EXPECT_TRUE(initSmartPortTelemetryExternal(testWriteFrame));
+}
+
+// Answers a poll, as the serial port does, returns true if the slot is still free
+static bool poll(void)
+{
+    testTimeUs += TEST_POLL_INTERVAL_US;
+    bool clearToSend = true;
+    const uint32_t requestTimeout = testMillis + 100;
+    processSmartPortTelemetry(NULL, &clearToSend, &requestTimeout);
+    return clearToSend;
+}
+
+// Answers the polls for a number of slots, returns how many frames were sent
+static int pollSlots(int slots)
+{
+    const int framesBefore = framesWritten;
+    for (int i = 0; i < slots; i++) {
+        poll();
+    }
+    return framesWritten - framesBefore;
+}
+
+TEST(TelemetrySmartPortTest, TestValuesWorkedOutByTheTelemetryTask)
+{
+    initSmartPort();
+
+    // nothing has been worked out yet
+    EXPECT_TRUE(poll());
+    EXPECT_EQ(0, framesWritten);
+
+    testBatteryVoltage = 168; // 16.8V
+    testAmperage = 1250;      // 12.5A
+    handleSmartPortTelemetry();
+
+    // the value sent is the one worked out by the refresh, not the one at the poll
+    testBatteryVoltage = 150;
+    testAmperage = 0;
+    memset(framesSent, 0, sizeof(framesSent));
+    const int sent = pollSlots(10);
+
+    // T1, VFAS, A4, CURRENT and FUEL, T2 has nothing to send without GPS or PIDs, heading and acc have a rate of 0
+    EXPECT_EQ(5, sent);
+    EXPECT_EQ(1, framesSent[FSSP_DATAID_T1]);
+    EXPECT_EQ(1, framesSent[FSSP_DATAID_VFAS]);
+    EXPECT_EQ(1, framesSent[FSSP_DATAID_A4]);
+    EXPECT_EQ(1, framesSent[FSSP_DATAID_CURRENT]);
+    EXPECT_EQ(1, framesSent[FSSP_DATAID_FUEL]);
+    EXPECT_EQ(0, framesSent[FSSP_DATAID_T2]);
+    EXPECT_EQ(0, framesSent[FSSP_DATAID_HEADING]);
+    EXPECT_EQ(0, framesSent[FSSP_DATAID_ACCX]);
+
+    EXPECT_EQ(1680u, dataSent[FSSP_DATAID_VFAS]);
+    EXPECT_EQ(420u, dataSent[FSSP_DATAID_A4]);
+    EXPECT_EQ(125u, dataSent[FSSP_DATAID_CURRENT]);
+
+    // and the next refresh picks up the change
+    handleSmartPortTelemetry();
+    EXPECT_EQ(5, pollSlots(10));
+    EXPECT_EQ(1500u, dataSent[FSSP_DATAID_VFAS]);
+    EXPECT_EQ(375u, dataSent[FSSP_DATAID_A4]);
+    EXPECT_EQ(0u, dataSent[FSSP_DATAID_CURRENT]);
+}
+
+TEST(TelemetrySmartPortTest, TestPollReturnsOnceEverythingIsSent)
+{
+    initSmartPort();
+
+    handleSmartPortTelemetry();
+    EXPECT_EQ(5, pollSlots(10));
+
+    // the slot is left for the next refresh, rather than spinning until the request times out
+    const int framesBefore = framesWritten;
+    const uint32_t millisBefore = testMillis;
+    EXPECT_TRUE(poll());
+    EXPECT_EQ(framesBefore, framesWritten);
+    EXPECT_GE(2u, testMillis - millisBefore);
+}
+
+TEST(TelemetrySmartPortTest, TestSensorRates)
+{
+    initSmartPort();
+
+    memset(framesSent, 0, sizeof(framesSent));
+    // refreshed by the telemetry task between each poll
+    for (int i = 0; i < TEST_SECONDS * 1000000 / TEST_POLL_INTERVAL_US; i++) {
+        handleSmartPortTelemetry();
+        EXPECT_FALSE(poll());
+    }
+
+    // every slot is used, shared out by the configured rates, 24 in all
+    const float share = (float)(TEST_SECONDS * 1000000 / TEST_POLL_INTERVAL_US) / 24;
+    EXPECT_NEAR(10 * share, framesSent[FSSP_DATAID_VFAS], 10 * share / 5);
+    EXPECT_NEAR(5 * share, framesSent[FSSP_DATAID_A4], 5 * share / 5);
+    EXPECT_NEAR(5 * share, framesSent[FSSP_DATAID_CURRENT], 5 * share / 5);
+    EXPECT_NEAR(2 * share, framesSent[FSSP_DATAID_T1], 2 * share / 5);
+    EXPECT_NEAR(2 * share, framesSent[FSSP_DATAID_FUEL], 2 * share / 5);
+    EXPECT_EQ(0, framesSent[FSSP_DATAID_T2]);
+    EXPECT_EQ(0, framesSent[FSSP_DATAID_HEADING]);
+    EXPECT_EQ(0, framesSent[FSSP_DATAID_ACCX]);
+}
+
+// STUBS
+
+extern "C" {
+
+attitudeEulerAngles_t attitude = { { 0, 0, 0 } };
+acc_t acc;
+gpsSolutionData_t gpsSol;
+uint16_t GPS_distanceToHome;
+pidProfile_t *currentPidProfile;
+controlRateConfig_t *currentControlRateProfile;
+
+uint32_t micros(void) { return testTimeUs; }
+uint32_t millis(void) { return ++testMillis; }
+
+bool featureIsEnabled(uint32_t) { return false; }
+
+bool isBatteryVoltageConfigured(void) { return true; }
+bool isAmperageConfigured(void) { return true; }
+uint16_t getBatteryVoltage(void) { return testBatteryVoltage; }
+uint8_t getBatteryCellCount(void) { return 4; }
+int32_t getAmperage(void) { return testAmperage; }
+int32_t getMAhDrawn(void) { return 0; }
+
+int32_t getEstimatedAltitudeCm(void) { return 0; }
+int16_t getEstimatedVario(void) { return 0; }
+
+void beeperConfirmationBeeps(uint8_t) {}
+
+uint32_t serialRxBytesWaiting(const serialPort_t *) { return 0; }
+uint8_t serialRead(serialPort_t *) { return 0; }
+void serialWrite(serialPort_t *, uint8_t) {}
+serialPort_t *openSerialPort(serialPortIdentifier_e, serialPortFunction_e, serialReceiveCallbackPtr, void *, uint32_t, portMode_e, portOptions_e) { return NULL; }
+void closeSerialPort(serialPort_t *) {}
+serialPortConfig_t *findSerialPortConfig(serialPortFunction_e) { return NULL; }
+portSharing_e determinePortSharing(const serialPortConfig_t *, serialPortFunction_e) { return PORTSHARING_NOT_SHARED; }
+bool telemetryDetermineEnabledState(portSharing_e) { return true; }
+
+}
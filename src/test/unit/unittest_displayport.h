@@ -33,6 +33,7 @@ void displayPortTestBufferSubstring(int x, int y, const char * expectedFormat, .
 #define UNITTEST_DISPLAYPORT_BUFFER_LEN (UNITTEST_DISPLAYPORT_ROWS * UNITTEST_DISPLAYPORT_COLS)
 
 char testDisplayPortBuffer[UNITTEST_DISPLAYPORT_BUFFER_LEN];
+int testDisplayPortCharsWritten;
 
 static displayPort_t testDisplayPort;
 
@@ -73,6 +74,7 @@ static int displayPortTestWriteString(displayPort_t *displayPort, uint8_t x, uin
     for (unsigned int i = 0; i < strlen(s); i++) {
         testDisplayPortBuffer[(y * UNITTEST_DISPLAYPORT_COLS) + x + i] = s[i];
     }
+    testDisplayPortCharsWritten += strlen(s);
     return 0;
 }
 
@@ -80,6 +82,7 @@ static int displayPortTestWriteChar(displayPort_t *displayPort, uint8_t x, uint8
 {
     UNUSED(displayPort);
     testDisplayPortBuffer[(y * UNITTEST_DISPLAYPORT_COLS) + x] = c;
+    testDisplayPortCharsWritten++;
     return 0;
 }
 
@@ -18,11 +18,13 @@
 #include <stdlib.h>
 
 #include <limits.h>
+#include <stdlib.h>
 
 extern "C" {
     #include "build/build_config.h"
 
     #include "common/color.h"
+    #include "common/colorconversion.h"
 
     #include "drivers/light_ws2811strip.h"
 }
@@ -33,7 +35,7 @@ extern "C" {
 extern "C" {
 STATIC_UNIT_TESTED extern uint16_t dmaBufferOffset;
 
-STATIC_UNIT_TESTED void fastUpdateLEDDMABuffer(rgbColor24bpp_t *color);
+STATIC_UNIT_TESTED void fastUpdateLEDDMABuffer(ledStripFormatRGB_e ledFormat, rgbColor24bpp_t *color);
 STATIC_UNIT_TESTED void updateLEDDMABuffer(uint8_t componentValue);
 }
 
@@ -50,7 +52,7 @@ TEST(WS2812, updateDMABuffer) {
     updateLEDDMABuffer(color1.rgb.r);
     updateLEDDMABuffer(color1.rgb.b);
 #else
-    fastUpdateLEDDMABuffer(&color1);
+    fastUpdateLEDDMABuffer(LED_GRB, &color1);
 #endif
 
     // then
@@ -90,15 +92,125 @@ TEST(WS2812, updateDMABuffer) {
     byteIndex++;
 }
 
-extern "C" {
-rgbColor24bpp_t* hsvToRgb24(const hsvColor_t *c) {
-    UNUSED(c);
-    return NULL;
+static int dmaTransfers;
+
+// Bit compare values for the whole strip, encoding every LED as it is
+static void expectStripEncoded(const hsvColor_t *colors, ledStripFormatRGB_e ledFormat)
+{
+    for (int led = 0; led < WS2811_LED_STRIP_LENGTH; led++) {
+        hsvColor_t color = colors[led];
+        const rgbColor24bpp_t *rgb24 = hsvToRgb24(&color);
+        const uint32_t packed = (ledFormat == LED_RGB)
+            ? (rgb24->rgb.r << 16) | (rgb24->rgb.g << 8) | rgb24->rgb.b
+            : (rgb24->rgb.g << 16) | (rgb24->rgb.r << 8) | rgb24->rgb.b;
+
+        for (int bit = 0; bit < WS2811_BITS_PER_LED; bit++) {
+            const uint16_t expected = (packed & (1 << (23 - bit))) ? BIT_COMPARE_1 : BIT_COMPARE_0;
+            ASSERT_EQ(expected, ledStripDMABuffer[led * WS2811_BITS_PER_LED + bit]) << "led " << led << " bit " << bit;
+        }
+    }
+}
+
+static void updateStrip(ledStripFormatRGB_e ledFormat)
+{
+    ws2811UpdateStrip(ledFormat);
+    // the transfer is done straight away
+    ws2811LedDataTransferInProgress = 0;
 }
 
+static void testInit(void)
+{
+    BIT_COMPARE_1 = 2;
+    BIT_COMPARE_0 = 1;
+    ws2811LedStripInit(IO_TAG_NONE);
+    ws2811LedDataTransferInProgress = 0;
+    dmaTransfers = 0;
+}
+
+TEST(WS2812, changedLedsEncodedAsWholeStrip) {
+    // given
+    testInit();
+    hsvColor_t colors[WS2811_LED_STRIP_LENGTH];
+    for (int led = 0; led < WS2811_LED_STRIP_LENGTH; led++) {
+        getLedHsv(led, &colors[led]);
+    }
+    srand(1);
+
+    for (int frame = 0; frame < 200; frame++) {
+        // when
+        // a background written everywhere every frame, as the LED strip layers do, with a few LEDs changed over it
+        for (int led = 0; led < WS2811_LED_STRIP_LENGTH; led++) {
+            setLedHsv(led, &colors[led]);
+        }
+        for (int change = rand() % 4; change > 0; change--) {
+            const int led = rand() % WS2811_LED_STRIP_LENGTH;
+            colors[led].h = rand() % (HSV_HUE_MAX + 1);
+            colors[led].s = rand() % 256;
+            colors[led].v = rand() % 256;
+            setLedHsv(led, &colors[led]);
+        }
+        if (frame % 10 == 0) {
+            const int led = rand() % WS2811_LED_STRIP_LENGTH;
+            scaleLedValue(led, 50);
+            colors[led].v = (uint16_t)colors[led].v * 50 / 100;
+        }
+        updateStrip(LED_GRB);
+
+        // then
+        expectStripEncoded(colors, LED_GRB);
+    }
+}
+
+TEST(WS2812, unchangedStripNotSent) {
+    // given
+    testInit();
+    const hsvColor_t red = { 0, 0, 255 };
+    setStripColor(&red);
+    updateStrip(LED_GRB);
+    EXPECT_EQ(1, dmaTransfers);
+
+    // when
+    setStripColor(&red);
+    updateStrip(LED_GRB);
+
+    // then
+    EXPECT_EQ(1, dmaTransfers);
+
+    // when
+    setLedValue(3, 100);
+    updateStrip(LED_GRB);
+
+    // then
+    EXPECT_EQ(2, dmaTransfers);
+}
+
+TEST(WS2812, formatChangeEncodesWholeStrip) {
+    // given
+    testInit();
+    hsvColor_t colors[WS2811_LED_STRIP_LENGTH];
+    for (int led = 0; led < WS2811_LED_STRIP_LENGTH; led++) {
+        colors[led].h = led * 11;
+        colors[led].s = 0;
+        colors[led].v = 255;
+    }
+    setStripColors(colors);
+    updateStrip(LED_GRB);
+    expectStripEncoded(colors, LED_GRB);
+
+    // when
+    updateStrip(LED_RGB);
+
+    // then
+    expectStripEncoded(colors, LED_RGB);
+    EXPECT_EQ(2, dmaTransfers);
+}
+
+extern "C" {
 void ws2811LedStripHardwareInit(ioTag_t ioTag) {
     UNUSED(ioTag);
 }
 
-void ws2811LedStripDMAEnable(void) {}
+void ws2811LedStripDMAEnable(void) {
+    dmaTransfers++;
+}
 }